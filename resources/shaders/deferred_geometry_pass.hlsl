@@ -16,8 +16,8 @@
 #ifndef __DEFERRED_GEOMETRY_PASS_HLSL__
 #define __DEFERRED_GEOMETRY_PASS_HLSL__
 
-//48 KiB; 48 * 1024 / sizeof(MeshNode)
-//48 * 1024 / (4 * 4 * 4) = 48 * 1024 / 64 = 48 * 16 = 768
+//Must match d3d12::settings::num_instances_per_batch
+//sizeof(ObjectData) = 2 * (3 * 4 * 4) = 96
 #define MAX_INSTANCES 768
 
 #include "material_util.hlsl"
@@ -73,10 +73,11 @@ cbuffer CameraProperties : register(b0)
 	uint has_reflections;
 };
 
+//Transposed 3x4 affine matrices; see temp::ObjectData
 struct ObjectData
 {
-	float4x4 model;
-	float4x4 prev_model;
+	row_major float3x4 model;
+	row_major float3x4 prev_model;
 };
 
 cbuffer ObjectProperties : register(b1)
@@ -92,22 +93,21 @@ VS_OUTPUT main_vs(VS_INPUT input, uint instid : SV_InstanceId)
 
 	ObjectData inst = instances[instid];
 
-	//TODO: Use precalculated MVP or at least VP
-	float4x4 vm = mul(view, inst.model);
-	float4x4 mvp = mul(projection, vm);
+	//TODO: Use precalculated VP
+	float4 world_pos = float4(mul(inst.model, float4(pos, 1.0f)), 1.0f);
 
-	float4x4 prev_mvp = mul(prev_projection, mul(prev_view, inst.prev_model));
-	
-	output.pos =  mul(mvp, float4(pos, 1.0f));
+	output.pos = mul(projection, mul(view, world_pos));
 	#ifdef IS_HYBRID
+	float4 prev_world_pos = float4(mul(inst.prev_model, float4(pos, 1.0f)), 1.0f);
+
 	output.curr_pos = output.pos;
-	output.prev_pos = mul(prev_mvp, float4(pos, 1.0f));
-	output.world_pos = mul(inst.model, float4(pos, 1.0f));
+	output.prev_pos = mul(prev_projection, mul(prev_view, prev_world_pos));
+	output.world_pos = world_pos;
 	#endif
 	output.uv = float2(input.uv.x, 1.0f - input.uv.y);
-	output.tangent = normalize(mul(inst.model, float4(input.tangent, 0))).xyz;
-	output.bitangent = normalize(mul(inst.model, float4(input.bitangent, 0))).xyz;
-	output.normal = normalize(mul(inst.model, float4(input.normal, 0))).xyz;
+	output.tangent = normalize(mul(inst.model, float4(input.tangent, 0)));
+	output.bitangent = normalize(mul(inst.model, float4(input.bitangent, 0)));
+	output.normal = normalize(mul(inst.model, float4(input.normal, 0)));
 	#ifdef IS_HYBRID
 	output.obj_normal = input.normal.xyz;
 	output.obj_tangent = input.tangent.xyz;
@@ -34,6 +34,30 @@ uint3 Load3x32BitIndices(ByteAddressBuffer buffer, uint offsetBytes)
 	return buffer.Load3(offsetBytes);
 }
 
+// Meshes with less than 65536 vertices use 16 bit indices, see ModelPool::LoadNodeMesh
+uint3 Load3x16BitIndices(ByteAddressBuffer buffer, uint offsetBytes)
+{
+	// ByteAddressBuffer loads have to be 4 byte aligned, so load the 2 dwords that contain the 3 indices
+	const uint dword_aligned_offset = offsetBytes & ~3;
+	const uint2 four_indices = buffer.Load2(dword_aligned_offset);
+
+	uint3 indices;
+	if (dword_aligned_offset == offsetBytes)
+	{
+		indices.x = four_indices.x & 0xffff;
+		indices.y = (four_indices.x >> 16) & 0xffff;
+		indices.z = four_indices.y & 0xffff;
+	}
+	else
+	{
+		indices.x = (four_indices.x >> 16) & 0xffff;
+		indices.y = four_indices.y & 0xffff;
+		indices.z = (four_indices.y >> 16) & 0xffff;
+	}
+
+	return indices;
+}
+
 // Retrieve hit world position.
 float3 HitWorldPosition()
 {
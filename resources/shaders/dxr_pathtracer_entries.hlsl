@@ -30,14 +30,14 @@ void ReflectionHit(inout PathTracingHitInfoCone payload, in Attributes attr)
 	const float vertex_offset = offset.vertex_offset;
 
 	// Find first index location
-	const uint index_size = 4;
+	const uint index_size = offset.index_stride;
 	const uint indices_per_triangle = 3;
 	const uint triangle_idx_stride = indices_per_triangle * index_size;
 
 	uint base_idx = PrimitiveIndex() * triangle_idx_stride;
-	base_idx += index_offset * 4; // offset the start
+	base_idx += index_offset * index_size; // offset the start
 
-	uint3 indices = Load3x32BitIndices(g_indices, base_idx);
+	uint3 indices = index_size == 2 ? Load3x16BitIndices(g_indices, base_idx) : Load3x32BitIndices(g_indices, base_idx);
 	indices += float3(vertex_offset, vertex_offset, vertex_offset); // offset the start
 
 	// Gather triangle vertices
@@ -67,6 +67,7 @@ void ReflectionHit(inout PathTracingHitInfoCone payload, in Attributes attr)
 		g_textures[material.emissive_id],
 		g_textures[material.ao_id],
 		mip_level,
+		material.resident_mips,
 		s0,
 		uv);
 
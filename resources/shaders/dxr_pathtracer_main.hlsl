@@ -29,7 +29,7 @@
 #include "dxr_structs.hlsl"
 
 // Definitions for: 
-// - HitWorldPosition, Load3x32BitIndices, unpack_position, HitAttribute
+// - HitWorldPosition, Load3x32BitIndices, Load3x16BitIndices, unpack_position, HitAttribute
 #include "dxr_functions.hlsl"
 
 RWTexture2D<float4> output : register(u0); // xyz: reflection, a: shadow factor
@@ -54,7 +54,8 @@ struct Material
 	uint metalicness_id;
 	uint emissive_id;
 	uint ao_id;
-	float2 padding;
+	uint resident_mips; // 4 bits per texture, in the order of the ids
+	float padding;
 
 	MaterialData data;
 };
@@ -64,6 +65,7 @@ struct Offset
 	uint material_idx;
 	uint idx_offset;
 	uint vertex_offset;
+	uint index_stride;
 };
 
 struct Ray
@@ -36,6 +36,13 @@ struct OutputMaterialData
 	float ao;
 };
 
+// Normal maps can be stored as BC5, which only keeps x and y, so z is always rebuilt
+float3 UnpackNormalMap(float2 xy)
+{
+	float2 n = xy * 2.0f - 1.0f;
+	return float3(n, sqrt(saturate(1.0f - dot(n, n))));
+}
+
 OutputMaterialData InterpretMaterialData(MaterialData data,
 	Texture2D material_albedo,
 	Texture2D material_normal,
@@ -65,7 +72,7 @@ OutputMaterialData InterpretMaterialData(MaterialData data,
 	float metallic = lerp(data.metallic, material_metallic.Sample(s0, uv * data.metallic_uv_scale).x, use_metallic_texture);
 #endif
 
-	float3 tex_normal = lerp(float3(0.0f, 0.0f, 1.0f), material_normal.Sample(s0, uv * data.normal_uv_scale).rgb * 2.0f - float3(1.0f, 1.0f, 1.0f), use_normal_texture);
+	float3 tex_normal = lerp(float3(0.0f, 0.0f, 1.0f), UnpackNormalMap(material_normal.Sample(s0, uv * data.normal_uv_scale).xy), use_normal_texture);
 	float3 emissive = lerp(float3(0.0f, 0.0f, 0.0f), material_emissive.Sample(s0, uv * data.emissive_uv_scale).xyz, use_emissive_texture);
 	float ao = lerp(1.0f, material_ambient_occlusion.Sample(s0, uv * data.ao_uv_scale).x, use_ao_texture);
 
@@ -80,6 +87,13 @@ OutputMaterialData InterpretMaterialData(MaterialData data,
 	return output;
 }
 
+// Streamed textures can lack their finest mips, mip 0 of their resource is mip resident_mip of the full chain.
+// texture_idx is the texture's place in the order of the material's texture ids.
+float GetResidentMipLevel(float mip_level, uint resident_mips, uint texture_idx)
+{
+	return max(mip_level - float((resident_mips >> (texture_idx * 4)) & 0xF), 0.0f);
+}
+
 OutputMaterialData InterpretMaterialDataRT(MaterialData data,
 	Texture2D material_albedo,
 	Texture2D material_normal,
@@ -88,6 +102,7 @@ OutputMaterialData InterpretMaterialDataRT(MaterialData data,
 	Texture2D material_emissive,
 	Texture2D material_ambient_occlusion,
 	float mip_level,
+	uint resident_mips,
 	SamplerState s0,
 	float2 uv)
 {
@@ -101,26 +116,26 @@ OutputMaterialData InterpretMaterialDataRT(MaterialData data,
 	float use_ao_texture = float((data.flags & MATERIAL_HAS_AO_TEXTURE) != 0);
 
 	const float4 albedo = lerp(float4(data.color, 1),
-		material_albedo.SampleLevel(s0, uv * (data.albedo_uv_scale), mip_level),
+		material_albedo.SampleLevel(s0, uv * (data.albedo_uv_scale), GetResidentMipLevel(mip_level, resident_mips, 0)),
 		use_albedo_texture);
 
 	#ifdef COMPRESSED
-	const float roughness = lerp(data.roughness, max(0.05, material_roughness.SampleLevel(s0, uv * data.roughness_uv_scale, mip_level).z), use_roughness_texture);
-	const float metallic = lerp(data.metallic, material_metallic.SampleLevel(s0, uv * data.metallic_uv_scale, mip_level).y, use_metallic_texture); 
+	const float roughness = lerp(data.roughness, max(0.05, material_roughness.SampleLevel(s0, uv * data.roughness_uv_scale, GetResidentMipLevel(mip_level, resident_mips, 2)).z), use_roughness_texture);
+	const float metallic = lerp(data.metallic, material_metallic.SampleLevel(s0, uv * data.metallic_uv_scale, GetResidentMipLevel(mip_level, resident_mips, 3)).y, use_metallic_texture); 
 	#else
-	const float roughness = lerp(data.roughness, max(0.05, material_roughness.SampleLevel(s0, uv * data.roughness_uv_scale, mip_level).x), use_roughness_texture);
-	const float metallic = lerp(data.metallic, material_metallic.SampleLevel(s0, uv * data.metallic_uv_scale, mip_level).x, use_metallic_texture); 
+	const float roughness = lerp(data.roughness, max(0.05, material_roughness.SampleLevel(s0, uv * data.roughness_uv_scale, GetResidentMipLevel(mip_level, resident_mips, 2)).x), use_roughness_texture);
+	const float metallic = lerp(data.metallic, material_metallic.SampleLevel(s0, uv * data.metallic_uv_scale, GetResidentMipLevel(mip_level, resident_mips, 3)).x, use_metallic_texture); 
 	#endif
 	
 	const float3 normal_t = lerp(float3(0.0, 0.0, 1.0),
-		material_normal.SampleLevel(s0, uv * data.normal_uv_scale, mip_level).xyz * 2 - 1,
+		UnpackNormalMap(material_normal.SampleLevel(s0, uv * data.normal_uv_scale, GetResidentMipLevel(mip_level, resident_mips, 1)).xy),
 		use_normal_texture);
 
 	float3 emissive = lerp(float3(0.0f, 0.0f, 0.0f), 
-		material_emissive.SampleLevel(s0, uv * data.emissive_uv_scale, mip_level).xyz, use_emissive_texture);
+		material_emissive.SampleLevel(s0, uv * data.emissive_uv_scale, GetResidentMipLevel(mip_level, resident_mips, 4)).xyz, use_emissive_texture);
 
 	float ao = lerp(1.0f, 
-		material_ambient_occlusion.SampleLevel(s0, uv * data.ao_uv_scale, mip_level).x, use_ao_texture);
+		material_ambient_occlusion.SampleLevel(s0, uv * data.ao_uv_scale, GetResidentMipLevel(mip_level, resident_mips, 5)).x, use_ao_texture);
 
 	output.albedo = pow(albedo.xyz, 2.2f);
 	output.alpha = albedo.w;
@@ -0,0 +1,357 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "animation_system.hpp"
+
+#include <cmath>
+
+#include "settings.hpp"
+
+namespace wr
+{
+
+	namespace
+	{
+		//! Index of the last key at or before time, or the first key when time is before every key.
+		inline std::size_t FindKey(std::vector<float> const & times, float time)
+		{
+			auto it = std::upper_bound(times.begin(), times.end(), time);
+			return it == times.begin() ? 0 : static_cast<std::size_t>(it - times.begin()) - 1;
+		}
+
+		//! Interpolation weight between key and the one after it, the first and last key are held outside of the keys.
+		inline float KeyWeight(std::vector<float> const & times, std::size_t key, float time)
+		{
+			if (key + 1 >= times.size() || time <= times[key])
+			{
+				return 0.f;
+			}
+
+			float const span = times[key + 1] - times[key];
+			return span > 0.f ? std::min((time - times[key]) / span, 1.f) : 0.f;
+		}
+
+		inline DirectX::XMVECTOR SampleVectorKeys(std::vector<float> const & times, std::vector<DirectX::XMFLOAT3> const & values, float time)
+		{
+			std::size_t const key = FindKey(times, time);
+			float const weight = KeyWeight(times, key, time);
+
+			DirectX::XMVECTOR const value = DirectX::XMLoadFloat3(&values[key]);
+			return weight > 0.f ? DirectX::XMVectorLerp(value, DirectX::XMLoadFloat3(&values[key + 1]), weight) : value;
+		}
+
+		inline DirectX::XMVECTOR SampleRotationKeys(std::vector<float> const & times, std::vector<DirectX::XMFLOAT4> const & values, float time)
+		{
+			std::size_t const key = FindKey(times, time);
+			float const weight = KeyWeight(times, key, time);
+
+			DirectX::XMVECTOR const value = DirectX::XMLoadFloat4(&values[key]);
+			return weight > 0.f ? DirectX::XMQuaternionSlerp(value, DirectX::XMLoadFloat4(&values[key + 1]), weight) : value;
+		}
+
+		//! Moves the playback time of an animation forward, looping or holding the last frame at the end.
+		inline float AdvanceTime(float time, float delta, float duration, bool loop)
+		{
+			time += delta;
+
+			if (duration <= 0.f)
+			{
+				return 0.f;
+			}
+
+			if (loop)
+			{
+				time = std::fmod(time, duration);
+				return time < 0.f ? time + duration : time;
+			}
+
+			return std::clamp(time, 0.f, duration);
+		}
+	}
+
+	void AnimatedModel::Play(int animation, bool loop)
+	{
+		m_animation = animation;
+		m_time = 0.f;
+		m_loop = loop;
+		m_previous_animation = -1;
+		m_fade_duration = 0.f;
+	}
+
+	void AnimatedModel::CrossFade(int animation, float duration, bool loop)
+	{
+		if (duration <= 0.f)
+		{
+			Play(animation, loop);
+			return;
+		}
+
+		m_previous_animation = m_animation;
+		m_previous_time = m_time;
+		m_previous_loop = m_loop;
+		m_fade_time = 0.f;
+		m_fade_duration = duration;
+
+		m_animation = animation;
+		m_time = 0.f;
+		m_loop = loop;
+	}
+
+	void GetBindPose(std::vector<ModelBoneData> const & bones, SkeletonPose& out_pose)
+	{
+		out_pose.resize(bones.size());
+
+		for (std::size_t i = 0; i < bones.size(); ++i)
+		{
+			out_pose[i].m_translation = bones[i].m_translation;
+			out_pose[i].m_rotation = bones[i].m_rotation;
+			out_pose[i].m_scale = bones[i].m_scale;
+		}
+	}
+
+	void SampleAnimation(ModelAnimationData const & animation, float time, SkeletonPose& out_pose)
+	{
+		for (ModelAnimationChannelData const & channel : animation.m_channels)
+		{
+			if (channel.m_bone < 0 || static_cast<std::size_t>(channel.m_bone) >= out_pose.size())
+			{
+				continue;
+			}
+
+			BoneTransform& transform = out_pose[channel.m_bone];
+
+			if (!channel.m_positions.empty() && channel.m_positions.size() == channel.m_position_times.size())
+			{
+				DirectX::XMStoreFloat3(&transform.m_translation, SampleVectorKeys(channel.m_position_times, channel.m_positions, time));
+			}
+
+			if (!channel.m_rotations.empty() && channel.m_rotations.size() == channel.m_rotation_times.size())
+			{
+				DirectX::XMStoreFloat4(&transform.m_rotation, SampleRotationKeys(channel.m_rotation_times, channel.m_rotations, time));
+			}
+
+			if (!channel.m_scales.empty() && channel.m_scales.size() == channel.m_scale_times.size())
+			{
+				DirectX::XMStoreFloat3(&transform.m_scale, SampleVectorKeys(channel.m_scale_times, channel.m_scales, time));
+			}
+		}
+	}
+
+	void BlendPoses(SkeletonPose const & from, SkeletonPose const & to, float weight, SkeletonPose& out_pose)
+	{
+		std::size_t const num_bones = std::min(from.size(), to.size());
+		out_pose.resize(num_bones);
+
+		for (std::size_t i = 0; i < num_bones; ++i)
+		{
+			DirectX::XMStoreFloat3(&out_pose[i].m_translation, DirectX::XMVectorLerp(DirectX::XMLoadFloat3(&from[i].m_translation), DirectX::XMLoadFloat3(&to[i].m_translation), weight));
+			DirectX::XMStoreFloat4(&out_pose[i].m_rotation, DirectX::XMQuaternionSlerp(DirectX::XMLoadFloat4(&from[i].m_rotation), DirectX::XMLoadFloat4(&to[i].m_rotation), weight));
+			DirectX::XMStoreFloat3(&out_pose[i].m_scale, DirectX::XMVectorLerp(DirectX::XMLoadFloat3(&from[i].m_scale), DirectX::XMLoadFloat3(&to[i].m_scale), weight));
+		}
+	}
+
+	void ComputeSkinningMatrices(std::vector<ModelBoneData> const & bones, DirectX::XMFLOAT4X4 const & inverse_root_transform, SkeletonPose const & pose, std::vector<DirectX::XMFLOAT4X4A>& out_matrices)
+	{
+		std::size_t const num_bones = std::min(bones.size(), pose.size());
+		out_matrices.resize(num_bones);
+
+		// First the model space transform of every bone, parents come first so theirs is always done
+		for (std::size_t i = 0; i < num_bones; ++i)
+		{
+			DirectX::XMMATRIX global = DirectX::XMMatrixAffineTransformation(
+				DirectX::XMLoadFloat3(&pose[i].m_scale),
+				DirectX::g_XMZero,
+				DirectX::XMLoadFloat4(&pose[i].m_rotation),
+				DirectX::XMLoadFloat3(&pose[i].m_translation));
+
+			int const parent = bones[i].m_parent;
+			if (parent >= 0 && static_cast<std::size_t>(parent) < i)
+			{
+				global = DirectX::XMMatrixMultiply(global, DirectX::XMLoadFloat4x4A(&out_matrices[parent]));
+			}
+
+			DirectX::XMStoreFloat4x4A(&out_matrices[i], global);
+		}
+
+		DirectX::XMMATRIX const inverse_root = DirectX::XMLoadFloat4x4(&inverse_root_transform);
+
+		for (std::size_t i = 0; i < num_bones; ++i)
+		{
+			DirectX::XMMATRIX const offset = DirectX::XMLoadFloat4x4(&bones[i].m_offset);
+			DirectX::XMMATRIX const global = DirectX::XMLoadFloat4x4A(&out_matrices[i]);
+			DirectX::XMStoreFloat4x4A(&out_matrices[i], DirectX::XMMatrixMultiply(DirectX::XMMatrixMultiply(offset, global), inverse_root));
+		}
+	}
+
+	AnimationSystem::AnimationSystem() :
+		m_thread_pool(std::make_unique<util::ThreadPool>(settings::num_animation_threads))
+	{
+	}
+
+	AnimationSystem::~AnimationSystem()
+	{
+		// The models belong to their pools, which may already be gone
+		for (AnimatedModel* instance : m_instances)
+		{
+			delete instance;
+		}
+	}
+
+	void AnimationSystem::DestroyInstance(AnimatedModel* instance)
+	{
+		auto it = std::find(m_instances.begin(), m_instances.end(), instance);
+		if (it == m_instances.end())
+		{
+			return;
+		}
+
+		m_instances.erase(it);
+
+		instance->m_model->m_model_pool->Destroy(instance->m_model);
+		delete instance;
+	}
+
+	void AnimationSystem::UpdatePose(AnimatedModel& instance, float delta)
+	{
+		SkinnedModelData const & data = *instance.m_data;
+		int const num_animations = static_cast<int>(data.m_animations.size());
+
+		GetBindPose(data.m_bones, instance.m_pose);
+
+		if (instance.m_animation >= 0 && instance.m_animation < num_animations)
+		{
+			ModelAnimationData const & animation = data.m_animations[instance.m_animation];
+			instance.m_time = AdvanceTime(instance.m_time, delta * instance.m_speed, animation.m_duration, instance.m_loop);
+			SampleAnimation(animation, instance.m_time, instance.m_pose);
+		}
+
+		if (instance.m_fade_duration > 0.f)
+		{
+			instance.m_fade_time += delta;
+
+			if (instance.m_fade_time >= instance.m_fade_duration)
+			{
+				instance.m_previous_animation = -1;
+				instance.m_fade_duration = 0.f;
+			}
+			else
+			{
+				GetBindPose(data.m_bones, instance.m_previous_pose);
+
+				if (instance.m_previous_animation >= 0 && instance.m_previous_animation < num_animations)
+				{
+					ModelAnimationData const & previous = data.m_animations[instance.m_previous_animation];
+					instance.m_previous_time = AdvanceTime(instance.m_previous_time, delta * instance.m_speed, previous.m_duration, instance.m_previous_loop);
+					SampleAnimation(previous, instance.m_previous_time, instance.m_previous_pose);
+				}
+
+				BlendPoses(instance.m_previous_pose, instance.m_pose, instance.m_fade_time / instance.m_fade_duration, instance.m_pose);
+			}
+		}
+
+		ComputeSkinningMatrices(data.m_bones, data.m_inverse_root_transform, instance.m_pose, instance.m_skinning_matrices);
+	}
+
+	void AnimationSystem::Update(float delta)
+	{
+		if (m_instances.empty())
+		{
+			return;
+		}
+
+		std::vector<std::future<void>> work;
+
+		// Sampling and blending is cheap per instance, so the instances are split evenly over the threads
+		std::size_t const num_pose_jobs = std::min<std::size_t>(m_instances.size(), std::max(settings::num_animation_threads, 1u));
+		for (std::size_t j = 0; j < num_pose_jobs; ++j)
+		{
+			std::size_t const first = m_instances.size() * j / num_pose_jobs;
+			std::size_t const last = m_instances.size() * (j + 1) / num_pose_jobs;
+
+			work.push_back(m_thread_pool->Enqueue([this, first, last, delta]
+			{
+				for (std::size_t i = first; i < last; ++i)
+				{
+					UpdatePose(*m_instances[i], delta);
+				}
+			}));
+		}
+
+		for (auto& w : work)
+		{
+			w.get();
+		}
+		work.clear();
+
+		// Skinning is the expensive part, large meshes are split so crowds and single big characters both use every thread
+		for (AnimatedModel* instance : m_instances)
+		{
+			SkinnedModelData const & data = *instance->m_data;
+
+			std::size_t num_ranges = 0;
+			for (SkinnedModelData::SkinnedMesh const & mesh : data.m_meshes)
+			{
+				num_ranges += (mesh.m_num_vertices + settings::skinning_vertices_per_job - 1) / settings::skinning_vertices_per_job;
+			}
+
+			instance->m_range_bounds.assign(num_ranges, Box());
+
+			std::size_t range = 0;
+			for (std::size_t m = 0; m < data.m_meshes.size(); ++m)
+			{
+				SkinnedModelData::SkinnedMesh const & mesh = data.m_meshes[m];
+
+				for (std::size_t first = 0; first < mesh.m_num_vertices; first += settings::skinning_vertices_per_job, ++range)
+				{
+					std::size_t const last = std::min(first + settings::skinning_vertices_per_job, mesh.m_num_vertices);
+
+					work.push_back(m_thread_pool->Enqueue([instance, &data, &mesh, m, first, last, range]
+					{
+						data.m_skin_vertices(mesh.m_bind_vertices.data(), mesh.m_bone_ids.data(), mesh.m_bone_weights.data(), first, last,
+							instance->m_skinning_matrices.data(), instance->m_skinning_matrices.size(), instance->m_skinned_vertices[m].data(), instance->m_range_bounds[range]);
+					}));
+				}
+			}
+		}
+
+		for (auto& w : work)
+		{
+			w.get();
+		}
+
+		// The model pools aren't thread safe
+		for (AnimatedModel* instance : m_instances)
+		{
+			SkinnedModelData const & data = *instance->m_data;
+			Model* model = instance->m_model;
+
+			for (std::size_t m = 0; m < data.m_meshes.size() && m < model->m_meshes.size(); ++m)
+			{
+				model->m_model_pool->UpdateVertices(model->m_meshes[m].first, instance->m_skinned_vertices[m].data(), data.m_meshes[m].m_num_vertices, data.m_vertex_stride);
+			}
+
+			Box bounds;
+			for (Box const & range_bounds : instance->m_range_bounds)
+			{
+				bounds.ExpandFromVector(range_bounds.GetMin());
+				bounds.ExpandFromVector(range_bounds.GetMax());
+			}
+
+			model->m_box = bounds;
+			model->m_version++;
+		}
+	}
+
+} /* wr */
@@ -0,0 +1,344 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <DirectXMath.h>
+
+#include "model_loader.hpp"
+#include "model_pool.hpp"
+#include "vertex_layout.hpp"
+#include "util/aabb.hpp"
+#include "util/log.hpp"
+#include "util/thread_pool.hpp"
+
+namespace wr
+{
+
+	//! Transform of a bone relative to its parent.
+	struct BoneTransform
+	{
+		DirectX::XMFLOAT3 m_translation = { 0.f, 0.f, 0.f };
+		DirectX::XMFLOAT4 m_rotation = { 0.f, 0.f, 0.f, 1.f };
+		DirectX::XMFLOAT3 m_scale = { 1.f, 1.f, 1.f };
+	};
+
+	//! One BoneTransform per bone of the skeleton.
+	using SkeletonPose = std::vector<BoneTransform>;
+
+	//! The skeleton, animations and bind pose meshes of a skinned model, shared by all of its AnimatedModel instances.
+	struct SkinnedModelData
+	{
+		struct SkinnedMesh
+		{
+			std::vector<std::uint8_t> m_bind_vertices; // Packed as the vertex type the data was created for
+			std::vector<std::uint32_t> m_indices;
+			std::vector<DirectX::XMFLOAT4> m_bone_ids;
+			std::vector<DirectX::XMFLOAT4> m_bone_weights;
+			std::size_t m_num_vertices = 0;
+			int m_material_id = 0;
+		};
+
+		std::vector<SkinnedMesh> m_meshes;
+		std::vector<ModelBoneData> m_bones;
+		std::vector<ModelAnimationData> m_animations;
+		DirectX::XMFLOAT4X4 m_inverse_root_transform;
+		std::size_t m_vertex_stride = 0;
+
+		//! SkinVertices for the vertex type the data was created for.
+		void (*m_skin_vertices)(void const * bind_vertices, DirectX::XMFLOAT4 const * bone_ids, DirectX::XMFLOAT4 const * bone_weights,
+			std::size_t first, std::size_t last, DirectX::XMFLOAT4X4A const * matrices, std::size_t num_matrices, void* out_vertices, Box& bounds) = nullptr;
+	};
+
+	//! An instance of a skinned model with its own meshes in the model pool, see AnimationSystem.
+	struct AnimatedModel
+	{
+		Model* m_model = nullptr; // Use it for a mesh node, its vertices are replaced by every AnimationSystem::Update
+		std::shared_ptr<SkinnedModelData const> m_data;
+
+		int m_animation = -1; // -1 shows the bind pose
+		float m_time = 0.f; // In seconds
+		float m_speed = 1.f;
+		bool m_loop = true;
+
+		// The animation CrossFade blends out, it keeps playing until it's gone
+		int m_previous_animation = -1;
+		float m_previous_time = 0.f;
+		bool m_previous_loop = true;
+		float m_fade_time = 0.f;
+		float m_fade_duration = 0.f;
+
+		void Play(int animation, bool loop = true);
+		//! Blends from the current animation to another one over duration seconds.
+		void CrossFade(int animation, float duration, bool loop = true);
+
+		// Results of the last update, kept around to avoid allocating every frame
+		SkeletonPose m_pose;
+		SkeletonPose m_previous_pose;
+		std::vector<DirectX::XMFLOAT4X4A> m_skinning_matrices;
+		std::vector<std::vector<std::uint8_t>> m_skinned_vertices;
+		std::vector<Box> m_range_bounds;
+	};
+
+	//! The bind pose of every bone.
+	void GetBindPose(std::vector<ModelBoneData> const & bones, SkeletonPose& out_pose);
+	//! Samples the animation at time seconds. Bones without a channel keep the transform they have in out_pose.
+	void SampleAnimation(ModelAnimationData const & animation, float time, SkeletonPose& out_pose);
+	//! Interpolates every bone from one pose to another, weight 0 is from and 1 is to.
+	void BlendPoses(SkeletonPose const & from, SkeletonPose const & to, float weight, SkeletonPose& out_pose);
+	//! Concatenates the pose down the hierarchy into the matrices that take bind pose vertices to the animated pose.
+	void ComputeSkinningMatrices(std::vector<ModelBoneData> const & bones, DirectX::XMFLOAT4X4 const & inverse_root_transform, SkeletonPose const & pose, std::vector<DirectX::XMFLOAT4X4A>& out_matrices);
+
+	//! Linear blend skinning of vertices [first, last), and expands bounds with the skinned positions.
+	/*!
+		The four bone matrices of a vertex are weighted and summed row by row in SIMD registers, then the position,
+		normal, tangent and bitangent are transformed by the sum. Vertices without weights keep their bind pose.
+	*/
+	template<typename TV>
+	void SkinVertices(TV const * bind_vertices, DirectX::XMFLOAT4 const * bone_ids, DirectX::XMFLOAT4 const * bone_weights,
+		std::size_t first, std::size_t last, DirectX::XMFLOAT4X4A const * matrices, std::size_t num_matrices, TV* out_vertices, Box& bounds)
+	{
+		using Layout = VertexLayout<TV>;
+		static_assert(Layout::has_position, "Skinning needs vertex positions.");
+
+		DirectX::XMVECTOR min = DirectX::XMVectorReplicate(std::numeric_limits<float>::max());
+		DirectX::XMVECTOR max = DirectX::XMVectorReplicate(-std::numeric_limits<float>::max());
+
+		for (std::size_t v = first; v < last; ++v)
+		{
+			TV vertex = bind_vertices[v];
+
+			float const * weights = &bone_weights[v].x;
+			float const * ids = &bone_ids[v].x;
+
+			DirectX::XMMATRIX skin = { DirectX::g_XMZero, DirectX::g_XMZero, DirectX::g_XMZero, DirectX::g_XMZero };
+			float total_weight = 0.f;
+
+			for (int j = 0; j < 4; ++j)
+			{
+				if (weights[j] <= 0.f || num_matrices == 0)
+				{
+					continue;
+				}
+
+				std::size_t const bone = std::min(static_cast<std::size_t>(ids[j]), num_matrices - 1);
+				DirectX::XMMATRIX const bone_matrix = DirectX::XMLoadFloat4x4A(&matrices[bone]);
+				DirectX::XMVECTOR const weight = DirectX::XMVectorReplicate(weights[j]);
+
+				skin.r[0] = DirectX::XMVectorMultiplyAdd(bone_matrix.r[0], weight, skin.r[0]);
+				skin.r[1] = DirectX::XMVectorMultiplyAdd(bone_matrix.r[1], weight, skin.r[1]);
+				skin.r[2] = DirectX::XMVectorMultiplyAdd(bone_matrix.r[2], weight, skin.r[2]);
+				skin.r[3] = DirectX::XMVectorMultiplyAdd(bone_matrix.r[3], weight, skin.r[3]);
+
+				total_weight += weights[j];
+			}
+
+			if (total_weight > 0.f)
+			{
+				auto transform_direction = [&skin](float (&direction)[3])
+				{
+					DirectX::XMFLOAT3* stored = reinterpret_cast<DirectX::XMFLOAT3*>(direction);
+					DirectX::XMStoreFloat3(stored, DirectX::XMVector3Normalize(DirectX::XMVector3TransformNormal(DirectX::XMLoadFloat3(stored), skin)));
+				};
+
+				DirectX::XMFLOAT3* pos = reinterpret_cast<DirectX::XMFLOAT3*>(vertex.m_pos);
+				DirectX::XMStoreFloat3(pos, DirectX::XMVector3Transform(DirectX::XMLoadFloat3(pos), skin));
+
+				if constexpr (Layout::has_normal)
+				{
+					transform_direction(vertex.m_normal);
+				}
+				if constexpr (Layout::has_tangent)
+				{
+					transform_direction(vertex.m_tangent);
+				}
+				if constexpr (Layout::has_bitangent)
+				{
+					transform_direction(vertex.m_bitangent);
+				}
+			}
+
+			DirectX::XMVECTOR const position = DirectX::XMLoadFloat3(reinterpret_cast<DirectX::XMFLOAT3 const *>(vertex.m_pos));
+			min = DirectX::XMVectorMin(min, position);
+			max = DirectX::XMVectorMax(max, position);
+
+			out_vertices[v] = vertex;
+		}
+
+		if (last > first)
+		{
+			bounds.ExpandFromVector(min);
+			bounds.ExpandFromVector(max);
+		}
+	}
+
+	namespace internal
+	{
+		template<typename TV>
+		void SkinPackedVertices(void const * bind_vertices, DirectX::XMFLOAT4 const * bone_ids, DirectX::XMFLOAT4 const * bone_weights,
+			std::size_t first, std::size_t last, DirectX::XMFLOAT4X4A const * matrices, std::size_t num_matrices, void* out_vertices, Box& bounds)
+		{
+			SkinVertices(static_cast<TV const *>(bind_vertices), bone_ids, bone_weights, first, last, matrices, num_matrices, static_cast<TV*>(out_vertices), bounds);
+		}
+	}
+
+	//! Animates and skins AnimatedModels on the CPU.
+	/*!
+		Update samples and blends the animations of every instance, then skins the meshes in batches of
+		settings::skinning_vertices_per_job vertices, all on the system's own threads. The skinned vertices are written into
+		the model pools afterwards, which marks the meshes as changed so their BLASes get rebuilt for ray tracing.
+	*/
+	class AnimationSystem
+	{
+	public:
+		AnimationSystem();
+		~AnimationSystem();
+
+		AnimationSystem(AnimationSystem const &) = delete;
+		AnimationSystem& operator=(AnimationSystem const &) = delete;
+		AnimationSystem(AnimationSystem&&) = delete;
+		AnimationSystem& operator=(AnimationSystem&&) = delete;
+
+		//! Copies what skinning needs out of a loaded model, like the model data ModelPool::Load returns through out_model_data.
+		/*!
+			Create it once per model and share it between the instances.
+		*/
+		template<typename TV>
+		[[nodiscard]] static std::shared_ptr<SkinnedModelData> CreateSkinnedModelData(ModelData const & data);
+
+		//! Uploads a copy of the meshes in their bind pose. materials are indexed with the material ids of the meshes.
+		template<typename TV, typename TI = std::uint32_t>
+		[[nodiscard]] AnimatedModel* CreateInstance(ModelPool* pool, std::shared_ptr<SkinnedModelData const> data, std::vector<MaterialHandle> const & materials = {});
+		//! Destroys the instance and its model.
+		void DestroyInstance(AnimatedModel* instance);
+
+		//! Advances every instance by delta seconds and replaces the vertices of their models. Call it from the thread that loads models.
+		void Update(float delta);
+
+	private:
+		static void UpdatePose(AnimatedModel& instance, float delta);
+
+		std::unique_ptr<util::ThreadPool> m_thread_pool;
+		std::vector<AnimatedModel*> m_instances;
+	};
+
+	template<typename TV>
+	std::shared_ptr<SkinnedModelData> AnimationSystem::CreateSkinnedModelData(ModelData const & data)
+	{
+		IS_PROPER_VERTEX_CLASS(TV);
+
+		auto skinned = std::make_shared<SkinnedModelData>();
+		skinned->m_vertex_stride = sizeof(TV);
+		skinned->m_skin_vertices = &internal::SkinPackedVertices<TV>;
+
+		if (data.m_skeleton_data != nullptr)
+		{
+			for (ModelBoneData const * bone : data.m_skeleton_data->m_bones)
+			{
+				skinned->m_bones.push_back(*bone);
+			}
+
+			for (ModelAnimationData const * animation : data.m_skeleton_data->m_animations)
+			{
+				skinned->m_animations.push_back(*animation);
+			}
+
+			skinned->m_inverse_root_transform = data.m_skeleton_data->m_inverse_root_transform;
+		}
+		else
+		{
+			DirectX::XMStoreFloat4x4(&skinned->m_inverse_root_transform, DirectX::XMMatrixIdentity());
+		}
+
+		for (ModelMeshData const * mesh : data.m_meshes)
+		{
+			SkinnedModelData::SkinnedMesh& skinned_mesh = skinned->m_meshes.emplace_back();
+			skinned_mesh.m_num_vertices = mesh->m_positions.size();
+			skinned_mesh.m_indices = mesh->m_indices;
+			skinned_mesh.m_material_id = mesh->m_material_id;
+
+			// A mesh without weights is still part of the model, it just doesn't move
+			skinned_mesh.m_bone_ids = mesh->m_bone_ids;
+			skinned_mesh.m_bone_weights = mesh->m_bone_weights;
+			skinned_mesh.m_bone_ids.resize(skinned_mesh.m_num_vertices, { 0.f, 0.f, 0.f, 0.f });
+			skinned_mesh.m_bone_weights.resize(skinned_mesh.m_num_vertices, { 0.f, 0.f, 0.f, 0.f });
+
+			Box bounds;
+			skinned_mesh.m_bind_vertices.resize(skinned_mesh.m_num_vertices * sizeof(TV));
+			PackVertices(*mesh, reinterpret_cast<TV*>(skinned_mesh.m_bind_vertices.data()), bounds);
+		}
+
+		return skinned;
+	}
+
+	template<typename TV, typename TI>
+	AnimatedModel* AnimationSystem::CreateInstance(ModelPool* pool, std::shared_ptr<SkinnedModelData const> data, std::vector<MaterialHandle> const & materials)
+	{
+		if (data == nullptr || data->m_vertex_stride != sizeof(TV))
+		{
+			LOGW("Skinned model data was created for a different vertex type.");
+			return nullptr;
+		}
+
+		std::vector<MeshData<TV, TI>> meshes(data->m_meshes.size());
+		for (std::size_t i = 0; i < data->m_meshes.size(); ++i)
+		{
+			SkinnedModelData::SkinnedMesh const & skinned_mesh = data->m_meshes[i];
+
+			meshes[i].m_vertices.resize(skinned_mesh.m_num_vertices);
+			std::memcpy(meshes[i].m_vertices.data(), skinned_mesh.m_bind_vertices.data(), skinned_mesh.m_bind_vertices.size());
+
+			if (!skinned_mesh.m_indices.empty())
+			{
+				meshes[i].m_indices = std::vector<TI>(skinned_mesh.m_indices.begin(), skinned_mesh.m_indices.end());
+			}
+		}
+
+		Model* model = pool->LoadDynamic<TV, TI>(meshes);
+		if (model == nullptr)
+		{
+			return nullptr;
+		}
+
+		for (std::size_t i = 0; i < model->m_meshes.size(); ++i)
+		{
+			int const material_id = data->m_meshes[i].m_material_id;
+			if (material_id >= 0 && static_cast<std::size_t>(material_id) < materials.size())
+			{
+				model->m_meshes[i].second = materials[material_id];
+			}
+		}
+
+		auto instance = new AnimatedModel();
+		instance->m_model = model;
+		instance->m_data = std::move(data);
+
+		for (SkinnedModelData::SkinnedMesh const & skinned_mesh : instance->m_data->m_meshes)
+		{
+			instance->m_skinned_vertices.push_back(skinned_mesh.m_bind_vertices);
+		}
+
+		m_instances.push_back(instance);
+
+		return instance;
+	}
+
+} /* wr */
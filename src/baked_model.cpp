@@ -0,0 +1,534 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "baked_model.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "model_pool.hpp"
+#include "settings.hpp"
+#include "util/content_hash.hpp"
+#include "util/log.hpp"
+#include "util/memory_mapped_file.hpp"
+
+namespace wr::internal
+{
+
+	namespace
+	{
+		// Bump when the layout below or the mesh processing changes in a way the settings don't capture
+		constexpr std::uint32_t baked_model_version = 3;
+		constexpr char baked_model_magic[4] = { 'W', 'B', 'M', 'D' };
+
+		// Blobs start at a multiple of this, so the mapped vertex data is as aligned as a freshly allocated buffer
+		constexpr std::size_t blob_alignment = 16;
+
+		// The fewest bytes a mesh, material and embedded texture take up in the file, counts that can't fit in what's left are corrupt
+		constexpr std::size_t min_mesh_size = 3 * sizeof(std::uint64_t) + sizeof(std::int32_t) + 2 * sizeof(float) + 3 * sizeof(std::uint64_t) + sizeof(std::uint32_t);
+		constexpr std::size_t min_texture_slot_size = sizeof(std::uint32_t) + sizeof(std::uint64_t) + sizeof(std::uint32_t);
+		constexpr std::size_t min_material_size = 6 * min_texture_slot_size;
+		constexpr std::size_t min_embedded_texture_size = 2 * sizeof(std::uint32_t) + sizeof(std::uint8_t) + sizeof(std::uint32_t) + sizeof(std::uint64_t);
+
+		class BakedWriter
+		{
+		public:
+			explicit BakedWriter(std::ofstream& stream) : m_stream(stream)
+			{
+			}
+
+			template<typename T>
+			void Write(T const & value)
+			{
+				static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written directly.");
+				WriteBytes(&value, sizeof(T));
+			}
+
+			void WriteString(std::string const & str)
+			{
+				Write(static_cast<std::uint32_t>(str.size()));
+				WriteBytes(str.data(), str.size());
+			}
+
+			void WriteBlob(void const * data, std::size_t size)
+			{
+				Write(static_cast<std::uint64_t>(size));
+
+				char const padding[blob_alignment] = {};
+				WriteBytes(padding, (blob_alignment - m_offset % blob_alignment) % blob_alignment);
+				WriteBytes(data, size);
+			}
+
+		private:
+			void WriteBytes(void const * data, std::size_t size)
+			{
+				m_stream.write(static_cast<char const *>(data), static_cast<std::streamsize>(size));
+				m_offset += size;
+			}
+
+			std::ofstream& m_stream;
+			std::size_t m_offset = 0;
+		};
+
+		//! Reads from the mapped file, every read is bounds checked so a truncated or corrupt file only fails the load.
+		class BakedReader
+		{
+		public:
+			BakedReader(unsigned char const * data, std::size_t size) : m_data(data), m_size(size)
+			{
+			}
+
+			template<typename T>
+			bool Read(T& out)
+			{
+				unsigned char const * bytes = ReadBytes(sizeof(T));
+				if (bytes == nullptr)
+				{
+					return false;
+				}
+
+				std::memcpy(&out, bytes, sizeof(T));
+				return true;
+			}
+
+			bool ReadString(std::string& out)
+			{
+				std::uint32_t size = 0;
+				unsigned char const * bytes = Read(size) ? ReadBytes(size) : nullptr;
+				if (bytes == nullptr)
+				{
+					return false;
+				}
+
+				out.assign(reinterpret_cast<char const *>(bytes), size);
+				return true;
+			}
+
+			//! Returns a pointer into the file, nullptr on failure. Empty blobs return the current position.
+			unsigned char const * ReadBlob(std::size_t& out_size)
+			{
+				std::uint64_t size = 0;
+				if (!Read(size))
+				{
+					return nullptr;
+				}
+
+				if (ReadBytes((blob_alignment - m_offset % blob_alignment) % blob_alignment) == nullptr)
+				{
+					return nullptr;
+				}
+
+				out_size = static_cast<std::size_t>(size);
+				return ReadBytes(out_size);
+			}
+
+			//! Whether count elements of at least element_size bytes each fit in the rest of the file.
+			bool CanHold(std::uint64_t count, std::size_t element_size) const
+			{
+				return count <= (m_size - m_offset) / element_size;
+			}
+
+		private:
+			unsigned char const * ReadBytes(std::size_t size)
+			{
+				if (size > m_size - m_offset)
+				{
+					return nullptr;
+				}
+
+				unsigned char const * bytes = m_data + m_offset;
+				m_offset += size;
+				return bytes;
+			}
+
+			unsigned char const * m_data;
+			std::size_t m_size;
+			std::size_t m_offset = 0;
+		};
+
+		void WriteMesh(BakedWriter& writer, ConvertedMeshData const & mesh, std::size_t vertex_stride)
+		{
+			writer.Write(static_cast<std::uint64_t>(mesh.m_num_vertices));
+			writer.Write(static_cast<std::uint64_t>(mesh.m_num_indices));
+			writer.Write(static_cast<std::uint64_t>(mesh.m_index_stride));
+			writer.Write(static_cast<std::int32_t>(mesh.m_material_id));
+			writer.Write(mesh.m_error);
+			writer.Write(mesh.m_uv_density);
+
+			writer.WriteBlob(mesh.VertexData(), mesh.m_num_vertices * vertex_stride);
+			writer.WriteBlob(mesh.IndexData(), mesh.m_num_indices * mesh.m_index_stride);
+			writer.WriteBlob(mesh.m_meshlets.data(), mesh.m_meshlets.size() * sizeof(util::Meshlet));
+
+			writer.Write(static_cast<std::uint32_t>(mesh.m_lods.size()));
+			for (ConvertedMeshData const & lod : mesh.m_lods)
+			{
+				WriteMesh(writer, lod, vertex_stride);
+			}
+		}
+
+		//! LODs are only one level deep, a LOD that has LODs itself is corrupt and would otherwise recurse as deep as the file allows.
+		bool ReadMesh(BakedReader& reader, ConvertedMeshData& mesh, std::size_t vertex_stride, bool is_lod)
+		{
+			std::uint64_t num_vertices = 0;
+			std::uint64_t num_indices = 0;
+			std::uint64_t index_stride = 0;
+			std::int32_t material_id = 0;
+
+			if (!reader.Read(num_vertices) || !reader.Read(num_indices) || !reader.Read(index_stride) ||
+				!reader.Read(material_id) || !reader.Read(mesh.m_error) || !reader.Read(mesh.m_uv_density))
+			{
+				return false;
+			}
+
+			if ((index_stride != sizeof(std::uint16_t) && index_stride != sizeof(std::uint32_t)) ||
+				num_vertices > std::numeric_limits<std::size_t>::max() / vertex_stride ||
+				num_indices > std::numeric_limits<std::size_t>::max() / index_stride)
+			{
+				return false;
+			}
+
+			mesh.m_num_vertices = static_cast<std::size_t>(num_vertices);
+			mesh.m_num_indices = static_cast<std::size_t>(num_indices);
+			mesh.m_index_stride = static_cast<std::size_t>(index_stride);
+			mesh.m_material_id = material_id;
+
+			std::size_t vertex_bytes = 0;
+			std::size_t index_bytes = 0;
+			std::size_t meshlet_bytes = 0;
+
+			mesh.m_vertex_view = reader.ReadBlob(vertex_bytes);
+			mesh.m_index_view = reader.ReadBlob(index_bytes);
+			unsigned char const * meshlets = reader.ReadBlob(meshlet_bytes);
+
+			if (mesh.m_vertex_view == nullptr || mesh.m_index_view == nullptr || meshlets == nullptr ||
+				vertex_bytes != mesh.m_num_vertices * vertex_stride || index_bytes != mesh.m_num_indices * mesh.m_index_stride ||
+				meshlet_bytes % sizeof(util::Meshlet) != 0)
+			{
+				return false;
+			}
+
+			// The meshlets are small and end up in the pool anyway, so they're copied out
+			mesh.m_meshlets.resize(meshlet_bytes / sizeof(util::Meshlet));
+			std::memcpy(mesh.m_meshlets.data(), meshlets, meshlet_bytes);
+
+			std::uint32_t num_lods = 0;
+			if (!reader.Read(num_lods) || num_lods > (is_lod ? 0 : settings::num_generated_lods) || !reader.CanHold(num_lods, min_mesh_size))
+			{
+				return false;
+			}
+
+			mesh.m_lods.resize(num_lods);
+			for (ConvertedMeshData& lod : mesh.m_lods)
+			{
+				if (!ReadMesh(reader, lod, vertex_stride, true))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		void WriteTextureSlot(BakedWriter& writer, std::string const & path, std::size_t embedded_texture, TextureLocation location)
+		{
+			writer.WriteString(location == TextureLocation::EXTERNAL ? path : std::string());
+			writer.Write(static_cast<std::uint64_t>(location == TextureLocation::EMBEDDED ? embedded_texture : 0));
+			writer.Write(static_cast<std::uint32_t>(location));
+		}
+
+		bool ReadTextureSlot(BakedReader& reader, std::string& path, std::size_t& embedded_texture, TextureLocation& location)
+		{
+			std::uint64_t embedded = 0;
+			std::uint32_t location_value = 0;
+
+			if (!reader.ReadString(path) || !reader.Read(embedded) || !reader.Read(location_value) ||
+				location_value > static_cast<std::uint32_t>(TextureLocation::NON_EXISTENT))
+			{
+				return false;
+			}
+
+			embedded_texture = static_cast<std::size_t>(embedded);
+			location = static_cast<TextureLocation>(location_value);
+			return true;
+		}
+
+		void WriteMaterial(BakedWriter& writer, ModelMaterialData const & material)
+		{
+			WriteTextureSlot(writer, material.m_albedo_texture, material.m_albedo_embedded_texture, material.m_albedo_texture_location);
+			WriteTextureSlot(writer, material.m_metallic_texture, material.m_metallic_embedded_texture, material.m_metallic_texture_location);
+			WriteTextureSlot(writer, material.m_roughness_texture, material.m_roughness_embedded_texture, material.m_roughness_texture_location);
+			WriteTextureSlot(writer, material.m_ambient_occlusion_texture, material.m_ambient_occlusion_embedded_texture, material.m_ambient_occlusion_texture_location);
+			WriteTextureSlot(writer, material.m_normal_map_texture, material.m_normal_map_embedded_texture, material.m_normal_map_texture_location);
+			WriteTextureSlot(writer, material.m_emissive_texture, material.m_emissive_embedded_texture, material.m_emissive_texture_location);
+
+			writer.Write(material.m_base_color);
+			writer.Write(material.m_base_metallic);
+			writer.Write(material.m_base_roughness);
+			writer.Write(material.m_base_transparency);
+			writer.Write(material.m_base_emissive);
+			writer.Write(static_cast<std::uint8_t>(material.m_two_sided));
+		}
+
+		bool ReadMaterial(BakedReader& reader, ModelMaterialData& material)
+		{
+			std::uint8_t two_sided = 0;
+
+			bool const valid =
+				ReadTextureSlot(reader, material.m_albedo_texture, material.m_albedo_embedded_texture, material.m_albedo_texture_location) &&
+				ReadTextureSlot(reader, material.m_metallic_texture, material.m_metallic_embedded_texture, material.m_metallic_texture_location) &&
+				ReadTextureSlot(reader, material.m_roughness_texture, material.m_roughness_embedded_texture, material.m_roughness_texture_location) &&
+				ReadTextureSlot(reader, material.m_ambient_occlusion_texture, material.m_ambient_occlusion_embedded_texture, material.m_ambient_occlusion_texture_location) &&
+				ReadTextureSlot(reader, material.m_normal_map_texture, material.m_normal_map_embedded_texture, material.m_normal_map_texture_location) &&
+				ReadTextureSlot(reader, material.m_emissive_texture, material.m_emissive_embedded_texture, material.m_emissive_texture_location) &&
+				reader.Read(material.m_base_color) &&
+				reader.Read(material.m_base_metallic) &&
+				reader.Read(material.m_base_roughness) &&
+				reader.Read(material.m_base_transparency) &&
+				reader.Read(material.m_base_emissive) &&
+				reader.Read(two_sided);
+
+			material.m_two_sided = two_sided != 0;
+			return valid;
+		}
+	}
+
+	std::string GetBakedModelPath(std::string_view source_path, BakedModelKey const & key)
+	{
+		util::MemoryMappedFile source(source_path);
+		if (!source.IsOpen())
+		{
+			return {};
+		}
+
+		std::uint64_t hash = util::HashBytes(source.Data(), source.Size(), baked_model_version);
+		hash = util::HashBytes(key.m_vertex_type.data(), key.m_vertex_type.size(), hash);
+
+		std::uint64_t const layout[] = { key.m_vertex_size, key.m_index_size, key.m_flip_normals };
+		hash = util::HashBytes(layout, sizeof(layout), hash);
+
+		// The settings that change the output of ModelPool::ProcessMesh and the index conversion
+		float const processing[] = {
+			static_cast<float>(settings::optimize_meshes),
+			settings::mesh_overdraw_threshold,
+			static_cast<float>(settings::automatic_16bit_indices),
+			static_cast<float>(settings::generate_meshlets),
+			static_cast<float>(settings::meshlet_min_triangles),
+			static_cast<float>(settings::meshlet_max_vertices),
+			static_cast<float>(settings::meshlet_max_triangles),
+			static_cast<float>(settings::num_generated_lods),
+			static_cast<float>(settings::lod_min_triangles),
+			settings::lod_triangle_ratio,
+			settings::lod_max_error,
+			static_cast<float>(settings::use_texture_streaming),
+		};
+		hash = util::HashBytes(processing, sizeof(processing), hash);
+
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx.wbm", static_cast<unsigned long long>(hash));
+
+		return std::string(settings::baked_model_cache_directory) + name;
+	}
+
+	bool WriteBakedModel(std::string const & path, ConvertedModelData const & model)
+	{
+		// The skeleton and animations aren't part of the format, skinned and animated models are always loaded from the source
+		ModelSkeletonData const * skeleton = model.m_data->m_skeleton_data;
+		if (skeleton != nullptr && (!skeleton->m_bones.empty() || !skeleton->m_animations.empty()))
+		{
+			return false;
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+		// Written next to the final file and renamed when complete, so a crash never leaves a truncated bake behind.
+		// The name is unique, two threads or processes baking the same model never write into the same file.
+		char suffix[32];
+		std::snprintf(suffix, sizeof(suffix), ".%08x%08x.tmp", std::random_device()(), std::random_device()());
+		std::string const temp_path = path + suffix;
+
+		{
+			std::ofstream stream(temp_path, std::ios::binary | std::ios::trunc);
+			if (!stream)
+			{
+				LOGW("Couldn't write baked model {}", path);
+				return false;
+			}
+
+			BakedWriter writer(stream);
+
+			writer.Write(baked_model_magic);
+			writer.Write(baked_model_version);
+			writer.Write(static_cast<std::uint64_t>(model.m_vertex_stride));
+
+			DirectX::XMFLOAT4 center, extents;
+			DirectX::XMStoreFloat4(&center, model.m_box.m_center);
+			DirectX::XMStoreFloat4(&extents, model.m_box.m_extents);
+			writer.Write(center);
+			writer.Write(extents);
+
+			writer.Write(static_cast<std::uint32_t>(model.m_meshes.size()));
+			for (ConvertedMeshData const & mesh : model.m_meshes)
+			{
+				WriteMesh(writer, mesh, model.m_vertex_stride);
+			}
+
+			writer.Write(static_cast<std::uint32_t>(model.m_data->m_materials.size()));
+			for (ModelMaterialData const * material : model.m_data->m_materials)
+			{
+				WriteMaterial(writer, *material);
+			}
+
+			writer.Write(static_cast<std::uint32_t>(model.m_data->m_embedded_textures.size()));
+			for (EmbeddedTexture const * texture : model.m_data->m_embedded_textures)
+			{
+				writer.Write(texture->m_width);
+				writer.Write(texture->m_height);
+				writer.Write(static_cast<std::uint8_t>(texture->m_compressed));
+				writer.WriteString(texture->m_format);
+				writer.WriteBlob(texture->m_data.data(), texture->m_data.size());
+			}
+
+			if (!stream)
+			{
+				stream.close();
+				std::filesystem::remove(temp_path, error);
+				LOGW("Couldn't write baked model {}", path);
+				return false;
+			}
+		}
+
+		std::filesystem::rename(temp_path, path, error);
+		if (error)
+		{
+			std::filesystem::remove(temp_path, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	ConvertedModelData* ReadBakedModel(std::string const & path)
+	{
+		auto file = std::make_unique<util::MemoryMappedFile>();
+		if (!file->Open(path))
+		{
+			return nullptr;
+		}
+
+		BakedReader reader(file->Data(), file->Size());
+
+		char magic[4] = {};
+		std::uint32_t version = 0;
+		std::uint64_t vertex_stride = 0;
+		DirectX::XMFLOAT4 center, extents;
+		std::uint32_t num_meshes = 0;
+
+		if (!reader.Read(magic) || std::memcmp(magic, baked_model_magic, sizeof(magic)) != 0 ||
+			!reader.Read(version) || version != baked_model_version ||
+			!reader.Read(vertex_stride) || vertex_stride == 0 || !reader.Read(center) || !reader.Read(extents) ||
+			!reader.Read(num_meshes) || !reader.CanHold(num_meshes, min_mesh_size))
+		{
+			LOGW("Ignoring invalid baked model {}", path);
+			return nullptr;
+		}
+
+		auto model = std::make_unique<ConvertedModelData>();
+		model->m_vertex_stride = static_cast<std::size_t>(vertex_stride);
+		model->m_box.m_center = DirectX::XMLoadFloat4(&center);
+		model->m_box.m_extents = DirectX::XMLoadFloat4(&extents);
+
+		// Only models without a skeleton are baked, see WriteBakedModel
+		model->m_data = new ModelData();
+		model->m_data->m_skeleton_data = new ModelSkeletonData();
+
+		bool valid = true;
+
+		model->m_meshes.resize(num_meshes);
+		for (std::size_t i = 0; valid && i < model->m_meshes.size(); ++i)
+		{
+			valid = ReadMesh(reader, model->m_meshes[i], model->m_vertex_stride, false);
+		}
+
+		std::uint32_t num_materials = 0;
+		valid = valid && reader.Read(num_materials) && reader.CanHold(num_materials, min_material_size);
+		for (std::uint32_t i = 0; valid && i < num_materials; ++i)
+		{
+			ModelMaterialData* material = new ModelMaterialData();
+			model->m_data->m_materials.push_back(material);
+			valid = ReadMaterial(reader, *material);
+		}
+
+		std::uint32_t num_textures = 0;
+		valid = valid && reader.Read(num_textures) && reader.CanHold(num_textures, min_embedded_texture_size);
+		for (std::uint32_t i = 0; valid && i < num_textures; ++i)
+		{
+			EmbeddedTexture* texture = new EmbeddedTexture();
+			model->m_data->m_embedded_textures.push_back(texture);
+
+			std::uint8_t compressed = 0;
+			std::size_t size = 0;
+			unsigned char const * data = nullptr;
+
+			valid = reader.Read(texture->m_width) && reader.Read(texture->m_height) && reader.Read(compressed) &&
+				reader.ReadString(texture->m_format) && (data = reader.ReadBlob(size)) != nullptr;
+
+			if (valid)
+			{
+				texture->m_compressed = compressed != 0;
+				texture->m_data.assign(data, data + size);
+			}
+		}
+
+		if (!valid)
+		{
+			LOGW("Ignoring invalid baked model {}", path);
+			DeleteBakedModelData(model->m_data);
+			return nullptr;
+		}
+
+		model->m_baked_file = std::move(file);
+
+		return model.release();
+	}
+
+	void DeleteBakedModelData(ModelData* data)
+	{
+		if (data == nullptr)
+		{
+			return;
+		}
+
+		for (ModelMaterialData* material : data->m_materials)
+		{
+			delete material;
+		}
+
+		for (EmbeddedTexture* texture : data->m_embedded_textures)
+		{
+			delete texture;
+		}
+
+		delete data->m_skeleton_data;
+		delete data;
+	}
+
+} /* wr::internal */
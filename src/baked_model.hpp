@@ -0,0 +1,62 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace wr
+{
+	struct ModelData;
+
+	namespace internal
+	{
+		struct ConvertedModelData;
+
+		//! Everything besides the source file that changes what a model converts to.
+		struct BakedModelKey
+		{
+			std::string m_vertex_type;
+			std::size_t m_vertex_size = 0;
+			std::size_t m_index_size = 0;
+			bool m_flip_normals = false;
+		};
+
+		//! Path of the baked version of a model in settings::baked_model_cache_directory.
+		/*!
+			The name is a hash of the source file's content, the key, the baked format version and the settings that
+			change the mesh processing, so a stale bake is never picked up. Returns an empty string when the source can't be read.
+		*/
+		std::string GetBakedModelPath(std::string_view source_path, BakedModelKey const & key);
+
+		//! Writes the converted meshes with their meshlets and LODs, the bounds, the materials and the embedded textures.
+		/*!
+			Models with bones or animations aren't baked, the format has no skeleton. Returns false for those and when writing fails.
+		*/
+		bool WriteBakedModel(std::string const & path, ConvertedModelData const & model);
+
+		//! Maps a baked model, returns nullptr when there is none or it can't be read.
+		/*!
+			The vertices and indices aren't copied, the meshes point into the mapped file which the result keeps open.
+			m_data holds the materials and embedded textures and has to be freed with DeleteBakedModelData.
+		*/
+		ConvertedModelData* ReadBakedModel(std::string const & path);
+
+		void DeleteBakedModelData(ModelData* data);
+	}
+
+} /* wr */
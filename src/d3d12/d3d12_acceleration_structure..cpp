@@ -164,7 +164,7 @@ namespace wr::d3d12
 
 					D3D12_RAYTRACING_INSTANCE_DESC instance_desc = {};
 
-					XMStoreFloat3x4(reinterpret_cast<DirectX::XMFLOAT3X4*>(instance_desc.Transform), transform);
+					*reinterpret_cast<DirectX::XMFLOAT3X4*>(instance_desc.Transform) = transform;
 
 					instance_desc.InstanceMask = 1;
 					instance_desc.InstanceID = material;
@@ -195,7 +195,7 @@ namespace wr::d3d12
 
 					D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC instance_desc = {};
 
-					XMStoreFloat3x4(reinterpret_cast<DirectX::XMFLOAT3X4*>(instance_desc.Transform), transform);
+					*reinterpret_cast<DirectX::XMFLOAT3X4*>(instance_desc.Transform) = transform;
 
 					instance_desc.InstanceMask = 1;
 					instance_desc.InstanceID = material;
@@ -265,9 +265,9 @@ namespace wr::d3d12
 			geometry_descs[i].Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
 			if (auto index_buffer = geom.index_buffer.value_or(nullptr))
 			{
-				geometry_descs[i].Triangles.IndexBuffer = index_buffer->m_buffer->GetGPUVirtualAddress() + (geom.m_indices_offset * index_buffer->m_stride_in_bytes);
+				geometry_descs[i].Triangles.IndexBuffer = index_buffer->m_buffer->GetGPUVirtualAddress() + (geom.m_indices_offset * geom.m_index_stride);
 				geometry_descs[i].Triangles.IndexCount = geom.m_num_indices;
-				geometry_descs[i].Triangles.IndexFormat = DXGI_FORMAT_R32_UINT;
+				geometry_descs[i].Triangles.IndexFormat = geom.m_index_stride == sizeof(std::uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 				geometry_descs[i].Triangles.Transform3x4 = 0;
 			}
 			else
@@ -285,7 +285,7 @@ namespace wr::d3d12
 		cmd_list->m_native->IASetVertexBuffers(0, 1, &view);
 	}
 
-	void BindIndexBuffer(CommandList* cmd_list, StagingBuffer* buffer, std::uint32_t offset, std::uint32_t size)
+	void BindIndexBuffer(CommandList* cmd_list, StagingBuffer* buffer, std::uint32_t offset, std::uint32_t size, std::uint32_t stride)
 	{
 		if (!buffer->m_gpu_address)
 		{
@@ -294,7 +294,7 @@ namespace wr::d3d12
 
 		D3D12_INDEX_BUFFER_VIEW view;
 		view.BufferLocation = buffer->m_gpu_address + offset;
-		view.Format = DXGI_FORMAT_R32_UINT;
+		view.Format = stride == sizeof(std::uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 		view.SizeInBytes = size;
 
 		cmd_list->m_native->IASetIndexBuffer(&view);
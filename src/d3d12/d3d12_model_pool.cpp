@@ -29,7 +29,8 @@ namespace wr
 		std::size_t index_buffer_size_in_bytes) :
 		ModelPool(SizeAlignAnyAlignment(vertex_buffer_size_in_bytes, 65536), SizeAlignAnyAlignment(index_buffer_size_in_bytes, 65536)),
 		m_render_system(render_system),
-		m_intermediate_size(0)
+		m_intermediate_size(0),
+		m_defrag_budget(d3d12::settings::model_pool_defrag_budget)
 	{
 		m_vertex_buffer = d3d12::CreateStagingBuffer(render_system.m_device,
 			nullptr,
@@ -47,19 +48,8 @@ namespace wr
 		SetName(m_index_buffer, L"Model Pool Index Buffer");
 		m_index_buffer_size = SizeAlignAnyAlignment(index_buffer_size_in_bytes, 65536);
 
-		m_vertex_heap_start_block = new MemoryBlock;
-		m_vertex_heap_start_block->m_free = true;
-		m_vertex_heap_start_block->m_next_block = nullptr;
-		m_vertex_heap_start_block->m_prev_block = nullptr;
-		m_vertex_heap_start_block->m_offset = 0;
-		m_vertex_heap_start_block->m_size = m_vertex_buffer_size;
-
-		m_index_heap_start_block = new MemoryBlock;
-		m_index_heap_start_block->m_free = true;
-		m_index_heap_start_block->m_next_block = nullptr;
-		m_index_heap_start_block->m_prev_block = nullptr;
-		m_index_heap_start_block->m_offset = 0;
-		m_index_heap_start_block->m_size = m_index_buffer_size;
+		m_vertex_heap_allocator.Resize(m_vertex_buffer_size);
+		m_index_heap_allocator.Resize(m_index_buffer_size);
 
 		m_intermediate_buffer = NULL;
 	}
@@ -69,23 +59,18 @@ namespace wr
 		d3d12::Destroy(m_vertex_buffer);
 		d3d12::Destroy(m_index_buffer);
 
-		while (m_vertex_heap_start_block != nullptr) 
-		{
-			MemoryBlock* temp = m_vertex_heap_start_block;
-			m_vertex_heap_start_block = m_vertex_heap_start_block->m_next_block;
-			delete temp;
-		}
-
-		while (m_index_heap_start_block != nullptr)
+		SAFE_RELEASE(m_intermediate_buffer);
+		for (auto& releases : m_intermediate_releases)
 		{
-			MemoryBlock* temp = m_index_heap_start_block;
-			m_index_heap_start_block = m_index_heap_start_block->m_next_block;
-			delete temp;
+			for (auto* buffer : releases)
+			{
+				SAFE_RELEASE(buffer);
+			}
 		}
 
-		for (auto& handle : m_loaded_meshes)
+		for (LoadedMesh& mesh : m_loaded_meshes)
 		{
-			delete handle.second;
+			delete mesh.m_data;
 		}
 	}
 
@@ -103,73 +88,186 @@ namespace wr
 
 	void D3D12ModelPool::StageMeshes(d3d12::CommandList * cmd_list)
 	{
-		while (!m_command_queue.empty())
+		while (!m_command_queue.Empty())
 		{
-			internal::Command* command = static_cast<internal::Command*>(m_command_queue.front());
+			internal::Command& command = m_command_queue.Front();
 
-			switch (command->m_type)
+			switch (command.m_type)
 			{
 			case internal::CommandType::STAGE:
 			{
-				internal::StageCommand* stage_command = static_cast<internal::StageCommand*>(command);
-				d3d12::StageBufferRegion(stage_command->m_buffer,
-					stage_command->m_size,
-					stage_command->m_offset,
-					cmd_list);
-
-				delete stage_command;
+				// Stages only read from the staging buffers, so a run of them can be merged and reordered
+				while (!m_command_queue.Empty() && m_command_queue.Front().m_type == internal::CommandType::STAGE)
+				{
+					internal::StageCommand& stage_command = m_command_queue.Front().m_stage;
+					m_stage_ranges.Add(stage_command.m_buffer, stage_command.m_offset, stage_command.m_size);
+					m_command_queue.Pop();
+				}
 
-				m_command_queue.pop();
-				break;
+				FlushStages(cmd_list);
 			}
+			break;
 			case internal::CommandType::COPY:
 			{
-				internal::CopyCommand* copy_command = static_cast<internal::CopyCommand*>(command);
+				internal::CopyCommand& copy_command = command.m_copy;
 
-				cmd_list->m_native->CopyBufferRegion(copy_command->m_dest,
-					copy_command->m_dest_offset,
-					copy_command->m_source,
-					copy_command->m_source_offset,
-					copy_command->m_size);
+				cmd_list->m_native->CopyBufferRegion(copy_command.m_dest,
+					copy_command.m_dest_offset,
+					copy_command.m_source,
+					copy_command.m_source_offset,
+					copy_command.m_size);
 
-				delete copy_command;
-				m_command_queue.pop();
+				m_command_queue.Pop();
 			}
 			break;
 			case internal::CommandType::TRANSITION:
 			{
-				internal::TransitionCommand* transition_command = static_cast<internal::TransitionCommand*>(command);
+				// Consecutive transitions are submitted as one barrier batch
+				while (!m_command_queue.Empty() && m_command_queue.Front().m_type == internal::CommandType::TRANSITION)
+				{
+					internal::TransitionCommand& transition_command = m_command_queue.Front().m_transition;
 
-				CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(transition_command->m_buffer,
-					static_cast<D3D12_RESOURCE_STATES>(transition_command->m_old_state),
-					static_cast<D3D12_RESOURCE_STATES>(transition_command->m_new_state));
+					m_barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(transition_command.m_buffer,
+						static_cast<D3D12_RESOURCE_STATES>(transition_command.m_old_state),
+						static_cast<D3D12_RESOURCE_STATES>(transition_command.m_new_state)));
 
-				cmd_list->m_native->ResourceBarrier(1, &barrier);
+					m_command_queue.Pop();
+				}
 
-				delete transition_command;
-				m_command_queue.pop();
+				FlushBarriers(cmd_list);
 			}
 			break;
 			case internal::CommandType::READ:
 			{
-				internal::ReadCommand* read_command = static_cast<internal::ReadCommand*>(command);
+				internal::ReadCommand& read_command = command.m_read;
 
-				cmd_list->m_native->CopyBufferRegion(read_command->m_buffer->m_staging,
-					read_command->m_offset,
-					read_command->m_buffer->m_buffer,
-					read_command->m_offset,
-					read_command->m_size);
+				cmd_list->m_native->CopyBufferRegion(read_command.m_buffer->m_staging,
+					read_command.m_offset,
+					read_command.m_buffer->m_buffer,
+					read_command.m_offset,
+					read_command.m_size);
 
-				delete read_command;
-				m_command_queue.pop();
+				m_command_queue.Pop();
 			}
 			break;
 			default:
 			{
-				delete command;
-				m_command_queue.pop();
+				m_command_queue.Pop();
+			}
+			break;
+			}
+		}
+	}
+
+	void D3D12ModelPool::FlushStages(d3d12::CommandList* cmd_list)
+	{
+		// Ranges are sorted by buffer, so every buffer is one contiguous run of ranges
+		auto const & ranges = m_stage_ranges.Coalesce();
+
+		for (std::size_t i = 0; i < ranges.size(); ++i)
+		{
+			auto buffer = static_cast<d3d12::StagingBuffer*>(ranges[i].m_key);
+			if ((i == 0 || ranges[i - 1].m_key != buffer) && buffer->m_is_staged)
+			{
+				m_barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(buffer->m_buffer,
+					static_cast<D3D12_RESOURCE_STATES>(buffer->m_target_resource_state),
+					D3D12_RESOURCE_STATE_COPY_DEST));
+			}
+		}
+
+		FlushBarriers(cmd_list);
+
+		for (auto const & range : ranges)
+		{
+			auto buffer = static_cast<d3d12::StagingBuffer*>(range.m_key);
+			cmd_list->m_native->CopyBufferRegion(buffer->m_buffer, range.m_offset, buffer->m_staging, range.m_offset, range.m_size);
+		}
+
+		for (std::size_t i = 0; i < ranges.size(); ++i)
+		{
+			auto buffer = static_cast<d3d12::StagingBuffer*>(ranges[i].m_key);
+			if (i == 0 || ranges[i - 1].m_key != buffer)
+			{
+				m_barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(buffer->m_buffer,
+					D3D12_RESOURCE_STATE_COPY_DEST,
+					static_cast<D3D12_RESOURCE_STATES>(buffer->m_target_resource_state)));
+
+				buffer->m_gpu_address = buffer->m_buffer->GetGPUVirtualAddress();
+				buffer->m_is_staged = true;
+			}
+		}
+
+		FlushBarriers(cmd_list);
+
+		m_stage_ranges.Clear();
+	}
+
+	void D3D12ModelPool::FlushBarriers(d3d12::CommandList* cmd_list)
+	{
+		if (!m_barriers.empty())
+		{
+			cmd_list->m_native->ResourceBarrier(static_cast<UINT>(m_barriers.size()), m_barriers.data());
+			m_barriers.clear();
+		}
+	}
+
+	void D3D12ModelPool::QueueStage(d3d12::StagingBuffer* buffer, std::size_t offset, std::size_t size)
+	{
+		internal::Command command;
+		command.m_type = internal::CommandType::STAGE;
+		command.m_stage = { buffer, size, offset };
+
+		m_command_queue.Push(command);
+	}
+
+	void D3D12ModelPool::QueueCopy(ID3D12Resource* source, std::size_t source_offset, ID3D12Resource* dest, std::size_t dest_offset, std::size_t size)
+	{
+		internal::Command command;
+		command.m_type = internal::CommandType::COPY;
+		command.m_copy = { source, dest, size, source_offset, dest_offset };
+
+		m_command_queue.Push(command);
+	}
+
+	void D3D12ModelPool::QueueTransition(ID3D12Resource* buffer, ResourceState old_state, ResourceState new_state)
+	{
+		internal::Command command;
+		command.m_type = internal::CommandType::TRANSITION;
+		command.m_transition = { buffer, old_state, new_state };
+
+		m_command_queue.Push(command);
+	}
+
+	void D3D12ModelPool::ReplaceQueuedResource(ID3D12Resource* old_resource, ID3D12Resource* new_resource)
+	{
+		for (std::size_t i = 0; i < m_command_queue.Size(); ++i)
+		{
+			internal::Command& command = m_command_queue[i];
+
+			switch (command.m_type)
+			{
+			case internal::CommandType::COPY:
+			{
+				if (command.m_copy.m_dest == old_resource)
+				{
+					command.m_copy.m_dest = new_resource;
+				}
+				if (command.m_copy.m_source == old_resource)
+				{
+					command.m_copy.m_source = new_resource;
+				}
+			}
+			break;
+			case internal::CommandType::TRANSITION:
+			{
+				if (command.m_transition.m_buffer == old_resource)
+				{
+					command.m_transition.m_buffer = new_resource;
+				}
 			}
 			break;
+			default:
+				break;
 			}
 		}
 	}
@@ -186,7 +284,7 @@ namespace wr
 
 	internal::D3D12MeshInternal * D3D12ModelPool::GetMeshData(std::uint64_t mesh_handle)
 	{
-		return static_cast<internal::D3D12MeshInternal*>(m_loaded_meshes[mesh_handle]);
+		return static_cast<internal::D3D12MeshInternal*>(FindMeshData(mesh_handle));
 	}
 
 	void D3D12ModelPool::ShrinkToFit()
@@ -197,21 +295,14 @@ namespace wr
 
 	void D3D12ModelPool::ShrinkVertexHeapToFit()
 	{
-		MemoryBlock* last_occupied_block = nullptr;
-		for (MemoryBlock* mem_block = m_vertex_heap_start_block; mem_block != nullptr; mem_block = mem_block->m_next_block)
-		{
-			if (mem_block->m_free == false)
-			{
-				last_occupied_block = mem_block;
-			}
-		}
+		CancelPendingMoves(nullptr);
 
-		if (last_occupied_block == nullptr)
+		if (m_vertex_heap_allocator.GetNumUsedBlocks() == 0)
 		{
 			LOGW("You're trying to shrink an empty vertex heap, returning instead.");
 			return;
 		}
-		size_t new_size = last_occupied_block->m_offset + last_occupied_block->m_size;
+		size_t new_size = m_vertex_heap_allocator.GetUsedEnd();
 		new_size = SizeAlignAnyAlignment(new_size, 65536);
 
 		if (new_size == m_vertex_buffer->m_size)
@@ -267,90 +358,12 @@ namespace wr
 		m_vertex_buffer->m_staging = new_staging;
 		m_vertex_buffer->m_gpu_address = new_buffer->GetGPUVirtualAddress();
 
-		for (int i = 0; i < m_command_queue.size(); ++i)
-		{
-			internal::Command* command = m_command_queue.front();
-			m_command_queue.pop();
-			m_command_queue.push(command);
+		ReplaceQueuedResource(old_staging, new_staging);
+		ReplaceQueuedResource(old_buffer, new_buffer);
 
-			switch (command->m_type)
-			{
-			case internal::CommandType::COPY:
-			{
-				internal::CopyCommand* copy_command = static_cast<internal::CopyCommand*>(command);
-				if (copy_command->m_dest == old_staging)
-				{
-					copy_command->m_dest = new_staging;
-				}
-				if (copy_command->m_dest == old_buffer)
-				{
-					copy_command->m_dest = new_buffer;
-				}
-				if (copy_command->m_source == old_staging)
-				{
-					copy_command->m_source = new_staging;
-				}
-				if (copy_command->m_source == old_buffer)
-				{
-					copy_command->m_source = new_buffer;
-				}
-			}
-			break;
-			case internal::CommandType::TRANSITION:
-			{
-				internal::TransitionCommand* transition_command = static_cast<internal::TransitionCommand*>(command);
-				if (transition_command->m_buffer == old_staging)
-				{
-					transition_command->m_buffer = new_staging;
-				}
-				if (transition_command->m_buffer == old_buffer)
-				{
-					transition_command->m_buffer = new_buffer;
-				}
-			}
-			break;
-			}
-		}
-
-		internal::StageCommand* stageCommand = new internal::StageCommand;
-
-		stageCommand->m_type = internal::STAGE;
-		stageCommand->m_buffer = m_vertex_buffer;
-		stageCommand->m_offset = 0;
-		stageCommand->m_size = new_size;
-
-		m_command_queue.push(stageCommand);
-
-		MemoryBlock* mem_block = last_occupied_block->m_next_block;
-		while (mem_block != nullptr)
-		{
-			MemoryBlock* old_block = mem_block;
-			mem_block = mem_block->m_next_block;
-			if (old_block->m_free)
-			{
-				delete old_block;
-			}
-			else
-			{
-				LOGE("Last occupied block wasn't last occupied block.");
-			}
-		}
-		last_occupied_block->m_next_block = nullptr;
+		QueueStage(m_vertex_buffer, 0, new_size);
 
-		if (last_occupied_block->m_offset + last_occupied_block->m_size < new_size)
-		{
-			MemoryBlock* new_block = new MemoryBlock;
-			ZeroMemory(new_block, sizeof(MemoryBlock));
-			new_block->m_alignment = 1;
-			new_block->m_free = true;
-			new_block->m_next_block = nullptr;
-			new_block->m_prev_block = last_occupied_block;
-			new_block->m_offset = last_occupied_block->m_offset + last_occupied_block->m_size;
-			new_block->m_size = new_size - new_block->m_offset;
-
-			last_occupied_block->m_next_block = new_block;
-		}
-		else if (last_occupied_block->m_offset + last_occupied_block->m_size > new_size)
+		if (!m_vertex_heap_allocator.Resize(new_size))
 		{
 			LOGE("Vertex buffer has shrunken too much and doesn't fit.");
 		}
@@ -360,19 +373,14 @@ namespace wr
 
 	void D3D12ModelPool::ShrinkIndexHeapToFit()
 	{
-		MemoryBlock* last_occupied_block = nullptr;
-		for (MemoryBlock* mem_block = m_index_heap_start_block; mem_block != nullptr; mem_block = mem_block->m_next_block)
-		{
-			if (mem_block->m_free == false)
-			{
-				last_occupied_block = mem_block;
-			}
-		}
-		if (last_occupied_block == nullptr)
+		CancelPendingMoves(nullptr);
+
+		if (m_index_heap_allocator.GetNumUsedBlocks() == 0)
 		{
 			LOGW("You're trying to shrink an empty index heap, returning instead.");
+			return;
 		}
-		size_t new_size = last_occupied_block->m_offset + last_occupied_block->m_size;
+		size_t new_size = m_index_heap_allocator.GetUsedEnd();
 		new_size = SizeAlignAnyAlignment(new_size, 65536);
 
 		if (new_size == m_index_buffer->m_size)
@@ -428,92 +436,14 @@ namespace wr
 		m_index_buffer->m_staging = new_staging;
 		m_index_buffer->m_gpu_address = new_buffer->GetGPUVirtualAddress();
 
-		for (int i = 0; i < m_command_queue.size(); ++i)
-		{
-			internal::Command* command = m_command_queue.front();
-			m_command_queue.pop();
-			m_command_queue.push(command);
+		ReplaceQueuedResource(old_staging, new_staging);
+		ReplaceQueuedResource(old_buffer, new_buffer);
 
-			switch (command->m_type)
-			{
-			case internal::CommandType::COPY:
-			{
-				internal::CopyCommand* copy_command = static_cast<internal::CopyCommand*>(command);
-				if (copy_command->m_dest == old_staging)
-				{
-					copy_command->m_dest = new_staging;
-				}
-				if (copy_command->m_dest == old_buffer)
-				{
-					copy_command->m_dest = new_buffer;
-				}
-				if (copy_command->m_source == old_staging)
-				{
-					copy_command->m_source = new_staging;
-				}
-				if (copy_command->m_source == old_buffer)
-				{
-					copy_command->m_source = new_buffer;
-				}
-			}
-			break;
-			case internal::CommandType::TRANSITION:
-			{
-				internal::TransitionCommand* transition_command = static_cast<internal::TransitionCommand*>(command);
-				if (transition_command->m_buffer == old_staging)
-				{
-					transition_command->m_buffer = new_staging;
-				}
-				if (transition_command->m_buffer == old_buffer)
-				{
-					transition_command->m_buffer = new_buffer;
-				}
-			}
-			break;
-			}
-		}
-
-		internal::StageCommand* stageCommand = new internal::StageCommand;
-
-		stageCommand->m_type = internal::STAGE;
-		stageCommand->m_buffer = m_index_buffer;
-		stageCommand->m_offset = 0;
-		stageCommand->m_size = new_size;
-
-		m_command_queue.push(stageCommand); 
+		QueueStage(m_index_buffer, 0, new_size);
 		
-		MemoryBlock* mem_block = last_occupied_block->m_next_block;
-		while (mem_block != nullptr)
+		if (!m_index_heap_allocator.Resize(new_size))
 		{
-			MemoryBlock* old_block = mem_block;
-			mem_block = mem_block->m_next_block;
-			if (old_block->m_free)
-			{
-				delete old_block;
-			}
-			else
-			{
-				LOGE("Last occupied block wasn't last occupied block.");
-			}
-		}
-		last_occupied_block->m_next_block = nullptr;
-
-		if (last_occupied_block->m_offset + last_occupied_block->m_size < new_size)
-		{
-			MemoryBlock* new_block = new MemoryBlock;
-			ZeroMemory(new_block, sizeof(MemoryBlock));
-			new_block->m_alignment = 1;
-			new_block->m_free = true;
-			new_block->m_next_block = nullptr;
-			new_block->m_prev_block = last_occupied_block;
-			new_block->m_offset = last_occupied_block->m_offset + last_occupied_block->m_size;
-			new_block->m_size = new_size - new_block->m_offset;
-
-			last_occupied_block->m_next_block = new_block;
-		}
-		else if (last_occupied_block->m_offset + last_occupied_block->m_size > new_size)
-		{
-			LOGE("Vertex buffer has shrunken too much and doesn't fit.");
+			LOGE("Index buffer has shrunken too much and doesn't fit.");
 		}
 
 		m_updated = true;
@@ -525,510 +455,289 @@ namespace wr
 		DefragmentIndexHeap();
 	}
 
-	void D3D12ModelPool::DefragmentVertexHeap()
+	void D3D12ModelPool::DefragmentIncremental(unsigned int frame_idx)
 	{
+		if (m_defrag_budget == 0)
 		{
-			internal::TransitionCommand* transition_command = new internal::TransitionCommand;
-			transition_command->m_type = internal::CommandType::TRANSITION;
-			transition_command->m_buffer = m_vertex_buffer->m_buffer;
-			if (m_vertex_buffer->m_is_staged)
-			{
-				transition_command->m_old_state = m_vertex_buffer->m_target_resource_state;
-			}
-			else
-			{
-				transition_command->m_old_state = ResourceState::COPY_DEST;
-			}
-			transition_command->m_new_state = ResourceState::COPY_SOURCE;
+			return;
+		}
 
-			m_command_queue.push(transition_command);
+		std::size_t moved = DefragmentHeapIncremental(m_vertex_heap_allocator, m_vertex_buffer, false, m_defrag_budget, frame_idx);
+		DefragmentHeapIncremental(m_index_heap_allocator, m_index_buffer, true, m_defrag_budget - std::min(moved, m_defrag_budget), frame_idx);
+	}
+
+	std::size_t D3D12ModelPool::DefragmentHeapIncremental(util::TLSFAllocator& allocator, d3d12::StagingBuffer* buffer, bool index_heap, std::size_t budget, unsigned int frame_idx)
+	{
+		if (budget == 0 || allocator.GetNumFreeBlocks() <= 1 || allocator.GetFragmentation() < d3d12::settings::model_pool_defrag_threshold)
+		{
+			return 0;
 		}
 
-		MemoryBlock* largest_block = m_vertex_heap_start_block;
-		for (MemoryBlock* mem_block = m_vertex_heap_start_block; mem_block != nullptr; mem_block = mem_block->m_next_block)
+		std::size_t moved = 0;
+		std::size_t candidates = 0;
+		bool transitioned = false;
+
+		// Move allocations from the end of the heap into the first hole they fit in, so the free space collects at the end.
+		for (auto* block = allocator.GetLastBlock(); block != nullptr && candidates < d3d12::settings::model_pool_defrag_max_candidates; )
 		{
-			if (!mem_block->m_free)
+			auto* prev = block->m_prev_physical;
+
+			auto mesh = static_cast<internal::D3D12MeshInternal*>(block->m_user_data);
+			bool moving = std::find_if(m_pending_moves.begin(), m_pending_moves.end(), [block](PendingMove const & move)
 			{
-				if (largest_block->m_free || mem_block->m_size > largest_block->m_size)
-				{
-					largest_block = mem_block;
-				}
+				return move.m_old_block == block;
+			}) != m_pending_moves.end();
+
+			if (block->m_free || mesh == nullptr || moving)
+			{
+				block = prev;
+				continue;
 			}
-		}
 
-		if (!largest_block->m_free)
-		{
-			if (largest_block->m_size > m_intermediate_size)
+			// A block larger than the budget is still moved if it's the first one this frame, otherwise it would never move
+			if (moved > 0 && moved + block->m_size > budget)
 			{
-				ID3D12Resource* buffer;
-				CD3DX12_HEAP_PROPERTIES heap_properties_default = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-				CD3DX12_RESOURCE_DESC buffer_desc = CD3DX12_RESOURCE_DESC::Buffer(SizeAlignAnyAlignment(largest_block->m_size, 65536));
-
-				m_render_system.m_device->m_native->CreateCommittedResource(
-					&heap_properties_default,
-					D3D12_HEAP_FLAG_NONE,
-					&buffer_desc,
-					D3D12_RESOURCE_STATE_COPY_DEST,
-					nullptr,
-					IID_PPV_ARGS(&buffer));
-				buffer->SetName(L"Memory pool intermediate buffer");
+				break;
+			}
 
-				m_render_system.WaitForAllPreviousWork();
+			candidates++;
 
-				for (int i = 0; i < m_command_queue.size(); ++i)
+			util::TLSFAllocator::Block* hole = nullptr;
+			for (auto* free_block = allocator.GetFirstBlock(); free_block != nullptr && free_block->m_offset < block->m_offset; free_block = free_block->m_next_physical)
+			{
+				if (free_block->m_free && util::TLSFAllocator::Fits(free_block, block->m_size, block->m_alignment))
 				{
-					internal::Command* command = m_command_queue.front();
-					m_command_queue.pop();
-					m_command_queue.push(command);
-
-					switch (command->m_type)
-					{
-					case internal::CommandType::COPY:
-					{
-						internal::CopyCommand* copy_command = static_cast<internal::CopyCommand*>(command);
-						if (copy_command->m_dest == m_intermediate_buffer)
-						{
-							copy_command->m_dest = buffer;
-						}
-						if (copy_command->m_source == m_intermediate_buffer)
-						{
-							copy_command->m_source = buffer;
-						}
-					}
-					break;
-					case internal::CommandType::TRANSITION:
-					{
-						internal::TransitionCommand* transition_command = static_cast<internal::TransitionCommand*>(command);
-						if (transition_command->m_buffer == m_intermediate_buffer)
-						{
-							transition_command->m_buffer = buffer;
-						}
-					}
+					hole = free_block;
 					break;
-					}
 				}
+			}
+
+			if (hole == nullptr)
+			{
+				block = prev;
+				continue;
+			}
 
-				SAFE_RELEASE(m_intermediate_buffer);
-				m_intermediate_buffer = buffer;
-				m_intermediate_size = SizeAlignAnyAlignment(largest_block->m_size, 65536);
+			if (!transitioned)
+			{
+				QueueCopyStateTransition(buffer, true);
+				transitioned = true;
 			}
+
+			ReserveIntermediateBuffer(block->m_size);
+
+			// The old block stays allocated and in use until the copy has retired on the GPU
+			util::TLSFAllocator::Block* new_block = allocator.AllocateFrom(hole, block->m_size, block->m_alignment);
+			QueueBufferMove(buffer, block->m_offset, new_block->m_offset, block->m_size);
+
+			m_pending_moves.push_back({ mesh, block, new_block, index_heap, frame_idx });
+
+			moved += block->m_size;
+			block = prev;
 		}
 
-		bool contents_changed = false;
+		if (transitioned)
+		{
+			QueueCopyStateTransition(buffer, false);
+		}
+
+		return moved;
+	}
 
-		MemoryBlock* mem_block = m_vertex_heap_start_block;
-		while (mem_block->m_next_block != nullptr)
+	void D3D12ModelPool::RetireDefragmentMoves(unsigned int frame_idx)
+	{
+		for (auto* buffer : m_intermediate_releases[frame_idx])
 		{
-			if (mem_block->m_free)
-			{
-				if (mem_block->m_next_block->m_free)
-				{
-					mem_block->m_size += mem_block->m_next_block->m_size;
-
-					if (mem_block->m_next_block->m_next_block != nullptr)
-					{
-						mem_block->m_next_block = mem_block->m_next_block->m_next_block;
-						delete mem_block->m_next_block->m_prev_block;
-						mem_block->m_next_block->m_prev_block = mem_block;
-					}
-					else
-					{
-						delete mem_block->m_next_block;
-						mem_block->m_next_block = nullptr;
-					}
-				}
-				else
-				{
-					MemoryBlock* next_block = mem_block->m_next_block;
-
-					size_t original_offset = next_block->m_offset;
-
-					if (mem_block->m_prev_block != nullptr)
-					{
-						mem_block->m_prev_block->m_next_block = mem_block->m_next_block;
-						next_block->m_prev_block = mem_block->m_prev_block;
-					}
-					else
-					{
-						m_vertex_heap_start_block = next_block;
-						next_block->m_prev_block = nullptr;
-					}
-
-					if (next_block->m_next_block != nullptr)
-					{
-						next_block->m_next_block->m_prev_block = mem_block;
-						mem_block->m_next_block = next_block->m_next_block;
-					}
-					else
-					{
-						mem_block->m_next_block = nullptr;
-					}
-
-					next_block->m_next_block = mem_block;
-					mem_block->m_prev_block = next_block;
-
-					next_block->m_offset = SizeAlignAnyAlignment(mem_block->m_offset, next_block->m_alignment);
-					if (next_block->m_offset%next_block->m_alignment != 0)
-					{
-						LOGW("Wrong alignment after trying to align");
-					}
-					if (next_block->m_prev_block != nullptr)
-					{
-						next_block->m_size += SizeAlignAnyAlignment(next_block->m_offset - mem_block->m_offset, next_block->m_alignment);
-					}
-					mem_block->m_size -= SizeAlignAnyAlignment(next_block->m_offset - mem_block->m_offset, next_block->m_alignment);
-					mem_block->m_offset = next_block->m_offset + next_block->m_size;
-
-					std::map<std::uint64_t, internal::MeshInternal*>::iterator it = m_loaded_meshes.begin();
-
-					for (; it != m_loaded_meshes.end(); ++it)
-					{
-						internal::D3D12MeshInternal* mesh = static_cast<internal::D3D12MeshInternal*>((*it).second);
-						if (mesh->m_vertex_memory_block == next_block)
-						{
-							mesh->m_vertex_staging_buffer_offset = next_block->m_offset / next_block->m_alignment;
-							if (next_block->m_offset%next_block->m_alignment != 0)
-							{
-								LOGW("Wrong alignment");
-							}
-						}
-					}
-
-					internal::CopyCommand* copy_to_intermediate_command = new internal::CopyCommand;
-
-					copy_to_intermediate_command->m_type = internal::CommandType::COPY;
-					copy_to_intermediate_command->m_source = m_vertex_buffer->m_buffer;
-					copy_to_intermediate_command->m_dest = m_intermediate_buffer;
-					copy_to_intermediate_command->m_source_offset = original_offset;
-					copy_to_intermediate_command->m_dest_offset = 0;
-					copy_to_intermediate_command->m_size = next_block->m_size;
-
-					m_command_queue.push(copy_to_intermediate_command);
-
-					internal::TransitionCommand* transition_intermediate_read_command = new internal::TransitionCommand;
-
-					transition_intermediate_read_command->m_type = internal::TRANSITION;
-					transition_intermediate_read_command->m_buffer = m_intermediate_buffer;
-					transition_intermediate_read_command->m_old_state = ResourceState::COPY_DEST;
-					transition_intermediate_read_command->m_new_state = ResourceState::COPY_SOURCE;
-
-					m_command_queue.push(transition_intermediate_read_command);
-
-					internal::TransitionCommand* transition_buffer_write_command = new internal::TransitionCommand;
-
-					transition_buffer_write_command->m_type = internal::TRANSITION;
-					transition_buffer_write_command->m_buffer = m_vertex_buffer->m_buffer;
-					transition_buffer_write_command->m_old_state = ResourceState::COPY_SOURCE;
-					transition_buffer_write_command->m_new_state = ResourceState::COPY_DEST;
-
-					m_command_queue.push(transition_buffer_write_command);
-
-					internal::CopyCommand* copy_to_buffer_command = new internal::CopyCommand;
-
-					copy_to_buffer_command->m_type = internal::COPY;
-					copy_to_buffer_command->m_source = m_intermediate_buffer;
-					copy_to_buffer_command->m_source_offset = 0;
-					copy_to_buffer_command->m_dest = m_vertex_buffer->m_buffer;
-					copy_to_buffer_command->m_dest_offset = next_block->m_offset;
-					copy_to_buffer_command->m_size = next_block->m_size;
-
-					m_command_queue.push(copy_to_buffer_command);
-
-					internal::TransitionCommand* transition_intermediate_write_command = new internal::TransitionCommand;
-
-					transition_intermediate_write_command->m_type = internal::TRANSITION;
-					transition_intermediate_write_command->m_buffer = m_intermediate_buffer;
-					transition_intermediate_write_command->m_old_state = ResourceState::COPY_SOURCE;
-					transition_intermediate_write_command->m_new_state = ResourceState::COPY_DEST;
-
-					m_command_queue.push(transition_intermediate_write_command);
-
-					internal::TransitionCommand* transition_buffer_read_command = new internal::TransitionCommand;
-
-					transition_buffer_read_command->m_type = internal::TRANSITION;
-					transition_buffer_read_command->m_buffer = m_vertex_buffer->m_buffer;
-					transition_buffer_read_command->m_old_state = ResourceState::COPY_DEST;
-					transition_buffer_read_command->m_new_state = ResourceState::COPY_SOURCE;
-
-					m_command_queue.push(transition_buffer_read_command);
-
-					memcpy(m_vertex_buffer->m_cpu_address + next_block->m_offset, m_vertex_buffer->m_cpu_address + original_offset, next_block->m_size);
+			SAFE_RELEASE(buffer);
+		}
+		m_intermediate_releases[frame_idx].clear();
 
-					contents_changed = true;
-				}
-			}
-			else
+		for (auto it = m_pending_moves.begin(); it != m_pending_moves.end();)
+		{
+			if (it->m_frame_idx != frame_idx)
 			{
-				mem_block = mem_block->m_next_block;
+				++it;
+				continue;
 			}
-		}
 
-		{
-			internal::TransitionCommand* transition_command = new internal::TransitionCommand;
-			transition_command->m_type = internal::CommandType::TRANSITION;
-			transition_command->m_buffer = m_vertex_buffer->m_buffer;
-			if (m_vertex_buffer->m_is_staged)
+			internal::D3D12MeshInternal* mesh = it->m_mesh;
+			util::TLSFAllocator::Block* new_block = it->m_new_block;
+			new_block->m_user_data = mesh;
+
+			if (it->m_index_heap)
 			{
-				transition_command->m_new_state = m_vertex_buffer->m_target_resource_state;
+				mesh->m_index_memory_block = new_block;
+				mesh->m_index_staging_buffer_offset = new_block->m_offset / new_block->m_alignment;
+				m_index_heap_allocator.Free(it->m_old_block);
 			}
 			else
 			{
-				transition_command->m_new_state = ResourceState::COPY_DEST;
+				mesh->m_vertex_memory_block = new_block;
+				mesh->m_vertex_staging_buffer_offset = new_block->m_offset / new_block->m_alignment;
+				m_vertex_heap_allocator.Free(it->m_old_block);
 			}
-			transition_command->m_old_state = ResourceState::COPY_SOURCE;
-
-			m_command_queue.push(transition_command);
-		}
 
-		if (contents_changed)
-		{
+			// Acceleration structures reference the old location
+			mesh->data_changed = true;
 			m_updated = true;
+
+			it = m_pending_moves.erase(it);
 		}
 	}
 
-	void D3D12ModelPool::DefragmentIndexHeap()
+	void D3D12ModelPool::CancelPendingMoves(internal::D3D12MeshInternal* mesh)
 	{
+		// Copies that are still in flight write into the freed block, anything allocated there later is staged after them
+		for (auto it = m_pending_moves.begin(); it != m_pending_moves.end();)
 		{
-			internal::TransitionCommand* transition_command = new internal::TransitionCommand;
-			transition_command->m_type = internal::CommandType::TRANSITION;
-			transition_command->m_buffer = m_index_buffer->m_buffer;
-			if (m_index_buffer->m_is_staged)
+			if (mesh != nullptr && it->m_mesh != mesh)
 			{
-				transition_command->m_old_state = m_index_buffer->m_target_resource_state;
+				++it;
+				continue;
+			}
+
+			if (it->m_index_heap)
+			{
+				m_index_heap_allocator.Free(it->m_new_block);
 			}
 			else
 			{
-				transition_command->m_old_state = ResourceState::COPY_DEST;
+				m_vertex_heap_allocator.Free(it->m_new_block);
 			}
-			transition_command->m_new_state = ResourceState::COPY_SOURCE;
 
-			m_command_queue.push(transition_command);
+			it = m_pending_moves.erase(it);
 		}
+	}
 
-		MemoryBlock* largest_block = m_index_heap_start_block;
-		for (MemoryBlock* mem_block = m_index_heap_start_block; mem_block != nullptr; mem_block = mem_block->m_next_block)
+	void D3D12ModelPool::QueueCopyStateTransition(d3d12::StagingBuffer* buffer, bool to_copy_source)
+	{
+		// Buffers that haven't been staged yet are still in the copy destination state
+		ResourceState resting_state = buffer->m_is_staged ? buffer->m_target_resource_state : ResourceState::COPY_DEST;
+
+		QueueTransition(buffer->m_buffer,
+			to_copy_source ? resting_state : ResourceState::COPY_SOURCE,
+			to_copy_source ? ResourceState::COPY_SOURCE : resting_state);
+	}
+
+	void D3D12ModelPool::ReserveIntermediateBuffer(std::size_t size)
+	{
+		if (size > m_intermediate_size)
 		{
-			if (!mem_block->m_free)
+			ID3D12Resource* buffer;
+			CD3DX12_HEAP_PROPERTIES heap_properties_default = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+			CD3DX12_RESOURCE_DESC buffer_desc = CD3DX12_RESOURCE_DESC::Buffer(SizeAlignAnyAlignment(size, 65536));
+
+			m_render_system.m_device->m_native->CreateCommittedResource(
+				&heap_properties_default,
+				D3D12_HEAP_FLAG_NONE,
+				&buffer_desc,
+				D3D12_RESOURCE_STATE_COPY_DEST,
+				nullptr,
+				IID_PPV_ARGS(&buffer));
+			buffer->SetName(L"Memory pool intermediate buffer");
+
+			// Moves that are still queued switch over to the new buffer, the ones already recorded keep the old one alive until their frame is done
+			ReplaceQueuedResource(m_intermediate_buffer, buffer);
+
+			if (m_intermediate_buffer != nullptr)
 			{
-				if (largest_block->m_free || mem_block->m_size > largest_block->m_size)
-				{
-					largest_block = mem_block;
-				}
+				m_intermediate_releases[m_render_system.GetFrameIdx()].push_back(m_intermediate_buffer);
 			}
+			m_intermediate_buffer = buffer;
+			m_intermediate_size = SizeAlignAnyAlignment(size, 65536);
 		}
+	}
 
-		if (!largest_block->m_free)
-		{
-			if (largest_block->m_size > m_intermediate_size)
-			{
-				ID3D12Resource* buffer;
-				CD3DX12_HEAP_PROPERTIES heap_properties_default = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-				CD3DX12_RESOURCE_DESC buffer_desc = CD3DX12_RESOURCE_DESC::Buffer(SizeAlignAnyAlignment(largest_block->m_size, 65536));
-
-				m_render_system.m_device->m_native->CreateCommittedResource(
-					&heap_properties_default,
-					D3D12_HEAP_FLAG_NONE,
-					&buffer_desc,
-					D3D12_RESOURCE_STATE_COPY_DEST,
-					nullptr,
-					IID_PPV_ARGS(&buffer));
-				buffer->SetName(L"Memory pool intermediate buffer");
+	void D3D12ModelPool::QueueBufferMove(d3d12::StagingBuffer* buffer, std::size_t old_offset, std::size_t new_offset, std::size_t size)
+	{
+		QueueCopy(buffer->m_buffer, old_offset, m_intermediate_buffer, 0, size);
 
-				m_render_system.WaitForAllPreviousWork();
+		QueueTransition(m_intermediate_buffer, ResourceState::COPY_DEST, ResourceState::COPY_SOURCE);
+		QueueTransition(buffer->m_buffer, ResourceState::COPY_SOURCE, ResourceState::COPY_DEST);
 
-				for (int i = 0; i < m_command_queue.size(); ++i)
-				{
-					internal::Command* command = m_command_queue.front();
-					m_command_queue.pop();
-					m_command_queue.push(command);
-
-					switch (command->m_type)
-					{
-					case internal::CommandType::COPY:
-					{
-						internal::CopyCommand* copy_command = static_cast<internal::CopyCommand*>(command);
-						if (copy_command->m_dest == m_intermediate_buffer)
-						{
-							copy_command->m_dest = buffer;
-						}
-						if (copy_command->m_source == m_intermediate_buffer)
-						{
-							copy_command->m_source = buffer;
-						}
-					}
-					break;
-					case internal::CommandType::TRANSITION:
-					{
-						internal::TransitionCommand* transition_command = static_cast<internal::TransitionCommand*>(command);
-						if (transition_command->m_buffer == m_intermediate_buffer)
-						{
-							transition_command->m_buffer = buffer;
-						}
-					}
-					break;
-					}
-				}
+		QueueCopy(m_intermediate_buffer, 0, buffer->m_buffer, new_offset, size);
+
+		QueueTransition(m_intermediate_buffer, ResourceState::COPY_SOURCE, ResourceState::COPY_DEST);
+		QueueTransition(buffer->m_buffer, ResourceState::COPY_DEST, ResourceState::COPY_SOURCE);
+
+		memmove(buffer->m_cpu_address + new_offset, buffer->m_cpu_address + old_offset, size);
+	}
+
+	void D3D12ModelPool::DefragmentVertexHeap()
+	{
+		CancelPendingMoves(nullptr);
+
+		QueueCopyStateTransition(m_vertex_buffer, true);
 
-				SAFE_RELEASE(m_intermediate_buffer);
-				m_intermediate_buffer = buffer;
-				m_intermediate_size = SizeAlignAnyAlignment(largest_block->m_size, 65536);
+		std::size_t largest_block_size = 0;
+		for (auto* block = m_vertex_heap_allocator.GetFirstBlock(); block != nullptr; block = block->m_next_physical)
+		{
+			if (!block->m_free)
+			{
+				largest_block_size = std::max(largest_block_size, block->m_size);
 			}
 		}
 
+		ReserveIntermediateBuffer(largest_block_size);
+
 		bool contents_changed = false;
 
-		MemoryBlock* mem_block = m_index_heap_start_block;
-		while (mem_block->m_next_block != nullptr)
+		// Every block that moves down goes through the intermediate buffer, the blocks are visited in ascending order
+		m_vertex_heap_allocator.Compact([&](util::TLSFAllocator::Block* block, std::size_t old_offset)
 		{
-			if (mem_block->m_free)
+			internal::D3D12MeshInternal* mesh = static_cast<internal::D3D12MeshInternal*>(block->m_user_data);
+			if (mesh != nullptr)
 			{
-				if (mem_block->m_next_block->m_free)
-				{
-					mem_block->m_size += mem_block->m_next_block->m_size;
-
-					if (mem_block->m_next_block->m_next_block != nullptr)
-					{
-						mem_block->m_next_block = mem_block->m_next_block->m_next_block;
-						delete mem_block->m_next_block->m_prev_block;
-						mem_block->m_next_block->m_prev_block = mem_block;
-					}
-					else
-					{
-						delete mem_block->m_next_block;
-						mem_block->m_next_block = nullptr;
-					}
-				}
-				else
-				{
-					MemoryBlock* next_block = mem_block->m_next_block;
-
-					size_t original_offset = next_block->m_offset;
-
-					if (mem_block->m_prev_block != nullptr)
-					{
-						mem_block->m_prev_block->m_next_block = mem_block->m_next_block;
-						next_block->m_prev_block = mem_block->m_prev_block;
-					}
-					else
-					{
-						m_index_heap_start_block = next_block;
-						next_block->m_prev_block = nullptr;
-					}
-
-					if (next_block->m_next_block != nullptr)
-					{
-						next_block->m_next_block->m_prev_block = mem_block;
-						mem_block->m_next_block = next_block->m_next_block;
-					}
-					else
-					{
-						mem_block->m_next_block = nullptr;
-					}
-
-					next_block->m_next_block = mem_block;
-					mem_block->m_prev_block = next_block;
-
-					next_block->m_offset = SizeAlignAnyAlignment(mem_block->m_offset, next_block->m_alignment);
-					if (next_block->m_prev_block != nullptr)
-					{
-						next_block->m_size += next_block->m_offset - mem_block->m_offset;
-					}
-					mem_block->m_size -= next_block->m_offset - mem_block->m_offset;
-					mem_block->m_offset = next_block->m_offset + next_block->m_size;
-
-					std::map<std::uint64_t, internal::MeshInternal*>::iterator it = m_loaded_meshes.begin();
-
-					for (; it != m_loaded_meshes.end(); ++it)
-					{
-						internal::D3D12MeshInternal* mesh = static_cast<internal::D3D12MeshInternal*>((*it).second);
-						if (mesh->m_index_memory_block == next_block)
-						{
-							mesh->m_index_staging_buffer_offset = SizeAlignAnyAlignment(next_block->m_offset, next_block->m_alignment)
-								/ next_block->m_alignment;
-						}
-					}
-
-					internal::CopyCommand* copy_to_intermediate_command = new internal::CopyCommand;
-
-					copy_to_intermediate_command->m_type = internal::CommandType::COPY;
-					copy_to_intermediate_command->m_source = m_index_buffer->m_buffer;
-					copy_to_intermediate_command->m_dest = m_intermediate_buffer;
-					copy_to_intermediate_command->m_source_offset = original_offset;
-					copy_to_intermediate_command->m_dest_offset = 0;
-					copy_to_intermediate_command->m_size = next_block->m_size;
-
-					m_command_queue.push(copy_to_intermediate_command);
-
-					internal::TransitionCommand* transition_intermediate_read_command = new internal::TransitionCommand;
-					transition_intermediate_read_command->m_type = internal::TRANSITION;
-					transition_intermediate_read_command->m_buffer = m_intermediate_buffer;
-					transition_intermediate_read_command->m_old_state = ResourceState::COPY_DEST;
-					transition_intermediate_read_command->m_new_state = ResourceState::COPY_SOURCE;
-
-					m_command_queue.push(transition_intermediate_read_command);
-
-					internal::TransitionCommand* transition_buffer_write_command = new internal::TransitionCommand;
-					transition_buffer_write_command->m_type = internal::TRANSITION;
-					transition_buffer_write_command->m_buffer = m_index_buffer->m_buffer;
-					transition_buffer_write_command->m_old_state = ResourceState::COPY_SOURCE;
-					transition_buffer_write_command->m_new_state = ResourceState::COPY_DEST;
-
-					m_command_queue.push(transition_buffer_write_command);
-
-					internal::CopyCommand* copy_to_buffer_command = new internal::CopyCommand;
-
-					copy_to_buffer_command->m_type = internal::COPY;
-					copy_to_buffer_command->m_source = m_intermediate_buffer;
-					copy_to_buffer_command->m_source_offset = 0;
-					copy_to_buffer_command->m_dest = m_index_buffer->m_buffer;
-					copy_to_buffer_command->m_dest_offset = next_block->m_offset;
-					copy_to_buffer_command->m_size = next_block->m_size;
-
-					m_command_queue.push(copy_to_buffer_command);
-
-					internal::TransitionCommand* transition_intermediate_write_command = new internal::TransitionCommand;
-					transition_intermediate_write_command->m_type = internal::TRANSITION;
-					transition_intermediate_write_command->m_buffer = m_intermediate_buffer;
-					transition_intermediate_write_command->m_old_state = ResourceState::COPY_SOURCE;
-					transition_intermediate_write_command->m_new_state = ResourceState::COPY_DEST;
-
-					m_command_queue.push(transition_intermediate_write_command);
-
-					internal::TransitionCommand* transition_buffer_read_command = new internal::TransitionCommand;
-					transition_buffer_read_command->m_type = internal::TRANSITION;
-					transition_buffer_read_command->m_buffer = m_index_buffer->m_buffer;
-					transition_buffer_read_command->m_old_state = ResourceState::COPY_DEST;
-					transition_buffer_read_command->m_new_state = ResourceState::COPY_SOURCE;
-
-					m_command_queue.push(transition_buffer_read_command);
-
-					memcpy(m_index_buffer->m_cpu_address + next_block->m_offset, m_index_buffer->m_cpu_address + original_offset, next_block->m_size);
-
-					contents_changed = true;
-				}
-			}
-			else
-			{
-				mem_block = mem_block->m_next_block;
+				mesh->m_vertex_staging_buffer_offset = block->m_offset / block->m_alignment;
 			}
+
+			QueueBufferMove(m_vertex_buffer, old_offset, block->m_offset, block->m_size);
+
+			contents_changed = true;
+		});
+
+		QueueCopyStateTransition(m_vertex_buffer, false);
+
+		if (contents_changed)
+		{
+			m_updated = true;
 		}
+	}
+
+	void D3D12ModelPool::DefragmentIndexHeap()
+	{
+		CancelPendingMoves(nullptr);
 
+		QueueCopyStateTransition(m_index_buffer, true);
+
+		std::size_t largest_block_size = 0;
+		for (auto* block = m_index_heap_allocator.GetFirstBlock(); block != nullptr; block = block->m_next_physical)
 		{
-			internal::TransitionCommand* transition_command = new internal::TransitionCommand;
-			transition_command->m_type = internal::CommandType::TRANSITION;
-			transition_command->m_buffer = m_index_buffer->m_buffer;
-			if (m_index_buffer->m_is_staged)
+			if (!block->m_free)
 			{
-				transition_command->m_new_state = m_index_buffer->m_target_resource_state;
+				largest_block_size = std::max(largest_block_size, block->m_size);
 			}
-			else
+		}
+
+		ReserveIntermediateBuffer(largest_block_size);
+
+		bool contents_changed = false;
+
+		// Every block that moves down goes through the intermediate buffer, the blocks are visited in ascending order
+		m_index_heap_allocator.Compact([&](util::TLSFAllocator::Block* block, std::size_t old_offset)
+		{
+			internal::D3D12MeshInternal* mesh = static_cast<internal::D3D12MeshInternal*>(block->m_user_data);
+			if (mesh != nullptr)
 			{
-				transition_command->m_new_state = ResourceState::COPY_DEST;
+				mesh->m_index_staging_buffer_offset = block->m_offset / block->m_alignment;
 			}
-			transition_command->m_old_state = ResourceState::COPY_SOURCE;
 
-			m_command_queue.push(transition_command);
-		}
+			QueueBufferMove(m_index_buffer, old_offset, block->m_offset, block->m_size);
+
+			contents_changed = true;
+		});
+
+		QueueCopyStateTransition(m_index_buffer, false);
 
 		if (contents_changed)
 		{
@@ -1044,57 +753,9 @@ namespace wr
 
 	void D3D12ModelPool::ResizeVertexHeap(size_t vertex_heap_new_size)
 	{
-		MemoryBlock* mem_block = m_vertex_heap_start_block;
-		while (mem_block->m_next_block != nullptr)
-		{
-			if (mem_block->m_free)
-			{
-				if (mem_block->m_next_block->m_free)
-				{
-					mem_block->m_size += mem_block->m_next_block->m_size;
-
-					if (mem_block->m_next_block->m_next_block != nullptr)
-					{
-						mem_block->m_next_block = mem_block->m_next_block->m_next_block;
-						delete mem_block->m_next_block->m_prev_block;
-						mem_block->m_next_block->m_prev_block = mem_block;
-					}
-					else
-					{
-						delete mem_block->m_next_block;
-						mem_block->m_next_block = nullptr;
-					}
-				}
-				else
-				{
-					mem_block = mem_block->m_next_block;
-				}
-			}
-			else
-			{
-				mem_block = mem_block->m_next_block;
-			}
-		}
+		CancelPendingMoves(nullptr);
 
-		MemoryBlock* last_occupied_block = nullptr;
-		for (mem_block = m_vertex_heap_start_block; mem_block != nullptr; mem_block = mem_block->m_next_block)
-		{
-			if (mem_block->m_free == false)
-			{
-				last_occupied_block = mem_block;
-			}
-		}
-
-		size_t new_size;
-		if (last_occupied_block != nullptr)
-		{
-			new_size = last_occupied_block->m_offset + last_occupied_block->m_size;
-		}
-		else
-		{
-			new_size = 0;
-		}
-		size_t old_size = m_vertex_buffer->m_size;
+		size_t new_size = m_vertex_heap_allocator.GetUsedEnd();
 
 		if (new_size > SizeAlignAnyAlignment(vertex_heap_new_size, 65536))
 		{
@@ -1156,142 +817,21 @@ namespace wr
 			m_vertex_buffer->m_staging = new_staging;
 			m_vertex_buffer->m_gpu_address = m_vertex_buffer->m_buffer->GetGPUVirtualAddress();
 
-			for (int i = 0; i < m_command_queue.size(); ++i)
-			{
-				internal::Command* command = m_command_queue.front();
-				m_command_queue.pop();
-				m_command_queue.push(command);
-
-				switch (command->m_type)
-				{
-				case internal::CommandType::COPY:
-				{
-					internal::CopyCommand* copy_command = static_cast<internal::CopyCommand*>(command);
-					if (copy_command->m_dest == old_staging)
-					{
-						copy_command->m_dest = new_staging;
-					}
-					if (copy_command->m_dest == old_buffer)
-					{
-						copy_command->m_dest = new_buffer;
-					}
-					if (copy_command->m_source == old_staging)
-					{
-						copy_command->m_source = new_staging;
-					}
-					if (copy_command->m_source == old_buffer)
-					{
-						copy_command->m_source = new_buffer;
-					}
-				}
-				break;
-				case internal::CommandType::TRANSITION:
-				{
-					internal::TransitionCommand* transition_command = static_cast<internal::TransitionCommand*>(command);
-					if (transition_command->m_buffer == old_staging)
-					{
-						transition_command->m_buffer = new_staging;
-					}
-					if (transition_command->m_buffer == old_buffer)
-					{
-						transition_command->m_buffer = new_buffer;
-					}
-				}
-				break;
-				}
-			}
-
-			internal::StageCommand* stageCommand = new internal::StageCommand;
+			ReplaceQueuedResource(old_staging, new_staging);
+			ReplaceQueuedResource(old_buffer, new_buffer);
 
-			stageCommand->m_type = internal::STAGE;
-			stageCommand->m_buffer = m_vertex_buffer;
-			stageCommand->m_offset = 0;
-			stageCommand->m_size = new_size;
+			QueueStage(m_vertex_buffer, 0, new_size);
 
-			m_command_queue.push(stageCommand);
-
-			if (last_occupied_block != nullptr)
-			{
-				if (last_occupied_block->m_offset + last_occupied_block->m_size < new_size)
-				{
-					if (last_occupied_block->m_next_block != nullptr)
-					{
-						last_occupied_block->m_next_block->m_size = new_size - (last_occupied_block->m_offset + last_occupied_block->m_size);
-					}
-					else
-					{
-						MemoryBlock* new_block = new MemoryBlock;
-
-						last_occupied_block->m_next_block = new_block;
-						new_block->m_prev_block = last_occupied_block;
-						new_block->m_free = true;
-						new_block->m_alignment = 1;
-						new_block->m_offset = last_occupied_block->m_offset + last_occupied_block->m_size;
-						new_block->m_next_block = nullptr;
-						new_block->m_size = new_size - new_block->m_offset;
-					}
-				}
-			}
-			else
-			{
-				m_vertex_heap_start_block->m_size = new_size;
-			}
+			m_vertex_heap_allocator.Resize(new_size);
 		}
 		m_updated = true;
 	}
 
 	void D3D12ModelPool::ResizeIndexHeap(size_t index_heap_new_size)
 	{
-		MemoryBlock* mem_block = m_index_heap_start_block;
-		while (mem_block->m_next_block != nullptr)
-		{
-			if (mem_block->m_free)
-			{
-				if (mem_block->m_next_block->m_free)
-				{
-					mem_block->m_size += mem_block->m_next_block->m_size;
-
-					if (mem_block->m_next_block->m_next_block != nullptr)
-					{
-						mem_block->m_next_block = mem_block->m_next_block->m_next_block;
-						delete mem_block->m_next_block->m_prev_block;
-						mem_block->m_next_block->m_prev_block = mem_block;
-					}
-					else
-					{
-						delete mem_block->m_next_block;
-						mem_block->m_next_block = nullptr;
-					}
-				}
-				else
-				{
-					mem_block = mem_block->m_next_block;
-				}
-			}
-			else
-			{
-				mem_block = mem_block->m_next_block;
-			}
-		}
+		CancelPendingMoves(nullptr);
 
-		MemoryBlock* last_occupied_block = nullptr;
-		for (mem_block = m_index_heap_start_block; mem_block != nullptr; mem_block = mem_block->m_next_block)
-		{
-			if (mem_block->m_free == false)
-			{
-				last_occupied_block = mem_block;
-			}
-		}
-
-		size_t new_size;
-		if (last_occupied_block != nullptr)
-		{
-			new_size = last_occupied_block->m_offset + last_occupied_block->m_size;
-		}
-		else
-		{
-			new_size = 0;
-		}
+		size_t new_size = m_index_heap_allocator.GetUsedEnd();
 
 		if (new_size > SizeAlignAnyAlignment(index_heap_new_size, 65536))
 		{
@@ -1353,88 +893,42 @@ namespace wr
 			m_index_buffer->m_staging = new_staging;
 			m_index_buffer->m_gpu_address = m_index_buffer->m_buffer->GetGPUVirtualAddress();
 
-			for (int i = 0; i < m_command_queue.size(); ++i)
-			{
-				internal::Command* command = m_command_queue.front();
-				m_command_queue.pop();
-				m_command_queue.push(command);
+			ReplaceQueuedResource(old_staging, new_staging);
+			ReplaceQueuedResource(old_buffer, new_buffer);
 
-				switch (command->m_type)
-				{
-				case internal::CommandType::COPY:
-				{
-					internal::CopyCommand* copy_command = static_cast<internal::CopyCommand*>(command);
-					if (copy_command->m_dest == old_staging)
-					{
-						copy_command->m_dest = new_staging;
-					}
-					if (copy_command->m_dest == old_buffer)
-					{
-						copy_command->m_dest = new_buffer;
-					}
-					if (copy_command->m_source == old_staging)
-					{
-						copy_command->m_source = new_staging;
-					}
-					if (copy_command->m_source == old_buffer)
-					{
-						copy_command->m_source = new_buffer;
-					}
-				}
-				break;
-				case internal::CommandType::TRANSITION:
-				{
-					internal::TransitionCommand* transition_command = static_cast<internal::TransitionCommand*>(command);
-					if (transition_command->m_buffer == old_staging)
-					{
-						transition_command->m_buffer = new_staging;
-					}
-					if (transition_command->m_buffer == old_buffer)
-					{
-						transition_command->m_buffer = new_buffer;
-					}
-				}
-				break;
-				}
-			}
+			QueueStage(m_index_buffer, 0, new_size);
 
-			internal::StageCommand* stageCommand = new internal::StageCommand;
+			m_index_heap_allocator.Resize(new_size);
+		}
+		m_updated = true;
+	}
 
-			stageCommand->m_type = internal::STAGE;
-			stageCommand->m_buffer = m_index_buffer;
-			stageCommand->m_offset = 0;
-			stageCommand->m_size = new_size;
+	util::TLSFAllocator::Block* D3D12ModelPool::AllocateOrGrow(bool index_heap, std::size_t size, std::size_t alignment)
+	{
+		util::TLSFAllocator& allocator = index_heap ? m_index_heap_allocator : m_vertex_heap_allocator;
 
-			m_command_queue.push(stageCommand);
+		util::TLSFAllocator::Block* block = allocator.Allocate(size, alignment);
+		if (block != nullptr)
+		{
+			return block;
+		}
 
-			if (last_occupied_block != nullptr)
-			{
-				if (last_occupied_block->m_offset + last_occupied_block->m_size < new_size)
-				{
-					if (last_occupied_block->m_next_block != nullptr)
-					{
-						last_occupied_block->m_next_block->m_size = new_size - (last_occupied_block->m_offset + last_occupied_block->m_size);
-					}
-					else
-					{
-						MemoryBlock* new_block = new MemoryBlock;
-
-						last_occupied_block->m_next_block = new_block;
-						new_block->m_prev_block = last_occupied_block;
-						new_block->m_free = true;
-						new_block->m_alignment = 1;
-						new_block->m_offset = last_occupied_block->m_offset + last_occupied_block->m_size;
-						new_block->m_next_block = nullptr;
-						new_block->m_size = new_size - new_block->m_offset;
-					}
-				}
-			}
-			else
-			{
-				m_index_heap_start_block->m_size = new_size;
-			}
+		// A full defragmentation would copy every mesh during this load; growing is cheap and DefragmentIncremental closes the holes over the next frames
+		LOGW("Allocating memory for {} buffer failed, allocating more memory.", index_heap ? "index" : "vertex");
+
+		std::size_t const heap_size = index_heap ? GetIndexHeapSize() : GetVertexHeapSize();
+		std::size_t const new_size = std::max(heap_size + size + alignment, heap_size * 2);
+
+		if (index_heap)
+		{
+			ResizeIndexHeap(new_size);
 		}
-		m_updated = true;
+		else
+		{
+			ResizeVertexHeap(new_size);
+		}
+
+		return allocator.Allocate(size, alignment);
 	}
 
 	void D3D12ModelPool::MakeSpaceForModel(size_t vertex_size, size_t index_size)
@@ -1456,51 +950,26 @@ namespace wr
 
 		//Allocate vertex buffer memory
 
-		// Find Free Page
-		MemoryBlock* vertex_memory_block = AllocateMemory(m_vertex_heap_start_block, num_vertices*vertex_size, vertex_size);
+		util::TLSFAllocator::Block* vertex_memory_block = AllocateOrGrow(false, num_vertices*vertex_size, vertex_size);
 
 		// Check if we found a page.
 		if (vertex_memory_block == nullptr)
 		{
-			LOGW("Allocating memory for vertex buffer failed, trying to defragment.");
-			DefragmentVertexHeap();
-			vertex_memory_block = AllocateMemory(m_vertex_heap_start_block, num_vertices*vertex_size, vertex_size);
-			if (vertex_memory_block == nullptr)
-			{
-				LOGW("Defragmenting failed, allocating more memory.");
-				ResizeVertexHeap(std::max(GetVertexHeapSize() + vertex_size * (num_vertices + 1), GetVertexHeapSize() * 2));
-				vertex_memory_block = AllocateMemory(m_vertex_heap_start_block, num_vertices*vertex_size, vertex_size);
-				if (vertex_memory_block == nullptr)
-				{
-					LOGE("Allocating memory for vertex buffer failed.");
-					delete mesh;
-					return nullptr;
-				}
-			}
+			LOGE("Allocating memory for vertex buffer failed.");
+			delete mesh;
+			return nullptr;
 		}
 		
 		//Repeat the same procedure as before, but now for the index buffer
-		MemoryBlock* index_memory_block = AllocateMemory(m_index_heap_start_block, num_indices*index_size, index_size);
+		util::TLSFAllocator::Block* index_memory_block = AllocateOrGrow(true, num_indices*index_size, index_size);
 
 		// Check if we found a page.
 		if (index_memory_block == nullptr)
 		{
-			LOGW("Allocating memory for index buffer failed, trying to defragment.");
-			DefragmentIndexHeap();
-			index_memory_block = AllocateMemory(m_index_heap_start_block, num_indices*index_size, index_size);
-			if (index_memory_block == nullptr)
-			{
-				LOGW("Defragmenting failed, allocating more memory.");
-				ResizeIndexHeap(std::max(GetIndexHeapSize() + index_size * (num_indices + 1), GetIndexHeapSize() * 2));
-				index_memory_block = AllocateMemory(m_index_heap_start_block, num_indices*index_size, index_size);
-				if (index_memory_block == nullptr)
-				{
-					LOGE("Allocating memory for index buffer failed.");
-					FreeMemory(m_vertex_heap_start_block, vertex_memory_block);
-					delete mesh;
-					return nullptr;
-				}
-			}
+			LOGE("Allocating memory for index buffer failed.");
+			m_vertex_heap_allocator.Free(vertex_memory_block);
+			delete mesh;
+			return nullptr;
 		}
 
 		//Store the offset of the allocated memory from the start of the staging buffer
@@ -1509,6 +978,7 @@ namespace wr
 		mesh->m_vertex_staging_buffer_stride = vertex_size;
 		mesh->m_vertex_count = num_vertices;
 		mesh->m_vertex_memory_block = vertex_memory_block;
+		vertex_memory_block->m_user_data = mesh;
 
 		mesh->m_vertex_buffer_base_address = m_vertex_buffer->m_gpu_address;
 
@@ -1518,29 +988,18 @@ namespace wr
 		//Store the offset of the allocated memory from the start of the staging buffer
 		mesh->m_index_staging_buffer_offset = SizeAlignAnyAlignment(index_memory_block->m_offset, index_size) / index_size;
 		mesh->m_index_staging_buffer_size = num_indices * index_size;
+		mesh->m_index_staging_buffer_stride = index_size;
 		mesh->m_index_count = num_indices;
 		mesh->m_index_memory_block = index_memory_block;
+		index_memory_block->m_user_data = mesh;
 
 		mesh->m_index_buffer_base_address = m_index_buffer->m_gpu_address;
 
 		//Send the index data to the index staging buffer
 		d3d12::UpdateStagingBuffer(m_index_buffer, indices_data, num_indices*index_size, mesh->m_index_staging_buffer_offset * index_size);
-		
-		internal::StageCommand* vertex_command = new internal::StageCommand;
-		vertex_command->m_type = internal::CommandType::STAGE;
-		vertex_command->m_buffer = m_vertex_buffer;
-		vertex_command->m_offset = mesh->m_vertex_staging_buffer_offset * mesh->m_vertex_staging_buffer_stride;
-		vertex_command->m_size = mesh->m_vertex_staging_buffer_size;
 
-		m_command_queue.push(vertex_command);
-		
-		internal::StageCommand* index_command = new internal::StageCommand;
-		index_command->m_type = internal::CommandType::STAGE;
-		index_command->m_buffer = m_index_buffer;
-		index_command->m_offset = mesh->m_index_staging_buffer_offset * index_size;
-		index_command->m_size = mesh->m_index_staging_buffer_size;
-
-		m_command_queue.push(index_command);
+		QueueStage(m_vertex_buffer, mesh->m_vertex_staging_buffer_offset * mesh->m_vertex_staging_buffer_stride, mesh->m_vertex_staging_buffer_size);
+		QueueStage(m_index_buffer, mesh->m_index_staging_buffer_offset * index_size, mesh->m_index_staging_buffer_size);
 
 		return mesh;
 	}
@@ -1552,25 +1011,15 @@ namespace wr
 
 		//Allocate vertex buffer memory
 		
-		MemoryBlock* vertex_memory_block = AllocateMemory(m_vertex_heap_start_block, num_vertices*vertex_size, vertex_size);
+		util::TLSFAllocator::Block* vertex_memory_block = AllocateOrGrow(false, num_vertices*vertex_size, vertex_size);
 
-		//The loop has exited, see if we've found enough free pages
+		//See if we've found enough free pages
 		if (vertex_memory_block == nullptr)
 		{
-			DefragmentVertexHeap();
-			vertex_memory_block = AllocateMemory(m_vertex_heap_start_block, num_vertices*vertex_size, vertex_size);
-			if (vertex_memory_block == nullptr)
-			{
-				ResizeVertexHeap(std::max(GetVertexHeapSize() + (num_vertices + 1) * vertex_size, GetVertexHeapSize() * 2));
-				vertex_memory_block = AllocateMemory(m_vertex_heap_start_block, num_vertices*vertex_size, vertex_size);
-				if (vertex_memory_block == nullptr)
-				{
-					//We haven't found enough pages, so delete the mesh and return a nullptr
-					LOGE("Allocating memory for vertex buffer failed.");
-					delete mesh;
-					return nullptr;
-				}
-			}
+			//We haven't found enough pages, so delete the mesh and return a nullptr
+			LOGE("Allocating memory for vertex buffer failed.");
+			delete mesh;
+			return nullptr;
 		}
 
 		//Store the offset of the allocated memory from the start of the staging buffer
@@ -1579,23 +1028,39 @@ namespace wr
 		mesh->m_vertex_staging_buffer_stride = vertex_size;
 		mesh->m_vertex_count = num_vertices;
 		mesh->m_vertex_memory_block = vertex_memory_block;
+		vertex_memory_block->m_user_data = mesh;
 
 		mesh->m_vertex_buffer_base_address = m_vertex_buffer->m_gpu_address;
 
 		//Send the vertex data to the vertex staging buffer
 		d3d12::UpdateStagingBuffer(m_vertex_buffer, vertices_data, num_vertices*vertex_size, mesh->m_vertex_staging_buffer_offset*vertex_size);
 
-		internal::StageCommand* vertex_command = new internal::StageCommand;
-		vertex_command->m_type = internal::CommandType::STAGE;
-		vertex_command->m_buffer = m_vertex_buffer;
-		vertex_command->m_offset = mesh->m_vertex_staging_buffer_offset * mesh->m_vertex_staging_buffer_stride;
-		vertex_command->m_size = mesh->m_vertex_staging_buffer_size;
-
-		m_command_queue.push(vertex_command);
+		QueueStage(m_vertex_buffer, mesh->m_vertex_staging_buffer_offset * mesh->m_vertex_staging_buffer_stride, mesh->m_vertex_staging_buffer_size);
 
 		return mesh;
 	}
 
+	bool D3D12ModelPool::HasSameContent(internal::MeshInternal* mesh, void const * vertices_data, std::size_t num_vertices, std::size_t vertex_size, void const * indices_data, std::size_t num_indices, std::size_t index_size)
+	{
+		auto mesh_data = static_cast<internal::D3D12MeshInternal*>(mesh);
+
+		std::size_t const index_count = indices_data != nullptr ? num_indices : 0;
+		if (mesh_data->m_vertex_count != num_vertices || mesh_data->m_vertex_staging_buffer_stride != vertex_size
+			|| mesh_data->m_index_count != index_count || (index_count > 0 && mesh_data->m_index_staging_buffer_stride != index_size))
+		{
+			return false;
+		}
+
+		// The staging buffers keep a CPU copy of everything, a pending defragmentation move leaves the old location intact until it retires
+		if (memcmp(m_vertex_buffer->m_cpu_address + mesh_data->m_vertex_staging_buffer_offset * vertex_size, vertices_data, num_vertices * vertex_size) != 0)
+		{
+			return false;
+		}
+
+		return index_count == 0
+			|| memcmp(m_index_buffer->m_cpu_address + mesh_data->m_index_staging_buffer_offset * index_size, indices_data, index_count * index_size) == 0;
+	}
+
 	void D3D12ModelPool::UpdateMeshData(Mesh * mesh, void * vertices_data, std::size_t num_vertices, std::size_t vertex_size, void * indices_data, std::size_t num_indices, std::size_t index_size)
 	{
 		UpdateMeshVertexData(mesh, vertices_data, num_vertices, vertex_size);
@@ -1605,17 +1070,13 @@ namespace wr
 	void D3D12ModelPool::UpdateMeshVertexData(Mesh * mesh, void * vertices_data, std::size_t num_vertices, std::size_t vertex_size)
 	{
 		internal::D3D12MeshInternal* mesh_data = GetMeshData(mesh->id);
+		CancelPendingMoves(mesh_data);
+
 		if (vertex_size == mesh_data->m_vertex_staging_buffer_stride&&num_vertices == mesh_data->m_vertex_count)
 		{
 			d3d12::UpdateStagingBuffer(m_vertex_buffer, vertices_data, num_vertices*vertex_size, mesh_data->m_vertex_staging_buffer_offset*vertex_size);
 
-			internal::StageCommand* vertex_command = new internal::StageCommand;
-			vertex_command->m_type = internal::STAGE;
-			vertex_command->m_buffer = m_vertex_buffer;
-			vertex_command->m_offset = mesh_data->m_vertex_staging_buffer_offset*vertex_size;
-			vertex_command->m_size = mesh_data->m_vertex_staging_buffer_size;
-
-			m_command_queue.push(vertex_command);
+			QueueStage(m_vertex_buffer, mesh_data->m_vertex_staging_buffer_offset*vertex_size, mesh_data->m_vertex_staging_buffer_size);
 		}
 		else
 		{
@@ -1628,26 +1089,17 @@ namespace wr
 				LOGW("New vertex count is larger than old vertex count.");
 			}
 
-			FreeMemory(m_vertex_heap_start_block, static_cast<MemoryBlock*>(mesh_data->m_vertex_memory_block));
+			m_vertex_heap_allocator.Free(static_cast<util::TLSFAllocator::Block*>(mesh_data->m_vertex_memory_block));
 
-			MemoryBlock* new_block = AllocateMemory(m_vertex_heap_start_block, num_vertices*vertex_size, vertex_size);
+			util::TLSFAllocator::Block* new_block = AllocateOrGrow(false, num_vertices*vertex_size, vertex_size);
 
 			if (new_block == nullptr)
 			{
-				DefragmentVertexHeap();
-				new_block = AllocateMemory(m_vertex_heap_start_block, num_vertices*vertex_size, vertex_size);
-				if (new_block == nullptr)
-				{
-					ResizeVertexHeap(GetVertexHeapSize() + (num_vertices + 1) * vertex_size);
-					new_block = AllocateMemory(m_vertex_heap_start_block, num_vertices*vertex_size, vertex_size);
-					if (new_block == nullptr)
-					{
-						LOGE("Unable to allocate memory for edited mesh.");
-					}
-				}
+				LOGE("Unable to allocate memory for edited mesh.");
 			}
 
 			mesh_data->m_vertex_memory_block = new_block;
+			new_block->m_user_data = mesh_data;
 			mesh_data->m_vertex_staging_buffer_offset = SizeAlignAnyAlignment(new_block->m_offset, vertex_size) / vertex_size;
 			mesh_data->m_vertex_staging_buffer_size = num_vertices * vertex_size;
 			mesh_data->m_vertex_staging_buffer_stride = vertex_size;
@@ -1655,13 +1107,7 @@ namespace wr
 
 			d3d12::UpdateStagingBuffer(m_vertex_buffer, vertices_data, num_vertices*vertex_size, mesh_data->m_vertex_staging_buffer_offset*vertex_size);
 
-			internal::StageCommand* vertex_command = new internal::StageCommand;
-			vertex_command->m_type = internal::STAGE;
-			vertex_command->m_buffer = m_vertex_buffer;
-			vertex_command->m_offset = mesh_data->m_vertex_staging_buffer_offset*vertex_size;
-			vertex_command->m_size = mesh_data->m_vertex_staging_buffer_size;
-
-			m_command_queue.push(vertex_command);
+			QueueStage(m_vertex_buffer, mesh_data->m_vertex_staging_buffer_offset*vertex_size, mesh_data->m_vertex_staging_buffer_size);
 		}
 
 		mesh_data->data_changed = true;
@@ -1670,17 +1116,13 @@ namespace wr
 	void D3D12ModelPool::UpdateMeshIndexData(Mesh * mesh, void * indices_data, std::size_t num_indices, std::size_t indices_size)
 	{
 		internal::D3D12MeshInternal* mesh_data = GetMeshData(mesh->id);
-		if (num_indices == mesh_data->m_index_count)
+		CancelPendingMoves(mesh_data);
+
+		if (num_indices == mesh_data->m_index_count && indices_size == mesh_data->m_index_staging_buffer_stride)
 		{
 			d3d12::UpdateStagingBuffer(m_index_buffer, indices_data, num_indices*indices_size, mesh_data->m_index_staging_buffer_offset*indices_size);
 
-			internal::StageCommand* index_command = new internal::StageCommand;
-			index_command->m_type = internal::STAGE;
-			index_command->m_buffer = m_index_buffer;
-			index_command->m_offset = mesh_data->m_index_staging_buffer_offset*indices_size;
-			index_command->m_size = mesh_data->m_index_staging_buffer_size;
-
-			m_command_queue.push(index_command);
+			QueueStage(m_index_buffer, mesh_data->m_index_staging_buffer_offset*indices_size, mesh_data->m_index_staging_buffer_size);
 		}
 		else
 		{
@@ -1693,39 +1135,25 @@ namespace wr
 				LOGW("New index count is larger than old index count.");
 			}
 
-			FreeMemory(m_index_heap_start_block, static_cast<MemoryBlock*>(mesh_data->m_index_memory_block));
+			m_index_heap_allocator.Free(static_cast<util::TLSFAllocator::Block*>(mesh_data->m_index_memory_block));
 
-			MemoryBlock* new_block = AllocateMemory(m_index_heap_start_block, num_indices*indices_size, indices_size);
+			util::TLSFAllocator::Block* new_block = AllocateOrGrow(true, num_indices*indices_size, indices_size);
 
 			if (new_block == nullptr)
 			{
-				DefragmentIndexHeap();
-				new_block = AllocateMemory(m_index_heap_start_block, num_indices*indices_size, indices_size);
-				if (new_block == nullptr)
-				{
-					ResizeIndexHeap(GetVertexHeapSize() + (num_indices + 1) * indices_size);
-					new_block = AllocateMemory(m_index_heap_start_block, num_indices*indices_size, indices_size);
-					if (new_block == nullptr)
-					{
-						LOGE("Unable to allocate memory for edited mesh.");
-					}
-				}
+				LOGE("Unable to allocate memory for edited mesh.");
 			}
 
 			mesh_data->m_index_memory_block = new_block;
+			new_block->m_user_data = mesh_data;
 			mesh_data->m_index_staging_buffer_offset = SizeAlignAnyAlignment(new_block->m_offset, indices_size) / indices_size;
 			mesh_data->m_index_staging_buffer_size = num_indices * indices_size;
+			mesh_data->m_index_staging_buffer_stride = indices_size;
 			mesh_data->m_index_count = num_indices;
 
 			d3d12::UpdateStagingBuffer(m_index_buffer, indices_data, num_indices*indices_size, mesh_data->m_index_staging_buffer_offset*indices_size);
 
-			internal::StageCommand* index_command = new internal::StageCommand;
-			index_command->m_type = internal::STAGE;
-			index_command->m_buffer = m_index_buffer;
-			index_command->m_offset = mesh_data->m_index_staging_buffer_offset*indices_size;
-			index_command->m_size = mesh_data->m_index_staging_buffer_size;
-
-			m_command_queue.push(index_command);
+			QueueStage(m_index_buffer, mesh_data->m_index_staging_buffer_offset*indices_size, mesh_data->m_index_staging_buffer_size);
 		}
 
 		mesh_data->data_changed = true;
@@ -1735,16 +1163,18 @@ namespace wr
 	{
 		for (auto& mesh : model->m_meshes)
 		{
-			DestroyMesh(m_loaded_meshes[mesh.first->id]);
+			// Deduplicated meshes are destroyed with the last model that uses them
+			if (ReleaseMesh(mesh.first->id))
+			{
+				DestroyMesh(mesh.first->id);
+			}
 			delete mesh.first;
 		}
 
-		std::vector<Model*>::iterator it = m_loaded_models.begin();
-		for (; (*it) != model && it != m_loaded_models.end(); ++it);
-
-		if (it != m_loaded_models.end())
+		// Models that failed to load were never added
+		if (Model** loaded = m_loaded_models.Find(model->m_id); loaded != nullptr && *loaded == model)
 		{
-			m_loaded_models.erase(it);
+			m_loaded_models.Erase(model->m_id);
 		}
 
 		if(model->m_owns_materials)
@@ -1758,278 +1188,75 @@ namespace wr
 		delete model;
 	}
 
-	void D3D12ModelPool::DestroyMesh(internal::MeshInternal * mesh)
+	void D3D12ModelPool::DestroyMesh(std::uint64_t mesh_id)
 	{
-		//Check for null pointers
+		//Check for destroyed meshes
+		internal::MeshInternal* mesh = FindMeshData(mesh_id);
 		if (mesh == nullptr)
 		{
-			LOGW("Tried to destroy a mesh that was a nullptr")
+			LOGW("Tried to destroy a mesh that doesn't exist")
 			return;
 		}
-		
-		std::map<std::uint64_t, internal::MeshInternal*>::iterator it;
-		for (it = m_loaded_meshes.begin(); it != m_loaded_meshes.end(); ++it)
-		{
-			if (it->second == mesh)
-				break;
-		}
 
-		if (it != m_loaded_meshes.end())
-		{
-			FreeID(it->first);
+		// Destroying the LODs erases from m_loaded_meshes, so the mesh data is looked up before
+		DestroyLODs(mesh_id);
+		FreeID(mesh_id);
 
-			m_loaded_meshes.erase(it);
+		internal::D3D12MeshInternal* n_mesh = static_cast<internal::D3D12MeshInternal*>(mesh);
 
-			internal::D3D12MeshInternal* n_mesh = static_cast<internal::D3D12MeshInternal*>(mesh);
+		CancelPendingMoves(n_mesh);
 
-			FreeMemory(m_vertex_heap_start_block, static_cast<MemoryBlock*>(n_mesh->m_vertex_memory_block));
+		m_vertex_heap_allocator.Free(static_cast<util::TLSFAllocator::Block*>(n_mesh->m_vertex_memory_block));
 
-			if (n_mesh->m_index_memory_block != nullptr)
-			{
-				FreeMemory(m_index_heap_start_block, static_cast<MemoryBlock*>(n_mesh->m_index_memory_block));
-			}
-
-			m_updated = true;
-
-			//Delete the mesh
-			delete mesh;
-		}
-	}
-
-	D3D12ModelPool::MemoryBlock * D3D12ModelPool::AllocateMemory(MemoryBlock * start_block, std::size_t size, std::size_t alignment)
-	{
-		while (start_block != nullptr) 
+		if (n_mesh->m_index_memory_block != nullptr)
 		{
-			if (start_block->m_size >= size + (start_block->m_offset%alignment == 0 ? 0 : (alignment - start_block->m_offset%alignment)) &&
-				start_block->m_free)
-			{
-				std::size_t needed_size = size + (start_block->m_offset%alignment == 0 ? 0 : (alignment - start_block->m_offset%alignment));
-
-				if (start_block->m_size == needed_size)
-				{
-					start_block->m_free = false;
-					start_block->m_alignment = alignment;
-					return start_block;
-				}
-				else
-				{
-					MemoryBlock* new_block = new MemoryBlock;
-					new_block->m_prev_block = start_block;
-					new_block->m_next_block = start_block->m_next_block;
-					start_block->m_next_block = new_block;
-					new_block->m_free = true;
-					new_block->m_size = start_block->m_size - needed_size;
-					new_block->m_offset = start_block->m_offset + needed_size;
-
-					if (new_block->m_next_block != nullptr) 
-					{
-						new_block->m_next_block->m_prev_block = new_block;
-					}
-
-					start_block->m_free = false;
-					start_block->m_size = needed_size;
-					start_block->m_alignment = alignment;
-					return start_block;
-				}
-			}
-			else
-			{
-				start_block = start_block->m_next_block;
-			}
+			m_index_heap_allocator.Free(static_cast<util::TLSFAllocator::Block*>(n_mesh->m_index_memory_block));
 		}
-		return nullptr;
-	}
 
-	void D3D12ModelPool::FreeMemory(MemoryBlock * heap_start_block, MemoryBlock * block)
-	{
-		MemoryBlock* heap_block = heap_start_block;
-		while (heap_block != nullptr)
-		{
-			if (heap_block == block) 
-			{
-				if (heap_block->m_prev_block != nullptr)
-				{
-					if (heap_block->m_prev_block->m_free)
-					{
-						heap_block->m_prev_block->m_size += heap_block->m_size;
-						if (heap_block->m_next_block != nullptr)
-						{
-							if (heap_block->m_next_block->m_free)
-							{
-								heap_block->m_prev_block->m_size += heap_block->m_next_block->m_size;
-								heap_block->m_prev_block->m_next_block = heap_block->m_next_block->m_next_block;
-								if (heap_block->m_prev_block->m_next_block != nullptr)
-								{
-									heap_block->m_prev_block->m_next_block->m_prev_block = heap_block->m_prev_block;
-								}
-
-								delete heap_block->m_next_block;
-								delete heap_block;
-								return;
-							}
-							else
-							{
-								heap_block->m_next_block->m_prev_block = heap_block->m_prev_block;
-								heap_block->m_prev_block->m_next_block = heap_block->m_next_block;
-
-								delete heap_block;
-								return;
-							}
-						}
-						else
-						{
-							heap_block->m_prev_block->m_next_block = heap_block->m_next_block;
-							delete heap_block;
-							return;
-						}
-					}
-					else
-					{
-						if (heap_block->m_next_block != nullptr)
-						{
-							if (heap_block->m_next_block->m_free)
-							{
-								MemoryBlock* temp = heap_block->m_next_block;
-								heap_block->m_size += heap_block->m_next_block->m_size;
-								heap_block->m_next_block = heap_block->m_next_block->m_next_block;
-								if (heap_block->m_next_block != nullptr)
-								{
-									heap_block->m_next_block->m_prev_block = heap_block;
-								}
-
-								delete temp;
-							}
-							else
-							{
-								heap_block->m_free = true;
-								return;
-							}
-						}
-						else
-						{
-							heap_block->m_free = true;
-							return;
-						}
-					}
-				}
-				else
-				{
-					if (heap_block->m_next_block != nullptr)
-					{
-						if (heap_block->m_next_block->m_free)
-						{
-							MemoryBlock* temp = heap_block->m_next_block;
-							heap_block->m_size += heap_block->m_next_block->m_size;
-							heap_block->m_next_block = heap_block->m_next_block->m_next_block;
-							if (heap_block->m_next_block != nullptr)
-							{
-								heap_block->m_next_block->m_prev_block = heap_block;
-							}
-
-							delete temp;
-						}
-						else
-						{
-							heap_block->m_free = true;
-							return;
-						}
-					}
-					else
-					{
-						heap_block->m_free = true;
-						return;
-					}
-				}
-			}
-			else
-			{
-				heap_block = heap_block->m_next_block;
-			}
-		}
+		m_updated = true;
+
+		//Delete the mesh
+		delete mesh;
 	}
 
 	size_t D3D12ModelPool::GetVertexHeapOccupiedSpace()
 	{
-		MemoryBlock* mem_block = m_vertex_heap_start_block;
-		size_t size = 0;
-		while (mem_block != nullptr)
-		{
-			if (!mem_block->m_free)
-			{
-				size += mem_block->m_size;
-			}
-			mem_block = mem_block->m_next_block;
-		}
-		return size;
+		return m_vertex_heap_allocator.GetUsedSize();
 	}
 
 	size_t D3D12ModelPool::GetIndexHeapOccupiedSpace()
 	{
-		MemoryBlock* mem_block = m_index_heap_start_block;
-		size_t size = 0;
-		while (mem_block != nullptr)
-		{
-			if (!mem_block->m_free)
-			{
-				size += mem_block->m_size;
-			}
-			mem_block = mem_block->m_next_block;
-		}
-		return size;
+		return m_index_heap_allocator.GetUsedSize();
 	}
 
 	size_t D3D12ModelPool::GetVertexHeapFreeSpace()
 	{
-		MemoryBlock* mem_block = m_vertex_heap_start_block;
-		size_t size = 0;
-		while (mem_block != nullptr)
-		{
-			if (mem_block->m_free)
-			{
-				size += mem_block->m_size;
-			}
-			mem_block = mem_block->m_next_block;
-		}
-		return size;
+		return m_vertex_heap_allocator.GetFreeSize();
 	}
 
 	size_t D3D12ModelPool::GetIndexHeapFreeSpace()
 	{
-		MemoryBlock* mem_block = m_index_heap_start_block;
-		size_t size = 0;
-		while (mem_block != nullptr)
-		{
-			if (mem_block->m_free)
-			{
-				size += mem_block->m_size;
-			}
-			mem_block = mem_block->m_next_block;
-		}
-		return size;
+		return m_index_heap_allocator.GetFreeSize();
 	}
 
 	size_t D3D12ModelPool::GetVertexHeapSize()
 	{
-		MemoryBlock* mem_block = m_vertex_heap_start_block;
-		size_t size = 0;
-		while (mem_block != nullptr)
-		{
-			size += mem_block->m_size;
-			mem_block = mem_block->m_next_block;
-		}
-		return size;
+		return m_vertex_heap_allocator.GetSize();
 	}
 
 	size_t D3D12ModelPool::GetIndexHeapSize()
 	{
-		MemoryBlock* mem_block = m_index_heap_start_block;
-		size_t size = 0;
-		while (mem_block != nullptr)
-		{
-			size += mem_block->m_size;
-			mem_block = mem_block->m_next_block;
-		}
-		return size;
+		return m_index_heap_allocator.GetSize();
+	}
+
+	float D3D12ModelPool::GetVertexHeapFragmentation()
+	{
+		return m_vertex_heap_allocator.GetFragmentation();
+	}
+
+	float D3D12ModelPool::GetIndexHeapFragmentation()
+	{
+		return m_index_heap_allocator.GetFragmentation();
 	}
 
 } /* wr */
\ No newline at end of file
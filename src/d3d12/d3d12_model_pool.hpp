@@ -16,9 +16,12 @@
 #pragma once
 
 #include "../model_pool.hpp"
+#include "../util/tlsf_allocator.hpp"
+#include "../util/ring_buffer.hpp"
+#include "../util/range_coalescer.hpp"
 #include "d3d12_structs.hpp"
 
-#include <queue>
+#include <vector>
 
 namespace wr::d3d12
 {
@@ -45,6 +48,7 @@ namespace wr
 			std::size_t m_index_staging_buffer_offset;
 			std::size_t m_index_count_offset;
 			std::size_t m_index_staging_buffer_size;
+			std::size_t m_index_staging_buffer_stride;
 			std::size_t m_index_count;
 			void* m_index_memory_block;
 
@@ -59,19 +63,14 @@ namespace wr
 			TRANSITION,
 		};
 
-		struct Command
-		{
-			CommandType m_type;
-		};
-
-		struct StageCommand : Command
+		struct StageCommand
 		{
 			d3d12::StagingBuffer* m_buffer;
 			std::size_t m_size;
 			std::size_t m_offset;
 		};
 
-		struct CopyCommand : Command
+		struct CopyCommand
 		{
 			ID3D12Resource* m_source;
 			ID3D12Resource* m_dest;
@@ -80,19 +79,32 @@ namespace wr
 			std::size_t m_dest_offset;
 		};
 
-		struct ReadCommand : Command
+		struct ReadCommand
 		{
 			d3d12::StagingBuffer* m_buffer;
 			std::size_t m_size;
 			std::size_t m_offset;
 		};
 
-		struct TransitionCommand : Command
+		struct TransitionCommand
 		{
 			ID3D12Resource* m_buffer;
 			ResourceState m_old_state;
 			ResourceState m_new_state;
 		};
+
+		// Commands are stored by value in a ring buffer, so queueing them doesn't allocate
+		struct Command
+		{
+			CommandType m_type;
+			union
+			{
+				StageCommand m_stage;
+				CopyCommand m_copy;
+				ReadCommand m_read;
+				TransitionCommand m_transition;
+			};
+		};
 	}
 
 	class D3D12ModelPool : public ModelPool
@@ -121,11 +133,18 @@ namespace wr
 		void ShrinkIndexHeapToFit() final;
 
 		// Removes any holes in the memory, stitching all allocations back together to maximize the amount of contiguous free space.
-		// These functions are called automatically if the allocator has enough free space but no large enough free blocks.
+		// This copies every allocation in one go; a failed allocation grows the heap instead and leaves the holes to DefragmentIncremental.
 		void Defragment() final;
 		void DefragmentVertexHeap() final;
 		void DefragmentIndexHeap() final;
 
+		// Moves allocations from the end of the heaps into earlier holes, copying at most the defragmentation budget per frame.
+		// The meshes keep using their old location until RetireDefragmentMoves is called for the same frame index.
+		void DefragmentIncremental(unsigned int frame_idx);
+		// Call once the fence of the frame is signaled; patches the mesh offsets, frees the old locations and replaced intermediate buffers.
+		void RetireDefragmentMoves(unsigned int frame_idx);
+		void SetDefragmentationBudget(std::size_t budget) { m_defrag_budget = budget; };
+
 		size_t GetVertexHeapOccupiedSpace() final;
 		size_t GetIndexHeapOccupiedSpace() final;
 
@@ -135,6 +154,9 @@ namespace wr
 		size_t GetVertexHeapSize() final;
 		size_t GetIndexHeapSize() final;
 
+		float GetVertexHeapFragmentation() final;
+		float GetIndexHeapFragmentation() final;
+
 		// Resizes both heaps to the supplied sizes. 
 		// If the supplied size is smaller than the required size the heaps will resize to the required size instead.
 		void Resize(size_t vertex_heap_new_size, size_t index_heap_new_size) final;
@@ -151,38 +173,66 @@ namespace wr
 	private:
 		internal::MeshInternal* LoadCustom_VerticesAndIndices(void* vertices_data, std::size_t num_vertices, std::size_t vertex_size, void* indices_data, std::size_t num_indices, std::size_t index_size) final;
 		internal::MeshInternal* LoadCustom_VerticesOnly(void* vertices_data, std::size_t num_vertices, std::size_t vertex_size) final;
+		bool HasSameContent(internal::MeshInternal* mesh, void const * vertices_data, std::size_t num_vertices, std::size_t vertex_size, void const * indices_data, std::size_t num_indices, std::size_t index_size) final;
 
 		virtual void UpdateMeshData(Mesh* mesh, void* vertices_data, std::size_t num_vertices, std::size_t vertex_size, void* indices_data, std::size_t num_indices, std::size_t index_size) final;
 
-		void UpdateMeshVertexData(Mesh* mesh, void* vertices_data, std::size_t num_vertices, std::size_t vertex_size);
+		void UpdateMeshVertexData(Mesh* mesh, void* vertices_data, std::size_t num_vertices, std::size_t vertex_size) final;
 		void UpdateMeshIndexData(Mesh* mesh, void* indices_data, std::size_t num_indices, std::size_t indices_size);
 
 		void DestroyModel(Model* model) final;
-		void DestroyMesh(internal::MeshInternal* mesh) final;
-
-		d3d12::StagingBuffer* m_vertex_buffer;
-		d3d12::StagingBuffer* m_index_buffer;
+		void DestroyMesh(std::uint64_t mesh_id) final;
 
-		struct MemoryBlock
+		struct PendingMove
 		{
-			MemoryBlock* m_prev_block;
-			MemoryBlock* m_next_block;
-			std::size_t m_size;
-			std::size_t m_offset;
-			std::size_t m_alignment;
-			bool m_free;
+			internal::D3D12MeshInternal* m_mesh;
+			util::TLSFAllocator::Block* m_old_block;
+			util::TLSFAllocator::Block* m_new_block;
+			bool m_index_heap;
+			unsigned int m_frame_idx;
 		};
 
-		MemoryBlock* m_vertex_heap_start_block;
-		MemoryBlock* m_index_heap_start_block;
+		// Allocates from one of the heaps, growing it when no free block is large enough.
+		util::TLSFAllocator::Block* AllocateOrGrow(bool index_heap, std::size_t size, std::size_t alignment);
+
+		std::size_t DefragmentHeapIncremental(util::TLSFAllocator& allocator, d3d12::StagingBuffer* buffer, bool index_heap, std::size_t budget, unsigned int frame_idx);
+		// Drops the moves of a mesh, or all moves when mesh is nullptr, leaving the meshes at their old location.
+		void CancelPendingMoves(internal::D3D12MeshInternal* mesh);
+
+		void QueueCopyStateTransition(d3d12::StagingBuffer* buffer, bool to_copy_source);
+		void ReserveIntermediateBuffer(std::size_t size);
+		void QueueBufferMove(d3d12::StagingBuffer* buffer, std::size_t old_offset, std::size_t new_offset, std::size_t size);
+
+		void QueueStage(d3d12::StagingBuffer* buffer, std::size_t offset, std::size_t size);
+		void QueueCopy(ID3D12Resource* source, std::size_t source_offset, ID3D12Resource* dest, std::size_t dest_offset, std::size_t size);
+		void QueueTransition(ID3D12Resource* buffer, ResourceState old_state, ResourceState new_state);
+		// Points queued copies and transitions at a resource that replaced another one
+		void ReplaceQueuedResource(ID3D12Resource* old_resource, ID3D12Resource* new_resource);
 
-		MemoryBlock* AllocateMemory(MemoryBlock* start_block, std::size_t size, std::size_t alignment);
-		void FreeMemory(MemoryBlock* heap_start_block,  MemoryBlock* block);
+		// Records a run of stage commands as merged copies, with one barrier batch before and after
+		void FlushStages(d3d12::CommandList* cmd_list);
+		void FlushBarriers(d3d12::CommandList* cmd_list);
+
+		d3d12::StagingBuffer* m_vertex_buffer;
+		d3d12::StagingBuffer* m_index_buffer;
+
+		// Offsets in the vertex and index buffers are handed out by these, the mesh data points to its block
+		util::TLSFAllocator m_vertex_heap_allocator;
+		util::TLSFAllocator m_index_heap_allocator;
 		
-		std::queue<internal::Command*> m_command_queue;
+		util::RingBuffer<internal::Command> m_command_queue;
+
+		// Scratch memory of StageMeshes, kept around between frames
+		util::RangeCoalescer m_stage_ranges;
+		std::vector<D3D12_RESOURCE_BARRIER> m_barriers;
 
 		ID3D12Resource* m_intermediate_buffer;
 		std::size_t m_intermediate_size;
+		// Intermediate buffers that were replaced by a larger one, released once the frame that recorded them is done
+		std::array<std::vector<ID3D12Resource*>, d3d12::settings::num_back_buffers> m_intermediate_releases;
+
+		std::vector<PendingMove> m_pending_moves;
+		std::size_t m_defrag_budget;
 
 		std::uint64_t m_vertex_buffer_size;
 		std::uint64_t m_index_buffer_size;
@@ -45,6 +45,9 @@
 
 #include <iostream>
 #include <string>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace wr
 {
@@ -214,6 +217,12 @@ namespace wr
 			pool->UnloadTextures(frame_idx);
 		}
 
+		//Defragmentation copies recorded for this frame index are done, switch the meshes over to their new location.
+		for (auto pool : m_model_pools)
+		{
+			pool->RetireDefragmentMoves(frame_idx);
+		}
+
 		// Perform reload requests
 		{
 			// Root Signatures
@@ -268,6 +277,12 @@ namespace wr
 
 		PreparePreRenderCommands(clear_frame_buffer, frame_idx);
 
+		// With double buffering the application commits at its own sync point.
+		if (!scene_graph.GetDoubleBufferingEnabled())
+		{
+			scene_graph.Commit();
+		}
+
 		scene_graph.Update();
 		scene_graph.Optimize();
 
@@ -1011,6 +1026,8 @@ namespace wr
 
 		for (int i = 0; i < m_model_pools.size(); ++i)
 		{
+			m_model_pools[i]->FinalizeAsyncLoads();
+			m_model_pools[i]->DefragmentIncremental(frame_idx);
 			m_model_pools[i]->StageMeshes(m_direct_cmd_list);
 		}
 
@@ -1024,6 +1041,10 @@ namespace wr
 
 	void D3D12RenderSystem::Update_MeshNodes(std::vector<std::shared_ptr<MeshNode>>& nodes)
 	{
+		m_dirty_mesh_nodes.clear();
+		m_dirty_mesh_boxes.clear();
+		m_dirty_mesh_transforms.clear();
+
 		for (auto& node : nodes)
 		{
 			if (!node->RequiresUpdate(GetFrameIdx()))
@@ -1031,7 +1052,18 @@ namespace wr
 				continue;
 			}
 
-			node->Update(GetFrameIdx());
+			m_dirty_mesh_nodes.push_back(node.get());
+			m_dirty_mesh_boxes.push_back(node->m_render_model->m_box);
+			m_dirty_mesh_transforms.push_back(node->m_transform);
+		}
+
+		m_dirty_mesh_aabbs.resize(m_dirty_mesh_nodes.size());
+		AABB::FromTransforms(m_dirty_mesh_boxes.data(), m_dirty_mesh_transforms.data(), m_dirty_mesh_aabbs.data(), m_dirty_mesh_nodes.size());
+
+		for (std::size_t i = 0; i < m_dirty_mesh_nodes.size(); ++i)
+		{
+			m_dirty_mesh_nodes[i]->m_aabb = m_dirty_mesh_aabbs[i];
+			m_dirty_mesh_nodes[i]->SignalUpdate(GetFrameIdx());
 		}
 	}
 
@@ -1121,12 +1153,15 @@ namespace wr
 			auto d3d12_cb_handle = static_cast<D3D12ConstantBufferHandle*>(batch.batch_buffer);
 			d3d12::BindConstantBuffer(n_cmd_list, d3d12_cb_handle->m_native, 1, GetFrameIdx());
 
+			float const lod_error = d3d12::settings::enable_lod_selection ? GetLODErrorBudget(model, batch, camera) : 0.f;
+
 			//Render meshes
 			for (std::size_t mesh_i = 0; mesh_i < model->m_meshes.size(); mesh_i++)
 			{
 				auto mesh = model->m_meshes[mesh_i];
-				auto n_mesh = static_cast<D3D12ModelPool*>(model->m_model_pool)->GetMeshData(mesh.first->id);
-				if (model->m_model_pool != m_bound_model_pool || n_mesh->m_vertex_staging_buffer_stride != m_bound_model_pool_stride)
+				std::uint64_t const mesh_id = model->m_model_pool->SelectLOD(mesh.first->id, lod_error);
+				auto n_mesh = static_cast<D3D12ModelPool*>(model->m_model_pool)->GetMeshData(mesh_id);
+				if (model->m_model_pool != m_bound_model_pool || n_mesh->m_vertex_staging_buffer_stride != m_bound_model_pool_stride || n_mesh->m_index_staging_buffer_stride != m_bound_model_pool_index_stride)
 				{
 					D3D12ModelPool* model_pool = static_cast<D3D12ModelPool*>(model->m_model_pool);
 
@@ -1139,10 +1174,12 @@ namespace wr
 					d3d12::BindIndexBuffer(n_cmd_list,
 						model_pool->GetIndexStagingBuffer(),
 						0,
-						static_cast<std::uint32_t>(model_pool->GetIndexStagingBuffer()->m_size));
+						static_cast<std::uint32_t>(model_pool->GetIndexStagingBuffer()->m_size),
+						static_cast<std::uint32_t>(n_mesh->m_index_staging_buffer_stride));
 
 					m_bound_model_pool = static_cast<D3D12ModelPool*>(model->m_model_pool);
 					m_bound_model_pool_stride = n_mesh->m_vertex_staging_buffer_stride;
+					m_bound_model_pool_index_stride = n_mesh->m_index_staging_buffer_stride;
 				}
 
 				d3d12::BindDescriptorHeaps(n_cmd_list);
@@ -1161,7 +1198,15 @@ namespace wr
 					BindMaterial(material_handle, cmd_list);
 				}
 
-				if (n_mesh->m_index_count != 0)
+				// Meshlets can only be culled per instance, so batches with several instances are drawn whole
+				auto const * meshlets = model->m_model_pool->GetMeshlets(mesh_id);
+				if (d3d12::settings::enable_meshlet_culling && meshlets != nullptr && n_mesh->m_index_count != 0 && batch.num_instances == 1)
+				{
+					DrawVisibleMeshlets(n_cmd_list, *meshlets, batch.data.objects[0].m_model, camera,
+						static_cast<std::uint32_t>(n_mesh->m_index_staging_buffer_offset),
+						static_cast<std::uint32_t>(n_mesh->m_vertex_staging_buffer_offset));
+				}
+				else if (n_mesh->m_index_count != 0)
 				{
 					d3d12::DrawIndexed(n_cmd_list,
 						static_cast<std::uint32_t>(n_mesh->m_index_count),
@@ -1185,6 +1230,99 @@ namespace wr
 
 	}
 
+	float D3D12RenderSystem::GetLODErrorBudget(Model* model, temp::MeshBatch const & batch, CameraNode* camera) const
+	{
+		// Orthographic views don't get smaller with distance
+		if (camera->m_enable_orthographic || batch.num_instances == 0)
+		{
+			return 0.f;
+		}
+
+		DirectX::XMVECTOR const camera_position = camera->m_inverse_view.r[3];
+		float const radius = DirectX::XMVectorGetX(DirectX::XMVector3Length(model->m_box.m_extents));
+		float const view_height_per_unit = 2.f * std::tan(camera->m_fov.m_fov * 0.5f);
+
+		float budget = std::numeric_limits<float>::max();
+
+		for (unsigned int i = 0; i < batch.num_instances; ++i)
+		{
+			DirectX::XMMATRIX const transform = DirectX::XMLoadFloat3x4(&batch.data.objects[i].m_model);
+
+			float const scale = std::max({
+				DirectX::XMVectorGetX(DirectX::XMVector3Length(transform.r[0])),
+				DirectX::XMVectorGetX(DirectX::XMVector3Length(transform.r[1])),
+				DirectX::XMVectorGetX(DirectX::XMVector3Length(transform.r[2])) });
+
+			if (scale <= 0.f)
+			{
+				continue;
+			}
+
+			// Distance to the nearest point of the bounding sphere, so a camera inside the model always gets the full mesh
+			DirectX::XMVECTOR const center = DirectX::XMVector3Transform(model->m_box.m_center, transform);
+			float const distance = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(center, camera_position))) - radius * scale;
+			if (distance <= camera->m_frustum_near)
+			{
+				return 0.f;
+			}
+
+			budget = std::min(budget, d3d12::settings::lod_screen_error * distance * view_height_per_unit / scale);
+		}
+
+		return budget == std::numeric_limits<float>::max() ? 0.f : budget;
+	}
+
+	void D3D12RenderSystem::DrawVisibleMeshlets(d3d12::CommandList* cmd_list, std::vector<util::Meshlet> const & meshlets, DirectX::XMFLOAT3X4 const & transform, CameraNode* camera,
+		std::uint32_t index_start, std::uint32_t vertex_start)
+	{
+		// Cull in object space, so the meshlet bounds don't have to be transformed
+		DirectX::XMMATRIX const model = DirectX::XMLoadFloat3x4(&transform);
+		DirectX::XMMATRIX const model_transposed = DirectX::XMMatrixTranspose(model);
+
+		float planes[6][4];
+		for (std::size_t i = 0; i < camera->m_planes.size(); ++i)
+		{
+			DirectX::XMVECTOR plane = DirectX::XMPlaneNormalize(DirectX::XMPlaneTransform(camera->m_planes[i], model_transposed));
+			DirectX::XMStoreFloat4(reinterpret_cast<DirectX::XMFLOAT4*>(planes[i]), plane);
+		}
+
+		float camera_position[3];
+		DirectX::XMVECTOR const world_position = camera->m_inverse_view.r[3];
+		DirectX::XMStoreFloat3(reinterpret_cast<DirectX::XMFLOAT3*>(camera_position), DirectX::XMVector3Transform(world_position, DirectX::XMMatrixInverse(nullptr, model)));
+
+		std::uint32_t run_start = 0;
+		std::uint32_t run_count = 0;
+
+		for (util::Meshlet const & meshlet : meshlets)
+		{
+			bool const visible = util::MeshletInFrustum(meshlet, planes) &&
+				!(d3d12::settings::enable_meshlet_cone_culling && util::MeshletBackfacing(meshlet, camera_position));
+
+			if (visible && run_count != 0 && run_start + run_count == meshlet.m_index_offset)
+			{
+				run_count += meshlet.m_index_count;
+				continue;
+			}
+
+			if (run_count != 0)
+			{
+				d3d12::DrawIndexed(cmd_list, run_count, 1, index_start + run_start, vertex_start);
+				run_count = 0;
+			}
+
+			if (visible)
+			{
+				run_start = meshlet.m_index_offset;
+				run_count = meshlet.m_index_count;
+			}
+		}
+
+		if (run_count != 0)
+		{
+			d3d12::DrawIndexed(cmd_list, run_count, 1, index_start + run_start, vertex_start);
+		}
+	}
+
 	void D3D12RenderSystem::BindMaterial(MaterialHandle material_handle, CommandList* cmd_list)
 	{
 		auto n_cmd_list = static_cast<d3d12::CommandList*>(cmd_list);
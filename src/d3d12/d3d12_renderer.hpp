@@ -22,6 +22,7 @@
 #include "../scene_graph/scene_graph.hpp"
 #include "../scene_graph/light_node.hpp"
 #include "../vertex.hpp"
+#include "../util/meshlet.hpp"
 #include "d3d12_structs.hpp"
 
 
@@ -151,7 +152,9 @@ namespace wr
 			std::uint32_t emissive_id = 0u;
 			std::uint32_t ao_id = 0u;
 
-			std::uint32_t padding[2] = { 0u };
+			// The resident mip of every texture, 4 bits each in the order of the ids above. See D3D12TexturePool::GetResidentMip
+			std::uint32_t resident_mips = 0u;
+			std::uint32_t padding = 0u;
 			Material::MaterialData material_data;
 		};
 
@@ -160,6 +163,7 @@ namespace wr
 			std::uint32_t material_idx = 0u;
 			std::uint32_t idx_offset = 0u;
 			std::uint32_t vertex_offset = 0u;
+			std::uint32_t index_stride = 4u;
 		};
 
 
@@ -279,6 +283,7 @@ namespace wr
 		std::vector<std::shared_ptr<D3D12ModelPool>> m_model_pools;
 		D3D12ModelPool* m_bound_model_pool;
 		std::size_t m_bound_model_pool_stride;
+		std::size_t m_bound_model_pool_index_stride;
 
 		std::optional<wr::TextureHandle> m_brdf_lut = std::nullopt;
 		bool m_brdf_lut_generated = false;
@@ -294,6 +299,11 @@ namespace wr
 
 	private:
 		void ResetBatches(SceneGraph& sg);
+		//! The object space error a LOD of the model may have, so the nearest instance in the batch stays within lod_screen_error.
+		float GetLODErrorBudget(Model* model, temp::MeshBatch const & batch, CameraNode* camera) const;
+		//! Draws the meshlets of one instance that are in view of the camera, merging neighbouring visible meshlets into one draw.
+		void DrawVisibleMeshlets(d3d12::CommandList* cmd_list, std::vector<util::Meshlet> const & meshlets, DirectX::XMFLOAT3X4 const & transform, CameraNode* camera,
+			std::uint32_t index_start, std::uint32_t vertex_start);
 		void LoadPrimitiveShapes();
 		void CreateDefaultResources();
 
@@ -306,6 +316,12 @@ namespace wr
 
 		bool m_skybox_changed = false;
 
+		// Scratch arrays used to update the bounds of all dirty mesh nodes in one batch.
+		std::vector<MeshNode*> m_dirty_mesh_nodes;
+		std::vector<Box> m_dirty_mesh_boxes;
+		std::vector<DirectX::XMFLOAT3X4> m_dirty_mesh_transforms;
+		std::vector<AABB> m_dirty_mesh_aabbs;
+
 	};
 
 } /* wr */
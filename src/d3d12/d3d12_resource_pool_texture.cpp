@@ -54,13 +54,212 @@ SOFTWARE.
 #include "d3d12_structs.hpp"
 #include "../pipeline_registry.hpp"
 #include "d3d12_descriptors_allocations.hpp"
+#include "d3d12_texture_cache.hpp"
 
 #include <DirectXTex.h>
 #include <comdef.h>
+#include <algorithm>
+#include <cmath>
 
 
 namespace wr
 {
+	namespace
+	{
+		//! WIC needs COM on every thread that decodes with it, so the decode threads initialize it before their first image.
+		void InitializeCOMForThread()
+		{
+			thread_local bool initialized = false;
+
+			if (!initialized)
+			{
+				// Threads that already initialized COM with another concurrency model keep using it
+				CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+				initialized = true;
+			}
+		}
+
+		//! Decodes an image file with the DirectXTex loader that matches its extension, logs why when it can't.
+		bool DecodeTextureFile(std::string_view path, DirectX::ScratchImage& image)
+		{
+			InitializeCOMForThread();
+
+			std::optional<std::string_view> extension = util::GetFileExtension(path);
+			std::wstring wide_string(path.begin(), path.end());
+
+			if (!extension.has_value())
+			{
+				LOGE("Texture {} not loaded. Format not supported.", path);
+				return false;
+			}
+
+			std::string_view ext_int = extension.value();
+			HRESULT hr = S_OK;
+
+			if (ext_int.find("png") != std::string_view::npos
+				|| ext_int.find("jpeg") != std::string_view::npos
+				|| ext_int.find("jpg") != std::string_view::npos
+				|| ext_int.find("bmp") != std::string_view::npos)
+			{
+				hr = LoadFromWICFile(wide_string.c_str(),
+					DirectX::WIC_FLAGS_NONE, nullptr, image);
+			}
+			else if (ext_int.find("dds") != std::string_view::npos)
+			{
+				hr = LoadFromDDSFile(wide_string.c_str(),
+					DirectX::DDS_FLAGS_NONE, nullptr, image);
+			}
+			else if (ext_int.find("hdr") != std::string_view::npos)
+			{
+				hr = LoadFromHDRFile(wide_string.c_str(), nullptr, image);
+			}
+			else if (ext_int.find("tga") != std::string_view::npos)
+			{
+				hr = DirectX::LoadFromTGAFile(wide_string.c_str(), nullptr, image);
+			}
+			else
+			{
+				LOGE("Texture {} not loaded. Format not supported.", path);
+				return false;
+			}
+
+			if (FAILED(hr))
+			{
+				_com_error err(hr);
+				LPCTSTR errMsg = err.ErrorMessage();
+
+				LOGE("ERROR: DirectXTex error: {}", errMsg);
+				return false;
+			}
+
+			return true;
+		}
+
+		//! Decodes size bytes of an encoded image, or copies width * height RGBA8 pixels for TextureFormat::RAW.
+		HRESULT DecodeTextureMemory(unsigned char const * data, size_t size, size_t width, size_t height, TextureFormat type, bool srgb, DirectX::ScratchImage& image)
+		{
+			InitializeCOMForThread();
+
+			switch (type)
+			{
+			case wr::TextureFormat::WIC:
+				return LoadFromWICMemory(data, size, DirectX::WIC_FLAGS_NONE, nullptr, image);
+			case wr::TextureFormat::DDS:
+				return LoadFromDDSMemory(data, size, DirectX::DDS_FLAGS_NONE, nullptr, image);
+			case wr::TextureFormat::HDR:
+				return LoadFromHDRMemory(data, size, nullptr, image);
+			case wr::TextureFormat::RAW:
+			{
+				DirectX::Image temp_image = {};
+
+				temp_image.format = srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+				temp_image.width = width;
+				temp_image.height = height;
+				temp_image.rowPitch = width * 4;
+				temp_image.slicePitch = width * height * 4;
+				temp_image.pixels = const_cast<uint8_t*>(data);
+
+				// Copies the pixels
+				return image.InitializeFromImage(temp_image);
+			}
+			default:
+				return E_INVALIDARG;
+			}
+		}
+
+		//! The cache key of a load, compression is turned off here when settings::use_texture_compression is.
+		/*!
+			The compression also tells what the texture holds, which picks how its mips are filtered.
+		*/
+		d3d12::CachedTextureKey GetTextureKey(bool srgb, bool generate_mips, TextureCompression compression)
+		{
+			d3d12::CachedTextureKey key;
+			key.m_srgb = srgb;
+			key.m_generate_mips = generate_mips;
+			key.m_normal_map = compression == TextureCompression::NORMAL_MAP;
+			key.m_preserve_alpha_coverage = compression == TextureCompression::COLOR;
+			key.m_compression = settings::use_texture_compression ? compression : TextureCompression::NONE;
+
+			return key;
+		}
+
+		//! DecodeTextureFile through the texture cache. A cached texture is read as is, anything else is decoded, baked and cached.
+		/*!
+			Without the cache textures are still baked, as their mips are only generated here, they just aren't written.
+		*/
+		bool LoadTextureFile(std::string_view path, d3d12::CachedTextureKey const & key, DirectX::ScratchImage& image)
+		{
+			std::optional<std::string_view> extension = util::GetFileExtension(path);
+
+			// DDS files are already stored the way the cache would store them, they're only baked when they lack mips
+			bool const is_dds = extension.has_value() && extension.value().find("dds") != std::string_view::npos;
+
+			std::string const cache_path = (settings::use_texture_cache && !is_dds) ? d3d12::GetCachedTexturePath(path, key) : std::string();
+
+			if (!cache_path.empty() && d3d12::ReadCachedTexture(cache_path, image))
+			{
+				return true;
+			}
+
+			if (!DecodeTextureFile(path, image))
+			{
+				return false;
+			}
+
+			if (d3d12::BakeTexture(image, key) && !cache_path.empty())
+			{
+				d3d12::WriteCachedTexture(cache_path, image);
+			}
+
+			return true;
+		}
+
+		//! DecodeTextureMemory through the texture cache, like LoadTextureFile.
+		HRESULT LoadTextureMemory(unsigned char const * data, size_t size, size_t width, size_t height, TextureFormat type, d3d12::CachedTextureKey key, DirectX::ScratchImage& image)
+		{
+			bool const srgb = key.m_srgb;
+
+			// Raw pixels without mips or compression upload as they are, there's nothing to save
+			bool const cache = type != TextureFormat::DDS
+				&& (type != TextureFormat::RAW || key.m_generate_mips || key.m_compression != TextureCompression::NONE);
+
+			if (!cache)
+			{
+				HRESULT hr = DecodeTextureMemory(data, size, width, height, type, srgb, image);
+
+				// DDS data skips the cache, but still gets the mips it lacks
+				if (SUCCEEDED(hr) && type == TextureFormat::DDS)
+				{
+					d3d12::BakeTexture(image, key);
+				}
+
+				return hr;
+			}
+
+			if (type == TextureFormat::RAW)
+			{
+				key.m_width = width;
+				key.m_height = height;
+			}
+
+			std::string const cache_path = settings::use_texture_cache ? d3d12::GetCachedTexturePath(data, size, key) : std::string();
+
+			if (!cache_path.empty() && d3d12::ReadCachedTexture(cache_path, image))
+			{
+				return S_OK;
+			}
+
+			HRESULT hr = DecodeTextureMemory(data, size, width, height, type, srgb, image);
+
+			if (SUCCEEDED(hr) && d3d12::BakeTexture(image, key) && !cache_path.empty())
+			{
+				d3d12::WriteCachedTexture(cache_path, image);
+			}
+
+			return hr;
+		}
+	}
+
 	D3D12TexturePool::D3D12TexturePool(D3D12RenderSystem& render_system)
 		: TexturePool()
 		, m_render_system(render_system)
@@ -91,10 +290,25 @@ namespace wr
 			d3d12::DescHeapCPUHandle handle = m_default_uav.GetDescriptorHandle(i);
 			device->m_native->CreateUnorderedAccessView(nullptr, nullptr, &uavDesc, handle.m_native);
 		}
+
+		m_decode_thread_pool = std::make_unique<util::ThreadPool>(settings::num_texture_decode_threads);
+
+		// Shown by asynchronous loads until their image is decoded
+		unsigned char black[4] = { 0, 0, 0, 255 };
+		unsigned char white[4] = { 255, 255, 255, 255 };
+		unsigned char flat_normal[4] = { 128, 128, 255, 255 };
+
+		m_default_color = D3D12TexturePool::LoadFromMemory(black, 1, 1, TextureFormat::RAW, true, false);
+		m_default_data = D3D12TexturePool::LoadFromMemory(white, 1, 1, TextureFormat::RAW, false, false);
+		m_default_normal = D3D12TexturePool::LoadFromMemory(flat_normal, 1, 1, TextureFormat::RAW, false, false);
 	}
 
 	D3D12TexturePool::~D3D12TexturePool()
 	{
+		// Waits for the decodes that are still queued, their images are dropped with m_async_loads
+		m_decode_thread_pool.reset();
+		m_async_loads.clear();
+
 		{
 			//Let the allocation go out of scope to clear it before the texture pool and its allocators are destroyed
 			DescriptorAllocation alloc = std::move(m_default_uav);
@@ -127,6 +341,14 @@ namespace wr
 		}
 
 		D3D12TexturePool::UnloadTextures(0);
+
+		for (auto& releases : m_stream_releases)
+		{
+			for (auto* resource : releases)
+			{
+				SAFE_RELEASE(resource);
+			}
+		}
 	}
 
 	void D3D12TexturePool::Evict()
@@ -139,6 +361,10 @@ namespace wr
 
 	void D3D12TexturePool::Stage(CommandList* cmd_list)
 	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		FinishAsyncLoads();
+
 		size_t unstaged_number = m_unstaged_textures.size();
 
 		if (unstaged_number > 0)
@@ -146,7 +372,6 @@ namespace wr
 			d3d12::CommandList* cmdlist = static_cast<d3d12::CommandList*>(cmd_list);
 
 			std::vector<d3d12::TextureResource*> unstaged_textures;
-			std::vector<d3d12::TextureResource*> need_mipmapping;
 
 			auto itr = m_unstaged_textures.begin();
 
@@ -156,43 +381,22 @@ namespace wr
 
 				unstaged_textures.push_back(texture);
 
-				decltype(d3d12::Device::m_native) n_device;
-				texture->m_resource->GetDevice(IID_PPV_ARGS(&n_device));
+				// Streamed textures start without their finer mips
+				auto streamed = m_streamed_textures.find(itr->first);
+				std::size_t const first_mip = streamed != m_streamed_textures.end() ? streamed->second.m_resident_mip : 0;
 
-
-				DirectX::ScratchImage* image = itr->second.second;
-
-				texture->m_subresources.resize(image->GetImageCount());
-				const DirectX::Image* pImages = image->GetImages();
-				for (int i = 0; i < image->GetImageCount(); ++i)
-				{
-					auto& subresource = texture->m_subresources[i];
-					subresource.RowPitch = pImages[i].rowPitch;
-					subresource.SlicePitch = pImages[i].slicePitch;
-					subresource.pData = pImages[i].pixels;
-				}
-
-
-				std::vector<D3D12_SUBRESOURCE_DATA> subresources = texture->m_subresources;
-				UpdateSubresources(cmdlist->m_native, texture->m_resource, texture->m_intermediate, 0, 0, static_cast<uint32_t>(subresources.size()), subresources.data());
-
-				texture->m_is_staged = true;
-
-				if (texture->m_need_mips)
-				{
-					need_mipmapping.push_back(texture);
-				}
+				UploadMips(cmdlist, texture, *itr->second.second, first_mip, itr->second.second->GetImageCount() - first_mip);
 			}
 
 			d3d12::Transition(cmdlist, unstaged_textures, wr::ResourceState::COPY_DEST, wr::ResourceState::PIXEL_SHADER_RESOURCE);
 
-			for (auto* t : need_mipmapping)
-			{
-				GenerateMips(t, cmd_list);
-			}
-
 			MoveStagedTextures(m_render_system.GetFrameIdx());
 		}
+
+		if constexpr (settings::use_texture_streaming)
+		{
+			StreamMips(static_cast<d3d12::CommandList*>(cmd_list));
+		}
 	}
 
 	void D3D12TexturePool::PostStageClear()
@@ -211,20 +415,7 @@ namespace wr
 
 		unsigned int frame_idx = m_render_system.GetFrameIdx();
 
-		//Release temporary textures
-		for (auto* t : m_temporary_textures[frame_idx])
-		{
-			d3d12::Destroy(t);
-		}
-
-		m_temporary_textures[frame_idx].clear();
-
-		//Release temporary heaps
-		for (auto* h : m_temporary_heaps[frame_idx])
-		{
-			d3d12::Destroy(h);
-		}
-
+		std::lock_guard<std::mutex> lock(m_mutex);
 
 		for (auto& map : m_staging_textures[frame_idx])
 		{
@@ -237,11 +428,24 @@ namespace wr
 		}
 
 		m_staging_textures[frame_idx].clear();
-		m_temporary_heaps[frame_idx].clear();
+
+		for (auto* resource : m_stream_releases[frame_idx])
+		{
+			SAFE_RELEASE(resource);
+		}
+
+		m_stream_releases[frame_idx].clear();
 	}
 
 	d3d12::TextureResource* D3D12TexturePool::GetTextureResource(TextureHandle handle)
 	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (auto load = m_async_loads.find(handle.m_id); load != m_async_loads.end())
+		{
+			return static_cast<d3d12::TextureResource*>(m_staged_textures.at(load->second.m_default_texture.m_id));
+		}
+
 		return static_cast<d3d12::TextureResource*>(m_staged_textures.at(handle.m_id));
 	}
 
@@ -309,6 +513,8 @@ namespace wr
 			d3d12::CreateRTVFromCubemap(texture);
 		}
 
+		std::lock_guard<std::mutex> lock(m_mutex);
+
 		m_loaded_textures++;
 
 		uint64_t texture_id = m_id_factory.GetUnusedID();
@@ -387,6 +593,8 @@ namespace wr
 			d3d12::CreateRTVFromTexture2D(texture);
 		}
 
+		std::lock_guard<std::mutex> lock(m_mutex);
+
 		m_loaded_textures++;
 
 		uint64_t texture_id = m_id_factory.GetUnusedID();
@@ -407,12 +615,32 @@ namespace wr
 
 	void D3D12TexturePool::MarkForUnload(TextureHandle& handle, unsigned int frame_idx)
 	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
 		uint64_t texture_id = handle.m_id;
 
+		// Still decoding or failed to, there's no resource yet
+		if (m_async_loads.erase(texture_id) > 0)
+		{
+			handle.m_pool = nullptr;
+			handle.m_id = -UINT_MAX;
+			return;
+		}
+
 		d3d12::TextureResource* texture = static_cast<d3d12::TextureResource*>(m_staged_textures.at(texture_id));
 		m_staged_textures.erase(texture_id);
 		m_staging_textures.at(frame_idx).erase(texture_id);
 
+		if (auto streamed = m_streamed_textures.find(texture_id); streamed != m_streamed_textures.end())
+		{
+			if (streamed->second.m_image != nullptr)
+			{
+				m_streamed_bytes -= GetStreamedSize(*streamed->second.m_image, streamed->second.m_resident_mip);
+			}
+
+			m_streamed_textures.erase(streamed);
+		}
+
 		m_marked_for_unload.at(frame_idx).push_back(texture);
 
 #ifdef _DEBUG
@@ -440,103 +668,67 @@ namespace wr
 		m_marked_for_unload.at(frame_idx).clear();
 	}
 
-	TextureHandle D3D12TexturePool::LoadFromFile(std::string_view path, bool srgb, bool generate_mips)
+	TextureHandle D3D12TexturePool::LoadFromFile(std::string_view path, bool srgb, bool generate_mips, TextureCompression compression)
 	{
-		auto device = m_render_system.m_device;
+		auto image = std::make_unique<DirectX::ScratchImage>();
 
-		DirectX::TexMetadata metadata;
-		DirectX::ScratchImage* image = new DirectX::ScratchImage;
+		if (!LoadTextureFile(path, GetTextureKey(srgb, generate_mips, compression), *image))
+		{
+			// Return an invalid texture handle when texture couldn't be loaded
+			return {};
+		}
 
-		std::optional<std::string_view> extension = util::GetFileExtension(path);
-		std::wstring wide_string(path.begin(), path.end());
+		LOG("[TEXTURE LOADED] {}", path);
 
-		if (std::string_view ext_int = extension.value(); extension.has_value())
-		{
-			HRESULT hr = S_OK;
+		// Only the decode above runs unlocked, the rest touches the pool's textures
+		std::lock_guard<std::mutex> lock(m_mutex);
 
-			if (ext_int.find("png") != std::string_view::npos
-				|| ext_int.find("jpeg") != std::string_view::npos
-				|| ext_int.find("jpg") != std::string_view::npos
-				|| ext_int.find("bmp") != std::string_view::npos)
-			{
-				hr = LoadFromWICFile(wide_string.c_str(),
-					DirectX::WIC_FLAGS_NONE, &metadata, *image);
-			}
-			else if (ext_int.find("dds") != std::string_view::npos)
-			{
-				hr = LoadFromDDSFile(wide_string.c_str(),
-					DirectX::DDS_FLAGS_NONE, &metadata, *image);
-			}
-			else if (ext_int.find("hdr") != std::string_view::npos)
-			{
-				hr = LoadFromHDRFile(wide_string.c_str(), &metadata, *image);
-			}
-			else if (ext_int.find("tga") != std::string_view::npos)
-			{
-				hr = DirectX::LoadFromTGAFile(wide_string.c_str(), &metadata, *image);
-			}
-			else
-			{
-				// Return an invalid texture handle when format is not supported
-				LOGE("Texture {} not loaded. Format not supported.", path);
-				return {};
-			}
+		std::wstring wide_string(path.begin(), path.end());
+		std::size_t const first_mip = GetInitialMip(image->GetMetadata());
+		d3d12::TextureResource* texture = CreateTextureFromImage(*image, first_mip, wide_string);
 
-			if (FAILED(hr))
-			{
-				_com_error err(hr);
-				LPCTSTR errMsg = err.ErrorMessage();
+		uint64_t texture_id = m_id_factory.GetUnusedID();
 
-				// Return an invalid texture handle when texture couldn't be loaded
-				LOGE("ERROR: DirectXTex error: {}", errMsg);
-				return {};
-			}
-		}
+		TextureHandle texture_handle;
+		texture_handle.m_pool = this;
+		texture_handle.m_id = static_cast<std::uint32_t>(texture_id);
 
-		uint32_t mip_lvls;
+		AddUnstagedTexture(texture_id, texture, std::move(image), first_mip, std::move(wide_string));
 
-		bool mip_generation = (metadata.mipLevels > 1) ? false : generate_mips;
+		return texture_handle;
+	}
+	
+	TextureHandle D3D12TexturePool::LoadFromMemory(unsigned char* data, size_t width, size_t height, TextureFormat type, bool srgb, bool generate_mips, TextureCompression compression)
+	{
+		std::optional<std::size_t> const size = GetTextureDataSize(width, height, type);
 
-		if (mip_generation)
-		{
-			mip_lvls = static_cast<uint32_t>(std::floor(std::log2(std::max(metadata.width, metadata.height)))) + 1;
-		}
-		else
+		if (!size.has_value())
 		{
-			mip_lvls = static_cast<std::uint32_t>(metadata.mipLevels);
+			LOGE("Texture data of {}x{} can't be loaded, encoded data needs a height of 0 and its size in bytes as width.", width, height);
+			return {};
 		}
 
-		Format texture_format = static_cast<wr::Format>(metadata.format);
-		
-		d3d12::desc::TextureDesc desc;
-
-		desc.m_width = static_cast<std::uint32_t>(metadata.width);
-		desc.m_height = static_cast<std::uint32_t>(metadata.height);
-		desc.m_is_cubemap = metadata.IsCubemap();
-		desc.m_depth = static_cast<std::uint32_t>(metadata.depth);
-		desc.m_array_size = static_cast<std::uint32_t>(metadata.arraySize);
-		desc.m_mip_levels = mip_lvls;
-		desc.m_texture_format = texture_format;
-		desc.m_initial_state = ResourceState::COPY_DEST;
-
-		d3d12::TextureResource* texture = d3d12::CreateTexture(device, &desc, mip_generation);
+		auto image = std::make_unique<DirectX::ScratchImage>();
 
-		DescriptorAllocation alloc = m_allocators[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]->Allocate();
+		HRESULT hr = LoadTextureMemory(data, size.value(), width, height, type, GetTextureKey(srgb, generate_mips, compression), *image);
 
-		if (alloc.IsNull())
+		if (FAILED(hr))
 		{
-			LOGC("Couldn't allocate descriptor for the texture resource");
-		}
+			_com_error err(hr);
+			LPCTSTR errMsg = err.ErrorMessage();
 
-		texture->m_need_mips = mip_generation;
-		texture->m_srv_allocation = std::move(alloc);
-		texture->m_resource->SetName(wide_string.c_str());
+			LOGC("ERROR: DirectXTex error: {}", errMsg);
+			return {};
+		}
 
-		d3d12::CreateSRVFromTexture(texture);
+		LOG("[TEXTURE LOADED]: Texture from Memory");
 
-		m_loaded_textures++;
+		// Only the decode above runs unlocked, the rest touches the pool's textures
+		std::lock_guard<std::mutex> lock(m_mutex);
 
-		LOG("[TEXTURE LOADED] {}", path);
+		std::wstring name = L"TextureFromMemory" + std::to_wstring(m_loaded_textures);
+		std::size_t const first_mip = GetInitialMip(image->GetMetadata());
+		d3d12::TextureResource* texture = CreateTextureFromImage(*image, first_mip, name);
 
 		uint64_t texture_id = m_id_factory.GetUnusedID();
 
@@ -544,105 +736,134 @@ namespace wr
 		texture_handle.m_pool = this;
 		texture_handle.m_id = static_cast<std::uint32_t>(texture_id);
 
-		m_unstaged_textures.insert(std::make_pair(texture_id, std::make_pair(texture, image)));
+		AddUnstagedTexture(texture_id, texture, std::move(image), first_mip, std::move(name));
 
 		return texture_handle;
+
 	}
-	
-	TextureHandle D3D12TexturePool::LoadFromMemory(unsigned char* data, size_t width, size_t height, TextureFormat type, bool srgb, bool generate_mips)
+
+	TextureHandle D3D12TexturePool::LoadFromFileAsync(std::string_view path, bool srgb, bool generate_mips, TextureCompression compression)
 	{
-		auto device = m_render_system.m_device;
+		auto image = m_decode_thread_pool->Enqueue([path = std::string(path), key = GetTextureKey(srgb, generate_mips, compression)]() -> std::unique_ptr<DirectX::ScratchImage>
+		{
+			auto image = std::make_unique<DirectX::ScratchImage>();
 
-		DirectX::TexMetadata metadata;
-		DirectX::ScratchImage* image = new DirectX::ScratchImage;
+			if (!LoadTextureFile(path, key, *image))
+			{
+				return nullptr;
+			}
 
-		HRESULT hr;
+			return image;
+		});
 
-		switch (type)
-		{
-		case wr::TextureFormat::WIC:
-		{
-			//Assuming RGBA8_UNORM for the time being, need to find a solution
-			hr = LoadFromWICMemory(data, width * height * 8/*bits*/ * 4/*channels*/,
-				DirectX::WIC_FLAGS_NONE, &metadata, *image);
+		return QueueAsyncLoad(std::move(image), std::string(path), srgb, compression);
+	}
 
-			break;
-		}
-		case wr::TextureFormat::DDS:
-		{
-			//Assuming RGBA8_UNORM for the time being, need to find a solution
-			hr = LoadFromDDSMemory(data, width * height * 8/*bits*/ * 4/*channels*/,
-				DirectX::DDS_FLAGS_NONE, &metadata, *image);
+	TextureHandle D3D12TexturePool::LoadFromMemoryAsync(unsigned char* data, size_t width, size_t height, TextureFormat type, bool srgb, bool generate_mips, TextureCompression compression)
+	{
+		std::optional<std::size_t> const size = GetTextureDataSize(width, height, type);
 
-			break;
+		if (!size.has_value())
+		{
+			LOGE("Texture data of {}x{} can't be loaded, encoded data needs a height of 0 and its size in bytes as width.", width, height);
+			return {};
 		}
 
-		case wr::TextureFormat::HDR:
-		{
-			//Assuming RGBA16_FLOAT for the time being, need to find a solution
-			hr = LoadFromHDRMemory(data, width * height * 16/*bits*/ * 4/*channels*/,
-				&metadata, *image);
+		std::vector<unsigned char> bytes(data, data + size.value());
 
-			break;
-		}
-		case wr::TextureFormat::RAW:
+		auto image = m_decode_thread_pool->Enqueue([bytes = std::move(bytes), width, height, type, key = GetTextureKey(srgb, generate_mips, compression)]() -> std::unique_ptr<DirectX::ScratchImage>
 		{
-			DirectX::Image temp_image = {};
+			auto image = std::make_unique<DirectX::ScratchImage>();
 
-			temp_image.format = srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
-			temp_image.width = width;
-			temp_image.height = height;
-			temp_image.rowPitch = width * 4;
-			temp_image.slicePitch = width * height * 4;
-			temp_image.pixels = data;
+			HRESULT hr = LoadTextureMemory(bytes.data(), bytes.size(), width, height, type, key, *image);
 
-			hr = image->InitializeFromImage(temp_image);
+			if (FAILED(hr))
+			{
+				_com_error err(hr);
+				LPCTSTR errMsg = err.ErrorMessage();
 
-			metadata.width = width;
-			metadata.height = height;
-			metadata.arraySize = 1;
-			metadata.format = srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
-			metadata.mipLevels = 1;
-			metadata.depth = 1;
-			metadata.dimension = DirectX::TEX_DIMENSION::TEX_DIMENSION_TEXTURE2D;
-			metadata.miscFlags = 0;
-			metadata.miscFlags2 = 0;
+				LOGE("ERROR: DirectXTex error: {}", errMsg);
+				return nullptr;
+			}
 
-			break;
-		}
+			return image;
+		});
 
-		default:
-			LOGC("[ERROR]: How did we even get here?")
-			break;
-		}
+		return QueueAsyncLoad(std::move(image), std::string(), srgb, compression);
+	}
 
-		if (FAILED(hr))
-		{
-			_com_error err(hr);
-			LPCTSTR errMsg = err.ErrorMessage();
+	TextureHandle D3D12TexturePool::QueueAsyncLoad(std::future<std::unique_ptr<DirectX::ScratchImage>> image, std::string name, bool srgb, TextureCompression compression)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
 
-			LOGC("ERROR: DirectXTex error: {}", errMsg);
-		}
+		uint64_t texture_id = m_id_factory.GetUnusedID();
 
-		uint32_t mip_lvls;
+		AsyncTextureLoad& load = m_async_loads[texture_id];
+		load.m_image = std::move(image);
+		load.m_name = std::move(name);
+		// Color textures show black and data textures white, so roughness and ambient occlusion stay neutral while decoding
+		load.m_default_texture = compression == TextureCompression::NORMAL_MAP ? m_default_normal
+			: srgb ? m_default_color
+			: m_default_data;
 
-		bool mip_generation = (metadata.mipLevels > 1) ? false : generate_mips;
+		TextureHandle texture_handle;
+		texture_handle.m_pool = this;
+		texture_handle.m_id = static_cast<std::uint32_t>(texture_id);
 
-		if (mip_generation)
-		{
-			mip_lvls = static_cast<uint32_t>(std::floor(std::log2(std::max(metadata.width, metadata.height)))) + 1;
-		}
-		else
+		return texture_handle;
+	}
+
+	void D3D12TexturePool::FinishAsyncLoads()
+	{
+		for (auto itr = m_async_loads.begin(); itr != m_async_loads.end();)
 		{
-			mip_lvls = static_cast<std::uint32_t>(metadata.mipLevels);
+			AsyncTextureLoad& load = itr->second;
+
+			if (load.m_failed || load.m_image.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				++itr;
+				continue;
+			}
+
+			std::unique_ptr<DirectX::ScratchImage> image = load.m_image.get();
+
+			if (image == nullptr)
+			{
+				LOGW("Texture {} couldn't be loaded, it keeps showing the default texture.", load.m_name.empty() ? "from memory" : load.m_name);
+
+				load.m_failed = true;
+				++itr;
+				continue;
+			}
+
+			std::wstring name = load.m_name.empty() ? L"TextureFromMemory" + std::to_wstring(m_loaded_textures) : std::wstring(load.m_name.begin(), load.m_name.end());
+			std::size_t const first_mip = GetInitialMip(image->GetMetadata());
+			d3d12::TextureResource* texture = CreateTextureFromImage(*image, first_mip, name);
+
+			LOG("[TEXTURE LOADED] {}", load.m_name.empty() ? "Texture from Memory" : load.m_name);
+
+			// Staged in the same Stage call, so the handle never points at nothing
+			AddUnstagedTexture(itr->first, texture, std::move(image), first_mip, std::move(name));
+
+			itr = m_async_loads.erase(itr);
 		}
+	}
+
+	d3d12::TextureResource* D3D12TexturePool::CreateTextureFromImage(DirectX::ScratchImage const & image, std::size_t first_mip, std::wstring const & name)
+	{
+		auto device = m_render_system.m_device;
+
+		DirectX::TexMetadata const & metadata = image.GetMetadata();
+
+		// The mips were generated with the image, on the decode threads
+		uint32_t mip_lvls = static_cast<std::uint32_t>(metadata.mipLevels - first_mip);
 
 		Format texture_format = static_cast<wr::Format>(metadata.format);
 
 		d3d12::desc::TextureDesc desc;
 
-		desc.m_width = static_cast<std::uint32_t>(metadata.width);
-		desc.m_height = static_cast<std::uint32_t>(metadata.height);
+		desc.m_width = static_cast<std::uint32_t>(std::max<std::size_t>(metadata.width >> first_mip, 1));
+		desc.m_height = static_cast<std::uint32_t>(std::max<std::size_t>(metadata.height >> first_mip, 1));
 		desc.m_is_cubemap = metadata.IsCubemap();
 		desc.m_depth = static_cast<std::uint32_t>(metadata.depth);
 		desc.m_array_size = static_cast<std::uint32_t>(metadata.arraySize);
@@ -650,7 +871,7 @@ namespace wr
 		desc.m_texture_format = texture_format;
 		desc.m_initial_state = ResourceState::COPY_DEST;
 
-		d3d12::TextureResource* texture = d3d12::CreateTexture(device, &desc, mip_generation);
+		d3d12::TextureResource* texture = d3d12::CreateTexture(device, &desc, false);
 
 		DescriptorAllocation alloc = m_allocators[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]->Allocate();
 
@@ -659,28 +880,15 @@ namespace wr
 			LOGC("Couldn't allocate descriptor for the texture resource");
 		}
 
-		texture->m_need_mips = mip_generation;
+		texture->m_need_mips = false;
 		texture->m_srv_allocation = std::move(alloc);
-
-		std::wstring name = L"TextureFromMemory" + std::to_wstring(m_loaded_textures);
 		texture->m_resource->SetName(name.c_str());
 
 		d3d12::CreateSRVFromTexture(texture);
 
 		m_loaded_textures++;
 
-		LOG("[TEXTURE LOADED]: Texture from Memory");
-
-		uint64_t texture_id = m_id_factory.GetUnusedID();
-
-		TextureHandle texture_handle;
-		texture_handle.m_pool = this;
-		texture_handle.m_id = static_cast<std::uint32_t>(texture_id);
-
-		m_unstaged_textures.insert(std::make_pair(texture_id, std::make_pair(texture, image)));
-
-		return texture_handle;
-
+		return texture;
 	}
 
 	void D3D12TexturePool::MoveStagedTextures(unsigned int frame_idx)
@@ -690,6 +898,14 @@ namespace wr
 			m_staged_textures.insert(std::make_pair(itr->first, itr->second.first));
 			m_staging_textures[frame_idx].insert(std::make_pair(itr->first, itr->second.first));
 
+			//Streamed textures keep their ScratchImage to upload the finer mips from later
+			if (auto streamed = m_streamed_textures.find(itr->first); streamed != m_streamed_textures.end())
+			{
+				streamed->second.m_image.reset(itr->second.second);
+				m_streamed_bytes += GetStreamedSize(*streamed->second.m_image, streamed->second.m_resident_mip);
+				continue;
+			}
+
 			//Free the ScratchImage as it's not needed anymore after staging
 			delete itr->second.second;
 		}
@@ -697,221 +913,283 @@ namespace wr
 		m_unstaged_textures.clear();
 	}
 
-	void D3D12TexturePool::GenerateMips(d3d12::TextureResource* texture, CommandList* cmd_list)
+	void D3D12TexturePool::AddUnstagedTexture(uint64_t texture_id, d3d12::TextureResource* texture, std::unique_ptr<DirectX::ScratchImage> image, std::size_t first_mip, std::wstring name)
 	{
-		wr::d3d12::CommandList* d3d12_cmd_list = static_cast<wr::d3d12::CommandList*>(cmd_list);
-		auto pipeline = static_cast<d3d12::PipelineState*>(PipelineRegistry::Get().Find(pipelines::mip_mapping));
-
-		d3d12::BindComputePipeline(d3d12_cmd_list, pipeline);
-
-		if (texture->m_need_mips)
+		if (first_mip > 0)
 		{
-			if (d3d12::CheckUAVCompatibility(texture->m_format) || d3d12::CheckOptionalUAVFormat(texture->m_format))
-			{
-				GenerateMips_UAV(texture, cmd_list);
-			}
-			else if (d3d12::CheckBGRFormat(texture->m_format))
-			{
-				GenerateMips_BGR(texture, cmd_list);
-			}
-			else if (d3d12::CheckSRGBFormat(texture->m_format))
-			{
-				GenerateMips_SRGB(texture, cmd_list);
-			}
-			else
-			{
-				LOGC("[ERROR]: GenerateMips-> I don't know how we ended up here!");
-			}
+			StreamedTexture& streamed = m_streamed_textures[texture_id];
+			streamed.m_metadata = image->GetMetadata();
+			streamed.m_name = std::move(name);
+			streamed.m_resident_mip = first_mip;
+			streamed.m_initial_mip = first_mip;
+			streamed.m_requested_mip = first_mip;
+			streamed.m_request_frame = m_stream_frame;
 		}
+
+		m_unstaged_textures.insert(std::make_pair(texture_id, std::make_pair(texture, image.release())));
 	}
 
-	void D3D12TexturePool::GenerateMips_UAV(d3d12::TextureResource* texture, CommandList* cmd_list)
+	void D3D12TexturePool::UploadMips(d3d12::CommandList* cmd_list, d3d12::TextureResource* texture, DirectX::ScratchImage const & image, std::size_t first_mip, std::size_t num_mips)
 	{
-		wr::d3d12::CommandList* d3d12_cmd_list = static_cast<wr::d3d12::CommandList*>(cmd_list);
-		
-		//Create shader resource view for the source texture in the descriptor heap
-		DescriptorAllocation srv_alloc = m_mipmapping_allocator->Allocate();
-		d3d12::DescHeapCPUHandle srv_handle = srv_alloc.GetDescriptorHandle();
+		// Only textures without array slices start at a later mip, their images are just the mips in order
+		texture->m_subresources.resize(num_mips);
+		const DirectX::Image* pImages = image.GetImages() + first_mip;
+		for (std::size_t i = 0; i < texture->m_subresources.size(); ++i)
+		{
+			auto& subresource = texture->m_subresources[i];
+			subresource.RowPitch = pImages[i].rowPitch;
+			subresource.SlicePitch = pImages[i].slicePitch;
+			subresource.pData = pImages[i].pixels;
+		}
 
-		d3d12::CreateSRVFromTexture(texture, srv_handle);
+		UpdateSubresources(cmd_list->m_native, texture->m_resource, texture->m_intermediate, 0, 0, static_cast<uint32_t>(texture->m_subresources.size()), texture->m_subresources.data());
 
-		MipMapping_CB generate_mips_cb;
+		texture->m_is_staged = true;
+	}
 
-		for (uint32_t src_mip = 0; src_mip < texture->m_mip_levels - 1u;)
+	std::size_t D3D12TexturePool::GetInitialMip(DirectX::TexMetadata const & metadata)
+	{
+		if (!settings::use_texture_streaming || metadata.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1 || metadata.IsCubemap())
 		{
-			uint32_t src_width = static_cast<std::uint32_t>(texture->m_width) >> src_mip;
-			uint32_t src_height = static_cast<std::uint32_t>(texture->m_height) >> src_mip;
-			uint32_t dst_width = src_width >> 1;
-			uint32_t dst_height = src_height >> 1;
-
-			// Determine the compute shader to use based on the dimension of the 
-			// source texture.
-			// 0b00(0): Both width and height are even.
-			// 0b01(1): Width is odd, height is even.
-			// 0b10(2): Width is even, height is odd.
-			// 0b11(3): Both width and height are odd.
-			generate_mips_cb.src_dimension = (src_height & 1) << 1 | (src_width & 1);
+			return 0;
+		}
 
-			// Max amount of mip levels to compute in a pass is 4.
-			DWORD mip_count;
+		std::size_t mip = 0;
+		while (mip + 1 < metadata.mipLevels && std::max(metadata.width >> mip, metadata.height >> mip) > settings::texture_stream_initial_size)
+		{
+			++mip;
+		}
 
-			// The number of times we can half the size of the texture and get
-			// exactly a 50% reduction in size.
-			// A 1 bit in the width or height indicates an odd dimension.
-			// The case where either the width or the height is exactly 1 is handled
-			// as a special case (as the dimension does not require reduction).
-			_BitScanForward(&mip_count, (dst_width == 1 ? dst_height : dst_width) |
-										(dst_height == 1 ? dst_width : dst_height));
+		while (mip > 0 && !CanStartAtMip(metadata, mip))
+		{
+			--mip;
+		}
 
-			// Maximum number of mips to generate is 4.
-			mip_count = std::min<DWORD>(4, mip_count + 1);
-			// Clamp to total number of mips left over.
-			mip_count = ((static_cast<DWORD>(src_mip) + mip_count) > texture->m_mip_levels) ? static_cast<DWORD>(texture->m_mip_levels - src_mip) : mip_count;
+		return mip;
+	}
 
-			// Dimensions should not reduce to 0.
-			// This can happen if the width and height are not the same.
-			dst_width = std::max<DWORD>(1, dst_width);
-			dst_height = std::max<DWORD>(1, dst_height);
+	bool D3D12TexturePool::CanStartAtMip(DirectX::TexMetadata const & metadata, std::size_t mip)
+	{
+		return !DirectX::IsCompressed(metadata.format) || ((metadata.width >> mip) % 4 == 0 && (metadata.height >> mip) % 4 == 0);
+	}
 
-			generate_mips_cb.src_mip_level = src_mip;
-			generate_mips_cb.num_mip_levels = mip_count;
-			generate_mips_cb.texel_size.x = 1.0f / (float)dst_width;
-			generate_mips_cb.texel_size.y = 1.0f / (float)dst_height;
+	std::size_t D3D12TexturePool::GetMipChainSize(DirectX::ScratchImage const & image, std::size_t first_mip)
+	{
+		std::size_t size = 0;
+		for (std::size_t mip = first_mip; mip < image.GetMetadata().mipLevels; ++mip)
+		{
+			size += image.GetImage(mip, 0, 0)->slicePitch;
+		}
 
-			d3d12::BindCompute32BitConstants(d3d12_cmd_list, &generate_mips_cb, sizeof(MipMapping_CB) / sizeof(uint32_t), 0, 0);
+		return size;
+	}
 
-			d3d12::Transition(d3d12_cmd_list, texture, texture->m_subresource_states[src_mip], ResourceState::PIXEL_SHADER_RESOURCE, src_mip, 1);
+	std::size_t D3D12TexturePool::GetStreamedSize(DirectX::ScratchImage const & image, std::size_t resident_mip)
+	{
+		// The whole chain stays in memory to stream from, the mips from the resident one on are on the GPU as well
+		return GetMipChainSize(image, 0) + GetMipChainSize(image, resident_mip);
+	}
 
-			d3d12::SetShaderSRV(d3d12_cmd_list, 1, COMPILATION_EVAL(rs_layout::GetHeapLoc(params::mip_mapping, params::MipMappingE::SOURCE)), srv_handle);
+	void D3D12TexturePool::RequestMips(std::vector<TextureMipRequest> const & requests)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
 
-			for (uint32_t mip = 0; mip < mip_count; ++mip)
+		for (TextureMipRequest const & request : requests)
+		{
+			auto itr = m_streamed_textures.find(request.m_texture.m_id);
+			if (itr == m_streamed_textures.end() || request.m_pixels_per_uv <= 0.f)
 			{
-				std::uint32_t idx = src_mip + mip + 1u;
-
-				d3d12::Transition(d3d12_cmd_list, texture, texture->m_subresource_states[idx], ResourceState::UNORDERED_ACCESS, idx, 1);
+				continue;
+			}
 
-				DescriptorAllocation uav_alloc = m_mipmapping_allocator->Allocate();
-				d3d12::DescHeapCPUHandle uav_handle = uav_alloc.GetDescriptorHandle();
+			StreamedTexture& streamed = itr->second;
 
-				d3d12::CreateUAVFromTexture(texture, uav_handle, src_mip + mip + 1);
+			// The mip that has about one texel per pixel, mip n has the texture's size >> n texels per UV unit
+			float const texels_per_pixel = static_cast<float>(std::max(streamed.m_metadata.width, streamed.m_metadata.height)) / request.m_pixels_per_uv;
+			float const lod = std::log2(std::max(texels_per_pixel, 1.f)) + settings::texture_stream_mip_bias;
 
-				d3d12::SetShaderUAV(d3d12_cmd_list, 1, COMPILATION_EVAL(rs_layout::GetHeapLoc(params::mip_mapping, params::MipMappingE::DEST)) + mip, uav_handle);
-			}
-			// Pad any unused mip levels with a default UAV to keeps the DX12 runtime happy.
-			if (mip_count < 4)
+			std::size_t mip = static_cast<std::size_t>(std::clamp(lod, 0.f, static_cast<float>(streamed.m_initial_mip)));
+			while (mip > 0 && !CanStartAtMip(streamed.m_metadata, mip))
 			{
-				d3d12_cmd_list->m_dynamic_descriptor_heaps[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]->StageDescriptors(
-					COMPILATION_EVAL(rs_layout::GetHeapLoc(params::mip_mapping, params::MipMappingE::DEST)),
-					mip_count + 1, 4 - mip_count, m_default_uav.GetDescriptorHandle());
+				--mip;
 			}
 
-			d3d12::Dispatch(d3d12_cmd_list, ((dst_width + 8 - 1) / 8), ((dst_height + 8 - 1) / 8), 1u);
-
-			//Wait for all accesses to the destination texture UAV to be finished before generating the next mipmap, as it will be the source texture for the next mipmap
-			d3d12::UAVBarrier(d3d12_cmd_list, { texture });
-
-			for (uint32_t mip = 0; mip < mip_count; ++mip)
+			// The finest mip any mesh needs this frame
+			if (streamed.m_request_frame != m_stream_frame || mip < streamed.m_requested_mip)
 			{
-				std::uint32_t idx = src_mip + mip + 1u;
-
-				d3d12::Transition(d3d12_cmd_list, texture, texture->m_subresource_states[idx], ResourceState::PIXEL_SHADER_RESOURCE, idx, 1);
+				streamed.m_requested_mip = mip;
+				streamed.m_request_frame = m_stream_frame;
 			}
-
-			src_mip += mip_count;
 		}
-
-		texture->m_need_mips = false;
 	}
 
-	void D3D12TexturePool::GenerateMips_BGR(d3d12::TextureResource* texture, CommandList* cmd_list)
+	void D3D12TexturePool::StreamMips(d3d12::CommandList* cmd_list)
 	{
-		auto device = m_render_system.m_device;
-		wr::d3d12::CommandList* d3d12_cmd_list = static_cast<wr::d3d12::CommandList*>(cmd_list);
-		unsigned int frame_idx = m_render_system.GetFrameIdx();
+		// The requests made since the last Stage belong to the previous frame
+		++m_stream_frame;
 
-		//Create new resource with UAV compatible format
-		d3d12::desc::TextureDesc copy_desc;
-		copy_desc.m_width = static_cast<std::uint32_t>(texture->m_width);
-		copy_desc.m_height = static_cast<std::uint32_t>(texture->m_height);
-		copy_desc.m_depth = static_cast<std::uint32_t>(texture->m_depth);
-		copy_desc.m_array_size = static_cast<std::uint32_t>(texture->m_array_size);
-		copy_desc.m_initial_state = ResourceState::COMMON;
-		copy_desc.m_is_cubemap = texture->m_is_cubemap;
-		copy_desc.m_mip_levels = static_cast<std::uint32_t>(texture->m_mip_levels);
-		copy_desc.m_texture_format = Format::R8G8B8A8_UNORM;
-
-		// Create a heap to alias the resource. This is used to copy the resource without 
-		// failing GPU validation.
-		auto resource = texture->m_resource;
-		auto resourceDesc = resource->GetDesc();
+		struct StreamCandidate
+		{
+			uint64_t m_id;
+			StreamedTexture* m_texture;
+			std::size_t m_wanted_mip;
+		};
 
-		auto allocation_info = device->m_native->GetResourceAllocationInfo(0, 1, &resourceDesc);
+		std::vector<StreamCandidate> stream_in;
+		std::vector<StreamCandidate> evictable;
 
-		d3d12::Heap<wr::HeapOptimization::BIG_STATIC_BUFFERS>* heap;
-		heap = d3d12::CreateHeap_BSBO(device, allocation_info.SizeInBytes, ResourceType::TEXTURE, 1);
+		for (auto& [id, streamed] : m_streamed_textures)
+		{
+			// Not staged yet
+			if (streamed.m_image == nullptr)
+			{
+				continue;
+			}
 
-		m_temporary_heaps[frame_idx].push_back(heap);
+			// A texture that wasn't requested for a while only needs the mips it started with
+			bool const recently_requested = m_stream_frame - streamed.m_request_frame <= settings::texture_stream_keep_frames;
+			std::size_t const wanted_mip = recently_requested ? streamed.m_requested_mip : streamed.m_initial_mip;
 
-		//Create the copy resource placed in the heap.
-		d3d12::TextureResource* copy_texture = d3d12::CreatePlacedTexture(device, &copy_desc, true, heap);
+			if (wanted_mip < streamed.m_resident_mip)
+			{
+				stream_in.push_back({ id, &streamed, wanted_mip });
+			}
+			else if (wanted_mip > streamed.m_resident_mip)
+			{
+				evictable.push_back({ id, &streamed, wanted_mip });
+			}
+		}
 
-		m_temporary_textures[frame_idx].push_back(copy_texture);
+		if (stream_in.empty())
+		{
+			return;
+		}
 
-		// Create an alias for which to perform the copy operation.
-		d3d12::desc::TextureDesc alias_desc = copy_desc;
-		alias_desc.m_texture_format = (texture->m_format == Format::B8G8R8X8_UNORM ||
-										texture->m_format == Format::B8G8R8X8_UNORM_SRGB) ?
-											Format::B8G8R8X8_UNORM : Format::B8G8R8A8_UNORM;
+		// The most recently requested textures go first, of those the ones missing the most detail
+		std::sort(stream_in.begin(), stream_in.end(), [](StreamCandidate const & a, StreamCandidate const & b)
+		{
+			if (a.m_texture->m_request_frame != b.m_texture->m_request_frame)
+			{
+				return a.m_texture->m_request_frame > b.m_texture->m_request_frame;
+			}
 
-		d3d12::TextureResource* alias_texture = d3d12::CreatePlacedTexture(device, &alias_desc, true, heap);
+			return a.m_texture->m_resident_mip - a.m_wanted_mip > b.m_texture->m_resident_mip - b.m_wanted_mip;
+		});
 
-		m_temporary_textures[frame_idx].push_back(alias_texture);
+		// The textures that were needed least recently lose their finer mips first
+		std::sort(evictable.begin(), evictable.end(), [](StreamCandidate const & a, StreamCandidate const & b)
+		{
+			return a.m_texture->m_request_frame < b.m_texture->m_request_frame;
+		});
 
-		d3d12::Alias(d3d12_cmd_list, nullptr, alias_texture);
+		std::size_t upload_budget = settings::texture_stream_bytes_per_frame;
+		auto next_evictable = evictable.begin();
 
-		//Copy resource
-		d3d12::CopyResource(d3d12_cmd_list, texture, alias_texture);
+		for (StreamCandidate const & candidate : stream_in)
+		{
+			// Like the model pool's streaming, the texture that exhausts the budget is still uploaded whole
+			if (upload_budget == 0)
+			{
+				break;
+			}
 
-		// Alias the UAV compatible texture back.
-		d3d12::Alias(d3d12_cmd_list, alias_texture, copy_texture);
+			StreamedTexture& streamed = *candidate.m_texture;
+			std::size_t const wanted_size = GetMipChainSize(*streamed.m_image, candidate.m_wanted_mip);
+			std::size_t const added_size = wanted_size - GetMipChainSize(*streamed.m_image, streamed.m_resident_mip);
 
-		//Now use the resource copy to generate the mips
-		GenerateMips_UAV(copy_texture, cmd_list);
+			while (m_streamed_bytes + added_size > settings::texture_streaming_budget && next_evictable != evictable.end())
+			{
+				// Evicting only copies mips on the GPU, it doesn't count towards the upload budget
+				SetResidentMip(cmd_list, next_evictable->m_id, next_evictable->m_wanted_mip);
+				++next_evictable;
+			}
 
-		// Copy back to the original (via the alias to ensure GPU validation)
-		d3d12::Alias(d3d12_cmd_list, copy_texture, alias_texture);
+			// Doesn't fit even with every unneeded mip evicted
+			if (m_streamed_bytes + added_size > settings::texture_streaming_budget)
+			{
+				continue;
+			}
 
-		d3d12::CopyResource(d3d12_cmd_list, alias_texture, texture);
+			SetResidentMip(cmd_list, candidate.m_id, candidate.m_wanted_mip);
+			upload_budget -= std::min(upload_budget, added_size);
+		}
 	}
 
-	void D3D12TexturePool::GenerateMips_SRGB(d3d12::TextureResource* texture, CommandList* cmd_list)
+	void D3D12TexturePool::SetResidentMip(d3d12::CommandList* cmd_list, uint64_t texture_id, std::size_t mip)
 	{
-		auto device = m_render_system.m_device;
-		wr::d3d12::CommandList* d3d12_cmd_list = static_cast<wr::d3d12::CommandList*>(cmd_list);
+		StreamedTexture& streamed = m_streamed_textures.at(texture_id);
+		auto* texture = static_cast<d3d12::TextureResource*>(m_staged_textures.at(texture_id));
+		DirectX::TexMetadata const & metadata = streamed.m_metadata;
 
-		//Create copy of the texture and store it for later deletion.
-		d3d12::desc::TextureDesc copy_desc;
+		d3d12::desc::TextureDesc desc;
+		desc.m_width = static_cast<std::uint32_t>(std::max<std::size_t>(metadata.width >> mip, 1));
+		desc.m_height = static_cast<std::uint32_t>(std::max<std::size_t>(metadata.height >> mip, 1));
+		desc.m_depth = static_cast<std::uint32_t>(metadata.depth);
+		desc.m_array_size = static_cast<std::uint32_t>(metadata.arraySize);
+		desc.m_mip_levels = static_cast<std::uint32_t>(metadata.mipLevels - mip);
+		desc.m_texture_format = static_cast<wr::Format>(metadata.format);
+		desc.m_initial_state = ResourceState::COPY_DEST;
 
-		copy_desc.m_width = static_cast<std::uint32_t>(texture->m_width);
-		copy_desc.m_height = static_cast<std::uint32_t>(texture->m_height);
-		copy_desc.m_is_cubemap = texture->m_is_cubemap;
-		copy_desc.m_depth = static_cast<std::uint32_t>(texture->m_depth);
-		copy_desc.m_array_size = static_cast<std::uint32_t>(texture->m_array_size);
-		copy_desc.m_mip_levels = static_cast<std::uint32_t>(texture->m_mip_levels);
-		copy_desc.m_texture_format = d3d12::RemoveSRGB(texture->m_format);
-		copy_desc.m_initial_state = ResourceState::COPY_DEST;
+		// Evicting only copies on the GPU, streaming in needs upload space for just the mips the old resource lacks
+		d3d12::TextureResource* replacement = d3d12::CreateTexture(m_render_system.m_device, &desc, false, false);
 
-		auto texture_copy = d3d12::CreateTexture(device, &copy_desc, true);
+		// The mips both resources have are copied on the GPU, only the finer mips that are streamed in come from the image
+		std::size_t const resident_mip = streamed.m_resident_mip;
+		d3d12::Transition(cmd_list, texture, texture->m_subresource_states[0], wr::ResourceState::COPY_SOURCE);
 
-		unsigned int frame_idx = m_render_system.GetFrameIdx();
+		for (std::size_t level = std::max(mip, resident_mip); level < metadata.mipLevels; ++level)
+		{
+			CD3DX12_TEXTURE_COPY_LOCATION destination(replacement->m_resource, static_cast<std::uint32_t>(level - mip));
+			CD3DX12_TEXTURE_COPY_LOCATION source(texture->m_resource, static_cast<std::uint32_t>(level - resident_mip));
+			cmd_list->m_native->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+		}
 
-		m_temporary_textures[frame_idx].push_back(texture_copy);
+		if (mip < resident_mip)
+		{
+			d3d12::CreateIntermediate(m_render_system.m_device, replacement, static_cast<unsigned int>(resident_mip - mip));
+			UploadMips(cmd_list, replacement, *streamed.m_image, mip, resident_mip - mip);
+		}
+
+		// Frames that are still in flight sample the old resource, and an upload of it might still be pending
+		unsigned int const frame_idx = m_render_system.GetFrameIdx();
+		m_stream_releases[frame_idx].push_back(texture->m_resource);
+		if (texture->m_intermediate)
+		{
+			m_stream_releases[frame_idx].push_back(texture->m_intermediate);
+		}
+
+		// The handle keeps resolving to the same TextureResource and descriptor, only what they point at changes
+		texture->m_resource = replacement->m_resource;
+		texture->m_intermediate = replacement->m_intermediate;
+		texture->m_width = replacement->m_width;
+		texture->m_height = replacement->m_height;
+		texture->m_mip_levels = replacement->m_mip_levels;
+		texture->m_subresource_states = std::move(replacement->m_subresource_states);
+		delete replacement;
+
+		texture->m_resource->SetName(streamed.m_name.c_str());
 
-		d3d12::CopyResource(d3d12_cmd_list, texture, texture_copy);
+		d3d12::Transition(cmd_list, texture, wr::ResourceState::COPY_DEST, wr::ResourceState::PIXEL_SHADER_RESOURCE);
+		d3d12::CreateSRVFromTexture(texture);
+
+		// Released with the old resource, ReleaseTemporaryResources only knows about the intermediates of newly staged textures
+		if (texture->m_intermediate)
+		{
+			m_stream_releases[frame_idx].push_back(texture->m_intermediate);
+			texture->m_intermediate = nullptr;
+		}
 
-		GenerateMips(texture_copy, cmd_list);
+		m_streamed_bytes -= GetMipChainSize(*streamed.m_image, resident_mip);
+		m_streamed_bytes += GetMipChainSize(*streamed.m_image, mip);
+		streamed.m_resident_mip = mip;
+	}
+
+	std::size_t D3D12TexturePool::GetResidentMip(TextureHandle const & handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
 
-		d3d12::CopyResource(d3d12_cmd_list, texture_copy, texture);
+		auto itr = m_streamed_textures.find(handle.m_id);
+		return itr != m_streamed_textures.end() ? itr->second.m_resident_mip : 0;
 	}
 
 	void D3D12TexturePool::GenerateMips_Cubemap(d3d12::TextureResource* texture, CommandList* cmd_list, unsigned int array_slice)
@@ -14,8 +14,8 @@
  * limitations under the License.
  */
 /*
-The mipmapping implementation used in this framework is a ported version of
-MiniEngine's implementation.
+The cubemap mipmapping implementation used in this framework is a ported version of
+MiniEngine's implementation. Loaded textures get their mips on the CPU, see util::GenerateMipChain.
 */
 /*
 The MIT License(MIT)
@@ -45,7 +45,10 @@ SOFTWARE.
 #include "../resource_pool_texture.hpp"
 #include "d3d12_enums.hpp"
 #include "d3d12_texture_resources.hpp"
+#include "../util/thread_pool.hpp"
 #include <DirectXMath.h>
+#include <future>
+#include <memory>
 
 
 namespace wr
@@ -75,17 +78,32 @@ namespace wr
 		void ReleaseTemporaryResources() final;
 
 		d3d12::TextureResource* GetTextureResource(TextureHandle handle) final;
+		void RequestMips(std::vector<TextureMipRequest> const & requests) final;
+		//! The mip of the full texture that is mip 0 of its resource, only streamed textures start at a coarser one.
+		std::size_t GetResidentMip(TextureHandle const & handle);
 
 		//! Loads a texture from file.
 		/*!
 		  \param path std::string that contains a path to the texture file location.
-		  \param srgb Defines if the texture should be loaded as srgb texture or not (currently not supported). 
-		  \param generate_mips Defines if mipmaps should be created.
+		  \param srgb Defines if the texture is sRGB, so its mips are filtered in linear space. 
+		  \param generate_mips Defines if mipmaps should be created, they're filtered on the CPU while the texture is loaded.
+		  \param compression The block compression the texture is stored with, see settings::use_texture_compression.
 		  \return The texture handle to the loaded texture.
 		  \sa wr::TextureHandle
 		*/
-		[[nodiscard]] TextureHandle LoadFromFile(std::string_view path, bool srgb, bool generate_mips) final;
-		[[nodiscard]] TextureHandle LoadFromMemory(unsigned char* data, size_t width, size_t height, TextureFormat type, bool srgb, bool generate_mips) final;
+		[[nodiscard]] TextureHandle LoadFromFile(std::string_view path, bool srgb, bool generate_mips, TextureCompression compression = TextureCompression::NONE) final;
+		[[nodiscard]] TextureHandle LoadFromMemory(unsigned char* data, size_t width, size_t height, TextureFormat type, bool srgb, bool generate_mips, TextureCompression compression = TextureCompression::NONE) final;
+		//! Loads a texture from file on one of the decode threads.
+		/*!
+		  \param path std::string that contains a path to the texture file location.
+		  \param srgb Defines if the texture is sRGB, the handle shows black while loading it.
+		  \param generate_mips Defines if mipmaps should be created.
+		  \param compression Normal maps show a flat normal while loading, other data textures white.
+		  \return The texture handle, valid right away.
+		  \sa wr::TexturePool::LoadFromFileAsync
+		*/
+		[[nodiscard]] TextureHandle LoadFromFileAsync(std::string_view path, bool srgb, bool generate_mips, TextureCompression compression = TextureCompression::NONE) final;
+		[[nodiscard]] TextureHandle LoadFromMemoryAsync(unsigned char* data, size_t width, size_t height, TextureFormat type, bool srgb, bool generate_mips, TextureCompression compression = TextureCompression::NONE) final;
 		[[nodiscard]] TextureHandle CreateCubemap(std::string_view name, uint32_t width, uint32_t height, uint32_t mip_levels, Format format, bool allow_render_dest) final;
 		[[nodiscard]] TextureHandle CreateTexture(std::string_view name, uint32_t width, uint32_t height, uint32_t mip_levels, Format format, bool allow_render_dest) final;
 
@@ -100,11 +118,31 @@ namespace wr
 	protected:
 
 		void MoveStagedTextures(unsigned int frame_idx);
-		void GenerateMips(d3d12::TextureResource* texture, CommandList* cmd_list);
-
-		void GenerateMips_UAV(d3d12::TextureResource* texture, CommandList* cmd_list);
-		void GenerateMips_BGR(d3d12::TextureResource* texture, CommandList* cmd_list);
-		void GenerateMips_SRGB(d3d12::TextureResource* texture, CommandList* cmd_list);
+		//! Creates the resources of the decoded asynchronous loads and adds them to the unstaged textures, m_mutex has to be held.
+		void FinishAsyncLoads();
+		TextureHandle QueueAsyncLoad(std::future<std::unique_ptr<DirectX::ScratchImage>> image, std::string name, bool srgb, TextureCompression compression);
+		//! Creates the resource of a decoded image, with the image's mips from first_mip on.
+		d3d12::TextureResource* CreateTextureFromImage(DirectX::ScratchImage const & image, std::size_t first_mip, std::wstring const & name);
+		//! Adds a created texture to the unstaged textures, and to the streamed textures when it doesn't start at mip 0.
+		void AddUnstagedTexture(uint64_t texture_id, d3d12::TextureResource* texture, std::unique_ptr<DirectX::ScratchImage> image, std::size_t first_mip, std::wstring name);
+		//! Copies num_mips of the image's mips, from first_mip on, to the first mips of a texture.
+		static void UploadMips(d3d12::CommandList* cmd_list, d3d12::TextureResource* texture, DirectX::ScratchImage const & image, std::size_t first_mip, std::size_t num_mips);
+
+		//! The mip a loaded texture starts at, 0 for textures that don't stream.
+		static std::size_t GetInitialMip(DirectX::TexMetadata const & metadata);
+		//! Block compressed textures can only start at mips with a multiple of 4 texels along both sides.
+		static bool CanStartAtMip(DirectX::TexMetadata const & metadata, std::size_t mip);
+		//! Bytes of the image's mips from first_mip on.
+		static std::size_t GetMipChainSize(DirectX::ScratchImage const & image, std::size_t first_mip);
+
+		//! Bytes a staged streamed texture counts against settings::texture_streaming_budget, its image in memory and its resident mips.
+		static std::size_t GetStreamedSize(DirectX::ScratchImage const & image, std::size_t resident_mip);
+
+		//! Streams in the requested mips of the streamed textures and evicts unneeded ones to stay in settings::texture_streaming_budget.
+		void StreamMips(d3d12::CommandList* cmd_list);
+		//! Recreates a streamed texture's resource with the mips from mip on, the old resource is released once the GPU is done with it.
+		//! The mips the old resource has are copied over on the GPU, only the ones it lacks are uploaded.
+		void SetResidentMip(d3d12::CommandList* cmd_list, uint64_t texture_id, std::size_t mip);
 
 		//Unstaged textures are stored as pairs in a map. This removes the necessity of having a ScratchImage
 		//pointer in the Texture struct. Once the textures are staged the ScratchImages are deleted.
@@ -115,6 +153,40 @@ namespace wr
 		StagedTextures m_staged_textures;
 		std::vector<StagedTextures> m_staging_textures;
 
+		struct AsyncTextureLoad
+		{
+			std::future<std::unique_ptr<DirectX::ScratchImage>> m_image; // nullptr when the image couldn't be decoded
+			std::string m_name; // Empty for textures loaded from memory
+			TextureHandle m_default_texture; // Shown until the image is decoded, picked by the texture's role
+			bool m_failed = false; // Keeps showing the default texture until it's unloaded
+		};
+
+		//Textures that are still being decoded, GetTextureResource returns a default texture for them
+		std::unordered_map<uint64_t, AsyncTextureLoad> m_async_loads;
+		std::unique_ptr<util::ThreadPool> m_decode_thread_pool;
+
+		struct StreamedTexture
+		{
+			std::unique_ptr<DirectX::ScratchImage> m_image; // The whole mip chain, nullptr until the texture is staged
+			DirectX::TexMetadata m_metadata;
+			std::wstring m_name;
+			std::size_t m_resident_mip = 0; // Finest mip on the GPU
+			std::size_t m_initial_mip = 0; // Coarsest mip the texture gets evicted to
+			std::size_t m_requested_mip = 0; // Finest mip requested in m_request_frame
+			std::uint64_t m_request_frame = 0;
+		};
+
+		//Textures that started at a coarser mip, see settings::use_texture_streaming
+		std::unordered_map<uint64_t, StreamedTexture> m_streamed_textures;
+		std::size_t m_streamed_bytes = 0; // Bytes of the streamed textures on the GPU and of the images they stream from
+		std::uint64_t m_stream_frame = 0; // Incremented by every Stage
+		//Resources replaced by streaming, released when the frame they were replaced in comes around again
+		std::array<std::vector<ID3D12Resource*>, d3d12::settings::num_back_buffers> m_stream_releases;
+
+		TextureHandle m_default_color;
+		TextureHandle m_default_data;
+		TextureHandle m_default_normal;
+
 		D3D12RenderSystem& m_render_system;
 
 		//CPU only visible heaps used for staging of descriptors.
@@ -123,10 +195,6 @@ namespace wr
 
 		DescriptorAllocator* m_mipmapping_allocator;
 
-		//Track resources that are created in one frame and destroyed after
-		std::array<std::vector<d3d12::TextureResource*>, d3d12::settings::num_back_buffers> m_temporary_textures;
-		std::array< std::vector<d3d12::Heap<wr::HeapOptimization::BIG_STATIC_BUFFERS>*>, d3d12::settings::num_back_buffers> m_temporary_heaps;
-
 		//Resources marked for deletion
 		std::array<std::vector<d3d12::TextureResource*>, d3d12::settings::num_back_buffers> m_marked_for_unload;
 
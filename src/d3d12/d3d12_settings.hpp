@@ -52,7 +52,7 @@ namespace wr::d3d12::settings
 	static std::array<LPCWSTR, 1> debug_shader_args = { L"/O3" };
 	static std::array<LPCWSTR, 1> release_shader_args = { L"/O3" };
 	static const constexpr std::uint8_t num_back_buffers = 3;
-	static const constexpr std::uint32_t num_instances_per_batch = 768U;		//48 KiB for ObjectData[]
+	static const constexpr std::uint32_t num_instances_per_batch = 768U;		//72 KiB for ObjectData[] (96 bytes per instance)
 	static const constexpr std::uint32_t num_lights = 21'845;					//1 MiB for StructuredBuffer<Light>
 	static const constexpr std::uint32_t num_indirect_draw_commands = 8;		//Allow 8 different meshes non-indexed
 	static const constexpr std::uint32_t num_indirect_index_commands = 32;		//Allow 32 different meshes indexed
@@ -60,12 +60,19 @@ namespace wr::d3d12::settings
 	static const constexpr bool force_dxr_fallback = false;
 	static const constexpr bool disable_rtx = false;
 	static const constexpr bool enable_object_culling = true;
+	static const constexpr bool enable_meshlet_culling = true; // frustum cull the meshlets of meshes drawn with a single instance
+	static const constexpr bool enable_meshlet_cone_culling = false; // also reject back facing meshlets, only valid when every pipeline culls back faces
+	static const constexpr bool enable_lod_selection = true; // draw generated mesh LODs at a distance
+	static const constexpr float lod_screen_error = 0.001f; // deviation from the full mesh a LOD may show, as a fraction of the screen height
 	static const constexpr unsigned int num_max_rt_materials = 3000;
 	static const constexpr unsigned int num_max_rt_textures = 1000;
 	static const constexpr unsigned int fallback_ptrs_offset = 3500;
 	static const constexpr std::uint32_t res_skybox = 1024;
 	static const constexpr std::uint32_t res_envmap = 512;
 	static const constexpr unsigned int shadow_denoiser_wavelet_iterations = 4; // controls the number of iterations of the shadow denoiser, controlling the effective size of the kernel (size = 2^i + 1)
+	static const constexpr std::size_t model_pool_defrag_budget = 1024 * 1024; // bytes moved per frame by the incremental model pool defragmentation, 0 disables it
+	static const constexpr float model_pool_defrag_threshold = 0.25f; // fragmentation at which a model pool heap starts being compacted
+	static const constexpr unsigned int model_pool_defrag_max_candidates = 64; // allocations inspected per heap per frame
 	static const constexpr unsigned int shadow_denoiser_feedback_tap = 1; // After which of the iterations should the result be stored for denoising the next frame.
 	
 } /* wr::d3d12::settings */
@@ -123,6 +123,7 @@ namespace wr::d3d12
 			std::uint32_t m_indices_offset = 0u;
 
 			std::uint32_t m_vertex_stride = 0u;
+			std::uint32_t m_index_stride = sizeof(std::uint32_t);
 		};
 
 		struct StateObjectDesc
@@ -415,7 +416,7 @@ namespace wr::d3d12
 		{
 			d3d12::AccelerationStructure m_as;
 			std::uint64_t m_material = 0u;
-			DirectX::XMMATRIX m_transform;
+			DirectX::XMFLOAT3X4 m_transform;
 		};
 	} /* desc */
 
@@ -0,0 +1,368 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "d3d12_texture_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../settings.hpp"
+#include "../util/block_compression.hpp"
+#include "../util/content_hash.hpp"
+#include "../util/log.hpp"
+#include "../util/memory_mapped_file.hpp"
+#include "../util/mip_generation.hpp"
+#include "../util/thread_pool.hpp"
+
+namespace wr::d3d12
+{
+
+	namespace
+	{
+		// Bump when BakeTexture changes in a way the settings don't capture
+		constexpr std::uint64_t texture_cache_version = 4;
+
+		//! Shared by the decode threads, the rows of a texture's mips and blocks are spread over it.
+		util::ThreadPool& GetBakeThreadPool()
+		{
+			static util::ThreadPool thread_pool(settings::num_texture_bake_threads);
+			return thread_pool;
+		}
+
+		//! 8 bit RGBA, in which the mip filters and the block encoder read and write texels.
+		DXGI_FORMAT GetRGBA8Format(DXGI_FORMAT format)
+		{
+			// The sRGB flag carries over so the stored format keeps it
+			return DirectX::IsSRGB(format) ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+		}
+
+		//! The image as 8 bit RGBA, converted into `converted` when it's in another format. Returns nullptr when it can't be converted.
+		DirectX::ScratchImage const * GetRGBA8Image(DirectX::ScratchImage const & source, DirectX::ScratchImage& converted)
+		{
+			DirectX::TexMetadata const & metadata = source.GetMetadata();
+			DXGI_FORMAT const rgba_format = GetRGBA8Format(metadata.format);
+
+			if (metadata.format == rgba_format)
+			{
+				return &source;
+			}
+
+			HRESULT hr = DirectX::Convert(source.GetImages(), source.GetImageCount(), metadata, rgba_format, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, converted);
+			return SUCCEEDED(hr) ? &converted : nullptr;
+		}
+
+		//! 8 bit color goes through util::GenerateMipChain, anything wider, like HDR images, through DirectXTex's box filter.
+		bool CanFilterMips(DirectX::TexMetadata const & metadata)
+		{
+			return !DirectX::IsTypeless(metadata.format)
+				&& !DirectX::IsPlanar(metadata.format)
+				&& DirectX::BitsPerColor(metadata.format) <= 8;
+		}
+
+		//! Generates the full mip chain of a texture on the CPU.
+		/*!
+			keep_rgba8 leaves 8 bit textures as RGBA8 for the block encoder, otherwise they go back to their own format
+			so a single channel texture doesn't grow to four.
+		*/
+		bool GenerateMips(DirectX::ScratchImage const & image, CachedTextureKey const & key, bool keep_rgba8, DirectX::ScratchImage& mipped)
+		{
+			DirectX::TexMetadata const & metadata = image.GetMetadata();
+
+			if (!CanFilterMips(metadata))
+			{
+				return SUCCEEDED(DirectX::GenerateMipMaps(image.GetImages(), image.GetImageCount(), metadata, DirectX::TEX_FILTER_BOX, 0, mipped));
+			}
+
+			DirectX::ScratchImage converted;
+			DirectX::ScratchImage const * rgba = GetRGBA8Image(image, converted);
+			if (rgba == nullptr)
+			{
+				return false;
+			}
+
+			DXGI_FORMAT const rgba_format = GetRGBA8Format(metadata.format);
+			std::size_t const num_mips = util::GetMipCount(metadata.width, metadata.height);
+
+			DirectX::ScratchImage rgba_mipped;
+			if (FAILED(rgba_mipped.Initialize2D(rgba_format, metadata.width, metadata.height, metadata.arraySize, num_mips)))
+			{
+				return false;
+			}
+
+			util::MipChainDesc desc;
+			desc.m_filter = settings::use_kaiser_mip_filter ? util::MipFilter::KAISER : util::MipFilter::BOX;
+			desc.m_srgb = DirectX::IsSRGB(rgba_format);
+			desc.m_normal_map = key.m_normal_map;
+			desc.m_alpha_test = key.m_preserve_alpha_coverage ? settings::texture_mip_alpha_test : 0.f;
+
+			std::vector<util::MipLevel> levels(num_mips);
+
+			for (std::size_t item = 0; item < metadata.arraySize; ++item)
+			{
+				DirectX::Image const * top = rgba->GetImage(0, item, 0);
+				DirectX::Image const * top_mip = rgba_mipped.GetImage(0, item, 0);
+
+				for (std::size_t y = 0; y < top->height; ++y)
+				{
+					std::memcpy(top_mip->pixels + y * top_mip->rowPitch, top->pixels + y * top->rowPitch, top->width * 4);
+				}
+
+				for (std::size_t mip = 0; mip < num_mips; ++mip)
+				{
+					DirectX::Image const * level = rgba_mipped.GetImage(mip, item, 0);
+					levels[mip] = { level->pixels, level->width, level->height, level->rowPitch };
+				}
+
+				util::GenerateMipChain(desc, levels.data(), num_mips, &GetBakeThreadPool());
+			}
+
+			if (keep_rgba8 || metadata.format == rgba_format)
+			{
+				mipped = std::move(rgba_mipped);
+				return true;
+			}
+
+			return SUCCEEDED(DirectX::Convert(rgba_mipped.GetImages(), rgba_mipped.GetImageCount(), rgba_mipped.GetMetadata(),
+				metadata.format, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, mipped));
+		}
+
+		//! Block compression needs whole blocks, 8 bit color and a format DirectXTex can convert from.
+		/*!
+			Only the top mip has to be a multiple of 4, D3D12 pads the smaller ones.
+		*/
+		bool CanCompress(DirectX::TexMetadata const & metadata)
+		{
+			return metadata.dimension == DirectX::TEX_DIMENSION_TEXTURE2D
+				&& !DirectX::IsCompressed(metadata.format)
+				&& !DirectX::IsTypeless(metadata.format)
+				&& DirectX::BitsPerColor(metadata.format) <= 8
+				&& metadata.width % 4 == 0
+				&& metadata.height % 4 == 0;
+		}
+
+		//! The block format a texture is compressed to and the DXGI format it's stored as.
+		std::pair<util::BlockFormat, DXGI_FORMAT> GetBlockFormat(TextureCompression compression, DirectX::ScratchImage const & rgba)
+		{
+			bool const srgb = DirectX::IsSRGB(rgba.GetMetadata().format);
+
+			switch (compression)
+			{
+			case TextureCompression::SINGLE_CHANNEL:
+				return { util::BlockFormat::BC4, DXGI_FORMAT_BC4_UNORM };
+			case TextureCompression::NORMAL_MAP:
+				return { util::BlockFormat::BC5, DXGI_FORMAT_BC5_UNORM };
+			default:
+				if (settings::texture_compression_quality)
+				{
+					return { util::BlockFormat::BC7, srgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM };
+				}
+				else if (rgba.IsAlphaAllOpaque())
+				{
+					return { util::BlockFormat::BC1, srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM };
+				}
+				return { util::BlockFormat::BC3, srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM };
+			}
+		}
+
+		//! Block compresses every image of a texture with util::CompressImage.
+		bool CompressTexture(DirectX::ScratchImage const & source, TextureCompression compression, DirectX::ScratchImage& compressed)
+		{
+			DirectX::TexMetadata const & metadata = source.GetMetadata();
+
+			DirectX::ScratchImage converted;
+			DirectX::ScratchImage const * rgba_image = GetRGBA8Image(source, converted);
+			if (rgba_image == nullptr)
+			{
+				return false;
+			}
+
+			DirectX::ScratchImage const & rgba = *rgba_image;
+
+			auto const [block_format, dxgi_format] = GetBlockFormat(compression, rgba);
+
+			if (FAILED(compressed.Initialize2D(dxgi_format, metadata.width, metadata.height, metadata.arraySize, metadata.mipLevels)))
+			{
+				return false;
+			}
+
+			for (std::size_t item = 0; item < metadata.arraySize; ++item)
+			{
+				for (std::size_t mip = 0; mip < metadata.mipLevels; ++mip)
+				{
+					DirectX::Image const * in = rgba.GetImage(mip, item, 0);
+					DirectX::Image const * out = compressed.GetImage(mip, item, 0);
+
+					util::CompressImage(block_format, in->pixels, in->width, in->height, in->rowPitch, out->pixels, out->rowPitch, &GetBakeThreadPool());
+				}
+			}
+
+			if constexpr (settings::log_texture_compression_psnr)
+			{
+				DirectX::Image const * in = rgba.GetImage(0, 0, 0);
+				DirectX::Image const * out = compressed.GetImage(0, 0, 0);
+
+				double const psnr = util::ComputeCompressionPSNR(block_format, in->pixels, in->width, in->height, in->rowPitch, out->pixels, out->rowPitch);
+				LOG("[TEXTURE COMPRESSED] {}x{} to format {}, PSNR {:.2f} dB", in->width, in->height, static_cast<int>(dxgi_format), psnr);
+			}
+
+			return true;
+		}
+	}
+
+	std::string GetCachedTexturePath(void const * data, std::size_t size, CachedTextureKey const & key)
+	{
+		std::uint64_t hash = util::HashBytes(data, size, texture_cache_version);
+
+		std::uint64_t const flags[] = {
+			key.m_srgb,
+			key.m_generate_mips,
+			key.m_normal_map,
+			key.m_preserve_alpha_coverage,
+			key.m_width,
+			key.m_height,
+			static_cast<std::uint64_t>(key.m_compression),
+			settings::texture_compression_quality,
+			settings::use_kaiser_mip_filter,
+			static_cast<std::uint64_t>(settings::texture_mip_alpha_test * 255.f),
+		};
+		hash = util::HashBytes(flags, sizeof(flags), hash);
+
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx.dds", static_cast<unsigned long long>(hash));
+
+		return std::string(settings::texture_cache_directory) + name;
+	}
+
+	std::string GetCachedTexturePath(std::string_view source_path, CachedTextureKey const & key)
+	{
+		util::MemoryMappedFile source(source_path);
+		if (!source.IsOpen())
+		{
+			return {};
+		}
+
+		return GetCachedTexturePath(source.Data(), source.Size(), key);
+	}
+
+	bool BakeTexture(DirectX::ScratchImage& image, CachedTextureKey const & key)
+	{
+		// Most color images don't say they're sRGB, the load's flag decides so their mips are filtered in linear space.
+		// The baked texture goes back to the format it was decoded as, as the material shaders linearize it themselves.
+		DXGI_FORMAT const decoded_format = image.GetMetadata().format;
+		bool const promote_srgb = key.m_srgb && DirectX::MakeSRGB(decoded_format) != decoded_format;
+
+		if (promote_srgb)
+		{
+			image.OverrideFormat(DirectX::MakeSRGB(decoded_format));
+		}
+
+		auto const restore_format = [&image, promote_srgb]()
+		{
+			if (promote_srgb)
+			{
+				image.OverrideFormat(DirectX::MakeTypelessUNORM(DirectX::MakeTypeless(image.GetMetadata().format)));
+			}
+		};
+
+		DirectX::TexMetadata const metadata = image.GetMetadata();
+
+		DirectX::ScratchImage mipped;
+		bool const generate_mips = key.m_generate_mips
+			&& metadata.mipLevels == 1
+			&& metadata.dimension == DirectX::TEX_DIMENSION_TEXTURE2D
+			&& !DirectX::IsCompressed(metadata.format)
+			&& (metadata.width > 1 || metadata.height > 1);
+
+		// Mips don't change the format or the size of the top mip, so this holds for the mipped texture too
+		bool const compress = key.m_compression != TextureCompression::NONE && CanCompress(metadata);
+
+		if (generate_mips && !GenerateMips(image, key, compress, mipped))
+		{
+			LOGW("Couldn't generate the mips of a texture for the texture cache.");
+			restore_format();
+			return false;
+		}
+
+		DirectX::ScratchImage& source = generate_mips ? mipped : image;
+
+		DirectX::ScratchImage compressed;
+
+		if (compress && !CompressTexture(source, key.m_compression, compressed))
+		{
+			LOGW("Couldn't block compress a texture for the texture cache.");
+			restore_format();
+			return false;
+		}
+
+		if (compress)
+		{
+			image = std::move(compressed);
+		}
+		else if (generate_mips)
+		{
+			image = std::move(mipped);
+		}
+
+		restore_format();
+
+		return true;
+	}
+
+	bool ReadCachedTexture(std::string const & path, DirectX::ScratchImage& image)
+	{
+		std::error_code error;
+		if (!std::filesystem::exists(path, error))
+		{
+			return false;
+		}
+
+		std::wstring const wide_path(path.begin(), path.end());
+		return SUCCEEDED(DirectX::LoadFromDDSFile(wide_path.c_str(), DirectX::DDS_FLAGS_NONE, nullptr, image));
+	}
+
+	bool WriteCachedTexture(std::string const & path, DirectX::ScratchImage const & image)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+		// Written next to the final file and renamed when complete. Every decode thread gets its own temporary file,
+		// as a texture shared by several materials may be baked by more than one at a time.
+		std::string const temp_path = path + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+		std::wstring const wide_temp_path(temp_path.begin(), temp_path.end());
+
+		HRESULT hr = DirectX::SaveToDDSFile(image.GetImages(), image.GetImageCount(), image.GetMetadata(), DirectX::DDS_FLAGS_NONE, wide_temp_path.c_str());
+		if (FAILED(hr))
+		{
+			std::filesystem::remove(temp_path, error);
+			LOGW("Couldn't write cached texture {}", path);
+			return false;
+		}
+
+		std::filesystem::rename(temp_path, path, error);
+		if (error)
+		{
+			std::filesystem::remove(temp_path, error);
+			return false;
+		}
+
+		return true;
+	}
+
+} /* wr::d3d12 */
@@ -0,0 +1,65 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include <DirectXTex.h>
+
+#include "../resource_pool_texture.hpp"
+
+namespace wr::d3d12
+{
+
+	//! The load flags that change what a texture is cached as.
+	struct CachedTextureKey
+	{
+		bool m_srgb = false;
+		bool m_generate_mips = false;
+		// Mips renormalize the normal, see util::MipChainDesc
+		bool m_normal_map = false;
+		// Mips keep the share of texels passing settings::texture_mip_alpha_test
+		bool m_preserve_alpha_coverage = false;
+		TextureCompression m_compression = TextureCompression::NONE;
+		// Only set for raw pixels, which don't describe their own size
+		std::size_t m_width = 0;
+		std::size_t m_height = 0;
+	};
+
+	//! Path of the cached version of an encoded image in settings::texture_cache_directory.
+	/*!
+		The name is a hash of the image data, the key, the cache format version and the settings that change the baked
+		texture, so a stale texture is never picked up.
+	*/
+	std::string GetCachedTexturePath(void const * data, std::size_t size, CachedTextureKey const & key);
+	//! Same for an image file, returns an empty string when the file can't be read.
+	std::string GetCachedTexturePath(std::string_view source_path, CachedTextureKey const & key);
+
+	//! Turns a decoded image into what's cached: the full mip chain filtered on the CPU, block compressed as the key asks.
+	/*!
+		Images loaded as sRGB are filtered as sRGB, even when their format doesn't say so. The image is left untouched
+		and false is returned when a step fails.
+	*/
+	bool BakeTexture(DirectX::ScratchImage& image, CachedTextureKey const & key);
+
+	//! Reads a cached texture, returns false when there is none or it can't be read.
+	bool ReadCachedTexture(std::string const & path, DirectX::ScratchImage& image);
+	//! Writes a baked texture as a DDS file, complete or not at all.
+	bool WriteCachedTexture(std::string const & path, DirectX::ScratchImage const & image);
+
+} /* wr::d3d12 */
@@ -23,7 +23,7 @@
 
 namespace wr::d3d12
 {
-	TextureResource* CreateTexture(Device* device, desc::TextureDesc* description, bool allow_uav)
+	TextureResource* CreateTexture(Device* device, desc::TextureDesc* description, bool allow_uav, bool create_intermediate)
 	{
 		D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE;
 
@@ -66,24 +66,6 @@ namespace wr::d3d12
 			LOGC("Error: Couldn't create texture");
 		}
 
-		// Create intermediate resource on upload heap for staging
-		uint64_t textureUploadBufferSize;
-		device->m_native->GetCopyableFootprints(&desc, 0, desc.MipLevels * desc.DepthOrArraySize, 0, nullptr, nullptr, nullptr, &textureUploadBufferSize);
-
-		ID3D12Resource* intermediate;
-
-		CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
-		CD3DX12_RESOURCE_DESC buffer_desc = CD3DX12_RESOURCE_DESC::Buffer(textureUploadBufferSize);
-
-		device->m_native->CreateCommittedResource(
-			&uploadHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&buffer_desc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&intermediate));
-
-
 		TextureResource* texture = new TextureResource();
 
 		texture->m_width = description->m_width;
@@ -93,7 +75,7 @@ namespace wr::d3d12
 		texture->m_mip_levels = description->m_mip_levels;
 		texture->m_format = description->m_texture_format;
 		texture->m_resource = resource;
-		texture->m_intermediate = intermediate;
+		texture->m_intermediate = nullptr;
 		texture->m_need_mips = (texture->m_mip_levels > 1);
 		texture->m_is_cubemap = description->m_is_cubemap;
 		texture->m_is_staged = false;
@@ -103,9 +85,34 @@ namespace wr::d3d12
 			texture->m_subresource_states.push_back(description->m_initial_state);
 		}
 
+		if (create_intermediate)
+		{
+			CreateIntermediate(device, texture, desc.MipLevels * desc.DepthOrArraySize);
+		}
+
 		return texture;
 	}
 
+	void CreateIntermediate(Device* device, TextureResource* tex, unsigned int num_subresources)
+	{
+		D3D12_RESOURCE_DESC desc = tex->m_resource->GetDesc();
+
+		// Create intermediate resource on upload heap for staging
+		uint64_t textureUploadBufferSize;
+		device->m_native->GetCopyableFootprints(&desc, 0, num_subresources, 0, nullptr, nullptr, nullptr, &textureUploadBufferSize);
+
+		CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+		CD3DX12_RESOURCE_DESC buffer_desc = CD3DX12_RESOURCE_DESC::Buffer(textureUploadBufferSize);
+
+		device->m_native->CreateCommittedResource(
+			&uploadHeapProperties,
+			D3D12_HEAP_FLAG_NONE,
+			&buffer_desc,
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(&tex->m_intermediate));
+	}
+
 	TextureResource* CreatePlacedTexture(Device* device, desc::TextureDesc* description, bool allow_uav, Heap<HeapOptimization::BIG_STATIC_BUFFERS>* heap)
 	{
 		D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE;
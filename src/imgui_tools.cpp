@@ -101,7 +101,7 @@ namespace wr::imgui::internal
 	void ManipulateNode(wr::Node* node, SceneGraph* scene_graph, ImVec2 viewport_pos, ImVec2 viewport_size)
 	{
 		DirectX::XMFLOAT4X4 rmat;
-		auto mat = DirectX::XMMatrixTranslationFromVector(node->m_position);
+		auto mat = DirectX::XMMatrixTranslationFromVector(node->GetPosition());
 		DirectX::XMStoreFloat4x4(&rmat, mat);
 
 		auto cam = scene_graph->GetActiveCamera();
@@ -240,7 +240,7 @@ namespace wr::imgui::window
 	{
 		if (ImGui::Button("Teleport To"))
 		{
-			scene_graph->GetActiveCamera()->SetPosition(node->m_position);
+			scene_graph->GetActiveCamera()->SetPosition(node->GetPosition());
 
 			return true; // close popup.
 		}
@@ -297,7 +297,7 @@ namespace wr::imgui::window
 			[](std::shared_ptr<Node> node, SceneGraph* scene_graph)
 			{
 				auto light_node = std::static_pointer_cast<LightNode>(node);
-				auto& light = *light_node->m_light;
+				auto& light = light_node->m_temp;
 
 				const char* listbox_items[] = { "Point Light", "Directional Light", "Spot Light" };
 				int type = (int)light.tid & 3;
@@ -305,13 +305,15 @@ namespace wr::imgui::window
 				light.tid = type;
 
 				ImGui::ColorEdit3("Color", &light.col.x, ImGuiColorEditFlags_HDR);
-				ImGui::DragFloat3("Position", light_node->m_position.m128_f32, 0.25f);
+				DirectX::XMFLOAT3 position = light_node->m_position;
+				ImGui::DragFloat3("Position", &position.x, 0.25f);
+				light_node->SetPosition(DirectX::XMLoadFloat3(&position));
 
 				if (type != (uint32_t)LightType::POINT)
 				{
-					float rot[3] = { DirectX::XMConvertToDegrees(DirectX::XMVectorGetX(light_node->m_rotation_radians)),
-					DirectX::XMConvertToDegrees(DirectX::XMVectorGetY(light_node->m_rotation_radians)),
-					DirectX::XMConvertToDegrees(DirectX::XMVectorGetZ(light_node->m_rotation_radians)) };
+					float rot[3] = { DirectX::XMConvertToDegrees(light_node->m_rotation_radians.x),
+					DirectX::XMConvertToDegrees(light_node->m_rotation_radians.y),
+					DirectX::XMConvertToDegrees(light_node->m_rotation_radians.z) };
 					ImGui::DragFloat3("Rotation", rot, 0.01f);
 					light_node->SetRotation(DirectX::XMVectorSet(DirectX::XMConvertToRadians(rot[0]), DirectX::XMConvertToRadians(rot[1]), DirectX::XMConvertToRadians(rot[2]), 0));
 
@@ -336,8 +338,8 @@ namespace wr::imgui::window
 
 				if (ImGui::Button("Take Camera Transform"))
 				{
-					light_node->SetPosition(scene_graph->GetActiveCamera()->m_position);
-					light_node->SetRotation(scene_graph->GetActiveCamera()->m_rotation_radians);
+					light_node->SetPosition(scene_graph->GetActiveCamera()->GetPosition());
+					light_node->SetRotation(scene_graph->GetActiveCamera()->GetRotationRadians());
 				}
 
 				light_node->SignalTransformChange();
@@ -355,24 +357,24 @@ namespace wr::imgui::window
 
 				ImGui::Separator();
 
-				ImGui::DragFloat3("Position", model_node->m_position.m128_f32, 0.25f);
+				DirectX::XMFLOAT3 position = model_node->m_position;
+				ImGui::DragFloat3("Position", &position.x, 0.25f);
+				model_node->SetPosition(DirectX::XMLoadFloat3(&position));
 
-				float rot[3] = { DirectX::XMConvertToDegrees(DirectX::XMVectorGetX(model_node->m_rotation_radians)),
-				DirectX::XMConvertToDegrees(DirectX::XMVectorGetY(model_node->m_rotation_radians)),
-				DirectX::XMConvertToDegrees(DirectX::XMVectorGetZ(model_node->m_rotation_radians)) };
+				float rot[3] = { DirectX::XMConvertToDegrees(model_node->m_rotation_radians.x),
+				DirectX::XMConvertToDegrees(model_node->m_rotation_radians.y),
+				DirectX::XMConvertToDegrees(model_node->m_rotation_radians.z) };
 				ImGui::DragFloat3("Rotation", rot, 0.1f);
 				model_node->SetRotation(DirectX::XMVectorSet(DirectX::XMConvertToRadians(rot[0]), DirectX::XMConvertToRadians(rot[1]), DirectX::XMConvertToRadians(rot[2]), 0));
 
-				float scale[3] = { DirectX::XMVectorGetX(model_node->m_scale),
-				DirectX::XMVectorGetY(model_node->m_scale),
-				DirectX::XMVectorGetZ(model_node->m_scale) };
-				ImGui::DragFloat3("Scale", scale, 0.01f);
-				model_node->SetScale(DirectX::XMVectorSet(scale[0], scale[1], scale[2], 1.f));
+				DirectX::XMFLOAT3 scale = model_node->m_scale;
+				ImGui::DragFloat3("Scale", &scale.x, 0.01f);
+				model_node->SetScale(DirectX::XMLoadFloat3(&scale));
 
 				if (ImGui::Button("Take Camera Transform"))
 				{
-					model_node->SetPosition(scene_graph->GetActiveCamera()->m_position);
-					model_node->SetRotation(scene_graph->GetActiveCamera()->m_rotation_radians);
+					model_node->SetPosition(scene_graph->GetActiveCamera()->GetPosition());
+					model_node->SetRotation(scene_graph->GetActiveCamera()->GetRotationRadians());
 				}
 
 				// Material Settings
@@ -571,20 +573,24 @@ namespace wr::imgui::window
 				}
 				else
 				{
-					ImGui::DragFloat3("Position", selected_node->m_position.m128_f32, 0.25f);
+					DirectX::XMFLOAT3 position = selected_node->m_position;
+					ImGui::DragFloat3("Position", &position.x, 0.25f);
+					selected_node->SetPosition(DirectX::XMLoadFloat3(&position));
 
-					float rot[3] = { DirectX::XMConvertToDegrees(DirectX::XMVectorGetX(selected_node->m_rotation_radians)),
-					DirectX::XMConvertToDegrees(DirectX::XMVectorGetY(selected_node->m_rotation_radians)),
-					DirectX::XMConvertToDegrees(DirectX::XMVectorGetZ(selected_node->m_rotation_radians)) };
+					float rot[3] = { DirectX::XMConvertToDegrees(selected_node->m_rotation_radians.x),
+					DirectX::XMConvertToDegrees(selected_node->m_rotation_radians.y),
+					DirectX::XMConvertToDegrees(selected_node->m_rotation_radians.z) };
 					ImGui::DragFloat3("Rotation", rot, 0.1f);
 					selected_node->SetRotation(DirectX::XMVectorSet(DirectX::XMConvertToRadians(rot[0]), DirectX::XMConvertToRadians(rot[1]), DirectX::XMConvertToRadians(rot[2]), 0));
 
-					ImGui::DragFloat3("Scale", selected_node->m_scale.m128_f32, 0.01f);
+					DirectX::XMFLOAT3 scale = selected_node->m_scale;
+					ImGui::DragFloat3("Scale", &scale.x, 0.01f);
+					selected_node->SetScale(DirectX::XMLoadFloat3(&scale));
 
 					if (ImGui::Button("Take Camera Transform"))
 					{
-						selected_node->SetPosition(scene_graph->GetActiveCamera()->m_position);
-						selected_node->SetRotation(scene_graph->GetActiveCamera()->m_rotation_radians);
+						selected_node->SetPosition(scene_graph->GetActiveCamera()->GetPosition());
+						selected_node->SetRotation(scene_graph->GetActiveCamera()->GetRotationRadians());
 					}
 
 					selected_node->SignalChange();
@@ -128,9 +128,9 @@ namespace wr
 
 	MaterialPool::~MaterialPool()
 	{
-		for(auto& m : m_materials)
+		for(Material* m : m_materials)
 		{
-			delete m.second;
+			delete m;
 		}
 	}
 
@@ -138,12 +138,11 @@ namespace wr
 	{
 		MaterialHandle handle;
 		handle.m_pool = this;
-		handle.m_id = m_id_factory.GetUnusedID();
 
 		Material* mat = new Material(pool);
 		mat->SetConstantBufferHandle(m_constant_buffer_pool->Create(sizeof(Material::MaterialData)));
 
-		m_materials.insert(std::make_pair(handle.m_id, mat));
+		handle.m_id = m_materials.Insert(mat);
 
 		return handle;
 	}
@@ -154,13 +153,12 @@ namespace wr
 	{
 		MaterialHandle handle = {};
 		handle.m_pool = this;
-		handle.m_id = m_id_factory.GetUnusedID();
 
 		Material* mat = new Material(pool, albedo, normal, roughness, metallic, emissive, ao, mat_scales, is_alpha_masked, is_double_sided);
 		mat->SetConstantBufferHandle(m_constant_buffer_pool->Create(sizeof(Material::MaterialData)));
 		mat->UpdateConstantBuffer();
 
-		m_materials.insert(std::make_pair(handle.m_id, mat));
+		handle.m_id = m_materials.Insert(mat);
 
 		return handle;
 	}
@@ -168,34 +166,40 @@ namespace wr
 	Material* MaterialPool::GetMaterial(MaterialHandle handle)
 	{
 		// Return the material if available.
-		if (auto it = m_materials.find(handle.m_id); it != m_materials.end())
+		if (Material* material = FindMaterial(handle))
 		{
-			return it->second;
+			return material;
 		}
 
 		LOGE("Failed to obtain a material from pool.");
 		return nullptr;
 	}
 
+	Material* MaterialPool::FindMaterial(MaterialHandle handle)
+	{
+		Material** material = m_materials.Find(handle.m_id);
+		return material != nullptr ? *material : nullptr;
+	}
+
 	void MaterialPool::DestroyMaterial(MaterialHandle handle)
 	{
-		auto it = m_materials.find(handle.m_id);
+		Material** material = m_materials.Find(handle.m_id);
 
-		if (it == m_materials.end())
+		if (material == nullptr)
 		{
 			return;
 			//LOGC("Can't destroy material; it's not part of the material pool");
 		}
 
-		auto *ptr = it->second;
-		m_materials.erase(it);
+		auto *ptr = *material;
+		m_materials.Erase(handle.m_id);
 		delete ptr;
 
 	}
 
 	bool MaterialPool::HasMaterial(MaterialHandle handle) const
 	{
-		return m_materials.find(handle.m_id) != m_materials.end();
+		return m_materials.Contains(handle.m_id);
 	}
 
 } /* wr */
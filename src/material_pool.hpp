@@ -28,7 +28,7 @@
 #include "structs.hpp"
 #include "util/defines.hpp"
 #include "util/log.hpp"
-#include "id_factory.hpp"
+#include "util/slot_map.hpp"
 #include "constant_buffer_pool.hpp"
 
 struct aiMaterial;
@@ -226,6 +226,8 @@ namespace wr
 			Throws an error if no material was found.
 		*/
 		virtual Material* GetMaterial(MaterialHandle handle);
+		/*! Like GetMaterial, but returns nullptr without logging when the handle isn't in the pool. */
+		Material* FindMaterial(MaterialHandle handle);
 		/*! Check if the material owns a material with the specified handle */
 		bool HasMaterial(MaterialHandle handle) const;
 
@@ -234,9 +236,8 @@ namespace wr
 	protected:
 		std::shared_ptr<ConstantBufferPool> m_constant_buffer_pool;
 
-		std::unordered_map<uint64_t, Material*> m_materials;
-
-		IDFactory m_id_factory;
+		//! Indexed by MaterialHandle::m_id, handles of destroyed materials don't resolve to a newer material.
+		util::SlotMap<Material*, std::uint32_t> m_materials;
 	};
 
 
@@ -46,6 +46,8 @@ namespace wr
 	ModelData * ModelLoader::Load(std::string_view model_path)
 	{
 		ModelData* model = LoadModel(model_path);
+
+		std::lock_guard<std::mutex> lock(m_loaded_models_mutex);
 		m_loaded_models.push_back(model);
 		return model;
 	}
@@ -53,12 +55,16 @@ namespace wr
 	ModelData * ModelLoader::Load(void * data, std::size_t length, std::string format)
 	{
 		ModelData* model = LoadModel(data, length, format);
+
+		std::lock_guard<std::mutex> lock(m_loaded_models_mutex);
 		m_loaded_models.push_back(model);
 		return model;
 	}
 
 	void ModelLoader::DeleteModel(ModelData * model)
 	{
+		std::unique_lock<std::mutex> lock(m_loaded_models_mutex);
+
 		std::vector<ModelData*>::iterator it = std::find(m_loaded_models.begin(), m_loaded_models.end(), model);
 
 		if (it == m_loaded_models.end())
@@ -67,6 +73,7 @@ namespace wr
 		}
 
 		m_loaded_models.erase(it);
+		lock.unlock();
 
 		for (int i = 0; i < model->m_meshes.size(); ++i) 
 		{
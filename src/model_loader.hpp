@@ -17,6 +17,7 @@
 
 #include <string>
 #include <vector>
+#include <mutex>
 #include <DirectXMath.h>
 
 #include "wisprenderer_export.hpp"
@@ -28,6 +29,7 @@ namespace wr
 	struct ModelData;
 	struct ModelSkeletonData;
 	struct ModelBoneData;
+	struct ModelAnimationChannelData;
 	struct ModelAnimationData;
 
 	struct EmbeddedTexture;
@@ -76,6 +78,7 @@ namespace wr
 		std::vector<DirectX::XMFLOAT3> m_tangents;
 		std::vector<DirectX::XMFLOAT3> m_bitangents;
 
+		// Up to four influences per vertex, the ids index ModelSkeletonData::m_bones and unused weights are 0
 		std::vector<DirectX::XMFLOAT4> m_bone_weights;
 
 		std::vector<DirectX::XMFLOAT4> m_bone_ids;
@@ -130,20 +133,50 @@ namespace wr
 		bool m_two_sided;
 	};
 
+	//! A node of the skeleton, every node of the scene is one so animations can target any of them.
 	struct ModelBoneData
 	{
+		std::string m_name;
+		int m_parent = -1; // Parents always come before their children
 
+		// Bind pose relative to the parent
+		DirectX::XMFLOAT3 m_translation = { 0.f, 0.f, 0.f };
+		DirectX::XMFLOAT4 m_rotation = { 0.f, 0.f, 0.f, 1.f };
+		DirectX::XMFLOAT3 m_scale = { 1.f, 1.f, 1.f };
+
+		// From mesh space to the space of the bone in the bind pose (the inverse bind matrix)
+		DirectX::XMFLOAT4X4 m_offset = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
 	};
 
-	struct ModelAnimationData
+	//! The keys of one animated bone, the times are in seconds and ascending.
+	struct ModelAnimationChannelData
 	{
+		int m_bone = -1;
+
+		std::vector<float> m_position_times;
+		std::vector<DirectX::XMFLOAT3> m_positions;
+
+		std::vector<float> m_rotation_times;
+		std::vector<DirectX::XMFLOAT4> m_rotations;
 
+		std::vector<float> m_scale_times;
+		std::vector<DirectX::XMFLOAT3> m_scales;
+	};
+
+	struct ModelAnimationData
+	{
+		std::string m_name;
+		float m_duration = 0.f; // In seconds
+		std::vector<ModelAnimationChannelData> m_channels;
 	};
 
 	struct ModelSkeletonData 
 	{
 		std::vector<ModelBoneData*> m_bones;
 		std::vector<ModelAnimationData*> m_animations;
+
+		// Applied after the bones, brings the skinned vertices back into the space of the model's root
+		DirectX::XMFLOAT4X4 m_inverse_root_transform = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
 	};
 
 	struct EmbeddedTexture 
@@ -186,5 +219,8 @@ namespace wr
 
 		std::vector<ModelData*> m_loaded_models;
 		std::vector<std::string> m_supported_model_formats;
+
+		// Loads can come from the model pool's worker threads
+		std::mutex m_loaded_models_mutex;
 	};
 } /* wr */
@@ -56,11 +56,13 @@ namespace wr
 			LoadEmbeddedTextures(model, scene);
 		}
 
+		// The meshes look up their bones in the skeleton
+		model->m_skeleton_data = new ModelSkeletonData();
+		LoadSkeleton(model, scene);
+
 		LoadMaterials(model, scene);
 		LoadMeshes(model, scene, scene->mRootNode);
 
-		model->m_skeleton_data = new ModelSkeletonData();
-
 		return model;
 	}
 
@@ -92,11 +94,13 @@ namespace wr
 			LoadEmbeddedTextures(model, scene);
 		}
 
+		// The meshes look up their bones in the skeleton
+		model->m_skeleton_data = new ModelSkeletonData();
+		LoadSkeleton(model, scene);
+
 		LoadMaterials(model, scene);
 		LoadMeshes(model, scene, scene->mRootNode);
 
-		model->m_skeleton_data = new ModelSkeletonData();
-
 		return model;
 	}
 
@@ -170,6 +174,11 @@ namespace wr
 				count += face->mNumIndices;
 			}
 
+			if (mesh->HasBones())
+			{
+				LoadBoneWeights(model, mesh_data, mesh);
+			}
+
 			mesh_data->m_material_id = mesh->mMaterialIndex;
 
 			model->m_meshes.push_back(mesh_data);
@@ -181,6 +190,194 @@ namespace wr
 		}
 	}
 
+	namespace
+	{
+		DirectX::XMFLOAT4X4 ToXMFloat4x4(aiMatrix4x4 const & matrix)
+		{
+			// Assimp transforms column vectors, DirectXMath row vectors
+			aiMatrix4x4 transposed = matrix;
+			transposed.Transpose();
+
+			DirectX::XMFLOAT4X4 result;
+			memcpy(&result, &transposed, sizeof(result));
+			return result;
+		}
+
+		int FindBone(ModelSkeletonData const & skeleton, aiString const & name)
+		{
+			for (std::size_t i = 0; i < skeleton.m_bones.size(); ++i)
+			{
+				if (skeleton.m_bones[i]->m_name == name.C_Str())
+				{
+					return static_cast<int>(i);
+				}
+			}
+
+			return -1;
+		}
+
+		void AddBoneNodes(ModelSkeletonData& skeleton, aiNode const * node, int parent)
+		{
+			aiVector3D scale;
+			aiQuaternion rotation;
+			aiVector3D translation;
+			node->mTransformation.Decompose(scale, rotation, translation);
+
+			ModelBoneData* bone = new ModelBoneData();
+			bone->m_name = node->mName.C_Str();
+			bone->m_parent = parent;
+			bone->m_translation = { translation.x, translation.y, translation.z };
+			bone->m_rotation = { rotation.x, rotation.y, rotation.z, rotation.w };
+			bone->m_scale = { scale.x, scale.y, scale.z };
+
+			int const index = static_cast<int>(skeleton.m_bones.size());
+			skeleton.m_bones.push_back(bone);
+
+			for (unsigned int i = 0; i < node->mNumChildren; ++i)
+			{
+				AddBoneNodes(skeleton, node->mChildren[i], index);
+			}
+		}
+	}
+
+	void AssimpModelLoader::LoadSkeleton(ModelData * model, const aiScene * scene)
+	{
+		bool has_bones = false;
+		for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
+		{
+			has_bones |= scene->mMeshes[i]->HasBones();
+		}
+
+		if (!has_bones && !scene->HasAnimations())
+		{
+			return;
+		}
+
+		ModelSkeletonData& skeleton = *model->m_skeleton_data;
+
+		AddBoneNodes(skeleton, scene->mRootNode, -1);
+
+		DirectX::XMFLOAT4X4 const root_transform = ToXMFloat4x4(scene->mRootNode->mTransformation);
+		DirectX::XMStoreFloat4x4(&skeleton.m_inverse_root_transform, DirectX::XMMatrixInverse(nullptr, DirectX::XMLoadFloat4x4(&root_transform)));
+
+		// The offset matrix of a bone is the same in every mesh it influences
+		for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
+		{
+			aiMesh const * mesh = scene->mMeshes[i];
+			for (unsigned int b = 0; b < mesh->mNumBones; ++b)
+			{
+				int const bone = FindBone(skeleton, mesh->mBones[b]->mName);
+				if (bone >= 0)
+				{
+					skeleton.m_bones[bone]->m_offset = ToXMFloat4x4(mesh->mBones[b]->mOffsetMatrix);
+				}
+			}
+		}
+
+		LoadAnimations(model, scene);
+	}
+
+	void AssimpModelLoader::LoadAnimations(ModelData * model, const aiScene * scene)
+	{
+		ModelSkeletonData& skeleton = *model->m_skeleton_data;
+
+		for (unsigned int i = 0; i < scene->mNumAnimations; ++i)
+		{
+			aiAnimation const * animation = scene->mAnimations[i];
+
+			// Key times are in ticks, files that don't say how long a tick is use 25 per second
+			double const ticks_per_second = animation->mTicksPerSecond != 0.0 ? animation->mTicksPerSecond : 25.0;
+
+			ModelAnimationData* animation_data = new ModelAnimationData();
+			animation_data->m_name = animation->mName.C_Str();
+			animation_data->m_duration = static_cast<float>(animation->mDuration / ticks_per_second);
+
+			for (unsigned int c = 0; c < animation->mNumChannels; ++c)
+			{
+				aiNodeAnim const * channel = animation->mChannels[c];
+
+				ModelAnimationChannelData& channel_data = animation_data->m_channels.emplace_back();
+				channel_data.m_bone = FindBone(skeleton, channel->mNodeName);
+
+				for (unsigned int k = 0; k < channel->mNumPositionKeys; ++k)
+				{
+					aiVectorKey const & key = channel->mPositionKeys[k];
+					channel_data.m_position_times.push_back(static_cast<float>(key.mTime / ticks_per_second));
+					channel_data.m_positions.push_back({ key.mValue.x, key.mValue.y, key.mValue.z });
+				}
+
+				for (unsigned int k = 0; k < channel->mNumRotationKeys; ++k)
+				{
+					aiQuatKey const & key = channel->mRotationKeys[k];
+					channel_data.m_rotation_times.push_back(static_cast<float>(key.mTime / ticks_per_second));
+					channel_data.m_rotations.push_back({ key.mValue.x, key.mValue.y, key.mValue.z, key.mValue.w });
+				}
+
+				for (unsigned int k = 0; k < channel->mNumScalingKeys; ++k)
+				{
+					aiVectorKey const & key = channel->mScalingKeys[k];
+					channel_data.m_scale_times.push_back(static_cast<float>(key.mTime / ticks_per_second));
+					channel_data.m_scales.push_back({ key.mValue.x, key.mValue.y, key.mValue.z });
+				}
+
+				if (channel_data.m_bone < 0)
+				{
+					animation_data->m_channels.pop_back();
+				}
+			}
+
+			skeleton.m_animations.push_back(animation_data);
+		}
+	}
+
+	void AssimpModelLoader::LoadBoneWeights(ModelData * model, ModelMeshData * mesh_data, const aiMesh * mesh)
+	{
+		for (unsigned int b = 0; b < mesh->mNumBones; ++b)
+		{
+			aiBone const * bone = mesh->mBones[b];
+
+			int const bone_id = FindBone(*model->m_skeleton_data, bone->mName);
+			if (bone_id < 0)
+			{
+				continue;
+			}
+
+			for (unsigned int w = 0; w < bone->mNumWeights; ++w)
+			{
+				aiVertexWeight const & weight = bone->mWeights[w];
+
+				float* weights = &mesh_data->m_bone_weights[weight.mVertexId].x;
+				float* ids = &mesh_data->m_bone_ids[weight.mVertexId].x;
+
+				// Keeps the four largest influences, replacing the smallest one when all slots are taken
+				int slot = 0;
+				for (int i = 1; i < 4; ++i)
+				{
+					if (weights[i] < weights[slot])
+					{
+						slot = i;
+					}
+				}
+
+				if (weight.mWeight > weights[slot])
+				{
+					weights[slot] = weight.mWeight;
+					ids[slot] = static_cast<float>(bone_id);
+				}
+			}
+		}
+
+		// Dropped influences would make the vertex shrink towards the origin
+		for (DirectX::XMFLOAT4& weights : mesh_data->m_bone_weights)
+		{
+			float const sum = weights.x + weights.y + weights.z + weights.w;
+			if (sum > 0.f)
+			{
+				DirectX::XMStoreFloat4(&weights, DirectX::XMVectorScale(DirectX::XMLoadFloat4(&weights), 1.f / sum));
+			}
+		}
+	}
+
 	void AssimpModelLoader::LoadMaterials(ModelData * model, const aiScene * scene)
 	{
 		model->m_materials.resize(scene->mNumMaterials);
@@ -40,5 +40,9 @@ namespace wr
 		void LoadMeshes(ModelData* model, const aiScene* scene, aiNode* node);
 		void LoadMaterials(ModelData* model, const aiScene* scene);
 		void LoadEmbeddedTextures(ModelData* model, const aiScene* scene);
+		//! Only fills in the skeleton when the scene has bones or animations.
+		void LoadSkeleton(ModelData* model, const aiScene* scene);
+		void LoadAnimations(ModelData* model, const aiScene* scene);
+		void LoadBoneWeights(ModelData* model, ModelMeshData* mesh_data, const aiMesh* mesh);
 	};
 }
\ No newline at end of file
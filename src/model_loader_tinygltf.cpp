@@ -15,7 +15,15 @@
  */
 #include "model_loader_tinygltf.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
 #include "util/log.hpp"
+#include "util/memory_mapped_file.hpp"
+#include "settings.hpp"
 
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -25,79 +33,488 @@
 namespace wr
 {
 
-	TinyGLTFModelLoader::TinyGLTFModelLoader()
+	TinyGLTFModelLoader::TinyGLTFModelLoader() :
+		m_decode_thread_pool(std::make_unique<util::ThreadPool>(settings::num_model_decode_threads))
 	{
-		m_supported_model_formats = { "gltf" };
+		m_supported_model_formats = { "gltf", "glb" };
 	}
 
 	TinyGLTFModelLoader::~TinyGLTFModelLoader()
 	{
 	}
 
-	std::pair<std::vector<DirectX::XMFLOAT3>, std::vector<DirectX::XMFLOAT3>> ComputeTangents(ModelMeshData* mesh_data)
+	//! Per-mesh state of the tangent generator.
+	/*!
+		The triangles are split into ranges that are accumulated by separate jobs, each into its own partial sums.
+		Range 0 sums straight into the mesh, the others into m_partial_*. The partial sums are added in range order,
+		so the result is the same no matter which job finishes first.
+	*/
+	struct TangentJob
+	{
+		ModelMeshData* m_mesh = nullptr;
+		std::size_t m_num_ranges = 1;
+		std::vector<std::vector<DirectX::XMFLOAT3>> m_partial_tangents;
+		std::vector<std::vector<DirectX::XMFLOAT3>> m_partial_bitangents;
+	};
+
+	static const constexpr std::size_t min_triangles_per_tangent_range = 16384;
+	static const constexpr std::size_t min_vertices_per_tangent_resolve = 65536;
+
+	//! Adds the tangent and bitangent of triangles [first, last) to their three vertices.
+	inline void AccumulateTangents(ModelMeshData const & mesh, std::size_t first, std::size_t last, DirectX::XMFLOAT3* tangents, DirectX::XMFLOAT3* bitangents)
+	{
+		for (std::size_t t = first; t < last; ++t)
+		{
+			std::uint32_t const i0 = mesh.m_indices[t * 3 + 0];
+			std::uint32_t const i1 = mesh.m_indices[t * 3 + 1];
+			std::uint32_t const i2 = mesh.m_indices[t * 3 + 2];
+
+			DirectX::XMVECTOR const pos0 = DirectX::XMLoadFloat3(&mesh.m_positions[i0]);
+			DirectX::XMVECTOR const edge1 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&mesh.m_positions[i1]), pos0);
+			DirectX::XMVECTOR const edge2 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&mesh.m_positions[i2]), pos0);
+
+			float const du1 = mesh.m_uvw[i1].x - mesh.m_uvw[i0].x;
+			float const dv1 = mesh.m_uvw[i1].y - mesh.m_uvw[i0].y;
+			float const du2 = mesh.m_uvw[i2].x - mesh.m_uvw[i0].x;
+			float const dv2 = mesh.m_uvw[i2].y - mesh.m_uvw[i0].y;
+
+			// Triangles without UV area have no tangent frame
+			float const det = du1 * dv2 - dv1 * du2;
+			if (std::abs(det) < 1e-12f)
+			{
+				continue;
+			}
+
+			float const r = 1.0f / det;
+
+			DirectX::XMVECTOR const tangent = DirectX::XMVectorScale(DirectX::XMVectorSubtract(DirectX::XMVectorScale(edge1, dv2), DirectX::XMVectorScale(edge2, dv1)), r);
+			DirectX::XMVECTOR const bitangent = DirectX::XMVectorScale(DirectX::XMVectorSubtract(DirectX::XMVectorScale(edge1, du2), DirectX::XMVectorScale(edge2, du1)), r);
+
+			for (std::uint32_t i : { i0, i1, i2 })
+			{
+				DirectX::XMStoreFloat3(&tangents[i], DirectX::XMVectorAdd(DirectX::XMLoadFloat3(&tangents[i]), tangent));
+				DirectX::XMStoreFloat3(&bitangents[i], DirectX::XMVectorAdd(DirectX::XMLoadFloat3(&bitangents[i]), bitangent));
+			}
+		}
+	}
+
+	//! Adds the partial sums of vertices [first, last) to the mesh and normalizes the result.
+	inline void ResolveTangents(TangentJob& job, std::size_t first, std::size_t last)
 	{
-		size_t vtxCount = mesh_data->m_positions.size();
-		std::vector<DirectX::XMFLOAT3> tanA(vtxCount, { 0, 0, 0 });
-		std::vector<DirectX::XMFLOAT3> tanB(vtxCount, { 0, 0, 0 });
+		ModelMeshData& mesh = *job.m_mesh;
 
-		if (mesh_data->m_uvw.empty())
+		for (std::size_t v = first; v < last; ++v)
 		{
-			return { tanA, tanB };
+			DirectX::XMVECTOR tangent = DirectX::XMLoadFloat3(&mesh.m_tangents[v]);
+			DirectX::XMVECTOR bitangent = DirectX::XMLoadFloat3(&mesh.m_bitangents[v]);
+
+			for (std::size_t r = 0; r < job.m_partial_tangents.size(); ++r)
+			{
+				tangent = DirectX::XMVectorAdd(tangent, DirectX::XMLoadFloat3(&job.m_partial_tangents[r][v]));
+				bitangent = DirectX::XMVectorAdd(bitangent, DirectX::XMLoadFloat3(&job.m_partial_bitangents[r][v]));
+			}
+
+			// XMVector3Normalize keeps zero vectors at zero
+			DirectX::XMStoreFloat3(&mesh.m_tangents[v], DirectX::XMVector3Normalize(tangent));
+			DirectX::XMStoreFloat3(&mesh.m_bitangents[v], DirectX::XMVector3Normalize(bitangent));
 		}
+	}
+
+	//! Generates tangents and bitangents for all meshes, large meshes are split over several jobs.
+	inline void GenerateTangents(std::vector<ModelMeshData*> const & meshes, util::ThreadPool& pool)
+	{
+		std::size_t const max_ranges = std::max<std::size_t>(1, settings::num_model_decode_threads);
 
-		// (1)
-		size_t indexCount = mesh_data->m_indices.size();
-		for (size_t i = 0; i < mesh_data->m_indices.size(); i += 3) {
-			size_t i0 = mesh_data->m_indices[i];
-			size_t i1 = mesh_data->m_indices[i + 1];
-			size_t i2 = mesh_data->m_indices[i + 2];
+		std::vector<TangentJob> jobs(meshes.size());
+		for (std::size_t m = 0; m < meshes.size(); ++m)
+		{
+			ModelMeshData* mesh = meshes[m];
+			std::size_t const num_vertices = mesh->m_positions.size();
 
-			auto pos0 = DirectX::XMLoadFloat3(&mesh_data->m_positions[i0]);
-			auto pos1 = DirectX::XMLoadFloat3(&mesh_data->m_positions[i1]);
-			auto pos2 = DirectX::XMLoadFloat3(&mesh_data->m_positions[i2]);
+			mesh->m_tangents.assign(num_vertices, { 0, 0, 0 });
+			mesh->m_bitangents.assign(num_vertices, { 0, 0, 0 });
 
-			auto tex0 = DirectX::XMLoadFloat2(&DirectX::XMFLOAT2{ mesh_data->m_uvw[i0].x, mesh_data->m_uvw[i0].y });
-			auto tex1 = DirectX::XMLoadFloat2(&DirectX::XMFLOAT2{ mesh_data->m_uvw[i1].x, mesh_data->m_uvw[i1].y });
-			auto tex2 = DirectX::XMLoadFloat2(&DirectX::XMFLOAT2{ mesh_data->m_uvw[i2].x, mesh_data->m_uvw[i2].y });
+			jobs[m].m_mesh = mesh;
 
-			DirectX::XMFLOAT3 edge1, edge2;
-			DirectX::XMStoreFloat3(&edge1, DirectX::XMVectorSubtract(pos1, pos0));
-			DirectX::XMStoreFloat3(&edge2, DirectX::XMVectorSubtract(pos2, pos0));
+			if (mesh->m_uvw.size() < num_vertices)
+			{
+				jobs[m].m_num_ranges = 0;
+				continue;
+			}
 
-			DirectX::XMFLOAT2 uv1, uv2;
-			DirectX::XMStoreFloat2(&uv1, DirectX::XMVectorSubtract(tex1, tex0));
-			DirectX::XMStoreFloat2(&uv2, DirectX::XMVectorSubtract(tex2, tex0));
+			std::size_t const num_triangles = mesh->m_indices.size() / 3;
+			jobs[m].m_num_ranges = std::clamp<std::size_t>(num_triangles / min_triangles_per_tangent_range, 1, max_ranges);
+			jobs[m].m_partial_tangents.assign(jobs[m].m_num_ranges - 1, std::vector<DirectX::XMFLOAT3>(num_vertices, { 0, 0, 0 }));
+			jobs[m].m_partial_bitangents.assign(jobs[m].m_num_ranges - 1, std::vector<DirectX::XMFLOAT3>(num_vertices, { 0, 0, 0 }));
+		}
 
-			float r = 1.0f / (uv1.x * uv2.y - uv1.y * uv2.x);
+		std::vector<std::future<void>> work;
 
-			DirectX::XMFLOAT3 tangent(
-				((edge1.x * uv2.y) - (edge2.x * uv1.y)) * r,
-				((edge1.y * uv2.y) - (edge2.y * uv1.y)) * r,
-				((edge1.z * uv2.y) - (edge2.z * uv1.y)) * r
-			);
+		for (TangentJob& job : jobs)
+		{
+			std::size_t const num_triangles = job.m_mesh->m_indices.size() / 3;
+			for (std::size_t r = 0; r < job.m_num_ranges; ++r)
+			{
+				std::size_t const first = num_triangles * r / job.m_num_ranges;
+				std::size_t const last = num_triangles * (r + 1) / job.m_num_ranges;
+
+				DirectX::XMFLOAT3* tangents = r == 0 ? job.m_mesh->m_tangents.data() : job.m_partial_tangents[r - 1].data();
+				DirectX::XMFLOAT3* bitangents = r == 0 ? job.m_mesh->m_bitangents.data() : job.m_partial_bitangents[r - 1].data();
+
+				work.push_back(pool.Enqueue([&job, first, last, tangents, bitangents]
+				{
+					AccumulateTangents(*job.m_mesh, first, last, tangents, bitangents);
+				}));
+			}
+		}
 
-			DirectX::XMFLOAT3 bitangent(
-				((edge1.x * uv2.x) - (edge2.x * uv1.x)) * r,
-				((edge1.y * uv2.x) - (edge2.y * uv1.x)) * r,
-				((edge1.z * uv2.x) - (edge2.z * uv1.x)) * r
-			);
+		for (auto& w : work)
+		{
+			w.get();
+		}
+		work.clear();
 
-			tanA[i0] = tangent;
-			tanA[i1] = tangent;
-			tanA[i2] = tangent;
+		for (TangentJob& job : jobs)
+		{
+			if (job.m_num_ranges == 0)
+			{
+				continue;
+			}
 
-			tanB[i0] = bitangent;
-			tanB[i1] = bitangent;
-			tanB[i2] = bitangent;
+			std::size_t const num_vertices = job.m_mesh->m_positions.size();
+			std::size_t const num_resolves = std::clamp<std::size_t>(num_vertices / min_vertices_per_tangent_resolve, 1, max_ranges);
+			for (std::size_t r = 0; r < num_resolves; ++r)
+			{
+				std::size_t const first = num_vertices * r / num_resolves;
+				std::size_t const last = num_vertices * (r + 1) / num_resolves;
 
+				work.push_back(pool.Enqueue([&job, first, last]
+				{
+					ResolveTangents(job, first, last);
+				}));
+			}
 		}
 
-		return { tanA, tanB };
+		for (auto& w : work)
+		{
+			w.get();
+		}
 	}
 
-	inline void LoadMaterial(ModelData* model, tinygltf::Model tg_model, tinygltf::Material mat)
+	//! Typed window into a glTF buffer, reading through it doesn't copy the buffer.
+	struct AccessorView
+	{
+		unsigned char const * m_data = nullptr;
+		std::size_t m_stride = 0;
+		std::size_t m_count = 0;
+		int m_component_type = -1;
+		int m_num_components = 0;
+		bool m_normalized = false;
+	};
+
+	inline AccessorView GetAccessorView(tinygltf::Model const & tg_model, int accessor_id)
+	{
+		AccessorView view;
+
+		if (accessor_id < 0 || accessor_id >= static_cast<int>(tg_model.accessors.size()))
+		{
+			return view;
+		}
+
+		tinygltf::Accessor const & accessor = tg_model.accessors[accessor_id];
+
+		// Accessors without a buffer view are all zeros, or only sparse, neither shows up in meshes we render
+		if (accessor.bufferView < 0 || accessor.count == 0)
+		{
+			return view;
+		}
+
+		tinygltf::BufferView const & buffer_view = tg_model.bufferViews[accessor.bufferView];
+		tinygltf::Buffer const & buffer = tg_model.buffers[buffer_view.buffer];
+
+		int const stride = accessor.ByteStride(buffer_view);
+		int const num_components = tinygltf::GetNumComponentsInType(static_cast<std::uint32_t>(accessor.type));
+		int const component_size = tinygltf::GetComponentSizeInBytes(static_cast<std::uint32_t>(accessor.componentType));
+		if (stride <= 0 || num_components <= 0 || component_size <= 0)
+		{
+			LOGW("TinyGLTF: accessor {} has an invalid layout", accessor_id);
+			return view;
+		}
+
+		std::size_t const offset = buffer_view.byteOffset + accessor.byteOffset;
+		std::size_t const last_byte = offset + static_cast<std::size_t>(stride) * (accessor.count - 1) + static_cast<std::size_t>(num_components * component_size);
+		if (last_byte > buffer.data.size())
+		{
+			LOGW("TinyGLTF: accessor {} reads past the end of its buffer", accessor_id);
+			return view;
+		}
+
+		view.m_data = buffer.data.data() + offset;
+		view.m_stride = static_cast<std::size_t>(stride);
+		view.m_count = accessor.count;
+		view.m_component_type = accessor.componentType;
+		view.m_num_components = num_components;
+		view.m_normalized = accessor.normalized;
+
+		return view;
+	}
+
+	inline std::uint32_t ReadIndex(AccessorView const & view, std::size_t i)
+	{
+		unsigned char const * element = view.m_data + i * view.m_stride;
+
+		switch (view.m_component_type)
+		{
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			return *element;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+		{
+			std::uint16_t index;
+			memcpy(&index, element, sizeof(index));
+			return index;
+		}
+		default:
+		{
+			std::uint32_t index;
+			memcpy(&index, element, sizeof(index));
+			return index;
+		}
+		}
+	}
+
+	//! Reads up to num_floats components of element i as floats, normalized integers are converted to [0, 1].
+	inline void ReadFloats(AccessorView const & view, std::size_t i, float* out, int num_floats)
+	{
+		unsigned char const * element = view.m_data + i * view.m_stride;
+		int const n = std::min(num_floats, view.m_num_components);
+
+		switch (view.m_component_type)
+		{
+		case TINYGLTF_COMPONENT_TYPE_FLOAT:
+			memcpy(out, element, n * sizeof(float));
+			break;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			for (int c = 0; c < n; ++c)
+			{
+				out[c] = element[c] / (view.m_normalized ? 255.f : 1.f);
+			}
+			break;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			for (int c = 0; c < n; ++c)
+			{
+				std::uint16_t value;
+				memcpy(&value, element + c * sizeof(value), sizeof(value));
+				out[c] = value / (view.m_normalized ? 65535.f : 1.f);
+			}
+			break;
+		default:
+			LOGW("TinyGLTF: unsupported vertex attribute component type {}", view.m_component_type);
+			break;
+		}
+	}
+
+	//! Reads a float3 attribute, optionally transformed as a point. Strided float data is converted 4-wide with DirectXMath.
+	inline void ReadFloat3s(AccessorView const & view, std::vector<DirectX::XMFLOAT3>& out, DirectX::XMMATRIX const * transform = nullptr)
+	{
+		out.resize(view.m_count);
+
+		if (view.m_component_type != TINYGLTF_COMPONENT_TYPE_FLOAT || view.m_num_components < 3)
+		{
+			for (std::size_t i = 0; i < view.m_count; ++i)
+			{
+				ReadFloats(view, i, &out[i].x, 3);
+				if (transform != nullptr)
+				{
+					DirectX::XMStoreFloat3(&out[i], DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&out[i]), *transform));
+				}
+			}
+			return;
+		}
+
+		// Tightly packed float3 without a transform is the common case and can be copied in one go
+		if (transform == nullptr && view.m_stride == sizeof(DirectX::XMFLOAT3))
+		{
+			memcpy(out.data(), view.m_data, view.m_count * sizeof(DirectX::XMFLOAT3));
+			return;
+		}
+
+		for (std::size_t i = 0; i < view.m_count; ++i)
+		{
+			DirectX::XMVECTOR v = DirectX::XMLoadFloat3(reinterpret_cast<DirectX::XMFLOAT3 const *>(view.m_data + i * view.m_stride));
+			if (transform != nullptr)
+			{
+				v = DirectX::XMVector3Transform(v, *transform);
+			}
+			DirectX::XMStoreFloat3(&out[i], v);
+		}
+	}
+
+	//! Reads TEXCOORD_0 into the UVW array, flipping V for D3D.
+	inline void ReadUVs(AccessorView const & view, std::vector<DirectX::XMFLOAT3>& out)
+	{
+		out.resize(view.m_count);
+
+		// XMLoadFloat2 clears z, so the multiply produces the whole UVW
+		DirectX::XMVECTOR const flip = DirectX::XMVectorSet(1.f, -1.f, 1.f, 1.f);
+
+		if (view.m_component_type == TINYGLTF_COMPONENT_TYPE_FLOAT)
+		{
+			for (std::size_t i = 0; i < view.m_count; ++i)
+			{
+				DirectX::XMVECTOR const uv = DirectX::XMLoadFloat2(reinterpret_cast<DirectX::XMFLOAT2 const *>(view.m_data + i * view.m_stride));
+				DirectX::XMStoreFloat3(&out[i], DirectX::XMVectorMultiply(uv, flip));
+			}
+			return;
+		}
+
+		for (std::size_t i = 0; i < view.m_count; ++i)
+		{
+			DirectX::XMFLOAT2 uv = { 0.f, 0.f };
+			ReadFloats(view, i, &uv.x, 2);
+			DirectX::XMStoreFloat3(&out[i], DirectX::XMVectorMultiply(DirectX::XMLoadFloat2(&uv), flip));
+		}
+	}
+
+	//! What the loader returns for files it can't load, a model without meshes.
+	inline ModelData* CreateEmptyModel()
+	{
+		auto model = new ModelData();
+		model->m_skeleton_data = new wr::ModelSkeletonData();
+		return model;
+	}
+
+	//! Frees a model that failed halfway through loading, before it was handed to the ModelLoader.
+	inline void DeleteModelData(ModelData* model)
+	{
+		for (ModelMeshData* mesh : model->m_meshes)
+		{
+			delete mesh;
+		}
+
+		for (ModelMaterialData* material : model->m_materials)
+		{
+			delete material;
+		}
+
+		for (EmbeddedTexture* texture : model->m_embedded_textures)
+		{
+			delete texture;
+		}
+
+		for (ModelAnimationData* animation : model->m_skeleton_data->m_animations)
+		{
+			delete animation;
+		}
+
+		for (ModelBoneData* bone : model->m_skeleton_data->m_bones)
+		{
+			delete bone;
+		}
+
+		delete model->m_skeleton_data;
+		delete model;
+	}
+
+	//! Keeps the encoded bytes of images instead of decoding them, the texture pool decodes them when it loads the texture.
+	/*!
+		Images in buffer views are read straight from the buffer later, so only data URIs need their bytes kept here.
+	*/
+	inline bool KeepEncodedImage(tinygltf::Image* image, const int, std::string*, std::string*, int, int, const unsigned char* bytes, int size, void*)
+	{
+		if (image->bufferView < 0 && image->uri.compare(0, 5, "data:") == 0)
+		{
+			image->image.assign(bytes, bytes + size);
+		}
+
+		return true;
+	}
+
+	//! Fills in where the texture of a material slot comes from, embedded images are added to the model once and shared between slots.
+	/*!
+		Returns false when an image points outside of its buffer.
+	*/
+	inline bool LoadTexture(ModelData* model, tinygltf::Model const & tg_model, int texture_id, std::vector<int>& embedded_images,
+		TextureLocation& out_location, std::string& out_path, std::size_t& out_embedded_texture)
+	{
+		if (texture_id < 0 || texture_id >= static_cast<int>(tg_model.textures.size()))
+		{
+			return true;
+		}
+
+		int const image_id = tg_model.textures[texture_id].source;
+		if (image_id < 0 || image_id >= static_cast<int>(tg_model.images.size()))
+		{
+			return true;
+		}
+
+		tinygltf::Image const & img = tg_model.images[image_id];
+
+		if (img.bufferView < 0 && img.uri.compare(0, 5, "data:") != 0)
+		{
+			out_location = TextureLocation::EXTERNAL;
+			out_path = img.uri;
+			return true;
+		}
+
+		if (img.bufferView >= static_cast<int>(tg_model.bufferViews.size()))
+		{
+			LOGE("TinyGLTF: image {} uses buffer view {}, which doesn't exist", image_id, img.bufferView);
+			return false;
+		}
+
+		if (img.bufferView >= 0)
+		{
+			tinygltf::BufferView const & buffer_view = tg_model.bufferViews[img.bufferView];
+			if (buffer_view.buffer < 0 || buffer_view.buffer >= static_cast<int>(tg_model.buffers.size()))
+			{
+				LOGE("TinyGLTF: buffer view {} of image {} uses a buffer that doesn't exist", img.bufferView, image_id);
+				return false;
+			}
+
+			std::size_t const buffer_size = tg_model.buffers[buffer_view.buffer].data.size();
+			if (buffer_view.byteOffset > buffer_size || buffer_view.byteLength > buffer_size - buffer_view.byteOffset)
+			{
+				LOGE("TinyGLTF: buffer view {} of image {} reads past the end of its buffer", img.bufferView, image_id);
+				return false;
+			}
+		}
+
+		if (embedded_images[image_id] < 0)
+		{
+			EmbeddedTexture* texture = new EmbeddedTexture();
+			texture->m_compressed = true;
+			texture->m_format = img.mimeType == "image/jpeg" ? "jpg" : "png";
+
+			if (img.bufferView >= 0)
+			{
+				tinygltf::BufferView const & buffer_view = tg_model.bufferViews[img.bufferView];
+				unsigned char const * data = tg_model.buffers[buffer_view.buffer].data.data() + buffer_view.byteOffset;
+				texture->m_data.assign(data, data + buffer_view.byteLength);
+			}
+			else
+			{
+				texture->m_data = img.image;
+			}
+
+			// Compressed embedded textures store their size in bytes as the width, like the assimp loader does
+			texture->m_width = static_cast<std::uint32_t>(texture->m_data.size());
+			texture->m_height = 0;
+
+			embedded_images[image_id] = static_cast<int>(model->m_embedded_textures.size());
+			model->m_embedded_textures.push_back(texture);
+		}
+
+		out_location = TextureLocation::EMBEDDED;
+		out_embedded_texture = static_cast<std::size_t>(embedded_images[image_id]);
+
+		return true;
+	}
+
+	//! Adds the material to the model, returns false when one of its textures is invalid.
+	inline bool LoadMaterial(ModelData* model, tinygltf::Model const & tg_model, tinygltf::Material const & mat, std::vector<int>& embedded_images)
 	{
 		ModelMaterialData* mat_data = new ModelMaterialData();
+		bool valid = true;
 				
 		mat_data->m_albedo_texture_location = TextureLocation::NON_EXISTENT;
 		mat_data->m_normal_map_texture_location = TextureLocation::NON_EXISTENT;
@@ -106,23 +523,20 @@ namespace wr
 		mat_data->m_emissive_texture_location = TextureLocation::NON_EXISTENT;
 		mat_data->m_ambient_occlusion_texture_location = TextureLocation::NON_EXISTENT;
 
-		for (auto value : mat.values)
+		for (auto const & value : mat.values)
 		{
 			if (value.first == "baseColorTexture")
 			{
-				auto img = tg_model.images[value.second.json_double_value.begin()->second];						
-
-				mat_data->m_albedo_texture_location = TextureLocation::EXTERNAL;
-				mat_data->m_albedo_texture = img.uri;
+				valid &= LoadTexture(model, tg_model, value.second.TextureIndex(), embedded_images,
+					mat_data->m_albedo_texture_location, mat_data->m_albedo_texture, mat_data->m_albedo_embedded_texture);
 			}
 			else if (value.first == "metallicRoughnessTexture")
 			{
-				auto img = tg_model.images[value.second.json_double_value.begin()->second];
-
-				mat_data->m_metallic_texture_location = TextureLocation::EXTERNAL;
-				mat_data->m_metallic_texture = img.uri;
-				mat_data->m_roughness_texture_location = TextureLocation::EXTERNAL;
-				mat_data->m_roughness_texture = img.uri;
+				valid &= LoadTexture(model, tg_model, value.second.TextureIndex(), embedded_images,
+					mat_data->m_metallic_texture_location, mat_data->m_metallic_texture, mat_data->m_metallic_embedded_texture);
+				mat_data->m_roughness_texture_location = mat_data->m_metallic_texture_location;
+				mat_data->m_roughness_texture = mat_data->m_metallic_texture;
+				mat_data->m_roughness_embedded_texture = mat_data->m_metallic_embedded_texture;
 			}
 			else if (value.first == "roughnessFactor")
 			{
@@ -136,28 +550,22 @@ namespace wr
 			}
 		}
 
-		for (auto value : mat.additionalValues)
+		for (auto const & value : mat.additionalValues)
 		{
 			if (value.first == "normalTexture")
 			{
-				auto img = tg_model.images[value.second.json_double_value.begin()->second];
-
-				mat_data->m_normal_map_texture_location = TextureLocation::EXTERNAL;
-				mat_data->m_normal_map_texture = img.uri;
+				valid &= LoadTexture(model, tg_model, value.second.TextureIndex(), embedded_images,
+					mat_data->m_normal_map_texture_location, mat_data->m_normal_map_texture, mat_data->m_normal_map_embedded_texture);
 			}
 			else if (value.first == "occlusionTexture")
 			{
-				auto img = tg_model.images[value.second.json_double_value.begin()->second];
-
-				mat_data->m_ambient_occlusion_texture_location = TextureLocation::EXTERNAL;
-				mat_data->m_ambient_occlusion_texture = img.uri;
+				valid &= LoadTexture(model, tg_model, value.second.TextureIndex(), embedded_images,
+					mat_data->m_ambient_occlusion_texture_location, mat_data->m_ambient_occlusion_texture, mat_data->m_ambient_occlusion_embedded_texture);
 			}
 			else if (value.first == "emissiveTexture")
 			{
-				auto img = tg_model.images[value.second.json_double_value.begin()->second];
-
-				mat_data->m_emissive_texture_location = TextureLocation::EXTERNAL;
-				mat_data->m_emissive_texture = img.uri;
+				valid &= LoadTexture(model, tg_model, value.second.TextureIndex(), embedded_images,
+					mat_data->m_emissive_texture_location, mat_data->m_emissive_texture, mat_data->m_emissive_embedded_texture);
 			}
 			else if (value.first == "emissiveFactor")
 			{
@@ -167,108 +575,253 @@ namespace wr
 		}
 
 		model->m_materials.push_back(mat_data);
+
+		return valid;
 	}
 
-	inline void LoadMesh(ModelData* model, tinygltf::Model tg_model, tinygltf::Node node, DirectX::XMMATRIX parent_transform)
+	//! A primitive to decode, found while walking the scene graph.
+	struct PrimitiveJob
+	{
+		int m_mesh;
+		int m_primitive;
+		DirectX::XMFLOAT4X4 m_transform;
+		std::vector<int> const * m_joint_bones = nullptr; // Skeleton bone of every joint of the node's skin, skinned primitives only
+	};
+
+	//! Reads the four joints and weights of every vertex, the joints are mapped from the skin's joint list to skeleton bones.
+	inline void ReadSkinWeights(AccessorView const & joints, AccessorView const & weights, std::vector<int> const & joint_bones, ModelMeshData& mesh_data)
 	{
-		auto mesh = tg_model.meshes[node.mesh];
+		std::size_t const num_vertices = mesh_data.m_positions.size();
+		mesh_data.m_bone_ids.assign(num_vertices, { 0.f, 0.f, 0.f, 0.f });
+		mesh_data.m_bone_weights.assign(num_vertices, { 0.f, 0.f, 0.f, 0.f });
 
-		auto translation = node.translation;
-		auto rotation = node.rotation;
-		auto scale = node.scale;
-		auto matrix = node.matrix;
+		if (joints.m_count < num_vertices || weights.m_count < num_vertices)
+		{
+			return;
+		}
 
-		for (auto primitive : mesh.primitives)
+		for (std::size_t i = 0; i < num_vertices; ++i)
 		{
-			std::size_t idx_buffer_offset = 0;
-			std::size_t uv_buffer_offset = 0;
-			std::size_t position_buffer_offset = 0;
-			std::size_t normal_buffer_offset = 0;
-			ModelMeshData* mesh_data = new ModelMeshData();
+			float* ids = &mesh_data.m_bone_ids[i].x;
+			float* vertex_weights = &mesh_data.m_bone_weights[i].x;
 
-			{ // GET INDICES
-				auto idx_accessor = tg_model.accessors[primitive.indices];
+			ReadFloats(joints, i, ids, 4);
+			ReadFloats(weights, i, vertex_weights, 4);
 
-				const auto& buffer_view = tg_model.bufferViews[idx_accessor.bufferView];
-				const auto& buffer = tg_model.buffers[buffer_view.buffer];
-				const auto data_address = buffer.data.data() + buffer_view.byteOffset + idx_accessor.byteOffset;
-				const auto byte_stride = idx_accessor.ByteStride(buffer_view);
+			for (int j = 0; j < 4; ++j)
+			{
+				std::size_t const joint = static_cast<std::size_t>(ids[j]);
+				if (joint < joint_bones.size() && joint_bones[joint] >= 0)
+				{
+					ids[j] = static_cast<float>(joint_bones[joint]);
+				}
+				else
+				{
+					ids[j] = 0.f;
+					vertex_weights[j] = 0.f;
+				}
+			}
+		}
+	}
+
+	//! Appends the keys of an animation sampler.
+	/*!
+		Only the values of cubic spline keys are used, their tangents are skipped. A STEP key gets a copy of the previous
+		value right before it, so sampling can always interpolate linearly.
+	*/
+	template<typename T>
+	inline void ReadAnimationKeys(tinygltf::Model const & tg_model, tinygltf::AnimationSampler const & sampler, std::vector<float>& out_times, std::vector<T>& out_values)
+	{
+		AccessorView const input = GetAccessorView(tg_model, sampler.input);
+		AccessorView const output = GetAccessorView(tg_model, sampler.output);
 
-				mesh_data->m_indices.resize(idx_buffer_offset + idx_accessor.count);
+		bool const cubic = sampler.interpolation == "CUBICSPLINE";
+		bool const step = sampler.interpolation == "STEP";
+		std::size_t const values_per_key = cubic ? 3 : 1;
 
-				memcpy(mesh_data->m_indices.data() + idx_buffer_offset, data_address, idx_accessor.count * byte_stride);
-				idx_buffer_offset += idx_accessor.count * byte_stride;
+		if (input.m_data == nullptr || output.m_data == nullptr || output.m_count < input.m_count * values_per_key)
+		{
+			return;
+		}
+
+		for (std::size_t k = 0; k < input.m_count; ++k)
+		{
+			float time = 0.f;
+			ReadFloats(input, k, &time, 1);
+
+			T value = {};
+			ReadFloats(output, k * values_per_key + (cubic ? 1 : 0), &value.x, static_cast<int>(sizeof(T) / sizeof(float)));
+
+			if (step && !out_values.empty())
+			{
+				T const previous = out_values.back();
+				out_times.push_back(std::nextafter(time, -std::numeric_limits<float>::infinity()));
+				out_values.push_back(previous);
 			}
 
-			// Get other attributes
-			for (const auto& attrib : primitive.attributes)
+			out_times.push_back(time);
+			out_values.push_back(value);
+		}
+	}
+
+	inline void LoadAnimation(ModelSkeletonData& skeleton, tinygltf::Model const & tg_model, tinygltf::Animation const & animation, std::vector<int> const & node_bones)
+	{
+		ModelAnimationData* animation_data = new ModelAnimationData();
+		animation_data->m_name = animation.name;
+
+		for (tinygltf::AnimationChannel const & channel : animation.channels)
+		{
+			if (channel.target_node < 0 || channel.target_node >= static_cast<int>(node_bones.size()) || node_bones[channel.target_node] < 0 ||
+				channel.sampler < 0 || channel.sampler >= static_cast<int>(animation.samplers.size()))
 			{
-				const auto attrib_accessor = tg_model.accessors[attrib.second];
-				const auto& buffer_view = tg_model.bufferViews[attrib_accessor.bufferView];
-				const auto& buffer = tg_model.buffers[buffer_view.buffer];
-				const auto data_address = buffer.data.data() + buffer_view.byteOffset + attrib_accessor.byteOffset;
-				const auto byte_stride = attrib_accessor.ByteStride(buffer_view);
-				const auto count = attrib_accessor.count;
-				if (attrib.first == "POSITION")
-				{
-					mesh_data->m_positions.resize(position_buffer_offset + count);
-					mesh_data->m_colors.resize(position_buffer_offset + count);
+				continue;
+			}
 
-					memcpy(mesh_data->m_positions.data() + position_buffer_offset, data_address, count * byte_stride);
-					position_buffer_offset += count * byte_stride;
-				}
-				else if (attrib.first == "NORMAL")
-				{
-					mesh_data->m_normals.resize(normal_buffer_offset + count);
+			int const bone = node_bones[channel.target_node];
 
-					memcpy(mesh_data->m_normals.data() + normal_buffer_offset, data_address, count * byte_stride);
-					normal_buffer_offset += count * byte_stride;
-				}
-				else if (attrib.first == "TEXCOORD_0")
-				{
-					std::vector<DirectX::XMFLOAT2> f2_data;
-					f2_data.resize(count);
+			// The translation, rotation and scale of a node are separate channels in glTF
+			auto it = std::find_if(animation_data->m_channels.begin(), animation_data->m_channels.end(),
+				[bone](ModelAnimationChannelData const & c) { return c.m_bone == bone; });
+			ModelAnimationChannelData& channel_data = it != animation_data->m_channels.end() ? *it : animation_data->m_channels.emplace_back();
+			channel_data.m_bone = bone;
 
-					memcpy(f2_data.data(), data_address, count * byte_stride);
+			tinygltf::AnimationSampler const & sampler = animation.samplers[channel.sampler];
 
-					for (auto& f2 : f2_data)
-					{
-						mesh_data->m_uvw.push_back({ f2.x, f2.y*-1, 0 });
-					}
+			if (channel.target_path == "translation")
+			{
+				ReadAnimationKeys(tg_model, sampler, channel_data.m_position_times, channel_data.m_positions);
+			}
+			else if (channel.target_path == "rotation")
+			{
+				ReadAnimationKeys(tg_model, sampler, channel_data.m_rotation_times, channel_data.m_rotations);
+			}
+			else if (channel.target_path == "scale")
+			{
+				ReadAnimationKeys(tg_model, sampler, channel_data.m_scale_times, channel_data.m_scales);
+			}
 
-					uv_buffer_offset += count * sizeof(DirectX::XMFLOAT3);
+			for (std::vector<float> const * times : { &channel_data.m_position_times, &channel_data.m_rotation_times, &channel_data.m_scale_times })
+			{
+				if (!times->empty())
+				{
+					animation_data->m_duration = std::max(animation_data->m_duration, times->back());
 				}
 			}
+		}
 
-			// Apply Transformation
-			for (auto& position : mesh_data->m_positions)
+		skeleton.m_animations.push_back(animation_data);
+	}
+
+	//! Decodes one primitive into mesh data in world space, returns nullptr for primitives that can't be rendered.
+	/*!
+		Only reads the tinygltf model, so primitives can be decoded in parallel. Tangents are generated afterwards.
+	*/
+	inline ModelMeshData* DecodePrimitive(tinygltf::Model const & tg_model, PrimitiveJob const & job)
+	{
+		tinygltf::Mesh const & mesh = tg_model.meshes[job.m_mesh];
+		tinygltf::Primitive const & primitive = mesh.primitives[job.m_primitive];
+
+		if (primitive.mode != TINYGLTF_MODE_TRIANGLES && primitive.mode != -1)
+		{
+			LOGW("TinyGLTF: skipped a primitive of mesh '{}' that isn't a triangle list", mesh.name);
+			return nullptr;
+		}
+
+		AccessorView positions;
+		AccessorView normals;
+		AccessorView uvs;
+		AccessorView joints;
+		AccessorView weights;
+
+		for (auto const & attrib : primitive.attributes)
+		{
+			if (attrib.first == "POSITION")
+			{
+				positions = GetAccessorView(tg_model, attrib.second);
+			}
+			else if (attrib.first == "NORMAL")
 			{
-				auto transformed_pos = DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&position), parent_transform);
-				DirectX::XMStoreFloat3(&position, transformed_pos);
+				normals = GetAccessorView(tg_model, attrib.second);
 			}
+			else if (attrib.first == "TEXCOORD_0")
+			{
+				uvs = GetAccessorView(tg_model, attrib.second);
+			}
+			else if (attrib.first == "JOINTS_0")
+			{
+				joints = GetAccessorView(tg_model, attrib.second);
+			}
+			else if (attrib.first == "WEIGHTS_0")
+			{
+				weights = GetAccessorView(tg_model, attrib.second);
+			}
+		}
 
-			auto tangent_bitangent = ComputeTangents(mesh_data);
-			mesh_data->m_tangents = tangent_bitangent.first;
-			mesh_data->m_bitangents = tangent_bitangent.second;
-			mesh_data->m_uvw.resize(mesh_data->m_positions.size());
-			mesh_data->m_material_id = primitive.material;
+		if (positions.m_data == nullptr)
+		{
+			return nullptr;
+		}
+
+		ModelMeshData* mesh_data = new ModelMeshData();
+
+		DirectX::XMMATRIX const transform = DirectX::XMLoadFloat4x4(&job.m_transform);
+		ReadFloat3s(positions, mesh_data->m_positions, &transform);
+		mesh_data->m_colors.resize(positions.m_count);
+
+		if (normals.m_data != nullptr)
+		{
+			ReadFloat3s(normals, mesh_data->m_normals);
+		}
+
+		if (uvs.m_data != nullptr)
+		{
+			ReadUVs(uvs, mesh_data->m_uvw);
+		}
+
+		if (job.m_joint_bones != nullptr && joints.m_data != nullptr && weights.m_data != nullptr)
+		{
+			ReadSkinWeights(joints, weights, *job.m_joint_bones, *mesh_data);
+		}
 
-			model->m_meshes.push_back(mesh_data);
+		// Non-indexed primitives draw their vertices in order
+		AccessorView const indices = GetAccessorView(tg_model, primitive.indices);
+		if (indices.m_data != nullptr)
+		{
+			mesh_data->m_indices.resize(indices.m_count);
+			for (std::size_t i = 0; i < indices.m_count; ++i)
+			{
+				mesh_data->m_indices[i] = ReadIndex(indices, i);
+			}
 		}
+		else
+		{
+			mesh_data->m_indices.resize(positions.m_count);
+			for (std::size_t i = 0; i < positions.m_count; ++i)
+			{
+				mesh_data->m_indices[i] = static_cast<std::uint32_t>(i);
+			}
+		}
+
+		mesh_data->m_material_id = primitive.material;
+
+		return mesh_data;
 	}
 
-	ModelData* TinyGLTFModelLoader::LoadModel(std::string_view model_path)
+	//! Parses a glTF or GLB file from memory, binary files are recognised by their magic instead of their extension.
+	inline ModelData* LoadGLTFFromMemory(unsigned char const * data, std::size_t length, std::string const & base_dir, util::ThreadPool& pool)
 	{
 		tinygltf::Model tg_model;
 		tinygltf::TinyGLTF loader;
 		std::string err;
 		std::string warn;
-		std::string path = std::string(model_path);
 
-		if (!loader.LoadASCIIFromFile(&tg_model, &err, &warn, path))
-		{
-			LOGC("TinyGLTF Parsing Failed");
-		}
+		loader.SetImageLoader(KeepEncodedImage, nullptr);
+
+		bool const is_binary = length >= 4 && memcmp(data, "glTF", 4) == 0;
+
+		bool const parsed = is_binary ?
+			loader.LoadBinaryFromMemory(&tg_model, &err, &warn, data, static_cast<unsigned int>(length), base_dir) :
+			loader.LoadASCIIFromString(&tg_model, &err, &warn, reinterpret_cast<char const *>(data), static_cast<unsigned int>(length), base_dir);
 
 		if (!warn.empty())
 		{
@@ -280,22 +833,43 @@ namespace wr
 			LOGE("TinyGLTF Error: {}", err);
 		}
 
-		auto model = new ModelData();
-		model->m_skeleton_data = new wr::ModelSkeletonData();
+		auto model = CreateEmptyModel();
 
-		for (auto mat : tg_model.materials)
+		if (!parsed)
 		{
-			LoadMaterial(model, tg_model, mat);
+			LOGC("TinyGLTF Parsing Failed");
+			return model;
 		}
 
-		std::function<void(int, DirectX::XMMATRIX)> recursive_func = [&](int node_id, DirectX::XMMATRIX parent_transform)
+		// Index of the embedded texture made for each image, -1 until a material uses it
+		std::vector<int> embedded_images(tg_model.images.size(), -1);
+
+		for (tinygltf::Material const & mat : tg_model.materials)
 		{
-			auto node = tg_model.nodes[node_id];
+			if (!LoadMaterial(model, tg_model, mat, embedded_images))
+			{
+				DeleteModelData(model);
+				return CreateEmptyModel();
+			}
+		}
 
-			auto translation = node.translation;
-			auto scale = node.scale;
-			auto rotation = node.rotation;
-			auto matrix = node.matrix;
+		// Walking the nodes is cheap, it only collects the primitives in scene order
+		std::vector<PrimitiveJob> primitive_jobs;
+
+		// Every node becomes a bone when the model is skinned or animated, so any node can be animated
+		ModelSkeletonData& skeleton = *model->m_skeleton_data;
+		bool const has_skeleton = !tg_model.skins.empty() || !tg_model.animations.empty();
+		std::vector<int> node_bones(tg_model.nodes.size(), -1);
+		std::vector<std::vector<int>> skin_joint_bones(tg_model.skins.size());
+
+		std::function<void(int, DirectX::XMMATRIX, int)> recursive_func = [&](int node_id, DirectX::XMMATRIX parent_transform, int parent_bone)
+		{
+			tinygltf::Node const & node = tg_model.nodes[node_id];
+
+			auto const & translation = node.translation;
+			auto const & scale = node.scale;
+			auto const & rotation = node.rotation;
+			auto const & matrix = node.matrix;
 
 			DirectX::XMMATRIX transform;
 
@@ -308,53 +882,164 @@ namespace wr
 			}
 			else
 			{
-				transform.r[0].m128_f32[0] = matrix[0];
-				transform.r[0].m128_f32[1] = matrix[1];
-				transform.r[0].m128_f32[2] = matrix[2];
-				transform.r[0].m128_f32[3] = matrix[3];
-
-				transform.r[1].m128_f32[0] = matrix[4];
-				transform.r[1].m128_f32[1] = matrix[5];
-				transform.r[1].m128_f32[2] = matrix[6];
-				transform.r[1].m128_f32[3] = matrix[7];
-
-				transform.r[2].m128_f32[0] = matrix[8];
-				transform.r[2].m128_f32[1] = matrix[9];
-				transform.r[2].m128_f32[2] = matrix[10];
-				transform.r[2].m128_f32[3] = matrix[11];
-
-				transform.r[3].m128_f32[0] = matrix[12];
-				transform.r[3].m128_f32[1] = matrix[13];
-				transform.r[3].m128_f32[2] = matrix[14];
-				transform.r[3].m128_f32[3] = matrix[15];
-
+				DirectX::XMFLOAT4X4 matrix_f;
+				for (std::size_t i = 0; i < 16; ++i)
+				{
+					matrix_f.m[i / 4][i % 4] = static_cast<float>(matrix[i]);
+				}
+				transform = DirectX::XMLoadFloat4x4(&matrix_f);
 			}
 
 			parent_transform = parent_transform * transform;
 
+			int bone_id = -1;
+			if (has_skeleton)
+			{
+				DirectX::XMVECTOR bone_scale;
+				DirectX::XMVECTOR bone_rotation;
+				DirectX::XMVECTOR bone_translation;
+				DirectX::XMMatrixDecompose(&bone_scale, &bone_rotation, &bone_translation, transform);
+
+				ModelBoneData* bone = new ModelBoneData();
+				bone->m_name = node.name;
+				bone->m_parent = parent_bone;
+				DirectX::XMStoreFloat3(&bone->m_translation, bone_translation);
+				DirectX::XMStoreFloat4(&bone->m_rotation, bone_rotation);
+				DirectX::XMStoreFloat3(&bone->m_scale, bone_scale);
+
+				bone_id = static_cast<int>(skeleton.m_bones.size());
+				node_bones[node_id] = bone_id;
+				skeleton.m_bones.push_back(bone);
+			}
+
 			if (node.mesh > -1)
 			{
-				LoadMesh(model, tg_model, node, parent_transform);
+				bool const skinned = has_skeleton && node.skin >= 0 && node.skin < static_cast<int>(tg_model.skins.size());
+
+				for (int p = 0; p < static_cast<int>(tg_model.meshes[node.mesh].primitives.size()); ++p)
+				{
+					PrimitiveJob& job = primitive_jobs.emplace_back();
+					job.m_mesh = node.mesh;
+					job.m_primitive = p;
+
+					// The joints place a skinned mesh, the transform of its node is ignored
+					DirectX::XMStoreFloat4x4(&job.m_transform, skinned ? DirectX::XMMatrixIdentity() : parent_transform);
+					job.m_joint_bones = skinned ? &skin_joint_bones[node.skin] : nullptr;
+				}
 			}
 
 			for (auto child_id : node.children)
 			{
-				recursive_func(child_id, parent_transform);
+				recursive_func(child_id, parent_transform, bone_id);
 			}
 		};
 
+		if (tg_model.scenes.empty())
+		{
+			return model;
+		}
+
 		DirectX::XMMATRIX parent_transform = DirectX::XMMatrixIdentity();
-		for (auto node_id : tg_model.scenes[tg_model.defaultScene].nodes)
+		for (auto node_id : tg_model.scenes[tg_model.defaultScene > -1 ? tg_model.defaultScene : 0].nodes)
+		{
+			recursive_func(node_id, parent_transform, -1);
+		}
+
+		// Needs every node to have its bone, the primitive jobs read the joint lists while decoding
+		for (std::size_t s = 0; s < tg_model.skins.size(); ++s)
+		{
+			tinygltf::Skin const & skin = tg_model.skins[s];
+			AccessorView const inverse_binds = GetAccessorView(tg_model, skin.inverseBindMatrices);
+
+			for (std::size_t j = 0; j < skin.joints.size(); ++j)
+			{
+				int const node_id = skin.joints[j];
+				int const bone = node_id >= 0 && node_id < static_cast<int>(node_bones.size()) ? node_bones[node_id] : -1;
+				skin_joint_bones[s].push_back(bone);
+
+				// glTF matrices are column major for column vectors, which is the same memory layout as row major for row vectors
+				if (bone >= 0 && j < inverse_binds.m_count && inverse_binds.m_num_components == 16)
+				{
+					ReadFloats(inverse_binds, j, &skeleton.m_bones[bone]->m_offset._11, 16);
+				}
+			}
+		}
+
+		for (tinygltf::Animation const & animation : tg_model.animations)
 		{
-			recursive_func(node_id, parent_transform);
+			LoadAnimation(skeleton, tg_model, animation, node_bones);
+		}
+
+		// Every primitive is decoded by its own job into its own slot, so the meshes keep the scene order
+		std::vector<ModelMeshData*> decoded(primitive_jobs.size(), nullptr);
+		{
+			std::vector<std::future<void>> work;
+			work.reserve(primitive_jobs.size());
+			for (std::size_t i = 0; i < primitive_jobs.size(); ++i)
+			{
+				work.push_back(pool.Enqueue([&tg_model, &primitive_jobs, &decoded, i]
+				{
+					decoded[i] = DecodePrimitive(tg_model, primitive_jobs[i]);
+				}));
+			}
+
+			for (auto& w : work)
+			{
+				w.get();
+			}
+		}
+
+		for (ModelMeshData* mesh_data : decoded)
+		{
+			if (mesh_data != nullptr)
+			{
+				model->m_meshes.push_back(mesh_data);
+			}
+		}
+
+		// Tangent generation and vertex packing index the attributes with these unchecked
+		for (std::size_t m = 0; m < model->m_meshes.size(); ++m)
+		{
+			ModelMeshData const * mesh_data = model->m_meshes[m];
+			auto const max_index = std::max_element(mesh_data->m_indices.begin(), mesh_data->m_indices.end());
+			if (max_index != mesh_data->m_indices.end() && *max_index >= mesh_data->m_positions.size())
+			{
+				LOGE("TinyGLTF: mesh {} references vertex {}, but only has {} vertices", m, *max_index, mesh_data->m_positions.size());
+				DeleteModelData(model);
+				return CreateEmptyModel();
+			}
+		}
+
+		GenerateTangents(model->m_meshes, pool);
+
+		// Meshes without UVs still get a UVW per vertex
+		for (ModelMeshData* mesh_data : model->m_meshes)
+		{
+			mesh_data->m_uvw.resize(mesh_data->m_positions.size());
 		}
 
 		return model;
 	}
 
+	ModelData* TinyGLTFModelLoader::LoadModel(std::string_view model_path)
+	{
+		// The file is mapped instead of read, tinygltf parses it straight from the mapping
+		util::MemoryMappedFile file;
+		if (!file.Open(model_path))
+		{
+			LOGW("TinyGLTF: couldn't open '{}'", model_path);
+			return CreateEmptyModel();
+		}
+
+		std::string const base_dir = std::filesystem::path(model_path).parent_path().string();
+
+		return LoadGLTFFromMemory(file.Data(), file.Size(), base_dir, *m_decode_thread_pool);
+	}
+
 	ModelData* TinyGLTFModelLoader::LoadModel(void* data, std::size_t length, std::string format)
 	{
-		return new ModelData();
+		// External buffers and images of a glTF in memory are looked up relative to the working directory
+		return LoadGLTFFromMemory(static_cast<unsigned char const *>(data), length, "", *m_decode_thread_pool);
 	}
 
 }
\ No newline at end of file
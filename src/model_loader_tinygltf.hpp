@@ -15,7 +15,10 @@
  */
 #pragma once
 
+#include <memory>
+
 #include "model_loader.hpp"
+#include "util/thread_pool.hpp"
 
 namespace wr
 {
@@ -31,6 +34,9 @@ namespace wr
 		ModelData* LoadModel(void* data, std::size_t length, std::string format) final;
 
 	private:
+		//! Decodes primitives and generates tangents, separate from the model pool's load threads because those wait on it.
+		std::unique_ptr<util::ThreadPool> m_decode_thread_pool;
+
 		//void LoadMeshes(ModelData* model, tinygltf::Model tg_model, tinygltf::Node node);
 		//void LoadMaterials(ModelData* model, const aiScene* scene);
 		//void LoadEmbeddedTextures(ModelData* model, const aiScene* scene);
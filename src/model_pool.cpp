@@ -15,6 +15,9 @@
  */
 #include "model_pool.hpp"
 #include <utility>
+#include <chrono>
+#include <thread>
+#include <cmath>
 
 namespace wr
 {
@@ -28,450 +31,934 @@ namespace wr
 		std::size_t index_buffer_pool_size_in_bytes) : 
 		m_vertex_buffer_pool_size_in_bytes(vertex_buffer_pool_size_in_bytes),
 		m_index_buffer_pool_size_in_bytes(index_buffer_pool_size_in_bytes),
-		m_current_id(0)
+		m_process_thread_pool(std::make_unique<util::ThreadPool>(settings::num_mesh_process_threads))
 	{
 	}
 
+	ModelPool::~ModelPool()
+	{
+		// Joins the workers, so every pending load has a result after this
+		m_load_thread_pool.reset();
+
+		for (internal::AsyncModelLoadTask* task : m_async_loads)
+		{
+			if (task->m_worker.valid())
+			{
+				DeleteConvertedModel(task->m_worker.get());
+			}
+			DeleteConvertedModel(task->m_converted);
+
+			task->m_handle->m_state = AsyncLoadState::CANCELLED;
+			task->m_promise.set_value(nullptr);
+			delete task;
+		}
+
+		// The LOD handles are the only mesh handles the pool owns
+		for (LoadedMesh& mesh : m_loaded_meshes)
+		{
+			for (MeshLOD& lod : mesh.m_lods)
+			{
+				delete lod.m_mesh;
+			}
+		}
+	}
+
 	void ModelPool::Destroy(Model * model)
 	{
+		// A cached model is only destroyed when every Load that returned it has been matched by a Destroy
+		if (model->m_ref_count > 1)
+		{
+			--model->m_ref_count;
+			return;
+		}
+
+		for (auto it = m_model_cache.begin(); it != m_model_cache.end(); ++it)
+		{
+			if (it->second == model)
+			{
+				m_model_cache.erase(it);
+				break;
+			}
+		}
+
+		// Destroying a model that is still loading cancels the load. Its meshes are still the borrowed placeholder meshes.
+		for (internal::AsyncModelLoadTask* task : m_async_loads)
+		{
+			if (task->m_handle->m_model == model)
+			{
+				task->m_handle->m_model = nullptr;
+				task->m_handle->m_cancel = true;
+
+				// Meshes that were streamed in already are the model's own
+				if (task->m_next_coarse_mesh == 0)
+				{
+					model->m_meshes.clear();
+				}
+			}
+		}
+
 		DestroyModel(model);
 	}
 
-	void ModelPool::Destroy(internal::MeshInternal * mesh)
+	void ModelPool::Destroy(Mesh* mesh)
+	{
+		DestroyMesh(mesh->id);
+	}
+
+	void ModelPool::UpdateVertices(Mesh* mesh, void const * vertices, std::size_t num_vertices, std::size_t vertex_size)
 	{
-		DestroyMesh(mesh);
+		// Only read, the pool's upload functions take mutable pointers
+		UpdateMeshVertexData(mesh, const_cast<void*>(vertices), num_vertices, vertex_size);
 	}
 
-	template<>
-	int ModelPool::LoadNodeMeshes<Vertex, std::uint32_t>(ModelData* data, Model* model, MaterialHandle default_material)
+	std::vector<MaterialHandle> ModelPool::LoadMaterials(MaterialPool* material_pool, TexturePool* texture_pool, ModelData* data, std::string const & dir)
 	{
-		model->m_meshes.reserve(data->m_meshes.size());
+		std::vector<MaterialHandle> material_handles;
 
-		for (unsigned int i = 0; i < data->m_meshes.size(); ++i)
+		for (int i = 0; i < data->m_materials.size(); ++i)
 		{
-			ModelMeshData* mesh = data->m_meshes[i];
+			TextureHandle albedo, normals, metallic, roughness, emissive, ambient_occlusion;
 
-			std::vector<Vertex> vertices(mesh->m_positions.size());
-			std::vector<std::uint32_t> indices(mesh->m_indices.size());
+			ModelMaterialData* material = data->m_materials[i];
 
-			Mesh* mesh_handle = new Mesh();
+			// This lambda loads a texture either from memory or from disc.
+			// Asynchronous loads only queue the decode, so every texture of every material is decoded in parallel.
+			auto load_material_texture = [&](auto texture_location, auto embedded_texture_idx, std::string &texture_path, TextureHandle &handle, bool srgb, bool gen_mips, TextureCompression compression)
+			{
+				if (texture_location == TextureLocation::EMBEDDED)
+				{
+					EmbeddedTexture* texture = data->m_embedded_textures[embedded_texture_idx];
+
+					if (texture->m_compressed)
+					{
+						handle = settings::use_async_texture_loading
+							? texture_pool->LoadFromMemoryAsync(texture->m_data.data(), texture->m_width, texture->m_height, texture->m_format, srgb, gen_mips, compression)
+							: texture_pool->LoadFromMemory(texture->m_data.data(), texture->m_width, texture->m_height, texture->m_format, srgb, gen_mips, compression);
+					}
+					else
+					{
+						handle = settings::use_async_texture_loading
+							? texture_pool->LoadFromMemoryAsync(texture->m_data.data(), texture->m_width, texture->m_height, wr::TextureFormat::RAW, srgb, gen_mips, compression)
+							: texture_pool->LoadFromMemory(texture->m_data.data(), texture->m_width, texture->m_height, wr::TextureFormat::RAW, srgb, gen_mips, compression);
+					}
+				}
+				else if (texture_location == TextureLocation::EXTERNAL)
+				{
+					handle = settings::use_async_texture_loading
+						? texture_pool->LoadFromFileAsync(dir + texture_path, srgb, gen_mips, compression)
+						: texture_pool->LoadFromFile(dir + texture_path, srgb, gen_mips, compression);
+				}
+			};
+
+			//TODO: Maya team integrate texture scales in loading
+			// Currently default scales are set to 1 for all materials.
+			MaterialUVScales default_scales;
+
+			auto new_handle = material_pool->Create(texture_pool);
+			Material* mat = material_pool->GetMaterial(new_handle);
+
+			if (material->m_albedo_texture_location!=TextureLocation::NON_EXISTENT)
+			{
+				load_material_texture(material->m_albedo_texture_location, material->m_albedo_embedded_texture, material->m_albedo_texture, albedo, true, true, TextureCompression::COLOR);
+				mat->SetTexture(TextureType::ALBEDO, albedo);
+			}
+
+			if (material->m_normal_map_texture_location != TextureLocation::NON_EXISTENT)
+			{
+				load_material_texture(material->m_normal_map_texture_location, material->m_normal_map_embedded_texture, material->m_normal_map_texture, normals, false, true, TextureCompression::NORMAL_MAP);
+				mat->SetTexture(TextureType::NORMAL, normals);
+			}
 
-			for (unsigned int j = 0; j < mesh->m_positions.size(); ++j)
+			if (material->m_metallic_texture_location != TextureLocation::NON_EXISTENT)
 			{
-				Vertex &vertex = vertices[j];
+				load_material_texture(material->m_metallic_texture_location, material->m_metallic_embedded_texture, material->m_metallic_texture, metallic, false, true, TextureCompression::SINGLE_CHANNEL);
+				mat->SetTexture(TextureType::METALLIC, metallic);
+			}
 
-				memcpy(vertex.m_pos, &mesh->m_positions[j], sizeof(vertex.m_pos));
-				memcpy(vertex.m_normal, &mesh->m_normals[j], sizeof(vertex.m_normal));
-				memcpy(vertex.m_tangent, &mesh->m_tangents[j], sizeof(vertex.m_tangent));
-				memcpy(vertex.m_bitangent, &mesh->m_bitangents[j], sizeof(vertex.m_bitangent));
-				memcpy(vertex.m_uv, &mesh->m_uvw[j], sizeof(vertex.m_uv));
+			if (material->m_roughness_texture_location != TextureLocation::NON_EXISTENT)
+			{
+				load_material_texture(material->m_roughness_texture_location, material->m_roughness_embedded_texture, material->m_roughness_texture, roughness, false, true, TextureCompression::SINGLE_CHANNEL);
+				mat->SetTexture(TextureType::ROUGHNESS, roughness);
+			}
 
-				model->Expand(vertex.m_pos);
+			if (material->m_emissive_texture_location != TextureLocation::NON_EXISTENT)
+			{
+				load_material_texture(material->m_emissive_texture_location, material->m_emissive_embedded_texture, material->m_emissive_texture, emissive, true, true, TextureCompression::COLOR);
+				mat->SetTexture(TextureType::EMISSIVE, emissive);
+			}
 
+			if (material->m_ambient_occlusion_texture_location != TextureLocation::NON_EXISTENT)
+			{
+				load_material_texture(material->m_ambient_occlusion_texture_location, material->m_ambient_occlusion_embedded_texture, material->m_ambient_occlusion_texture, ambient_occlusion, false, true, TextureCompression::SINGLE_CHANNEL);
+				mat->SetTexture(TextureType::AO, ambient_occlusion);
 			}
 
-			memcpy(indices.data(), mesh->m_indices.data(), mesh->m_indices.size() * 4);
+			bool two_sided = material->m_two_sided;
 
-			internal::MeshInternal* mesh_data = LoadCustom_VerticesAndIndices(
-				vertices.data(),
-				vertices.size(),
-				sizeof(Vertex),
-				indices.data(),
-				indices.size(),
-				sizeof(std::uint32_t));
+			float opacity = material->m_base_transparency;
 
-			if (mesh_data == nullptr)
-			{
-				for (auto &elem : model->m_meshes)
-					delete elem.first;
+			mat->SetConstant<MaterialConstant::COLOR>({ material->m_base_color[0], material->m_base_color[1], material->m_base_color[2] });
+			mat->SetConstant<MaterialConstant::METALLIC>(material->m_base_metallic);
+			mat->SetConstant<MaterialConstant::EMISSIVE_MULTIPLIER>(material->m_base_emissive);
+			mat->SetConstant<MaterialConstant::ROUGHNESS>(material->m_base_roughness);
+			mat->SetConstant<MaterialConstant::IS_ALPHA_MASKED>(false);
+			mat->SetConstant<MaterialConstant::IS_DOUBLE_SIDED>(false);
+
+			material_handles.push_back(new_handle);
+		}
+
+		return material_handles;
+	}
 
-				delete model;
+	void ModelPool::FinalizeAsyncLoads()
+	{
+		// Shared by every streamed load, the ones that were started first finish first
+		std::size_t stream_budget = settings::model_stream_bytes_per_frame;
 
-				return 1;
+		for (auto it = m_async_loads.begin(); it != m_async_loads.end();)
+		{
+			internal::AsyncModelLoadTask* task = *it;
+			internal::ConvertedModelData* converted = task->m_converted;
+			bool const streaming = converted != nullptr;
+
+			if (!streaming)
+			{
+				if (task->m_worker.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				{
+					++it;
+					continue;
+				}
+
+				converted = task->m_worker.get();
 			}
 
-			std::uint64_t id = GetNewID();
-			m_loaded_meshes[id] = mesh_data;
-			mesh_handle->id = id;
+			AsyncModelHandle& handle = task->m_handle;
 
-			MaterialHandle material_handle = default_material;
+			Model* result = nullptr;
 
-			std::pair<Mesh*, MaterialHandle> n_mesh = std::make_pair(
-				mesh_handle,
-				material_handle);
+			if (handle->m_model != nullptr && task->m_next_coarse_mesh == 0 && (handle->m_cancel || converted == nullptr))
+			{
+				// Drop the borrowed placeholder meshes, the model stays empty until it's destroyed
+				handle->m_model->m_meshes.clear();
+				handle->m_model->m_version++;
+			}
 
+			if (handle->m_model == nullptr || handle->m_cancel)
+			{
+				// A streamed model keeps the meshes that made it
+				handle->m_state = AsyncLoadState::CANCELLED;
+			}
+			else
+			{
+				bool uploaded = false;
+
+				if (converted != nullptr && settings::stream_async_models)
+				{
+					if (!streaming)
+					{
+						BeginStreamedLoad(task, converted);
+					}
+
+					AsyncLoadState const state = StreamAsyncLoad(task, stream_budget);
+					if (state == AsyncLoadState::STREAMING)
+					{
+						handle->m_state = AsyncLoadState::STREAMING;
+						++it;
+						continue;
+					}
+
+					uploaded = state == AsyncLoadState::READY;
+				}
+				else
+				{
+					uploaded = converted != nullptr && FinalizeAsyncLoad(task, converted);
+				}
+
+				if (!uploaded)
+				{
+					LOGW("Failed to load model {} asynchronously.", handle->m_model->m_model_name);
+					handle->m_state = AsyncLoadState::FAILED;
+				}
+				else
+				{
+					result = handle->m_model;
+					handle->m_progress = 1.f;
+					handle->m_state = AsyncLoadState::READY;
+				}
+			}
 
-			model->m_meshes.push_back(n_mesh);
-		}
+			DeleteConvertedModel(converted);
+
+			task->m_promise.set_value(result);
 
-		return 0;
+			delete task;
+			it = m_async_loads.erase(it);
+		}
 	}
-	
-	template<>
-	int ModelPool::LoadNodeMeshes<VertexColor, std::uint32_t>(ModelData* data, Model* model, MaterialHandle default_material)
+
+	bool ModelPool::FinalizeAsyncLoad(internal::AsyncModelLoadTask* task, internal::ConvertedModelData* converted)
 	{
-		model->m_meshes.reserve(data->m_meshes.size());
+		Model* model = task->m_handle->m_model;
 
-		for (unsigned int i = 0; i < data->m_meshes.size(); ++i)
+		std::vector<MaterialHandle> material_handles;
+		if (task->m_with_materials)
 		{
-			ModelMeshData* mesh = data->m_meshes[i];
+			material_handles = LoadMaterials(task->m_material_pool, task->m_texture_pool, converted->m_data, task->m_directory);
+		}
 
-			std::vector<VertexColor> vertices(mesh->m_positions.size());
-			std::vector<std::uint32_t> indices(mesh->m_indices.size());
+		return UploadConvertedModel(*converted, model, material_handles);
+	}
 
-			Mesh* mesh_handle = new Mesh();
+	bool ModelPool::UploadConvertedModel(internal::ConvertedModelData& converted, Model* model, std::vector<MaterialHandle> const & material_handles)
+	{
+		std::size_t total_vertex_size = 0;
+		std::size_t total_index_size = 0;
 
-			for (unsigned int j = 0; j < mesh->m_positions.size(); ++j)
-			{
-				VertexColor &vertex = vertices[j];
+		for (auto& mesh : converted.m_meshes)
+		{
+			AddConvertedMeshSize(mesh, converted.m_vertex_stride, total_vertex_size, total_index_size);
+		}
 
-				memcpy(vertex.m_pos, &mesh->m_positions[j], sizeof(vertex.m_pos));
-				memcpy(vertex.m_normal, &mesh->m_normals[j], sizeof(vertex.m_normal));
-				memcpy(vertex.m_tangent, &mesh->m_tangents[j], sizeof(vertex.m_tangent));
-				memcpy(vertex.m_bitangent, &mesh->m_bitangents[j], sizeof(vertex.m_bitangent));
-				memcpy(vertex.m_uv, &mesh->m_uvw[j], sizeof(vertex.m_uv));
-				memcpy(vertex.m_color, &mesh->m_colors[j], sizeof(vertex.m_color));
+		MakeSpaceForModel(total_vertex_size, total_index_size);
 
-				model->Expand(vertex.m_pos);
+		// The placeholder meshes of an async load are borrowed, so they are only removed from the list
+		model->m_meshes.clear();
+		model->m_meshes.reserve(converted.m_meshes.size());
 
+		for (auto& mesh : converted.m_meshes)
+		{
+			Mesh* mesh_handle = UploadConvertedMesh(mesh, converted.m_vertex_stride);
+			if (mesh_handle == nullptr)
+			{
+				return false;
 			}
 
-			memcpy(indices.data(), mesh->m_indices.data(), sizeof(std::uint32_t)*mesh->m_indices.size());
-
-			internal::MeshInternal* mesh_data = LoadCustom_VerticesAndIndices(
-				vertices.data(),
-				vertices.size(),
-				sizeof(VertexColor),
-				indices.data(),
-				indices.size(),
-				sizeof(std::uint32_t));
-
-			if (mesh_data == nullptr)
+			MaterialHandle material_handle = { nullptr, 0 };
+			if (mesh.m_material_id >= 0 && mesh.m_material_id < material_handles.size())
 			{
-				for (auto &elem : model->m_meshes)
-					delete elem.first;
+				material_handle = material_handles[mesh.m_material_id];
+			}
 
-				delete model;
+			model->m_meshes.push_back(std::make_pair(mesh_handle, material_handle));
+		}
 
-				return 1;
-			}
+		model->m_box = converted.m_box;
+		model->m_version++;
 
-			std::uint64_t id = GetNewID();
-			m_loaded_meshes[id] = mesh_data;
-			mesh_handle->id = id;
+		return true;
+	}
 
-			MaterialHandle material_handle = default_material;
+	void ModelPool::BeginStreamedLoad(internal::AsyncModelLoadTask* task, internal::ConvertedModelData* converted)
+	{
+		task->m_converted = converted;
 
-			std::pair<Mesh*, MaterialHandle> n_mesh = std::make_pair(
-				mesh_handle,
-				material_handle);
+		if (task->m_with_materials)
+		{
+			task->m_material_handles = LoadMaterials(task->m_material_pool, task->m_texture_pool, converted->m_data, task->m_directory);
+		}
 
+		std::size_t total_vertex_size = 0;
+		std::size_t total_index_size = 0;
 
-			model->m_meshes.push_back(n_mesh);
+		for (auto& mesh : converted->m_meshes)
+		{
+			AddConvertedMeshSize(mesh, converted->m_vertex_stride, total_vertex_size, total_index_size);
 		}
 
-		return 0;
+		// Reserved up front, so streaming never grows the heaps halfway through a model
+		MakeSpaceForModel(total_vertex_size, total_index_size);
+
+		task->m_total_bytes = total_vertex_size + total_index_size;
 	}
 
-	template<>
-	int ModelPool::LoadNodeMeshes<VertexNoTangent, std::uint32_t>(ModelData* data, Model* model, MaterialHandle default_material)
+	AsyncLoadState ModelPool::StreamAsyncLoad(internal::AsyncModelLoadTask* task, std::size_t& budget)
 	{
-		model->m_meshes.reserve(data->m_meshes.size());
+		Model* model = task->m_handle->m_model;
+		internal::ConvertedModelData& converted = *task->m_converted;
 
-		for (unsigned int i = 0; i < data->m_meshes.size(); ++i)
+		auto consume = [&](std::size_t size)
 		{
-			ModelMeshData* mesh = data->m_meshes[i];
+			budget -= std::min(budget, size);
+			task->m_uploaded_bytes += size;
 
-			std::vector<VertexNoTangent> vertices(mesh->m_positions.size());
-			std::vector<std::uint32_t> indices(mesh->m_indices.size());
-
-			Mesh* mesh_handle = new Mesh();
+			if (task->m_total_bytes > 0)
+			{
+				task->m_handle->m_progress = 0.9f + 0.1f * static_cast<float>(task->m_uploaded_bytes) / static_cast<float>(task->m_total_bytes);
+			}
+		};
 
-			for (unsigned int j = 0; j < mesh->m_positions.size(); ++j)
+		while (task->m_next_coarse_mesh < converted.m_meshes.size())
+		{
+			if (budget == 0)
 			{
-				VertexNoTangent &vertex = vertices[j];
+				return AsyncLoadState::STREAMING;
+			}
+
+			internal::ConvertedMeshData& mesh = converted.m_meshes[task->m_next_coarse_mesh];
 
-				memcpy(vertex.m_pos, &mesh->m_positions[j], sizeof(vertex.m_pos));
-				memcpy(vertex.m_normal, &mesh->m_normals[j], sizeof(vertex.m_normal));
-				memcpy(vertex.m_uv, &mesh->m_uvw[j], sizeof(vertex.m_uv));
+			// A mesh without LODs is uploaded whole and doesn't need refining
+			internal::ConvertedMeshData& coarse = mesh.m_lods.empty() ? mesh : mesh.m_lods.back();
 
-				model->Expand(vertex.m_pos);
+			std::size_t vertex_size = 0;
+			std::size_t index_size = 0;
+			AddConvertedMeshSize(coarse, converted.m_vertex_stride, vertex_size, index_size);
 
+			Mesh* mesh_handle = UploadConvertedMesh(coarse, converted.m_vertex_stride);
+			if (mesh_handle == nullptr)
+			{
+				return AsyncLoadState::FAILED;
+			}
+
+			MaterialHandle material_handle = { nullptr, 0 };
+			if (mesh.m_material_id >= 0 && mesh.m_material_id < task->m_material_handles.size())
+			{
+				material_handle = task->m_material_handles[mesh.m_material_id];
+			}
+
+			// The borrowed placeholder meshes are shown until the first mesh of the model is resident
+			if (task->m_next_coarse_mesh == 0)
+			{
+				model->m_meshes.clear();
+				model->m_meshes.reserve(converted.m_meshes.size());
+				model->m_box = converted.m_box;
 			}
 
-			memcpy(indices.data(), mesh->m_indices.data(), sizeof(std::uint32_t)*mesh->m_indices.size());
+			model->m_meshes.push_back(std::make_pair(mesh_handle, material_handle));
+			model->m_version++;
 
-			internal::MeshInternal* mesh_data = LoadCustom_VerticesAndIndices(
-				vertices.data(),
-				vertices.size(),
-				sizeof(VertexNoTangent),
-				indices.data(),
-				indices.size(),
-				sizeof(std::uint32_t));
+			++task->m_next_coarse_mesh;
+			consume(vertex_size + index_size);
+		}
+
+		while (task->m_next_refined_mesh < converted.m_meshes.size())
+		{
+			internal::ConvertedMeshData& mesh = converted.m_meshes[task->m_next_refined_mesh];
+
+			if (mesh.m_lods.empty())
+			{
+				++task->m_next_refined_mesh;
+				continue;
+			}
 
-			if (mesh_data == nullptr)
+			if (budget == 0)
 			{
-				for (auto &elem : model->m_meshes)
-					delete elem.first;
+				return AsyncLoadState::STREAMING;
+			}
+
+			// Already resident, it's only needed to extend the LOD chain
+			internal::ConvertedMeshData coarse = std::move(mesh.m_lods.back());
+			mesh.m_lods.pop_back();
 
-				delete model;
+			std::size_t vertex_size = 0;
+			std::size_t index_size = 0;
+			AddConvertedMeshSize(mesh, converted.m_vertex_stride, vertex_size, index_size);
 
-				return 1;
+			Mesh* model_mesh = model->m_meshes[task->m_next_refined_mesh].first;
+			std::uint64_t const coarse_id = model_mesh->id;
+
+			// The model keeps the coarse LODs that are resident
+			Mesh* full_mesh = UploadConvertedMesh(mesh, converted.m_vertex_stride);
+			if (full_mesh == nullptr)
+			{
+				return AsyncLoadState::FAILED;
 			}
 
-			std::uint64_t id = GetNewID();
-			m_loaded_meshes[id] = mesh_data;
-			mesh_handle->id = id;
+			// A deduplicated mesh already has a complete LOD chain, a new one takes over the model's reference to the coarse LOD
+			if (m_mesh_deduplicator.IsShared(full_mesh->id))
+			{
+				if (ReleaseMesh(coarse_id))
+				{
+					DestroyMesh(coarse_id);
+				}
+			}
+			else
+			{
+				Mesh* lod_handle = new Mesh();
+				lod_handle->id = coarse_id;
+				m_loaded_meshes.Find(full_mesh->id)->m_lods.push_back({ lod_handle, coarse.m_error, coarse.m_num_indices / 3 });
+			}
 
-			MaterialHandle material_handle = default_material;
+			model_mesh->id = full_mesh->id;
+			delete full_mesh;
+			model->m_version++;
 
-			std::pair<Mesh*, MaterialHandle> n_mesh = std::make_pair(
-				mesh_handle,
-				material_handle);
+			++task->m_next_refined_mesh;
+			consume(vertex_size + index_size);
+		}
 
-			model->m_meshes.push_back(n_mesh);
+		return AsyncLoadState::READY;
+	}
+
+	void ModelPool::AddConvertedMeshSize(internal::ConvertedMeshData const & mesh, std::size_t vertex_stride, std::size_t& vertex_size, std::size_t& index_size)
+	{
+		vertex_size += mesh.m_num_vertices * vertex_stride;
+		index_size += mesh.m_num_indices * mesh.m_index_stride;
+
+		for (auto& lod : mesh.m_lods)
+		{
+			AddConvertedMeshSize(lod, vertex_stride, vertex_size, index_size);
+		}
+	}
+
+	void ModelPool::DeleteConvertedModel(internal::ConvertedModelData* converted)
+	{
+		if (converted == nullptr)
+		{
+			return;
+		}
+
+		if (converted->m_loader != nullptr)
+		{
+			converted->m_loader->DeleteModel(converted->m_data);
+		}
+		else
+		{
+			internal::DeleteBakedModelData(converted->m_data);
 		}
 
-		return 0;
+		delete converted;
 	}
 
-	template<>
-	int ModelPool::LoadNodeMeshesWithMaterials<Vertex, std::uint32_t>(ModelData* data, Model * model, std::vector<MaterialHandle> materials)
+	Mesh* ModelPool::UploadConvertedMesh(internal::ConvertedMeshData& mesh, std::size_t vertex_stride)
 	{
-		model->m_meshes.reserve(data->m_meshes.size());
+		bool shared = false;
+		// AcquireMesh only reads the data, a baked mesh points into a read-only mapping
+		std::optional<std::uint64_t> mesh_id = AcquireMesh(
+			const_cast<std::uint8_t*>(mesh.VertexData()),
+			mesh.m_num_vertices,
+			vertex_stride,
+			mesh.m_num_indices > 0 ? const_cast<std::uint8_t*>(mesh.IndexData()) : nullptr,
+			mesh.m_num_indices,
+			mesh.m_index_stride,
+			shared);
+
+		if (!mesh_id.has_value())
+		{
+			return nullptr;
+		}
+
+		Mesh* mesh_handle = new Mesh();
+
+		std::uint64_t const id = mesh_id.value();
+		mesh_handle->id = id;
 
-		for (unsigned int i = 0; i < data->m_meshes.size(); ++i)
+		// A shared mesh already has its meshlets and LODs
+		if (shared)
 		{
-			ModelMeshData* mesh = data->m_meshes[i];
+			return mesh_handle;
+		}
 
-			std::vector<Vertex> vertices(mesh->m_positions.size());
-			std::vector<std::uint32_t> indices(mesh->m_indices.size());
+		if (!mesh.m_meshlets.empty())
+		{
+			m_loaded_meshes.Find(id)->m_meshlets = std::move(mesh.m_meshlets);
+		}
 
-			Mesh* mesh_handle = new Mesh();
+		m_loaded_meshes.Find(id)->m_uv_density = mesh.m_uv_density;
 
-			for (unsigned int j = 0; j < mesh->m_positions.size(); ++j)
+		// A LOD that doesn't fit is skipped, the mesh itself is still usable
+		for (auto& lod : mesh.m_lods)
+		{
+			Mesh* lod_handle = UploadConvertedMesh(lod, vertex_stride);
+			if (lod_handle == nullptr)
 			{
-				Vertex &vertex = vertices[j];
+				break;
+			}
+
+			// Looked up again every time, uploading the LOD inserted into m_loaded_meshes
+			m_loaded_meshes.Find(id)->m_lods.push_back({ lod_handle, lod.m_error, lod.m_num_indices / 3 });
+		}
+
+		return mesh_handle;
+	}
 
-				memcpy(vertex.m_pos, &mesh->m_positions[j], sizeof(vertex.m_pos));
-				memcpy(vertex.m_normal, &mesh->m_normals[j], sizeof(vertex.m_normal));
-				memcpy(vertex.m_tangent, &mesh->m_tangents[j], sizeof(vertex.m_tangent));
-				memcpy(vertex.m_bitangent, &mesh->m_bitangents[j], sizeof(vertex.m_bitangent));
-				memcpy(vertex.m_uv, &mesh->m_uvw[j], sizeof(vertex.m_uv));
+	void ModelPool::DestroyLODs(std::uint64_t mesh_id)
+	{
+		LoadedMesh* mesh = m_loaded_meshes.Find(mesh_id);
+		if (mesh == nullptr || mesh->m_lods.empty())
+		{
+			return;
+		}
 
-				model->Expand(vertex.m_pos);
+		// Moved out first, destroying a LOD goes through DestroyMesh and with that through here again
+		std::vector<MeshLOD> lods = std::move(mesh->m_lods);
+		mesh->m_lods.clear();
 
+		for (MeshLOD& lod : lods)
+		{
+			if (ReleaseMesh(lod.m_mesh->id))
+			{
+				DestroyMesh(lod.m_mesh->id);
 			}
+			delete lod.m_mesh;
+		}
+	}
 
-			memcpy(indices.data(), mesh->m_indices.data(), sizeof(std::uint32_t)*mesh->m_indices.size());
+	std::optional<std::uint64_t> ModelPool::AcquireMesh(void* vertices_data, std::size_t num_vertices, std::size_t vertex_size, void* indices_data, std::size_t num_indices, std::size_t index_size, bool& out_shared, bool deduplicate)
+	{
+		out_shared = false;
+		deduplicate &= settings::deduplicate_meshes;
 
-			internal::MeshInternal* mesh_data = LoadCustom_VerticesAndIndices(
-				vertices.data(),
-				vertices.size(),
-				sizeof(Vertex),
-				indices.data(),
-				indices.size(),
-				sizeof(std::uint32_t));
+		std::uint64_t hash = 0;
+		if (deduplicate)
+		{
+			// The layout goes into the hash too, the same bytes with a different stride are a different mesh
+			std::uint64_t const layout[] = { num_vertices, vertex_size, indices_data != nullptr ? num_indices : 0, index_size };
+			hash = util::HashBytes(layout, sizeof(layout));
+			hash = util::HashBytes(vertices_data, num_vertices * vertex_size, hash);
+			if (indices_data != nullptr)
+			{
+				hash = util::HashBytes(indices_data, num_indices * index_size, hash);
+			}
 
-			if (mesh_data == nullptr)
+			// A hash hit is only reused when the bytes match as well, a collision gets its own allocation
+			std::optional<std::uint64_t> existing_id = m_mesh_deduplicator.Acquire(hash, [&](std::uint64_t id)
 			{
-				for (auto &elem : model->m_meshes)
-					delete elem.first;
+				LoadedMesh const * existing = m_loaded_meshes.Find(id);
+				if (existing != nullptr && HasSameContent(existing->m_data, vertices_data, num_vertices, vertex_size, indices_data, num_indices, index_size))
+				{
+					return true;
+				}
 
-				delete model;
+				LOGW("Mesh hash collision, the mesh is loaded without deduplication.");
+				return false;
+			});
 
-				return 1;
+			if (existing_id.has_value())
+			{
+				out_shared = true;
+				return existing_id;
 			}
+		}
 
-			std::uint64_t id = GetNewID();
-			m_loaded_meshes[id] = mesh_data;
-			mesh_handle->id = id;
-
-			MaterialHandle material_handle = materials[mesh->m_material_id];
+		internal::MeshInternal* mesh_data = nullptr;
+		if (indices_data != nullptr)
+		{
+			mesh_data = LoadCustom_VerticesAndIndices(vertices_data, num_vertices, vertex_size, indices_data, num_indices, index_size);
+		}
+		else
+		{
+			mesh_data = LoadCustom_VerticesOnly(vertices_data, num_vertices, vertex_size);
+		}
 
-			std::pair<Mesh*, MaterialHandle> n_mesh = std::make_pair(
-				mesh_handle,
-				material_handle);
-			
-			model->m_meshes.push_back(n_mesh);
+		if (mesh_data == nullptr)
+		{
+			return std::nullopt;
 		}
 
-		return 0;
+		LoadedMesh loaded;
+		loaded.m_data = mesh_data;
+		std::uint64_t const id = m_loaded_meshes.Insert(std::move(loaded));
+
+		// On a collision the hash keeps pointing at the mesh that had it first
+		m_mesh_deduplicator.Insert(id, hash, deduplicate);
+
+		return id;
 	}
 
-	template<>
-	void ModelPool::UpdateModelBoundingBoxes<Vertex>(Model * model, std::vector<Vertex> vertices_data)
+	bool ModelPool::ReleaseMesh(std::uint64_t mesh_id)
 	{
-		for (int i = 0; i < vertices_data.size(); ++i)
-		{
-			model->Expand(vertices_data[i].m_pos);
-		}
+		return m_mesh_deduplicator.Release(mesh_id);
+	}
+
+	void ModelPool::ForgetMeshContent(std::uint64_t mesh_id)
+	{
+		m_mesh_deduplicator.Forget(mesh_id);
 	}
 
-	template<>
-	void ModelPool::UpdateModelBoundingBoxes<VertexNoTangent>(Model * model, std::vector<VertexNoTangent> vertices_data)
+	Model* ModelPool::FindCachedModel(std::string const & key)
 	{
-		for (int i = 0; i < vertices_data.size(); ++i)
+		auto it = m_model_cache.find(key);
+		if (it == m_model_cache.end())
 		{
-			model->Expand(vertices_data[i].m_pos);
+			return nullptr;
 		}
+
+		++it->second->m_ref_count;
+		return it->second;
+	}
+
+	std::vector<MeshLOD> const * ModelPool::GetLODs(std::uint64_t mesh_id) const
+	{
+		LoadedMesh const * mesh = m_loaded_meshes.Find(mesh_id);
+		return mesh != nullptr && !mesh->m_lods.empty() ? &mesh->m_lods : nullptr;
 	}
 
-	template<>
-	void ModelPool::UpdateModelBoundingBoxes<VertexColor>(Model * model, std::vector<VertexColor> vertices_data)
+	std::uint64_t ModelPool::SelectLOD(std::uint64_t mesh_id, float max_error) const
 	{
-		for (int i = 0; i < vertices_data.size(); ++i)
+		LoadedMesh const * mesh = m_loaded_meshes.Find(mesh_id);
+		if (mesh == nullptr)
 		{
-			model->Expand(vertices_data[i].m_pos);
+			return mesh_id;
 		}
+
+		std::uint64_t selected = mesh_id;
+		for (MeshLOD const & lod : mesh->m_lods)
+		{
+			if (lod.m_error > max_error)
+			{
+				break;
+			}
+			selected = lod.m_mesh->id;
+		}
+
+		return selected;
 	}
-	
-	template<>
-	int ModelPool::LoadNodeMeshesWithMaterials<VertexColor, std::uint32_t>(ModelData* data, Model * model, std::vector<MaterialHandle> materials)
+
+	internal::ProcessedMeshData ModelPool::ProcessMesh(ModelMeshData& mesh)
 	{
-		model->m_meshes.reserve(data->m_meshes.size());
+		internal::ProcessedMeshData processed;
 
-		for (unsigned int i = 0; i < data->m_meshes.size(); ++i)
+		if constexpr (settings::optimize_meshes)
 		{
-			ModelMeshData* mesh = data->m_meshes[i];
+			OptimizeMesh(mesh);
+		}
 
-			std::vector<VertexColor> vertices(mesh->m_positions.size());
-			std::vector<std::uint32_t> indices(mesh->m_indices.size());
+		if constexpr (settings::generate_meshlets)
+		{
+			processed.m_meshlets = GenerateMeshlets(mesh);
+		}
 
-			Mesh* mesh_handle = new Mesh();
+		if constexpr (settings::num_generated_lods > 0)
+		{
+			processed.m_lods = GenerateLODs(mesh);
+		}
 
-			for (unsigned int j = 0; j < mesh->m_positions.size(); ++j)
-			{
-				VertexColor &vertex = vertices[j];
+		if constexpr (settings::use_texture_streaming)
+		{
+			processed.m_uv_density = ComputeUVDensity(mesh);
+		}
 
-				memcpy(vertex.m_pos, &mesh->m_positions[j], sizeof(vertex.m_pos));
-				memcpy(vertex.m_normal, &mesh->m_normals[j], sizeof(vertex.m_normal));
-				memcpy(vertex.m_tangent, &mesh->m_tangents[j], sizeof(vertex.m_tangent));
-				memcpy(vertex.m_bitangent, &mesh->m_bitangents[j], sizeof(vertex.m_bitangent));
-				memcpy(vertex.m_uv, &mesh->m_uvw[j], sizeof(vertex.m_uv));
-				memcpy(vertex.m_color, &mesh->m_colors[j], sizeof(vertex.m_color));
+		return processed;
+	}
 
-				model->Expand(vertex.m_pos);
+	std::vector<internal::ProcessedMeshData> ModelPool::ProcessMeshes(std::vector<ModelMeshData*> const & meshes)
+	{
+		std::vector<internal::ProcessedMeshData> processed(meshes.size());
 
+		// The meshes are independent, every job takes the next unprocessed one until none are left
+		std::atomic<std::size_t> next_mesh = 0;
+		auto process = [&]()
+		{
+			for (std::size_t i = next_mesh++; i < meshes.size(); i = next_mesh++)
+			{
+				processed[i] = ProcessMesh(*meshes[i]);
 			}
+		};
 
-			memcpy(indices.data(), mesh->m_indices.data(), sizeof(std::uint32_t)*mesh->m_indices.size());
+		// The calling thread processes meshes too, so a busy pool only slows the load down instead of stalling it
+		std::size_t const num_jobs = std::min<std::size_t>(settings::num_mesh_process_threads + 1, meshes.size());
 
-			internal::MeshInternal* mesh_data = LoadCustom_VerticesAndIndices(
-				vertices.data(),
-				vertices.size(),
-				sizeof(VertexColor),
-				indices.data(),
-				indices.size(),
-				sizeof(std::uint32_t));
+		std::vector<std::future<void>> workers;
+		for (std::size_t i = 1; i < num_jobs; ++i)
+		{
+			workers.push_back(m_process_thread_pool->Enqueue(process));
+		}
 
-			if (mesh_data == nullptr)
-			{
-				for (auto &elem : model->m_meshes)
-					delete elem.first;
+		process();
 
-				delete model;
+		for (auto& worker : workers)
+		{
+			worker.get();
+		}
 
-				return 1;
-			}
+		return processed;
+	}
 
-			std::uint64_t id = GetNewID();
-			m_loaded_meshes[id] = mesh_data;
-			mesh_handle->id = id;
+	std::vector<internal::MeshLODData> ModelPool::GenerateLODs(ModelMeshData const & mesh)
+	{
+		std::vector<internal::MeshLODData> lods;
+		lods.reserve(settings::num_generated_lods);
 
-			MaterialHandle material_handle = materials[mesh->m_material_id];
+		std::size_t const num_vertices = mesh.m_positions.size();
+		if (mesh.m_indices.size() / 3 < settings::lod_min_triangles || num_vertices == 0)
+		{
+			return lods;
+		}
 
-			std::pair<Mesh*, MaterialHandle> n_mesh = std::make_pair(
-				mesh_handle,
-				material_handle);
-			
-			model->m_meshes.push_back(n_mesh);
+		// The simplifier's errors are relative to the largest extent of the mesh
+		DirectX::XMVECTOR min = DirectX::XMLoadFloat3(&mesh.m_positions[0]);
+		DirectX::XMVECTOR max = min;
+		for (DirectX::XMFLOAT3 const & position : mesh.m_positions)
+		{
+			DirectX::XMVECTOR const p = DirectX::XMLoadFloat3(&position);
+			min = DirectX::XMVectorMin(min, p);
+			max = DirectX::XMVectorMax(max, p);
 		}
 
-		return 0;
-	}
+		DirectX::XMFLOAT3 size;
+		DirectX::XMStoreFloat3(&size, DirectX::XMVectorSubtract(max, min));
+		float const extent = std::max({ size.x, size.y, size.z });
 
-	template<>
-	int ModelPool::LoadNodeMeshesWithMaterials<VertexNoTangent, std::uint32_t>(ModelData* data, Model * model, std::vector<MaterialHandle> materials)
-	{
-		model->m_meshes.reserve(data->m_meshes.size());
+		// Every LOD is simplified from the previous one, so its error is bounded by the sum of the errors along the chain
+		std::vector<std::uint32_t> const * source = &mesh.m_indices;
+		float relative_error = 0.f;
 
-		for (unsigned int i = 0; i < data->m_meshes.size(); ++i)
+		for (unsigned int i = 0; i < settings::num_generated_lods; ++i)
 		{
-			ModelMeshData* mesh = data->m_meshes[i];
+			std::size_t const source_count = source->size();
+			std::size_t const target_count = static_cast<std::size_t>(static_cast<float>(source_count / 3) * settings::lod_triangle_ratio) * 3;
 
-			std::vector<VertexNoTangent> vertices(mesh->m_positions.size());
-			std::vector<std::uint32_t> indices(mesh->m_indices.size());
+			internal::MeshLODData lod;
+			lod.m_indices.resize(source_count);
 
-			Mesh* mesh_handle = new Mesh();
+			float error = 0.f;
+			std::size_t const count = util::SimplifyMesh(lod.m_indices.data(), source->data(), source_count, &mesh.m_positions[0].x, sizeof(DirectX::XMFLOAT3), num_vertices,
+				target_count, settings::lod_max_error - relative_error, &error);
 
-			for (unsigned int j = 0; j < mesh->m_positions.size(); ++j)
+			lod.m_indices.resize(count);
+
+			// A LOD that barely got simplified isn't worth the memory, the error limit was reached
+			if (count == 0 || count > source_count - (source_count - target_count) / 2)
 			{
-				VertexNoTangent &vertex = vertices[j];
+				break;
+			}
 
-				memcpy(vertex.m_pos, &mesh->m_positions[j], sizeof(vertex.m_pos));
-				memcpy(vertex.m_normal, &mesh->m_normals[j], sizeof(vertex.m_normal));
-				memcpy(vertex.m_uv, &mesh->m_uvw[j], sizeof(vertex.m_uv));
+			util::OptimizeVertexCache(lod.m_indices.data(), lod.m_indices.size(), num_vertices);
 
-				model->Expand(vertex.m_pos);
+			relative_error += error;
+			lod.m_error = relative_error * extent;
 
+			if constexpr (settings::log_mesh_optimization_statistics)
+			{
+				LOG("[MESH LOD] LOD {}: {} -> {} triangles, error {:.5f}", i + 1, mesh.m_indices.size() / 3, count / 3, lod.m_error);
 			}
 
-			memcpy(indices.data(), mesh->m_indices.data(), sizeof(std::uint32_t)*mesh->m_indices.size());
+			lods.push_back(std::move(lod));
+			source = &lods.back().m_indices;
+		}
 
-			internal::MeshInternal* mesh_data = LoadCustom_VerticesAndIndices(
-				vertices.data(),
-				vertices.size(),
-				sizeof(VertexNoTangent),
-				indices.data(),
-				indices.size(),
-				sizeof(std::uint32_t));
+		return lods;
+	}
 
-			if (mesh_data == nullptr)
-			{
-				for (auto &elem : model->m_meshes)
-					delete elem.first;
+	void ModelPool::ConvertIndices(ModelMeshData const & mesh, std::size_t index_size, void* out_indices)
+	{
+		if (index_size == sizeof(std::uint32_t))
+		{
+			memcpy(out_indices, mesh.m_indices.data(), mesh.m_indices.size() * sizeof(std::uint32_t));
+			return;
+		}
 
-				delete model;
+		std::uint16_t* indices = static_cast<std::uint16_t*>(out_indices);
+		for (std::size_t i = 0; i < mesh.m_indices.size(); ++i)
+		{
+			indices[i] = static_cast<std::uint16_t>(mesh.m_indices[i]);
+		}
+	}
 
-				return 1;
-			}
+	void ModelPool::OptimizeMesh(ModelMeshData& mesh)
+	{
+		std::size_t const num_vertices = mesh.m_positions.size();
+		if (mesh.m_indices.size() < 3 || num_vertices == 0)
+		{
+			return;
+		}
+
+		std::vector<std::uint32_t> remap;
+		std::size_t const num_unique_vertices = OptimizeIndices(mesh.m_indices, num_vertices, &mesh.m_positions[0].x, sizeof(DirectX::XMFLOAT3), remap);
+
+		// Attributes that aren't provided per vertex are skipped by RemapVertices, same as PackVertices ignores them
+		util::RemapVertices(mesh.m_positions, remap, num_unique_vertices);
+		util::RemapVertices(mesh.m_colors, remap, num_unique_vertices);
+		util::RemapVertices(mesh.m_normals, remap, num_unique_vertices);
+		util::RemapVertices(mesh.m_uvw, remap, num_unique_vertices);
+		util::RemapVertices(mesh.m_tangents, remap, num_unique_vertices);
+		util::RemapVertices(mesh.m_bitangents, remap, num_unique_vertices);
+		util::RemapVertices(mesh.m_bone_weights, remap, num_unique_vertices);
+		util::RemapVertices(mesh.m_bone_ids, remap, num_unique_vertices);
+	}
+
+	std::size_t ModelPool::OptimizeIndices(std::vector<std::uint32_t>& indices, std::size_t num_vertices, float const * positions, std::size_t position_stride, std::vector<std::uint32_t>& out_remap)
+	{
+		util::VertexCacheStatistics before;
+		if constexpr (settings::log_mesh_optimization_statistics)
+		{
+			before = util::AnalyzeVertexCache(indices.data(), indices.size(), num_vertices);
+		}
 
-			std::uint64_t id = GetNewID();
-			m_loaded_meshes[id] = mesh_data;
-			mesh_handle->id = id;
+		util::OptimizeVertexCache(indices.data(), indices.size(), num_vertices);
 
-			MaterialHandle material_handle = materials[mesh->m_material_id];
+		if (positions != nullptr)
+		{
+			util::OptimizeOverdraw(indices.data(), indices.size(), positions, position_stride, num_vertices, settings::mesh_overdraw_threshold);
+		}
 
-			std::pair<Mesh*, MaterialHandle> n_mesh = std::make_pair(
-				mesh_handle,
-				material_handle);
+		std::size_t const num_unique_vertices = util::OptimizeVertexFetchRemap(indices.data(), indices.size(), num_vertices, out_remap);
 
-			model->m_meshes.push_back(n_mesh);
+		if constexpr (settings::log_mesh_optimization_statistics)
+		{
+			util::VertexCacheStatistics const after = util::AnalyzeVertexCache(indices.data(), indices.size(), num_unique_vertices);
+			LOG("[MESH OPTIMIZED] {} triangles, {} -> {} vertices, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+				indices.size() / 3, num_vertices, num_unique_vertices, before.m_acmr, after.m_acmr, before.m_atvr, after.m_atvr);
 		}
 
-		return 0;
+		return num_unique_vertices;
 	}
 
-	std::uint64_t ModelPool::GetNewID()
+	std::vector<util::Meshlet> ModelPool::GenerateMeshlets(ModelMeshData const & mesh)
 	{
-		std::uint64_t id;
-		if (m_freed_ids.size() > 0)
+		if (mesh.m_indices.size() / 3 < settings::meshlet_min_triangles || mesh.m_positions.empty())
 		{
-			id = m_freed_ids.top();
-			m_freed_ids.pop();
+			return {};
 		}
-		else
+
+		return util::BuildMeshlets(mesh.m_indices.data(), mesh.m_indices.size(), &mesh.m_positions[0].x, sizeof(DirectX::XMFLOAT3), mesh.m_positions.size(),
+			settings::meshlet_max_vertices, settings::meshlet_max_triangles);
+	}
+
+	std::vector<util::Meshlet> const * ModelPool::GetMeshlets(std::uint64_t mesh_id) const
+	{
+		LoadedMesh const * mesh = m_loaded_meshes.Find(mesh_id);
+		return mesh != nullptr && !mesh->m_meshlets.empty() ? &mesh->m_meshlets : nullptr;
+	}
+
+	float ModelPool::GetUVDensity(std::uint64_t mesh_id) const
+	{
+		LoadedMesh const * mesh = m_loaded_meshes.Find(mesh_id);
+		return mesh != nullptr ? mesh->m_uv_density : 0.f;
+	}
+
+	float ModelPool::ComputeUVDensity(ModelMeshData const & mesh)
+	{
+		if (mesh.m_uvw.size() != mesh.m_positions.size())
 		{
-			id = m_current_id;
-			m_current_id++;
+			return 0.f;
 		}
-		return id;
+
+		double surface_area = 0.0;
+		double uv_area = 0.0;
+
+		for (std::size_t i = 0; i + 2 < mesh.m_indices.size(); i += 3)
+		{
+			DirectX::XMVECTOR const p0 = DirectX::XMLoadFloat3(&mesh.m_positions[mesh.m_indices[i]]);
+			DirectX::XMVECTOR const p1 = DirectX::XMLoadFloat3(&mesh.m_positions[mesh.m_indices[i + 1]]);
+			DirectX::XMVECTOR const p2 = DirectX::XMLoadFloat3(&mesh.m_positions[mesh.m_indices[i + 2]]);
+			surface_area += DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVector3Cross(DirectX::XMVectorSubtract(p1, p0), DirectX::XMVectorSubtract(p2, p0))));
+
+			DirectX::XMFLOAT3 const & t0 = mesh.m_uvw[mesh.m_indices[i]];
+			DirectX::XMFLOAT3 const & t1 = mesh.m_uvw[mesh.m_indices[i + 1]];
+			DirectX::XMFLOAT3 const & t2 = mesh.m_uvw[mesh.m_indices[i + 2]];
+			uv_area += std::abs((t1.x - t0.x) * (t2.y - t0.y) - (t2.x - t0.x) * (t1.y - t0.y));
+		}
+
+		if (surface_area <= 0.0 || uv_area <= 0.0)
+		{
+			return 0.f;
+		}
+
+		// Both areas are doubled, the factor cancels out
+		return static_cast<float>(std::sqrt(uv_area / surface_area));
+	}
+
+	internal::MeshInternal* ModelPool::FindMeshData(std::uint64_t id) const
+	{
+		LoadedMesh const * mesh = m_loaded_meshes.Find(id);
+		return mesh != nullptr ? mesh->m_data : nullptr;
 	}
 
 	void ModelPool::FreeID(std::uint64_t id)
 	{
-		m_freed_ids.push(id);
+		m_mesh_deduplicator.Remove(id);
+		m_loaded_meshes.Erase(id);
 	}
 
 } /* wr */
\ No newline at end of file
@@ -20,6 +20,14 @@
 #include <optional>
 #include <map>
 #include <stack>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <filesystem>
+#include <typeinfo>
 //#include <d3d12.h>
 #include <DirectXMath.h>
 
@@ -29,10 +37,21 @@
 
 #include "model_loader.hpp" 
 #include "model_loader_assimp.hpp"
+#include "baked_model.hpp"
 
 #include "util/log.hpp"
 #include "util/aabb.hpp"
+#include "util/thread_pool.hpp"
+#include "util/mesh_optimizer.hpp"
+#include "util/meshlet.hpp"
+#include "util/mesh_simplifier.hpp"
+#include "util/content_hash.hpp"
+#include "util/content_deduplicator.hpp"
+#include "util/slot_map.hpp"
+#include "util/memory_mapped_file.hpp"
+#include "settings.hpp"
 #include "vertex.hpp"
+#include "vertex_layout.hpp"
 
 struct aiScene;
 struct aiNode;
@@ -55,6 +74,14 @@ namespace wr
 		//Box m_box;
 	};
 
+	//! A simplified version of a loaded mesh, see ModelPool::GetLODs.
+	struct MeshLOD
+	{
+		Mesh* m_mesh = nullptr;
+		float m_error = 0.f; // Largest deviation from the original mesh, in object space units
+		std::size_t m_num_triangles = 0;
+	};
+
 	template<typename TV, typename TI = std::uint32_t>
 	struct MeshData
 	{
@@ -71,15 +98,131 @@ namespace wr
 
 		Box m_box;
 
+		//! Incremented when the meshes or bounds change after creation, so mesh nodes know to update their bounds.
+		std::uint32_t m_version = 0;
+
+		//! Every Load that returned this model from the model cache adds a reference, ModelPool::Destroy only destroys the last one.
+		std::uint32_t m_ref_count = 1;
+
+		//! Key of the model in ModelPool's list of loaded models.
+		std::uint64_t m_id = 0;
+
 		void Expand(float (&pos)[3]);
 	};
 
+	enum class AsyncLoadState
+	{
+		LOADING = 0,
+		STREAMING, // Renderable, but not every mesh has its full detail yet
+		READY,
+		FAILED,
+		CANCELLED
+	};
+
+	//! Handle to a model that is loaded in the background.
+	/*!
+		m_model is valid immediately and can be used by mesh nodes as a placeholder.
+		Its meshes are filled in at the first frame boundary after the worker thread finishes.
+		With settings::stream_async_models they arrive over several frames instead, coarsest LODs first.
+		Don't block on m_future from the thread that renders, it is only resolved by the render system.
+	*/
+	struct AsyncModelLoad
+	{
+		Model* m_model = nullptr;
+
+		std::atomic<float> m_progress{ 0.f };
+		std::atomic<AsyncLoadState> m_state{ AsyncLoadState::LOADING };
+		std::atomic<bool> m_cancel{ false };
+
+		std::shared_future<Model*> m_future;
+
+		bool IsDone() const { return m_state != AsyncLoadState::LOADING && m_state != AsyncLoadState::STREAMING; }
+		bool IsReady() const { return m_state == AsyncLoadState::READY; }
+		bool IsRenderable() const { return m_state == AsyncLoadState::STREAMING || m_state == AsyncLoadState::READY; }
+		float GetProgress() const { return m_progress; }
+		void Cancel() { m_cancel = true; }
+	};
+
+	using AsyncModelHandle = std::shared_ptr<AsyncModelLoad>;
+
+	namespace internal
+	{
+		//! Mesh data converted to the final vertex and index layout by a worker thread.
+		struct ConvertedMeshData
+		{
+			std::vector<std::uint8_t> m_vertices;
+			std::vector<std::uint8_t> m_indices;
+			std::size_t m_num_vertices = 0;
+			std::size_t m_num_indices = 0;
+			std::size_t m_index_stride = 0;
+			std::vector<util::Meshlet> m_meshlets;
+			std::vector<ConvertedMeshData> m_lods;
+			float m_error = 0.f; // Only set for LODs
+			float m_uv_density = 0.f; // LODs have the density of the mesh they simplify, see ModelPool::GetUVDensity
+			int m_material_id = 0;
+
+			// Set instead of m_vertices and m_indices when the mesh was read from a baked model, they point into the mapped file
+			std::uint8_t const * m_vertex_view = nullptr;
+			std::uint8_t const * m_index_view = nullptr;
+
+			std::uint8_t const * VertexData() const { return m_vertex_view != nullptr ? m_vertex_view : m_vertices.data(); }
+			std::uint8_t const * IndexData() const { return m_index_view != nullptr ? m_index_view : m_indices.data(); }
+		};
+
+		//! A LOD produced by the simplifier; the indices still refer to the vertices of the full mesh.
+		struct MeshLODData
+		{
+			std::vector<std::uint32_t> m_indices;
+			float m_error = 0.f;
+		};
+
+		//! The CPU side results of ModelPool::ProcessMesh for one mesh.
+		struct ProcessedMeshData
+		{
+			std::vector<util::Meshlet> m_meshlets;
+			std::vector<MeshLODData> m_lods;
+			float m_uv_density = 0.f;
+		};
+
+		struct ConvertedModelData
+		{
+			ModelLoader* m_loader = nullptr;
+			ModelData* m_data = nullptr;
+			std::vector<ConvertedMeshData> m_meshes;
+			std::size_t m_vertex_stride = 0;
+			Box m_box;
+
+			// Keeps the meshes of a baked model valid; m_loader is nullptr in that case
+			std::unique_ptr<util::MemoryMappedFile> m_baked_file;
+		};
+
+		struct AsyncModelLoadTask
+		{
+			AsyncModelHandle m_handle;
+			std::future<ConvertedModelData*> m_worker;
+			std::promise<Model*> m_promise;
+
+			MaterialPool* m_material_pool = nullptr;
+			TexturePool* m_texture_pool = nullptr;
+			std::string m_directory;
+			bool m_with_materials = false;
+
+			// Set once the worker finished while the meshes are streamed in, see ModelPool::StreamAsyncLoad
+			ConvertedModelData* m_converted = nullptr;
+			std::vector<MaterialHandle> m_material_handles;
+			std::size_t m_next_coarse_mesh = 0; // Until the first one is uploaded the model still has the placeholder meshes
+			std::size_t m_next_refined_mesh = 0;
+			std::size_t m_uploaded_bytes = 0;
+			std::size_t m_total_bytes = 0;
+		};
+	}
+
 	class ModelPool
 	{
 	public:
 		explicit ModelPool(std::size_t vertex_buffer_pool_size_in_bytes,
 			std::size_t index_buffer_pool_size_in_bytes);
-		virtual ~ModelPool() = default;
+		virtual ~ModelPool();
 
 		ModelPool(ModelPool const &) = delete;
 		ModelPool& operator=(ModelPool const &) = delete;
@@ -90,11 +233,35 @@ namespace wr
 		[[nodiscard]] Model* Load(MaterialPool* material_pool, TexturePool* texture_pool, std::string_view path, std::optional<ModelData**> out_model_data = std::nullopt);
 		template<typename TV, typename TI = std::uint32_t>
 		[[nodiscard]] Model* LoadWithMaterials(MaterialPool* material_pool, TexturePool* texture_pool, std::string_view path, bool flip_normals = false, std::optional<ModelData**> out_model_data = std::nullopt);
+		//! Loads meshes built by the application.
+		/*!
+			The vertices and indices are uploaded as given. With optimize the meshes go through OptimizeMesh first,
+			which reorders the triangles and vertices and drops unreferenced vertices (see settings::optimize_meshes).
+		*/
+		template<typename TV, typename TI = std::uint32_t>
+		[[nodiscard]] Model* LoadCustom(std::vector<MeshData<TV, TI>> meshes, bool optimize = false);
+		//! Loads meshes whose vertices are replaced often through UpdateVertices, like the meshes of an AnimatedModel.
+		/*!
+			Unlike LoadCustom the vertices keep their order, and the meshes are never optimized, deduplicated or simplified.
+		*/
 		template<typename TV, typename TI = std::uint32_t>
-		[[nodiscard]] Model* LoadCustom(std::vector<MeshData<TV, TI>> meshes);
+		[[nodiscard]] Model* LoadDynamic(std::vector<MeshData<TV, TI>> const & meshes);
+
+		//! Loads a model on a worker thread.
+		/*!
+			Parsing and vertex conversion happen on the model pool's worker threads.
+			Material creation, texture loading and the allocation in the pool happen in FinalizeAsyncLoads.
+			The meshes of the (optional) placeholder are shown until the model is ready; the placeholder itself isn't owned.
+		*/
+		template<typename TV, typename TI = std::uint32_t>
+		[[nodiscard]] AsyncModelHandle LoadAsync(MaterialPool* material_pool, TexturePool* texture_pool, std::string_view path, bool with_materials = true, bool flip_normals = false, Model* placeholder = nullptr);
+
+		//! Moves finished background loads into the pool. Called by the render system at the start of a frame.
+		void FinalizeAsyncLoads();
+		bool HasPendingAsyncLoads() const { return !m_async_loads.empty(); }
 
 		void Destroy(Model* model);
-		void Destroy(internal::MeshInternal* mesh);
+		void Destroy(Mesh* mesh);
 
 		// Shrinks down both heaps to the minimum size required. 
 		// Does not rearrange the contents of the heaps, meaning that it doesn't shrink to the absolute minimum size.
@@ -118,13 +285,40 @@ namespace wr
 		virtual size_t GetVertexHeapSize() = 0;
 		virtual size_t GetIndexHeapSize() = 0;
 
+		// Returns 0 when all free space is contiguous, approaching 1 as it gets split into smaller holes.
+		virtual float GetVertexHeapFragmentation() = 0;
+		virtual float GetIndexHeapFragmentation() = 0;
+
 		// Resizes both heaps to the supplied sizes. 
 		// If the supplied size is smaller than the required size the heaps will resize to the required size instead.
 		virtual void Resize(size_t vertex_heap_new_size, size_t index_heap_new_size) = 0;
 		virtual void ResizeVertexHeap(size_t vertex_heap_new_size) = 0;
 		virtual void ResizeIndexHeap(size_t index_heap_new_size) = 0;
 
+		//! Replaces the vertices and indices of a mesh. A mesh deduplicated with other models gets a copy, so only this model changes.
 		template<typename TV, typename TI> void EditMesh(Mesh* mesh, std::vector<TV> vertices, std::vector<TI> indices);
+		//! Replaces the vertices of a mesh loaded with LoadDynamic, the number of vertices and their size have to stay the same.
+		void UpdateVertices(Mesh* mesh, void const * vertices, std::size_t num_vertices, std::size_t vertex_size);
+
+		//! The meshlets of a loaded mesh, nullptr when the mesh wasn't split (see settings::generate_meshlets).
+		/*!
+			The meshlets are contiguous ranges of the mesh's index buffer, with bounds in object space.
+			Editing the mesh discards them.
+		*/
+		std::vector<util::Meshlet> const * GetMeshlets(std::uint64_t mesh_id) const;
+
+		//! The LOD chain of a loaded mesh from fine to coarse, nullptr when none was generated (see settings::num_generated_lods).
+		/*!
+			The LODs are meshes of their own that are owned by the pool; they're destroyed with the mesh they belong to.
+		*/
+		std::vector<MeshLOD> const * GetLODs(std::uint64_t mesh_id) const;
+		//! The id of the coarsest LOD that deviates at most max_error (object space) from the mesh, or mesh_id itself.
+		std::uint64_t SelectLOD(std::uint64_t mesh_id, float max_error) const;
+		//! UV units per object space unit, averaged over the mesh's surface. Returns 0 for meshes without texture coordinates or unknown ids.
+		/*!
+			SceneGraph uses it to estimate which mip of a material's textures a mesh needs on screen.
+		*/
+		float GetUVDensity(std::uint64_t mesh_id) const;
 
 
 		virtual void Evict() = 0;
@@ -135,37 +329,146 @@ namespace wr
 	protected:
 		virtual internal::MeshInternal* LoadCustom_VerticesAndIndices(void* vertices_data, std::size_t num_vertices, std::size_t vertex_size, void* indices_data, std::size_t num_indices, std::size_t index_size) = 0;
 		virtual internal::MeshInternal* LoadCustom_VerticesOnly(void* vertices_data, std::size_t num_vertices, std::size_t vertex_size) = 0;
+		//! Compares the layout and bytes a mesh holds with the supplied data, indices_data is nullptr for meshes without indices.
+		virtual bool HasSameContent(internal::MeshInternal* mesh, void const * vertices_data, std::size_t num_vertices, std::size_t vertex_size, void const * indices_data, std::size_t num_indices, std::size_t index_size) = 0;
 
 		virtual void UpdateMeshData(Mesh* mesh, void* vertices_data, std::size_t num_vertices, std::size_t vertex_size, void* indices_data, std::size_t num_indices, std::size_t index_size) = 0;
+		virtual void UpdateMeshVertexData(Mesh* mesh, void* vertices_data, std::size_t num_vertices, std::size_t vertex_size) = 0;
 
 		virtual void DestroyModel(Model* model) = 0;
-		virtual void DestroyMesh(internal::MeshInternal* mesh) = 0;
+		virtual void DestroyMesh(std::uint64_t mesh_id) = 0;
 
 		template<typename TV, typename TI = std::uint32_t>
 		int LoadNodeMeshes(ModelData* data, Model* model, MaterialHandle default_material);
 		template<typename TV, typename TI = std::uint32_t>
 		int LoadNodeMeshesWithMaterials(ModelData* data, Model* model, std::vector<MaterialHandle> materials);
 
+		// Packs the vertices with PackVertices<TV>, expands the model bounds and uploads the mesh with its LODs. Returns nullptr if the mesh doesn't fit.
+		template<typename TV, typename TI>
+		Mesh* LoadNodeMesh(ModelMeshData* mesh, internal::ProcessedMeshData& processed, Model* model);
+
+		//! Optimizes the mesh and builds its meshlets and LODs. Only touches the mesh, so it's safe to call from any thread.
+		static internal::ProcessedMeshData ProcessMesh(ModelMeshData& mesh);
+		//! ProcessMesh for every mesh, spread over the process thread pool and the calling thread. Safe to call from the load workers.
+		std::vector<internal::ProcessedMeshData> ProcessMeshes(std::vector<ModelMeshData*> const & meshes);
+		//! Packs the vertices a LOD uses and converts its indices.
+		template<typename TV, typename TI>
+		static internal::ConvertedMeshData ConvertLOD(TV const * vertices, std::size_t num_vertices, internal::MeshLODData const & lod);
+		//! Uploads a converted mesh together with its LODs and registers its meshlets. Returns nullptr if the mesh doesn't fit.
+		Mesh* UploadConvertedMesh(internal::ConvertedMeshData& mesh, std::size_t vertex_stride);
+
+		//! Packs the vertices and indices of every mesh in converted.m_data and adds their meshlets and LODs.
+		/*!
+			Only touches the converted model, so it's safe to call from any thread.
+			Reports progress from 0.5 to 0.9 to the async load and stops early when it gets cancelled.
+		*/
+		template<typename TV, typename TI>
+		static void ConvertModel(internal::ConvertedModelData& converted, bool flip_normals, AsyncModelLoad* async_load = nullptr);
+		//! Reads the model from the baked model cache, or loads and converts it and bakes the result. Returns nullptr on failure.
+		template<typename TV, typename TI>
+		static internal::ConvertedModelData* LoadConvertedModel(ModelLoader* loader, std::string const & path, bool flip_normals, AsyncModelLoad* async_load = nullptr);
+		//! Loads a model through LoadConvertedModel and uploads it, see settings::use_baked_model_cache.
+		template<typename TV, typename TI>
+		Model* LoadBaked(ModelLoader* loader, MaterialPool* material_pool, TexturePool* texture_pool, std::string_view path, bool with_materials, bool flip_normals);
+		//! Replaces the meshes, bounds and materials of the model with the converted ones. Returns false if a mesh doesn't fit.
+		bool UploadConvertedModel(internal::ConvertedModelData& converted, Model* model, std::vector<MaterialHandle> const & material_handles);
+		static void DeleteConvertedModel(internal::ConvertedModelData* converted);
+		//! Destroys the LODs of a mesh, called when the mesh itself is destroyed or edited.
+		void DestroyLODs(std::uint64_t mesh_id);
+
+		//! Uploads the mesh data and returns the id of the new mesh, or nothing if it doesn't fit.
+		/*!
+			With settings::deduplicate_meshes the data is hashed first, and when a mesh with the same content is already
+			in the pool its id is returned with an extra reference instead; out_shared tells the caller it didn't upload anything.
+			indices_data is nullptr for meshes without indices. Meshes acquired without deduplicate are never shared.
+		*/
+		std::optional<std::uint64_t> AcquireMesh(void* vertices_data, std::size_t num_vertices, std::size_t vertex_size, void* indices_data, std::size_t num_indices, std::size_t index_size, bool& out_shared, bool deduplicate = true);
+		//! Drops a reference to a mesh, returns true when it was the last one and the mesh has to be destroyed.
+		bool ReleaseMesh(std::uint64_t mesh_id);
+		//! Stops new meshes from being deduplicated against this one, because it's being edited or destroyed.
+		void ForgetMeshContent(std::uint64_t mesh_id);
+
+		template<typename TV, typename TI>
+		static std::string GetModelCacheKey(std::string_view path, bool with_materials, bool flip_normals, MaterialPool* material_pool, TexturePool* texture_pool);
+		//! Returns the cached model with an extra reference, or nullptr when the key isn't cached.
+		Model* FindCachedModel(std::string const & key);
+
+		//! The index size a loaded mesh is stored with; 16 bit when the vertices fit and TI is the default 32 bit.
+		template<typename TI>
+		static std::size_t ChooseIndexSize(std::size_t num_vertices);
+		//! Writes the indices of the mesh to out_indices with an index size of 2 or 4 bytes.
+		static void ConvertIndices(ModelMeshData const & mesh, std::size_t index_size, void* out_indices);
+
 		template<typename TV>
-		void UpdateModelBoundingBoxes(Model* model, std::vector<TV> vertices_data);
+		void UpdateModelBoundingBoxes(Model* model, std::vector<TV> const & vertices_data);
+
+		//! Optimizes the triangle order for the vertex cache and overdraw, then the vertex order for vertex fetch.
+		/*!
+			The mesh is modified in place, including the data handed back through out_model_data.
+			Unreferenced vertices are dropped.
+		*/
+		static void OptimizeMesh(ModelMeshData& mesh);
+		template<typename TV, typename TI>
+		static void OptimizeMesh(MeshData<TV, TI>& mesh);
+		// Shared by both OptimizeMesh overloads. positions can be nullptr, which skips the overdraw optimization.
+		static std::size_t OptimizeIndices(std::vector<std::uint32_t>& indices, std::size_t num_vertices, float const * positions, std::size_t position_stride, std::vector<std::uint32_t>& out_remap);
+
+		//! Splits meshes with at least settings::meshlet_min_triangles triangles into meshlets, returns nothing for smaller ones.
+		static std::vector<util::Meshlet> GenerateMeshlets(ModelMeshData const & mesh);
+		//! Simplifies meshes with at least settings::lod_min_triangles triangles into a chain of settings::num_generated_lods LODs.
+		static std::vector<internal::MeshLODData> GenerateLODs(ModelMeshData const & mesh);
+		//! sqrt of the mesh's total UV area over its total surface area.
+		static float ComputeUVDensity(ModelMeshData const & mesh);
+
+		std::vector<MaterialHandle> LoadMaterials(MaterialPool* material_pool, TexturePool* texture_pool, ModelData* data, std::string const & dir);
+		bool FinalizeAsyncLoad(internal::AsyncModelLoadTask* task, internal::ConvertedModelData* converted);
+		//! Loads the materials and makes space for the whole model, the meshes follow in StreamAsyncLoad.
+		void BeginStreamedLoad(internal::AsyncModelLoadTask* task, internal::ConvertedModelData* converted);
+		//! Uploads the meshes of a streamed load until budget (in bytes) runs out.
+		/*!
+			The coarsest LOD of every mesh goes first so the whole model is visible early, then every coarse LOD is swapped
+			for the full mesh and moved to the end of its LOD chain. The piece that exhausts the budget is still uploaded whole.
+			Returns STREAMING while meshes are left, READY or FAILED when the load is done.
+		*/
+		AsyncLoadState StreamAsyncLoad(internal::AsyncModelLoadTask* task, std::size_t& budget);
+		//! Adds the bytes a converted mesh and its LODs take up in the heaps.
+		static void AddConvertedMeshSize(internal::ConvertedMeshData const & mesh, std::size_t vertex_stride, std::size_t& vertex_size, std::size_t& index_size);
 
 		std::size_t m_vertex_buffer_pool_size_in_bytes;
 		std::size_t m_index_buffer_pool_size_in_bytes;
 
-		std::map<std::uint64_t, internal::MeshInternal*> m_loaded_meshes;
-		std::stack<std::uint64_t> m_freed_ids;
+		//! Everything the pool keeps per mesh, Mesh::id is the key of this in m_loaded_meshes.
+		struct LoadedMesh
+		{
+			internal::MeshInternal* m_data = nullptr;
+			std::vector<util::Meshlet> m_meshlets;
+			std::vector<MeshLOD> m_lods;
+			float m_uv_density = 0.f;
+		};
 
-		std::uint64_t m_current_id;
+		util::SlotMap<LoadedMesh> m_loaded_meshes;
 
-		std::uint64_t GetNewID();
+		//! Returns nullptr for ids of destroyed meshes.
+		internal::MeshInternal* FindMeshData(std::uint64_t id) const;
+		//! Removes a mesh from m_loaded_meshes, after this its id doesn't resolve anymore.
 		void FreeID(std::uint64_t id);
 
-		std::vector<Model*> m_loaded_models;
+		//! Reference counts of the meshes in m_loaded_meshes, and the content hashes of the deduplicated ones.
+		util::ContentDeduplicator m_mesh_deduplicator;
+		std::unordered_map<std::string, Model*> m_model_cache;
+
+		util::SlotMap<Model*> m_loaded_models;
+
+		// Created on the first asynchronous load
+		std::unique_ptr<util::ThreadPool> m_load_thread_pool;
+		// Shared by the synchronous loads and the load workers, which wait on it but never run on it
+		std::unique_ptr<util::ThreadPool> m_process_thread_pool;
+		std::vector<internal::AsyncModelLoadTask*> m_async_loads;
 
 	};
 
 	template<typename TV, typename TI>
-	Model* ModelPool::LoadCustom(std::vector<MeshData<TV, TI>> meshes)
+	Model* ModelPool::LoadCustom(std::vector<MeshData<TV, TI>> meshes, bool optimize)
 	{
 		IS_PROPER_VERTEX_CLASS(TV);
 
@@ -176,6 +479,11 @@ namespace wr
 
 		for (int i = 0; i < meshes.size(); ++i)
 		{
+			if (optimize && settings::optimize_meshes)
+			{
+				OptimizeMesh(meshes[i]);
+			}
+
 			total_vertex_size += meshes[i].m_vertices.size() * sizeof(TV);
 			if (meshes[i].m_indices.has_value())
 			{
@@ -187,49 +495,93 @@ namespace wr
 
 		for (int i = 0; i < meshes.size(); ++i)
 		{
-			Mesh* mesh = new Mesh();
-			if (meshes[i].m_indices.has_value())
+			bool shared = false;
+			std::optional<std::uint64_t> id = AcquireMesh(
+				meshes[i].m_vertices.data(),
+				meshes[i].m_vertices.size(),
+				sizeof(TV),
+				meshes[i].m_indices.has_value() ? meshes[i].m_indices.value().data() : nullptr,
+				meshes[i].m_indices.has_value() ? meshes[i].m_indices.value().size() : 0,
+				sizeof(TI),
+				shared);
+
+			if (!id.has_value())
 			{
-				internal::MeshInternal* mesh_data = LoadCustom_VerticesAndIndices(
-					meshes[i].m_vertices.data(),
-					meshes[i].m_vertices.size(),
-					sizeof(TV),
-					meshes[i].m_indices.value().data(),
-					meshes[i].m_indices.value().size(),
-					sizeof(TI));
-
-				std::uint64_t id = GetNewID();
-				m_loaded_meshes[id] = mesh_data;
-				mesh->id = id;
-			}
-			else
-			{
-				internal::MeshInternal* mesh_data = LoadCustom_VerticesOnly(
-					meshes[i].m_vertices.data(),
-					meshes[i].m_vertices.size(),
-					sizeof(TV));
-
-				std::uint64_t id = GetNewID();
-				m_loaded_meshes[id] = mesh_data;
-				mesh->id = id;
+				DestroyModel(model);
+				return nullptr;
 			}
+
+			Mesh* mesh = new Mesh();
+			mesh->id = id.value();
+
 			MaterialHandle handle = { nullptr, 0 };
 			model->m_meshes.push_back(
 				std::make_pair(mesh, handle));
 
-			if constexpr (std::is_same<TV, Vertex>::value || std::is_same<TV, VertexNoTangent>::value)
+			ExpandBounds(meshes[i].m_vertices.data(), meshes[i].m_vertices.size(), model->m_box);
+
+		}
+
+		model->m_model_pool = this;
+
+		model->m_id = m_loaded_models.Insert(model);
+
+		return model;
+	}
+
+	template<typename TV, typename TI>
+	Model* ModelPool::LoadDynamic(std::vector<MeshData<TV, TI>> const & meshes)
+	{
+		IS_PROPER_VERTEX_CLASS(TV);
+
+		auto model = new Model();
+
+		std::size_t total_vertex_size = 0;
+		std::size_t total_index_size = 0;
+
+		for (auto const & mesh : meshes)
+		{
+			total_vertex_size += mesh.m_vertices.size() * sizeof(TV);
+			if (mesh.m_indices.has_value())
 			{
-				for (uint32_t j = 0, k = (uint32_t) meshes[i].m_vertices.size(); j < k; ++j)
-				{
-					model->Expand(meshes[i].m_vertices[j].m_pos);
-				}
+				total_index_size += mesh.m_indices.value().size() * sizeof(TI);
+			}
+		}
+
+		MakeSpaceForModel(total_vertex_size, total_index_size);
+
+		for (auto const & mesh : meshes)
+		{
+			// Only read, AcquireMesh takes mutable pointers because the pool's upload functions do
+			bool shared = false;
+			std::optional<std::uint64_t> id = AcquireMesh(
+				const_cast<TV*>(mesh.m_vertices.data()),
+				mesh.m_vertices.size(),
+				sizeof(TV),
+				mesh.m_indices.has_value() ? const_cast<TI*>(mesh.m_indices.value().data()) : nullptr,
+				mesh.m_indices.has_value() ? mesh.m_indices.value().size() : 0,
+				sizeof(TI),
+				shared,
+				false);
+
+			if (!id.has_value())
+			{
+				DestroyModel(model);
+				return nullptr;
 			}
 
+			Mesh* mesh_handle = new Mesh();
+			mesh_handle->id = id.value();
+
+			MaterialHandle handle = { nullptr, 0 };
+			model->m_meshes.push_back(std::make_pair(mesh_handle, handle));
+
+			ExpandBounds(mesh.m_vertices.data(), mesh.m_vertices.size(), model->m_box);
 		}
 
 		model->m_model_pool = this;
 
-		m_loaded_models.push_back(model);
+		model->m_id = m_loaded_models.Insert(model);
 
 		return model;
 	}
@@ -248,6 +600,27 @@ namespace wr
 			return nullptr;
 		}
 
+		// The model data is deleted after loading, so a caller that asks for it always gets a fresh load
+		std::string cache_key;
+		if (settings::cache_models && !out_model_data.has_value())
+		{
+			cache_key = GetModelCacheKey<TV, TI>(path, false, false, material_pool, texture_pool);
+			if (Model* cached = FindCachedModel(cache_key))
+			{
+				return cached;
+			}
+		}
+
+		if (settings::use_baked_model_cache && !out_model_data.has_value())
+		{
+			Model* model = LoadBaked<TV, TI>(loader, material_pool, texture_pool, path, false, false);
+			if (model != nullptr && !cache_key.empty())
+			{
+				m_model_cache[cache_key] = model;
+			}
+			return model;
+		}
+
 		ModelData* data = loader->Load(path);
 
 		Model* model = new Model;
@@ -282,7 +655,12 @@ namespace wr
 		model->m_model_name = path.data();
 		model->m_model_pool = this;
 
-		m_loaded_models.push_back(model);
+		model->m_id = m_loaded_models.Insert(model);
+
+		if (!cache_key.empty())
+		{
+			m_model_cache[cache_key] = model;
+		}
 
 		return model;
 	}
@@ -301,6 +679,26 @@ namespace wr
 			return nullptr;
 		}
 
+		std::string cache_key;
+		if (settings::cache_models && !out_model_data.has_value())
+		{
+			cache_key = GetModelCacheKey<TV, TI>(path, true, flip_normals, material_pool, texture_pool);
+			if (Model* cached = FindCachedModel(cache_key))
+			{
+				return cached;
+			}
+		}
+
+		if (settings::use_baked_model_cache && !out_model_data.has_value())
+		{
+			Model* model = LoadBaked<TV, TI>(loader, material_pool, texture_pool, path, true, flip_normals);
+			if (model != nullptr && !cache_key.empty())
+			{
+				m_model_cache[cache_key] = model;
+			}
+			return model;
+		}
+
 		ModelData* data = loader->Load(path);
 
 		if (flip_normals)
@@ -322,138 +720,513 @@ namespace wr
 
 		Model* model = new Model;
 		model->m_owns_materials = true;
-		std::vector<MaterialHandle> material_handles;
+		std::vector<MaterialHandle> material_handles = LoadMaterials(material_pool, texture_pool, data, dir);
+
+		MakeSpaceForModel(data->GetTotalVertexSize<TV>(), data->GetTotalIndexSize<TI>());
+
+		int ret = LoadNodeMeshesWithMaterials<TV, TI>(data, model, material_handles);
 
-		for (int i = 0; i < data->m_materials.size(); ++i)
+		if (ret == 1)
 		{
-			TextureHandle albedo, normals, metallic, roughness, emissive, ambient_occlusion;
+			DestroyModel(model);
+			loader->DeleteModel(data);
+			return nullptr;
+		}
 
-			ModelMaterialData* material = data->m_materials[i];
+		if (out_model_data.has_value())
+		{
+			(*out_model_data.value()) = data;
 
-			// This lambda loads a texture either from memory or from disc.
-			auto load_material_texture = [&](auto texture_location, auto embedded_texture_idx, std::string &texture_path, TextureHandle &handle, bool srgb, bool gen_mips)
-			{
-				if (texture_location == TextureLocation::EMBEDDED)
-				{
-					EmbeddedTexture* texture = data->m_embedded_textures[embedded_texture_idx];
-
-					if (texture->m_compressed)
-					{
-						handle = texture_pool->LoadFromMemory(texture->m_data.data(), texture->m_width, texture->m_height, texture->m_format, srgb, gen_mips);
-					}
-					else
-					{
-						handle = texture_pool->LoadFromMemory(texture->m_data.data(), texture->m_width, texture->m_height, wr::TextureFormat::RAW, srgb, gen_mips);
-					}
-				}
-				else if (texture_location == TextureLocation::EXTERNAL)
-				{
-					handle = texture_pool->LoadFromFile(dir + texture_path, srgb, gen_mips);
-				}
-			};
+		}
+		else
+		{
+			loader->DeleteModel(data);
+		}
 
-			//TODO: Maya team integrate texture scales in loading
-			// Currently default scales are set to 1 for all materials.
-			MaterialUVScales default_scales;
+		model->m_model_name = path.data();
+		model->m_model_pool = this;
+
+		model->m_id = m_loaded_models.Insert(model);
 
-			auto new_handle = material_pool->Create(texture_pool);
-			Material* mat = material_pool->GetMaterial(new_handle);
+		if (!cache_key.empty())
+		{
+			m_model_cache[cache_key] = model;
+		}
 
-			if (material->m_albedo_texture_location!=TextureLocation::NON_EXISTENT)
+		return model;
+	}
+
+	//! Loads a model on a worker thread
+	template<typename TV, typename TI>
+	AsyncModelHandle ModelPool::LoadAsync(MaterialPool* material_pool, TexturePool* texture_pool, std::string_view path, bool with_materials, bool flip_normals, Model* placeholder)
+	{
+		IS_PROPER_VERTEX_CLASS(TV);
+
+		auto handle = std::make_shared<AsyncModelLoad>();
+
+		Model* model = new Model;
+		model->m_model_name = path.data();
+		model->m_model_pool = this;
+		model->m_owns_materials = with_materials;
+
+		if (placeholder != nullptr)
+		{
+			model->m_meshes = placeholder->m_meshes;
+			model->m_box = placeholder->m_box;
+		}
+
+		model->m_id = m_loaded_models.Insert(model);
+		handle->m_model = model;
+
+		auto task = new internal::AsyncModelLoadTask();
+		task->m_handle = handle;
+		task->m_material_pool = material_pool;
+		task->m_texture_pool = texture_pool;
+		task->m_with_materials = with_materials;
+
+		std::string file_path = std::string(path);
+		task->m_directory = file_path;
+		task->m_directory.erase(task->m_directory.begin() + task->m_directory.find_last_of('/') + 1, task->m_directory.end());
+
+		handle->m_future = task->m_promise.get_future().share();
+
+		if (m_load_thread_pool == nullptr)
+		{
+			m_load_thread_pool = std::make_unique<util::ThreadPool>(settings::num_model_load_threads);
+		}
+
+		// The worker only touches the handle and the data it creates, everything else waits for FinalizeAsyncLoads.
+		task->m_worker = m_load_thread_pool->Enqueue([handle, file_path, flip_normals]() -> internal::ConvertedModelData*
+		{
+			ModelLoader* loader = ModelLoader::FindFittingModelLoader(
+				file_path.substr(file_path.find_last_of(".") + 1));
+
+			if (loader == nullptr || handle->m_cancel)
 			{
-				load_material_texture(material->m_albedo_texture_location, material->m_albedo_embedded_texture, material->m_albedo_texture, albedo, true, true);
-				mat->SetTexture(TextureType::ALBEDO, albedo);
+				return nullptr;
 			}
 
-			if (material->m_normal_map_texture_location != TextureLocation::NON_EXISTENT)
+			return LoadConvertedModel<TV, TI>(loader, file_path, flip_normals, handle.get());
+		});
+
+		m_async_loads.push_back(task);
+
+		return handle;
+	}
+
+	template<typename TV, typename TI>
+	void ModelPool::ConvertModel(internal::ConvertedModelData& converted, bool flip_normals, AsyncModelLoad* async_load)
+	{
+		ModelData* data = converted.m_data;
+
+		converted.m_vertex_stride = sizeof(TV);
+		converted.m_meshes.resize(data->m_meshes.size());
+
+		if (flip_normals)
+		{
+			for (auto* mesh : data->m_meshes)
 			{
-				load_material_texture(material->m_normal_map_texture_location, material->m_normal_map_embedded_texture, material->m_normal_map_texture, normals, false, true);
-				mat->SetTexture(TextureType::NORMAL, normals);
+				for (auto& normal : mesh->m_normals)
+				{
+					normal.x = -1.f * normal.x;
+					normal.y = -1.f * normal.y;
+					normal.z = -1.f * normal.z;
+				}
 			}
+		}
+
+		std::vector<internal::ProcessedMeshData> processed = ProcessMeshes(data->m_meshes);
 
-			if (material->m_metallic_texture_location != TextureLocation::NON_EXISTENT)
+		for (std::size_t i = 0; i < data->m_meshes.size(); ++i)
+		{
+			// A cancelled load is cleaned up when it gets finalized
+			if (async_load != nullptr && async_load->m_cancel)
 			{
-				load_material_texture(material->m_metallic_texture_location, material->m_metallic_embedded_texture, material->m_metallic_texture, metallic, false, true);
-				mat->SetTexture(TextureType::METALLIC, metallic);
+				break;
 			}
 
-			if (material->m_roughness_texture_location != TextureLocation::NON_EXISTENT)
+			ModelMeshData* mesh = data->m_meshes[i];
+			internal::ConvertedMeshData& out_mesh = converted.m_meshes[i];
+
+			out_mesh.m_num_vertices = mesh->m_positions.size();
+			out_mesh.m_vertices.resize(out_mesh.m_num_vertices * sizeof(TV));
+
+			PackVertices(*mesh, reinterpret_cast<TV*>(out_mesh.m_vertices.data()), converted.m_box);
+
+			out_mesh.m_num_indices = mesh->m_indices.size();
+			out_mesh.m_index_stride = ChooseIndexSize<TI>(out_mesh.m_num_vertices);
+			out_mesh.m_indices.resize(out_mesh.m_num_indices * out_mesh.m_index_stride);
+			ConvertIndices(*mesh, out_mesh.m_index_stride, out_mesh.m_indices.data());
+
+			out_mesh.m_meshlets = std::move(processed[i].m_meshlets);
+			out_mesh.m_uv_density = processed[i].m_uv_density;
+			for (internal::MeshLODData const & lod : processed[i].m_lods)
 			{
-				load_material_texture(material->m_roughness_texture_location, material->m_roughness_embedded_texture, material->m_roughness_texture, roughness, false, true);
-				mat->SetTexture(TextureType::ROUGHNESS, roughness);
+				out_mesh.m_lods.push_back(ConvertLOD<TV, TI>(reinterpret_cast<TV const *>(out_mesh.m_vertices.data()), out_mesh.m_num_vertices, lod));
+				out_mesh.m_lods.back().m_uv_density = out_mesh.m_uv_density;
 			}
 
-			if (material->m_emissive_texture_location != TextureLocation::NON_EXISTENT)
+			out_mesh.m_material_id = mesh->m_material_id;
+
+			if (async_load != nullptr)
 			{
-				load_material_texture(material->m_emissive_texture_location, material->m_emissive_embedded_texture, material->m_emissive_texture, emissive, true, true);
-				mat->SetTexture(TextureType::EMISSIVE, emissive);
+				async_load->m_progress = 0.5f + 0.4f * static_cast<float>(i + 1) / static_cast<float>(data->m_meshes.size());
 			}
+		}
+	}
 
-			if (material->m_ambient_occlusion_texture_location != TextureLocation::NON_EXISTENT)
+	template<typename TV, typename TI>
+	internal::ConvertedModelData* ModelPool::LoadConvertedModel(ModelLoader* loader, std::string const & path, bool flip_normals, AsyncModelLoad* async_load)
+	{
+		std::string baked_path;
+		if constexpr (settings::use_baked_model_cache)
+		{
+			baked_path = internal::GetBakedModelPath(path, { typeid(TV).name(), sizeof(TV), sizeof(TI), flip_normals });
+
+			if (!baked_path.empty())
 			{
-				load_material_texture(material->m_ambient_occlusion_texture_location, material->m_ambient_occlusion_embedded_texture, material->m_ambient_occlusion_texture, ambient_occlusion, false, true);
-				mat->SetTexture(TextureType::AO, ambient_occlusion);
+				if (internal::ConvertedModelData* baked = internal::ReadBakedModel(baked_path))
+				{
+					return baked;
+				}
 			}
+		}
+
+		ModelData* data = loader->Load(path);
+
+		if (data == nullptr)
+		{
+			return nullptr;
+		}
 
-			bool two_sided = material->m_two_sided;
+		if (async_load != nullptr)
+		{
+			async_load->m_progress = 0.5f;
+		}
 
-			float opacity = material->m_base_transparency;
+		auto converted = new internal::ConvertedModelData();
+		converted->m_loader = loader;
+		converted->m_data = data;
 
-			mat->SetConstant<MaterialConstant::COLOR>({ material->m_base_color[0], material->m_base_color[1], material->m_base_color[2] });
-			mat->SetConstant<MaterialConstant::METALLIC>(material->m_base_metallic);
-			mat->SetConstant<MaterialConstant::EMISSIVE_MULTIPLIER>(material->m_base_emissive);
-			mat->SetConstant<MaterialConstant::ROUGHNESS>(material->m_base_roughness);
-			mat->SetConstant<MaterialConstant::IS_ALPHA_MASKED>(false);
-			mat->SetConstant<MaterialConstant::IS_DOUBLE_SIDED>(false);
+		ConvertModel<TV, TI>(*converted, flip_normals, async_load);
 
-			material_handles.push_back(new_handle);
+		// A cancelled conversion is incomplete, and a failed write only costs the next load its head start
+		if (!baked_path.empty() && (async_load == nullptr || !async_load->m_cancel))
+		{
+			internal::WriteBakedModel(baked_path, *converted);
 		}
 
-		MakeSpaceForModel(data->GetTotalVertexSize<TV>(), data->GetTotalIndexSize<TI>());
+		return converted;
+	}
 
-		int ret = LoadNodeMeshesWithMaterials<TV, TI>(data, model, material_handles);
+	template<typename TV, typename TI>
+	Model* ModelPool::LoadBaked(ModelLoader* loader, MaterialPool* material_pool, TexturePool* texture_pool, std::string_view path, bool with_materials, bool flip_normals)
+	{
+		internal::ConvertedModelData* converted = LoadConvertedModel<TV, TI>(loader, std::string(path), flip_normals);
 
-		if (ret == 1)
+		if (converted == nullptr)
 		{
-			DestroyModel(model);
-			loader->DeleteModel(data);
 			return nullptr;
 		}
 
-		if (out_model_data.has_value())
+		Model* model = new Model;
+		model->m_owns_materials = with_materials;
+
+		std::vector<MaterialHandle> material_handles;
+		if (with_materials)
 		{
-			(*out_model_data.value()) = data;
+			std::string dir = std::string(path);
+			dir.erase(dir.begin() + dir.find_last_of('/') + 1, dir.end());
 
+			material_handles = LoadMaterials(material_pool, texture_pool, converted->m_data, dir);
 		}
-		else
+
+		bool const uploaded = UploadConvertedModel(*converted, model, material_handles);
+		DeleteConvertedModel(converted);
+
+		if (!uploaded)
 		{
-			loader->DeleteModel(data);
+			DestroyModel(model);
+			return nullptr;
 		}
 
 		model->m_model_name = path.data();
 		model->m_model_pool = this;
 
-		m_loaded_models.push_back(model);
+		model->m_id = m_loaded_models.Insert(model);
 
 		return model;
 	}
 
 	template<typename TV, typename TI>
-	void ModelPool::EditMesh(Mesh* mesh, std::vector<TV> vertices, std::vector<TI> indices)
+	Mesh* ModelPool::LoadNodeMesh(ModelMeshData* mesh, internal::ProcessedMeshData& processed, Model* model)
 	{
-		UpdateMeshData(mesh,
+		std::vector<TV> vertices(mesh->m_positions.size());
+		PackVertices(*mesh, vertices.data(), model->m_box);
+
+		// The loaders always produce 32 bit indices, those are passed on without a copy
+		std::size_t const index_size = ChooseIndexSize<TI>(vertices.size());
+		void* indices = mesh->m_indices.data();
+
+		std::vector<std::uint8_t> converted_indices;
+		if (index_size != sizeof(std::uint32_t))
+		{
+			converted_indices.resize(mesh->m_indices.size() * index_size);
+			ConvertIndices(*mesh, index_size, converted_indices.data());
+			indices = converted_indices.data();
+		}
+
+		bool shared = false;
+		std::optional<std::uint64_t> mesh_id = AcquireMesh(
 			vertices.data(),
 			vertices.size(),
 			sizeof(TV),
-			indices.data(),
-			indices.size(),
-			sizeof(TI));
+			indices,
+			mesh->m_indices.size(),
+			index_size,
+			shared);
+
+		if (!mesh_id.has_value())
+		{
+			return nullptr;
+		}
+
+		Mesh* mesh_handle = new Mesh();
+
+		std::uint64_t const id = mesh_id.value();
+		mesh_handle->id = id;
+
+		// A shared mesh already has its meshlets and LODs
+		if (shared)
+		{
+			return mesh_handle;
+		}
+
+		if (!processed.m_meshlets.empty())
+		{
+			m_loaded_meshes.Find(id)->m_meshlets = std::move(processed.m_meshlets);
+		}
+
+		m_loaded_meshes.Find(id)->m_uv_density = processed.m_uv_density;
+
+		// A LOD that doesn't fit is skipped, the mesh itself is still usable
+		for (internal::MeshLODData const & lod : processed.m_lods)
+		{
+			internal::ConvertedMeshData converted = ConvertLOD<TV, TI>(vertices.data(), vertices.size(), lod);
+			converted.m_uv_density = processed.m_uv_density;
+			Mesh* lod_handle = UploadConvertedMesh(converted, sizeof(TV));
+			if (lod_handle == nullptr)
+			{
+				break;
+			}
+
+			// Looked up again every time, uploading the LOD inserted into m_loaded_meshes
+			m_loaded_meshes.Find(id)->m_lods.push_back({ lod_handle, lod.m_error, lod.m_indices.size() / 3 });
+		}
+
+		return mesh_handle;
+	}
+
+	// On failure the meshes loaded so far stay in the model, the caller destroys the model.
+	template<typename TV, typename TI>
+	int ModelPool::LoadNodeMeshes(ModelData* data, Model* model, MaterialHandle default_material)
+	{
+		model->m_meshes.reserve(data->m_meshes.size());
+
+		std::vector<internal::ProcessedMeshData> processed = ProcessMeshes(data->m_meshes);
+
+		for (std::size_t i = 0; i < data->m_meshes.size(); ++i)
+		{
+			Mesh* mesh_handle = LoadNodeMesh<TV, TI>(data->m_meshes[i], processed[i], model);
+			if (mesh_handle == nullptr)
+			{
+				return 1;
+			}
+
+			model->m_meshes.push_back(std::make_pair(mesh_handle, default_material));
+		}
+
+		return 0;
+	}
+
+	template<typename TV, typename TI>
+	int ModelPool::LoadNodeMeshesWithMaterials(ModelData* data, Model* model, std::vector<MaterialHandle> materials)
+	{
+		model->m_meshes.reserve(data->m_meshes.size());
+
+		std::vector<internal::ProcessedMeshData> processed = ProcessMeshes(data->m_meshes);
+
+		for (std::size_t i = 0; i < data->m_meshes.size(); ++i)
+		{
+			Mesh* mesh_handle = LoadNodeMesh<TV, TI>(data->m_meshes[i], processed[i], model);
+			if (mesh_handle == nullptr)
+			{
+				return 1;
+			}
+
+			model->m_meshes.push_back(std::make_pair(mesh_handle, materials[data->m_meshes[i]->m_material_id]));
+		}
+
+		return 0;
+	}
+
+	template<typename TI>
+	std::size_t ModelPool::ChooseIndexSize(std::size_t num_vertices)
+	{
+		static_assert(sizeof(TI) == sizeof(std::uint16_t) || sizeof(TI) == sizeof(std::uint32_t), "Index buffers only support 16 and 32 bit indices.");
+
+		if constexpr (settings::automatic_16bit_indices && std::is_same<TI, std::uint32_t>::value)
+		{
+			if (num_vertices <= 65536)
+			{
+				return sizeof(std::uint16_t);
+			}
+		}
+
+		return sizeof(TI);
+	}
+
+	template<typename TV, typename TI>
+	internal::ConvertedMeshData ModelPool::ConvertLOD(TV const * vertices, std::size_t num_vertices, internal::MeshLODData const & lod)
+	{
+		internal::ConvertedMeshData converted;
+		converted.m_error = lod.m_error;
+
+		// Only the vertices the LOD still uses are uploaded with it
+		std::vector<std::uint32_t> indices = lod.m_indices;
+		std::vector<std::uint32_t> remap;
+		std::size_t const num_lod_vertices = util::OptimizeVertexFetchRemap(indices.data(), indices.size(), num_vertices, remap);
+
+		converted.m_num_vertices = num_lod_vertices;
+		converted.m_vertices.resize(num_lod_vertices * sizeof(TV));
+
+		TV* lod_vertices = reinterpret_cast<TV*>(converted.m_vertices.data());
+		for (std::size_t i = 0; i < num_vertices; ++i)
+		{
+			if (remap[i] != ~0u)
+			{
+				lod_vertices[remap[i]] = vertices[i];
+			}
+		}
+
+		converted.m_num_indices = indices.size();
+		converted.m_index_stride = ChooseIndexSize<TI>(num_lod_vertices);
+		converted.m_indices.resize(indices.size() * converted.m_index_stride);
+
+		if (converted.m_index_stride == sizeof(std::uint32_t))
+		{
+			std::memcpy(converted.m_indices.data(), indices.data(), converted.m_indices.size());
+		}
+		else
+		{
+			std::uint16_t* out_indices = reinterpret_cast<std::uint16_t*>(converted.m_indices.data());
+			std::transform(indices.begin(), indices.end(), out_indices, [](std::uint32_t index) { return static_cast<std::uint16_t>(index); });
+		}
+
+		return converted;
+	}
+
+	template<typename TV, typename TI>
+	void ModelPool::OptimizeMesh(MeshData<TV, TI>& mesh)
+	{
+		if (!mesh.m_indices.has_value() || mesh.m_indices->size() < 3 || mesh.m_vertices.empty())
+		{
+			return;
+		}
+
+		std::vector<std::uint32_t> indices(mesh.m_indices->begin(), mesh.m_indices->end());
+
+		float const * positions = nullptr;
+		if constexpr (VertexLayout<TV>::has_position)
+		{
+			positions = &mesh.m_vertices[0].m_pos[0];
+		}
+
+		std::vector<std::uint32_t> remap;
+		std::size_t const num_unique_vertices = OptimizeIndices(indices, mesh.m_vertices.size(), positions, sizeof(TV), remap);
+
+		std::transform(indices.begin(), indices.end(), mesh.m_indices->begin(), [](std::uint32_t index) { return static_cast<TI>(index); });
+		util::RemapVertices(mesh.m_vertices, remap, num_unique_vertices);
+	}
+
+	template<typename TV, typename TI>
+	std::string ModelPool::GetModelCacheKey(std::string_view path, bool with_materials, bool flip_normals, MaterialPool* material_pool, TexturePool* texture_pool)
+	{
+		// Different spellings of the same file share the cache entry
+		std::error_code error;
+		std::filesystem::path const canonical = std::filesystem::weakly_canonical(std::filesystem::path(path), error);
+
+		std::string key = error ? std::string(path) : canonical.generic_string();
+		key += '|';
+		key += typeid(TV).name();
+		key += '|' + std::to_string(sizeof(TI));
+		key += with_materials ? "|materials" : "|no_materials";
+		key += flip_normals ? "|flipped" : "";
+		key += '|' + std::to_string(reinterpret_cast<std::uintptr_t>(material_pool));
+		key += '|' + std::to_string(reinterpret_cast<std::uintptr_t>(texture_pool));
+
+		return key;
+	}
+
+	template<typename TV>
+	void ModelPool::UpdateModelBoundingBoxes(Model* model, std::vector<TV> const & vertices_data)
+	{
+		ExpandBounds(vertices_data.data(), vertices_data.size(), model->m_box);
+	}
+
+	template<typename TV, typename TI>
+	void ModelPool::EditMesh(Mesh* mesh, std::vector<TV> vertices, std::vector<TI> indices)
+	{
+		if (m_mesh_deduplicator.IsShared(mesh->id))
+		{
+			// Other models use the same deduplicated mesh, this one gets its own copy with the new data and the others keep theirs
+			MakeSpaceForModel(vertices.size() * sizeof(TV), indices.size() * sizeof(TI));
+
+			bool shared = false;
+			std::optional<std::uint64_t> id = AcquireMesh(
+				vertices.data(),
+				vertices.size(),
+				sizeof(TV),
+				indices.empty() ? nullptr : indices.data(),
+				indices.size(),
+				sizeof(TI),
+				shared,
+				false);
+
+			if (!id.has_value())
+			{
+				LOGE("Unable to allocate memory for edited mesh.");
+				return;
+			}
+
+			// Not the last reference, so the shared mesh stays
+			ReleaseMesh(mesh->id);
+			mesh->id = id.value();
+		}
+		else
+		{
+			// The new indices don't follow the old meshlet ranges, and the LODs would show the old shape
+			if (LoadedMesh* loaded = m_loaded_meshes.Find(mesh->id))
+			{
+				loaded->m_meshlets.clear();
+			}
+			DestroyLODs(mesh->id);
+			ForgetMeshContent(mesh->id);
+
+			UpdateMeshData(mesh,
+				vertices.data(),
+				vertices.size(),
+				sizeof(TV),
+				indices.data(),
+				indices.size(),
+				sizeof(TI));
+		}
 
 		for (auto model : m_loaded_models)
 		{
 			for (auto mesh_material : model->m_meshes)
 			{
-				if (mesh_material.first->id == mesh->id)
+				if (mesh_material.first == mesh)
 				{
 					UpdateModelBoundingBoxes<TV>(model, vertices);
 				}
@@ -115,8 +115,9 @@ namespace wr
 			ansel::Camera ansel_camera{};
 			ansel_camera.aspectRatio = camera->m_aspect_ratio;
 			ansel_camera.fov = DirectX::XMConvertToDegrees(camera->m_fov.m_fov);
-			ansel_camera.position = { camera->m_position.m128_f32[0], camera->m_position.m128_f32[1], camera->m_position.m128_f32[2] };
-			ansel_camera.rotation = { camera->m_rotation.m128_f32[0], camera->m_rotation.m128_f32[1], camera->m_rotation.m128_f32[2], camera->m_rotation.m128_f32[3] };
+			auto const & transform = camera->m_render_transform;
+			ansel_camera.position = { transform.m_position.x, transform.m_position.y, transform.m_position.z };
+			ansel_camera.rotation = { transform.m_rotation.x, transform.m_rotation.y, transform.m_rotation.z, transform.m_rotation.w };
 			ansel_camera.nearPlane = camera->m_frustum_near;
 			ansel_camera.farPlane = camera->m_frustum_far;
 			ansel_camera.projectionOffsetX = proj_offset.first;
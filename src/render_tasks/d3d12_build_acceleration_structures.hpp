@@ -110,6 +110,26 @@ namespace wr
 		namespace internal
 		{
 
+			//! Packs the resident mip of each of the material's textures into 4 bits, the RT shaders sample relative to it.
+			inline std::uint32_t GetResidentMips(Material* material)
+			{
+				std::uint32_t resident_mips = 0u;
+
+				for (std::uint32_t type = 0; type < static_cast<std::uint32_t>(TextureType::COUNT); ++type)
+				{
+					TextureHandle texture = material->GetTexture(static_cast<TextureType>(type));
+					if (texture.m_pool == nullptr)
+					{
+						continue;
+					}
+
+					std::size_t const mip = static_cast<D3D12TexturePool*>(texture.m_pool)->GetResidentMip(texture);
+					resident_mips |= static_cast<std::uint32_t>(std::min<std::size_t>(mip, 0xF)) << (type * 4);
+				}
+
+				return resident_mips;
+			}
+
 			//! Get a material id from a mesh.
 			inline unsigned int ExtractMaterialFromMesh(ASBuildData& data, MaterialHandle material_handle)
 			{
@@ -128,6 +148,7 @@ namespace wr
 					material.metallicness_id = material_internal->GetTexture(wr::TextureType::METALLIC).m_id;
 					material.emissive_id = material_internal->GetTexture(wr::TextureType::EMISSIVE).m_id;
 					material.ao_id = material_internal->GetTexture(wr::TextureType::AO).m_id;
+					material.resident_mips = GetResidentMips(material_internal);
 					material.material_data = material_internal->GetMaterialData();
 					data.out_materials.push_back(material);
 					data.out_parsed_materials[material_handle.m_id] = material_id;
@@ -149,6 +170,7 @@ namespace wr
 				offset.material_idx = material_id;
 				offset.idx_offset = static_cast<std::uint32_t>(mesh->m_index_staging_buffer_offset);
 				offset.vertex_offset = static_cast<std::uint32_t>(mesh->m_vertex_staging_buffer_offset);
+				offset.index_stride = static_cast<std::uint32_t>(mesh->m_index_staging_buffer_stride);
 				data.out_offsets.push_back(offset);
 			}
 
@@ -163,6 +185,7 @@ namespace wr
 				obj.m_vertices_offset = static_cast<std::uint32_t>(mesh->m_vertex_staging_buffer_offset);
 				obj.m_num_vertices = static_cast<std::uint32_t>(mesh->m_vertex_count);
 				obj.m_vertex_stride = static_cast<std::uint32_t>(mesh->m_vertex_staging_buffer_stride);
+				obj.m_index_stride = static_cast<std::uint32_t>(mesh->m_index_staging_buffer_stride);
 
 				return obj;
 			}
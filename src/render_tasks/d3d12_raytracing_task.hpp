@@ -199,15 +199,15 @@ namespace wr
 				d3d12::SetRTShaderSRV(cmd_list, 0, COMPILATION_EVAL(rs_layout::GetHeapLoc(params::full_raytracing, params::FullRaytracingE::OFFSETS)), scene_offset_handle);
 
 				// Reset accmulation if nessessary
-				if (DirectX::XMVector3Length(DirectX::XMVectorSubtract(scene_graph.GetActiveCamera()->m_position, data.last_cam_pos)).m128_f32[0] > 0.01)
+				if (DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&scene_graph.GetActiveCamera()->m_render_transform.m_position), data.last_cam_pos))) > 0.01)
 				{
-					data.last_cam_pos = scene_graph.GetActiveCamera()->m_position;
+					data.last_cam_pos = DirectX::XMLoadFloat3(&scene_graph.GetActiveCamera()->m_render_transform.m_position);
 					n_render_system.temp_rough = -1;
 				}
 
-				if (DirectX::XMVector3Length(DirectX::XMVectorSubtract(scene_graph.GetActiveCamera()->m_rotation_radians, data.last_cam_rot)).m128_f32[0] > 0.001)
+				if (DirectX::XMVectorGetX(DirectX::XMVector4Length(DirectX::XMVectorSubtract(DirectX::XMLoadFloat4(&scene_graph.GetActiveCamera()->m_render_transform.m_rotation), data.last_cam_rot))) > 0.001)
 				{
-					data.last_cam_rot = scene_graph.GetActiveCamera()->m_rotation_radians;
+					data.last_cam_rot = DirectX::XMLoadFloat4(&scene_graph.GetActiveCamera()->m_render_transform.m_rotation);
 					n_render_system.temp_rough = -1;
 				}
 
@@ -302,7 +302,7 @@ namespace wr
 				auto camera = scene_graph.GetActiveCamera();
 				temp::RayTracingCamera_CBData cam_data;
 				cam_data.m_view = camera->m_view;
-				cam_data.m_camera_position = camera->m_position;
+				cam_data.m_camera_position = DirectX::XMLoadFloat3(&camera->m_render_transform.m_position);
 				cam_data.m_inverse_view_projection = DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, camera->m_view * camera->m_projection));
 				cam_data.focal_radius = camera->m_f_number;
 				cam_data.focal_length = camera->m_focal_length;
@@ -33,34 +33,71 @@ namespace wr
 #endif
 	}
 
-	TextureHandle TexturePool::LoadFromMemory(unsigned char* data, size_t width, size_t height, const std::string& texture_extension, bool srgb, bool generate_mips)
+	TextureHandle TexturePool::LoadFromMemory(unsigned char* data, size_t width, size_t height, const std::string& texture_extension, bool srgb, bool generate_mips, TextureCompression compression)
+	{
+		std::optional<TextureFormat> type = GetTextureFormat(texture_extension);
+
+		if (!type.has_value())
+		{
+			LOGC("[ERROR]: Texture format not supported.");
+			return {};
+		}
+
+		// The loads lock the pool themselves, once the data is decoded
+		return LoadFromMemory(data, width, height, type.value(), srgb, generate_mips, compression);
+	}
+
+	TextureHandle TexturePool::LoadFromMemoryAsync(unsigned char* data, size_t width, size_t height, const std::string& texture_extension, bool srgb, bool generate_mips, TextureCompression compression)
+	{
+		std::optional<TextureFormat> type = GetTextureFormat(texture_extension);
+
+		if (!type.has_value())
+		{
+			LOGE("[ERROR]: Texture format not supported.");
+			return {};
+		}
+
+		// The asynchronous loads lock the pool themselves, only for as long as it takes to queue the decode
+		return LoadFromMemoryAsync(data, width, height, type.value(), srgb, generate_mips, compression);
+	}
+
+	std::optional<TextureFormat> TexturePool::GetTextureFormat(std::string const & texture_extension)
 	{
 		std::string new_str = texture_extension;
 
 		std::transform(texture_extension.begin(), texture_extension.end(), new_str.begin(), ::tolower);
 
-		TextureFormat type;
-
 		if (new_str == "png"|| new_str == "jpg"
 			|| new_str == "jpeg" || new_str == "bmp")
 		{
-			type = TextureFormat::WIC;
+			return TextureFormat::WIC;
 		}
 		else if (new_str.compare("dds") == 0)
 		{
-			type = TextureFormat::DDS;
+			return TextureFormat::DDS;
 		}
 		else if (new_str.compare("hdr") == 0)
 		{
-			type = TextureFormat::HDR;
+			return TextureFormat::HDR;
+		}
+
+		return std::nullopt;
+	}
+
+	std::optional<std::size_t> TexturePool::GetTextureDataSize(size_t width, size_t height, TextureFormat type)
+	{
+		if (type == TextureFormat::RAW)
+		{
+			//RGBA8_UNORM pixels
+			return width * height * 4;
 		}
-		else
+
+		//Encoded files can't be sized from their dimensions, their byte size is passed as width
+		if (height != 0)
 		{
-			LOGC("[ERROR]: Texture format not supported.");
-			return {};
+			return std::nullopt;
 		}
 
-		std::lock_guard<std::mutex> lock(m_mutex);
-		return LoadFromMemory(data, width, height, type, srgb, generate_mips);
+		return width;
 	}
 }
\ No newline at end of file
@@ -38,6 +38,22 @@ namespace wr
 		RAW
 	};
 
+	//! How a texture is block compressed, picked by what it's used for. Only applies to 8 bit textures.
+	enum class TextureCompression
+	{
+		NONE,
+		COLOR, // BC1, BC3 when it has transparent texels or BC7 with settings::texture_compression_quality
+		SINGLE_CHANNEL, // BC4 of the red channel, for roughness, metallic and ambient occlusion
+		NORMAL_MAP, // BC5 of the red and green channels, the shaders rebuild z
+	};
+
+	//! A texture that is sampled at about m_pixels_per_uv screen pixels per UV unit this frame, see TexturePool::RequestMips.
+	struct TextureMipRequest
+	{
+		TextureHandle m_texture;
+		float m_pixels_per_uv = 0.f;
+	};
+
 	class TexturePool
 	{
 	public:
@@ -49,9 +65,18 @@ namespace wr
 		TexturePool(TexturePool&&) = delete;
 		TexturePool& operator=(TexturePool&&) = delete;
 
-		[[nodiscard]] virtual TextureHandle LoadFromFile(std::string_view path, bool srgb, bool generate_mips) = 0;
-		[[nodiscard]] virtual TextureHandle LoadFromMemory(unsigned char* data, size_t width, size_t height, const std::string& texture_extension, bool srgb, bool generate_mips);
-		[[nodiscard]] virtual TextureHandle LoadFromMemory(unsigned char* data, size_t width, size_t height, TextureFormat type, bool srgb, bool generate_mips) = 0;
+		[[nodiscard]] virtual TextureHandle LoadFromFile(std::string_view path, bool srgb, bool generate_mips, TextureCompression compression = TextureCompression::NONE) = 0;
+		[[nodiscard]] virtual TextureHandle LoadFromMemory(unsigned char* data, size_t width, size_t height, const std::string& texture_extension, bool srgb, bool generate_mips, TextureCompression compression = TextureCompression::NONE);
+		[[nodiscard]] virtual TextureHandle LoadFromMemory(unsigned char* data, size_t width, size_t height, TextureFormat type, bool srgb, bool generate_mips, TextureCompression compression = TextureCompression::NONE) = 0;
+		//! Returns a handle right away and reads and decodes the file on a worker thread.
+		/*!
+			The handle resolves to one of the pool's default textures until the first Stage after the image is decoded.
+			If it can't be loaded it keeps the default texture.
+		*/
+		[[nodiscard]] virtual TextureHandle LoadFromFileAsync(std::string_view path, bool srgb, bool generate_mips, TextureCompression compression = TextureCompression::NONE) = 0;
+		//! Like LoadFromFileAsync, the data is copied so it doesn't have to outlive the call.
+		[[nodiscard]] virtual TextureHandle LoadFromMemoryAsync(unsigned char* data, size_t width, size_t height, const std::string& texture_extension, bool srgb, bool generate_mips, TextureCompression compression = TextureCompression::NONE);
+		[[nodiscard]] virtual TextureHandle LoadFromMemoryAsync(unsigned char* data, size_t width, size_t height, TextureFormat type, bool srgb, bool generate_mips, TextureCompression compression = TextureCompression::NONE) = 0;
 		[[nodiscard]] virtual TextureHandle CreateCubemap(std::string_view name, uint32_t width, uint32_t height, uint32_t mip_levels, Format format, bool allow_render_dest) = 0;
 		[[nodiscard]] virtual TextureHandle CreateTexture(std::string_view name, uint32_t width, uint32_t height, uint32_t mip_levels, Format format, bool allow_render_dest) = 0;
 		virtual void MarkForUnload(TextureHandle& handle, unsigned int frame_idx) = 0;
@@ -65,8 +90,22 @@ namespace wr
 
 		virtual Texture* GetTextureResource(TextureHandle handle) = 0;
 
+		//! Tells the pool which of its textures are sampled this frame and how densely, see settings::use_texture_streaming.
+		/*!
+			A frame's requests are submitted at once, so the pool is locked once per frame instead of once per texture.
+			The finest mip asked for since the last Stage is streamed in by the next one, as far as the budget allows.
+			Textures that don't stream ignore it.
+		*/
+		virtual void RequestMips(std::vector<TextureMipRequest> const & requests) = 0;
+
 	protected:
 
+		//! Maps a file extension to the decoder LoadFromMemory uses for it.
+		static std::optional<TextureFormat> GetTextureFormat(std::string const & texture_extension);
+		//! Size in bytes of image data passed to LoadFromMemory, RAW data is RGBA8 pixels.
+		//! Encoded files (WIC, DDS, HDR) pass their size in bytes as width and a height of 0, std::nullopt when they don't.
+		static std::optional<std::size_t> GetTextureDataSize(size_t width, size_t height, TextureFormat type);
+
 		std::size_t m_loaded_textures = 0;
 		std::mutex m_mutex;
 
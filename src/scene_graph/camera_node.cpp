@@ -82,11 +82,12 @@ namespace wr
 
 	void CameraNode::UpdateTemp(unsigned int frame_idx)
 	{
-		DirectX::XMVECTOR pos = { m_transform.r[3].m128_f32[0], m_transform.r[3].m128_f32[1], m_transform.r[3].m128_f32[2] };
+		DirectX::XMMATRIX transform = GetTransform();
+		DirectX::XMVECTOR pos = DirectX::XMVectorSetW(transform.r[3], 0);
 
-		DirectX::XMVECTOR up = DirectX::XMVector3Normalize(m_transform.r[1]);
-		DirectX::XMVECTOR forward = DirectX::XMVectorNegate(DirectX::XMVector3Normalize(m_transform.r[2]));
-		DirectX::XMVECTOR right = DirectX::XMVector3Normalize(m_transform.r[0]);
+		DirectX::XMVECTOR up = DirectX::XMVector3Normalize(transform.r[1]);
+		DirectX::XMVECTOR forward = DirectX::XMVectorNegate(DirectX::XMVector3Normalize(transform.r[2]));
+		DirectX::XMVECTOR right = DirectX::XMVector3Normalize(transform.r[0]);
 
 		m_prev_view = m_view;
 		m_prev_projection = m_projection;
@@ -108,8 +109,7 @@ namespace wr
 					m_frustum_far);
 			}
 
-			m_projection.r[2].m128_f32[0] += m_projection_offset_x;
-			m_projection.r[2].m128_f32[1] += m_projection_offset_y;
+			m_projection.r[2] = DirectX::XMVectorAdd(m_projection.r[2], DirectX::XMVectorSet(m_projection_offset_x, m_projection_offset_y, 0, 0));
 		}
 
 		m_view_projection = m_view * m_projection;
@@ -126,60 +126,26 @@ namespace wr
 	//https://www.braynzarsoft.net/viewtutorial/q16390-34-aabb-cpu-side-frustum-culling
 	void CameraNode::CalculatePlanes()
 	{
-		//Left plane
+		//Rows of the transposed view projection are the columns used to build the planes
+		DirectX::XMMATRIX vp = DirectX::XMMatrixTranspose(m_view_projection);
 
-		m_planes[0] = DirectX::XMPlaneNormalize({
-			m_view_projection.r[0].m128_f32[3] + *m_view_projection.r[0].m128_f32,
-			m_view_projection.r[1].m128_f32[3] + *m_view_projection.r[1].m128_f32,
-			m_view_projection.r[2].m128_f32[3] + *m_view_projection.r[2].m128_f32,
-			m_view_projection.r[3].m128_f32[3] + *m_view_projection.r[3].m128_f32
-			});
+		//Left plane
+		m_planes[0] = DirectX::XMPlaneNormalize(DirectX::XMVectorAdd(vp.r[3], vp.r[0]));
 
 		//Right plane
-
-		m_planes[1] = DirectX::XMPlaneNormalize({
-			m_view_projection.r[0].m128_f32[3] - *m_view_projection.r[0].m128_f32,
-			m_view_projection.r[1].m128_f32[3] - *m_view_projection.r[1].m128_f32,
-			m_view_projection.r[2].m128_f32[3] - *m_view_projection.r[2].m128_f32,
-			m_view_projection.r[3].m128_f32[3] - *m_view_projection.r[3].m128_f32
-			});
+		m_planes[1] = DirectX::XMPlaneNormalize(DirectX::XMVectorSubtract(vp.r[3], vp.r[0]));
 
 		//Top plane
-
-		m_planes[2] = DirectX::XMPlaneNormalize({
-			m_view_projection.r[0].m128_f32[3] - m_view_projection.r[0].m128_f32[1],
-			m_view_projection.r[1].m128_f32[3] - m_view_projection.r[1].m128_f32[1],
-			m_view_projection.r[2].m128_f32[3] - m_view_projection.r[2].m128_f32[1],
-			m_view_projection.r[3].m128_f32[3] - m_view_projection.r[3].m128_f32[1]
-			});
+		m_planes[2] = DirectX::XMPlaneNormalize(DirectX::XMVectorSubtract(vp.r[3], vp.r[1]));
 
 		//Bottom plane
-
-		m_planes[3] = DirectX::XMPlaneNormalize({
-			m_view_projection.r[0].m128_f32[3] + m_view_projection.r[0].m128_f32[1],
-			m_view_projection.r[1].m128_f32[3] + m_view_projection.r[1].m128_f32[1],
-			m_view_projection.r[2].m128_f32[3] + m_view_projection.r[2].m128_f32[1],
-			m_view_projection.r[3].m128_f32[3] + m_view_projection.r[3].m128_f32[1]
-			});
+		m_planes[3] = DirectX::XMPlaneNormalize(DirectX::XMVectorAdd(vp.r[3], vp.r[1]));
 
 		//Near plane
-
-		m_planes[4] = DirectX::XMPlaneNormalize({
-			m_view_projection.r[0].m128_f32[2],
-			m_view_projection.r[1].m128_f32[2],
-			m_view_projection.r[2].m128_f32[2],
-			m_view_projection.r[3].m128_f32[2]
-			});
+		m_planes[4] = DirectX::XMPlaneNormalize(vp.r[2]);
 
 		//Far plane
-
-		m_planes[5] = DirectX::XMPlaneNormalize({
-			m_view_projection.r[0].m128_f32[3] - m_view_projection.r[0].m128_f32[2],
-			m_view_projection.r[1].m128_f32[3] - m_view_projection.r[1].m128_f32[2],
-			m_view_projection.r[2].m128_f32[3] - m_view_projection.r[2].m128_f32[2],
-			m_view_projection.r[3].m128_f32[3] - m_view_projection.r[3].m128_f32[2]
-		});
-
+		m_planes[5] = DirectX::XMPlaneNormalize(DirectX::XMVectorSubtract(vp.r[3], vp.r[2]));
 	}
 
 	bool CameraNode::InView(const std::shared_ptr<MeshNode>& node) const
@@ -191,7 +157,7 @@ namespace wr
 	bool CameraNode::InRange(const std::shared_ptr<MeshNode> &node, const float dist) const
 	{
 		const AABB &aabb = node->m_aabb;
-		const Sphere sphere{ m_position, dist };
+		const Sphere sphere{ DirectX::XMLoadFloat3(&m_render_transform.m_position), dist };
 		return aabb.Contains(sphere);
 	}
 
@@ -56,25 +56,25 @@ namespace wr
 
 	void LightNode::SetAngle(float ang)
 	{
-		m_light->ang = ang;
+		m_temp.ang = ang;
 		SignalChange();
 	}
 
 	void LightNode::SetRadius(float rad)
 	{
-		m_light->rad = rad;
+		m_temp.rad = rad;
 		SignalChange();
 	}
 
 	void LightNode::SetType(LightType tid)
 	{
-		m_light->tid = (uint32_t) tid;
+		m_temp.tid = (uint32_t) tid;
 		SignalChange();
 	}
 
 	void LightNode::SetColor(DirectX::XMVECTOR col)
 	{
-		memcpy(&m_light->col, &col, 12);
+		memcpy(&m_temp.col, &col, 12);
 		SignalChange();
 	}
 
@@ -105,24 +105,39 @@ namespace wr
 
 	void LightNode::SetLightSize(float size_in_deg)
 	{
-		m_light->light_size = DirectX::XMConvertToRadians(size_in_deg);
+		m_temp.light_size = DirectX::XMConvertToRadians(size_in_deg);
 		SignalChange();
 	}
 
 	void LightNode::Update(uint32_t frame_idx)
 	{
-		DirectX::XMVECTOR position = { m_transform.r[3].m128_f32[0], m_transform.r[3].m128_f32[1], m_transform.r[3].m128_f32[2] };
-		memcpy(&m_light->pos, &position, 12);
+		DirectX::XMMATRIX transform = GetTransform();
+		DirectX::XMStoreFloat3(&m_light->pos, transform.r[3]);
 
-		DirectX::XMVECTOR forward = DirectX::XMVector3Normalize(m_transform.r[2]);
-		memcpy(&m_light->dir, &forward, 12);
+		DirectX::XMVECTOR forward = DirectX::XMVector3Normalize(transform.r[2]);
+		DirectX::XMStoreFloat3(&m_light->dir, forward);
 
 		SignalUpdate(frame_idx);
 	}
 
+	void LightNode::Commit()
+	{
+		if (m_light != &m_temp)
+		{
+			//Position and direction come from the transform; the upper bits of tid hold the light count
+			m_light->rad = m_temp.rad;
+			m_light->col = m_temp.col;
+			m_light->tid = (m_light->tid & ~0x3u) | (m_temp.tid & 0x3u);
+			m_light->ang = m_temp.ang;
+			m_light->light_size = m_temp.light_size;
+		}
+
+		Node::Commit();
+	}
+
 	LightType LightNode::GetType()
 	{
-		return (LightType)(m_light->tid & 0x3);
+		return (LightType)(m_temp.tid & 0x3);
 	}
 
 }
\ No newline at end of file
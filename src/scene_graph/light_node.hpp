@@ -59,13 +59,16 @@ namespace wr
 		//! Update
 		void Update(uint32_t frame_idx);
 
+		//! Copies the write side light data into the allocated light
+		void Commit() override;
+
 		//! Helper for getting the LightType (doesn't include light count for the first light)
 		LightType GetType();
 
-		//! Allocated data (either temp or array data)
+		//! Allocated data (either temp or array data); render side
 		Light* m_light;
 
-		//! Physical data
+		//! Physical data; write side, applied to m_light on commit
 		Light m_temp;
 
 	};
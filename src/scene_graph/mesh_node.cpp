@@ -17,17 +17,38 @@
 
 namespace wr {
 
-	MeshNode::MeshNode(Model* model) : Node(typeid(MeshNode)), m_model(model), m_materials(), m_visible(true)
+	MeshNode::MeshNode(Model* model) : Node(typeid(MeshNode)), m_model(model), m_materials(), m_visible(true), m_render_model(model), m_render_model_version(model->m_version), m_render_materials(), m_render_visible(true)
 	{
 	}
 
 	void MeshNode::Update(uint32_t frame_idx)
 	{
-		m_aabb = AABB::FromTransform(m_model->m_box, m_transform);
+		m_aabb = AABB::FromTransform(m_render_model->m_box, GetTransform());
 
 		SignalUpdate(frame_idx);
 	}
 
+	void MeshNode::Commit()
+	{
+		//Materials and visibility can be written directly, so compare instead of relying on a dirty flag
+		// Models that finish loading asynchronously change their bounds after the node was created
+		if (m_render_model != m_model || m_render_model_version != m_model->m_version)
+		{
+			m_render_model = m_model;
+			m_render_model_version = m_model->m_version;
+			MarkRequiresUpdate();
+		}
+
+		if (m_render_materials != m_materials)
+		{
+			m_render_materials = m_materials;
+		}
+
+		m_render_visible = m_visible;
+
+		Node::Commit();
+	}
+
 	void MeshNode::AddMaterial(MaterialHandle handle)
 	{
 		m_materials.push_back(handle);
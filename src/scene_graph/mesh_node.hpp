@@ -27,6 +27,7 @@ namespace wr
 		explicit MeshNode(Model* model);
 
 		void Update(uint32_t frame_idx);
+		void Commit() override;
 		/*! Add a material */
 		/*!
 			You can add a material for every single sub-mesh.
@@ -44,6 +45,12 @@ namespace wr
 		std::vector<MaterialHandle> m_materials;
 		bool m_visible;
 
+		//Render side copies of the model, materials and visibility; applied on commit
+		Model* m_render_model;
+		std::uint32_t m_render_model_version;
+		std::vector<MaterialHandle> m_render_materials;
+		bool m_render_visible;
+
 	private:
 		/*! Check whether their are more materials than meshes */
 		/*!
@@ -19,28 +19,62 @@
 
 namespace wr
 {
-	Node::Node() : m_type_info(typeid(Node))
+	Node::Node() : m_transform(), m_prev_transform(), m_type_info(typeid(Node))
 	{
 		SignalTransformChange();
 	}
 
-	Node::Node(std::type_info const & type_info) : m_type_info(type_info)
+	Node::Node(std::type_info const & type_info) : m_transform(), m_prev_transform(), m_type_info(type_info)
 	{
 		SignalTransformChange();
 	}
 
 	void Node::SignalChange()
 	{
-		m_requires_update[0] = m_requires_update[1] = m_requires_update[2] = true;
+		m_requires_commit = true;
 	}
 
 	void Node::SignalTransformChange()
+	{
+		m_requires_transform_commit = true;
+	}
+
+	void Node::MarkRequiresUpdate()
+	{
+		m_requires_update[0] = m_requires_update[1] = m_requires_update[2] = true;
+	}
+
+	void Node::MarkRequiresTransformUpdate()
 	{
 		m_requires_transform_update[0] = m_requires_transform_update[1] = m_requires_transform_update[2] = true;
 
 		for (std::shared_ptr<Node>& child : m_children)
 		{
-			child->SignalTransformChange();
+			child->MarkRequiresTransformUpdate();
+		}
+	}
+
+	void Node::Commit()
+	{
+		if (m_requires_transform_commit)
+		{
+			if (!m_use_quaternion)
+			{
+				DirectX::XMStoreFloat4(&m_rotation, DirectX::XMQuaternionRotationRollPitchYawFromVector(DirectX::XMLoadFloat3(&m_rotation_radians)));
+			}
+
+			m_render_transform.m_position = m_position;
+			m_render_transform.m_rotation = m_rotation;
+			m_render_transform.m_scale = m_scale;
+
+			m_requires_transform_commit = false;
+			MarkRequiresTransformUpdate();
+		}
+
+		if (m_requires_commit)
+		{
+			m_requires_commit = false;
+			MarkRequiresUpdate();
 		}
 	}
 
@@ -66,14 +100,14 @@ namespace wr
 
 	void Node::SetRotation(DirectX::XMVECTOR roll_pitch_yaw)
 	{
-		m_rotation_radians = roll_pitch_yaw;
+		DirectX::XMStoreFloat3(&m_rotation_radians, roll_pitch_yaw);
 		m_use_quaternion = false;
 		SignalTransformChange();
 	}
 
 	void Node::SetRotationQuaternion(DirectX::XMVECTOR rotation)
 	{
-		m_rotation = rotation;
+		DirectX::XMStoreFloat4(&m_rotation, rotation);
 		m_use_quaternion = true;
 		SignalTransformChange();
 	}
@@ -87,13 +121,13 @@ namespace wr
 
 	void Node::SetPosition(DirectX::XMVECTOR position)
 	{
-		m_position = position;
+		DirectX::XMStoreFloat3(&m_position, position);
 		SignalTransformChange();
 	}
 
 	void Node::SetScale(DirectX::XMVECTOR scale)
 	{
-		m_scale = scale;
+		DirectX::XMStoreFloat3(&m_scale, scale);
 		SignalTransformChange();
 	}
 
@@ -104,23 +138,42 @@ namespace wr
 		SetScale(scale);
 	}
 
+	DirectX::XMVECTOR Node::GetPosition() const
+	{
+		return DirectX::XMLoadFloat3(&m_position);
+	}
+
+	DirectX::XMVECTOR Node::GetRotationRadians() const
+	{
+		return DirectX::XMLoadFloat3(&m_rotation_radians);
+	}
+
+	DirectX::XMVECTOR Node::GetScale() const
+	{
+		return DirectX::XMLoadFloat3(&m_scale);
+	}
+
 	void Node::UpdateTransform()
 	{
-		if (!m_use_quaternion)
-		{
-			m_rotation = DirectX::XMQuaternionRotationRollPitchYawFromVector(m_rotation_radians);
-		}
 		m_prev_transform = m_transform;
 
-		DirectX::XMMATRIX translation_mat = DirectX::XMMatrixTranslationFromVector(m_position);
-		DirectX::XMMATRIX rotation_mat = DirectX::XMMatrixRotationQuaternion(m_rotation);
-		DirectX::XMMATRIX scale_mat = DirectX::XMMatrixScalingFromVector(m_scale);
-		m_transform = m_local_transform = scale_mat * rotation_mat * translation_mat;
+		DirectX::XMMATRIX transform = DirectX::XMMatrixAffineTransformation(
+			DirectX::XMLoadFloat3(&m_render_transform.m_scale),
+			DirectX::g_XMZero,
+			DirectX::XMLoadFloat4(&m_render_transform.m_rotation),
+			DirectX::XMLoadFloat3(&m_render_transform.m_position));
 
 		if (m_parent)
-			m_transform *= m_parent->m_transform;
+			transform *= m_parent->GetTransform();
 
-		SignalChange();
+		DirectX::XMStoreFloat3x4(&m_transform, transform);
+
+		MarkRequiresUpdate();
+	}
+
+	DirectX::XMMATRIX Node::GetTransform() const
+	{
+		return DirectX::XMLoadFloat3x4(&m_transform);
 	}
 
 } /* wr */
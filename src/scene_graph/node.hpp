@@ -22,19 +22,32 @@
 
 namespace wr
 {
+	//! Compact local transform; matrices are only derived when the world transform is rebuilt
+	struct LocalTransform
+	{
+		DirectX::XMFLOAT4 m_rotation = { 0, 0, 0, 1 };
+		DirectX::XMFLOAT3 m_position = { 0, 0, 0 };
+		DirectX::XMFLOAT3 m_scale = { 1, 1, 1 };
+	};
+
 	struct Node : std::enable_shared_from_this<Node>
 	{
 		Node();
 		explicit Node(std::type_info const & type_info);
 
+		//Write side; marks the node for the next SceneGraph::Commit
 		void SignalChange();
+		void SignalTransformChange();
+
+		//Render side; consumed by the render system once per frame index
 		void SignalUpdate(unsigned int frame_idx);
 		bool RequiresUpdate(unsigned int frame_idx);
-
-		void SignalTransformChange();
 		void SignalTransformUpdate(unsigned int frame_idx);
 		bool RequiresTransformUpdate(unsigned int frame_idx);
 
+		//Copies pending write side changes into the render side state; called by SceneGraph::Commit
+		virtual void Commit();
+
 		//Takes roll, pitch and yaw and converts it to quaternion
 		virtual void SetRotation(DirectX::XMVECTOR roll_pitch_yaw);
 		virtual void SetRotationQuaternion(DirectX::XMVECTOR rotation);
@@ -51,33 +64,50 @@ namespace wr
 		//Position, rotation (roll, pitch, yaw) and scale
 		virtual void SetTransform(DirectX::XMVECTOR position, DirectX::XMVECTOR rotation, DirectX::XMVECTOR scale);
 
-		//Update the transform; done automatically when SignalChange is called
+		//Write side transform loaded into a register
+		DirectX::XMVECTOR GetPosition() const;
+		DirectX::XMVECTOR GetRotationRadians() const;
+		DirectX::XMVECTOR GetScale() const;
+
+		//Update the transform from the committed local transform; done by the render system after a commit
 		void UpdateTransform();
 
+		//World transform expanded to a full matrix
+		DirectX::XMMATRIX GetTransform() const;
+
 		std::shared_ptr<Node> m_parent;
 		std::vector<std::shared_ptr<Node>> m_children;
 
 		//Translation of mesh node
-		DirectX::XMVECTOR m_position = { 0, 0, 0, 1 };
+		DirectX::XMFLOAT3 m_position = { 0, 0, 0 };
 
 		//Rotation as quaternion
-		DirectX::XMVECTOR m_rotation;
+		DirectX::XMFLOAT4 m_rotation = { 0, 0, 0, 1 };
 
 		//Rotation in radians
-		DirectX::XMVECTOR m_rotation_radians = { 0,0,0 };
+		DirectX::XMFLOAT3 m_rotation_radians = { 0, 0, 0 };
 
 		//Scale
-		DirectX::XMVECTOR m_scale = { 1, 1, 1, 0 };
+		DirectX::XMFLOAT3 m_scale = { 1, 1, 1 };
 
-		//Transformation
-		DirectX::XMMATRIX m_local_transform, m_transform, m_prev_transform;
+		//Local transform as last committed; only read by the render side
+		LocalTransform m_render_transform;
+
+		//World transformation as a transposed 3x4 affine matrix (see XMStoreFloat3x4)
+		DirectX::XMFLOAT3X4 m_transform, m_prev_transform;
 
 		const std::type_info& m_type_info;
 
 	protected:
+		void MarkRequiresUpdate();
+		void MarkRequiresTransformUpdate();
+
 		bool m_use_quaternion = false;
 
 	private:
+		bool m_requires_commit = false;
+		bool m_requires_transform_commit = false;
+
 		std::bitset<3> m_requires_update;
 		std::bitset<3> m_requires_transform_update;
 	};
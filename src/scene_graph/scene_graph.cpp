@@ -16,8 +16,12 @@
 #include "scene_graph.hpp"
 
 #include <algorithm>
+#include <limits>
 
 #include "../renderer.hpp"
+#include "../window.hpp"
+#include "../material_pool.hpp"
+#include "../settings.hpp"
 #include "../util/log.hpp"
 
 #include "camera_node.hpp"
@@ -144,6 +148,29 @@ namespace wr
 
 	}
 
+	//! Commit the write side of the scene graph to the render side
+	/*!
+		Node setters, `SignalChange` and `SignalTransformChange` only touch the write side of a node.
+		This applies those pending changes (transforms, materials, visibility and light data) to the state the renderer reads.
+		With double buffering disabled the render system calls this at the start of every frame.
+		With it enabled the application calls it at its own sync point, after simulating frame N+1 and while frame N is not being prepared,
+		so simulation can overlap with render preparation. Creating or destroying nodes still has to happen at that sync point.
+	*/
+	void SceneGraph::Commit()
+	{
+		CommitNode(m_root);
+	}
+
+	void SceneGraph::CommitNode(std::shared_ptr<Node> const & node)
+	{
+		node->Commit();
+
+		for (auto& child : node->m_children)
+		{
+			CommitNode(child);
+		}
+	}
+
 	//! Update the scene graph
 	void SceneGraph::Update()
 	{
@@ -202,6 +229,16 @@ namespace wr
 		m_rt_culling_distance = GetRTCullingDistance() * (b * 2 - 1);
 	}
 
+	bool SceneGraph::GetDoubleBufferingEnabled()
+	{
+		return m_double_buffering;
+	}
+
+	void SceneGraph::SetDoubleBufferingEnable(bool b)
+	{
+		m_double_buffering = b;
+	}
+
 	Light* SceneGraph::GetLight(uint32_t offset)
 	{
 		return offset >= m_next_light_id ? m_lights.data() : m_lights.data() + offset;
@@ -259,12 +296,12 @@ namespace wr
 			for (auto& node : m_mesh_nodes)
 			{
 
-				auto mesh_materials_pair = std::make_pair(node->m_model, node->m_materials);
+				auto mesh_materials_pair = std::make_pair(node->m_render_model, node->m_render_materials);
 
 				auto it = m_batches.find(mesh_materials_pair);
 
 				//It won't keep track of anything if it has no model
-				if (node->m_model == nullptr)
+				if (node->m_render_model == nullptr)
 				{
 					continue;
 				}
@@ -278,7 +315,7 @@ namespace wr
 
 					auto& batch = m_batches[mesh_materials_pair];
 					batch.batch_buffer = object_buffer;
-					batch.m_materials = node->GetMaterials();
+					batch.m_materials = node->m_render_materials;
 					batch.data.objects.resize(d3d12::settings::num_instances_per_batch);
 					
 					if (obj == m_objects.end()) {
@@ -293,13 +330,13 @@ namespace wr
 				++it->second.num_total_instances;
 
 				//Model should remain loaded, but not rendered
-				if (!node->m_visible)
+				if (!node->m_render_visible)
 				{
 					continue;
 				}
 
 				temp::MeshBatch& batch = it->second;
-				batch.m_materials = node->GetMaterials();
+				batch.m_materials = node->m_render_materials;
 
 				//Cull for rasterizer
 				if (!d3d12::settings::enable_object_culling || GetActiveCamera()->InView(node))
@@ -351,7 +388,94 @@ namespace wr
 			}
 
 		}
-		
+
+		if constexpr (settings::use_texture_streaming)
+		{
+			RequestTextureMips();
+		}
+	}
+
+	void SceneGraph::RequestTextureMips()
+	{
+		std::shared_ptr<CameraNode> camera = GetActiveCamera();
+		if (camera == nullptr)
+		{
+			return;
+		}
+
+		// Without a window there's no screen to estimate the texel density for, visible textures get all their mips
+		bool const has_window = m_render_system->m_window.has_value();
+		float const pixels_per_unit_at_unit_distance = has_window ?
+			0.5f * DirectX::XMVectorGetY(camera->m_projection.r[1]) * static_cast<float>(m_render_system->m_window.value()->GetHeight()) : 0.f;
+		DirectX::XMVECTOR const camera_position = camera->m_inverse_view.r[3];
+
+		// Collected per pool and submitted at the end, so every pool is locked once per frame
+		std::unordered_map<TexturePool*, std::vector<TextureMipRequest>> requests;
+
+		for (auto& node : m_mesh_nodes)
+		{
+			Model* model = node->m_render_model;
+
+			if (model == nullptr || !node->m_render_visible || !camera->InView(node))
+			{
+				continue;
+			}
+
+			float pixels_per_unit = std::numeric_limits<float>::infinity();
+			if (has_window)
+			{
+				// The nearest point of the bounds is where the node's textures are magnified the most, orthographic views don't get smaller with distance
+				DirectX::XMVECTOR const nearest = DirectX::XMVectorClamp(camera_position, node->m_aabb.m_min, node->m_aabb.m_max);
+				float const distance = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(nearest, camera_position)));
+				pixels_per_unit = pixels_per_unit_at_unit_distance / (camera->m_enable_orthographic ? 1.f : std::max(distance, camera->m_frustum_near));
+			}
+
+			DirectX::XMMATRIX const transform = DirectX::XMLoadFloat3x4(&node->m_transform);
+			float const scale = std::max({
+				DirectX::XMVectorGetX(DirectX::XMVector3Length(transform.r[0])),
+				DirectX::XMVectorGetX(DirectX::XMVector3Length(transform.r[1])),
+				DirectX::XMVectorGetX(DirectX::XMVector3Length(transform.r[2])) });
+
+			for (std::size_t mesh_i = 0; mesh_i < model->m_meshes.size(); ++mesh_i)
+			{
+				// Same material choice as the renderer
+				auto const & [mesh, model_material] = model->m_meshes[mesh_i];
+				MaterialHandle material_handle = mesh_i < node->m_render_materials.size() ? node->m_render_materials[mesh_i] : model_material;
+
+				if (material_handle.m_pool == nullptr)
+				{
+					continue;
+				}
+
+				// Destroyed materials are skipped without logging, the renderer reports those
+				Material* material = material_handle.m_pool->FindMaterial(material_handle);
+				if (material == nullptr)
+				{
+					continue;
+				}
+
+				// Meshes without texture coordinates are treated as having one UV unit per object space unit
+				float const uv_density = model->m_model_pool != nullptr ? model->m_model_pool->GetUVDensity(mesh->id) : 0.f;
+				float const pixels_per_uv = pixels_per_unit * scale / (uv_density > 0.f ? uv_density : 1.f);
+
+				for (std::size_t type = 0; type < static_cast<std::size_t>(TextureType::COUNT); ++type)
+				{
+					if (material->HasTexture(static_cast<TextureType>(type)))
+					{
+						TextureHandle texture = material->GetTexture(static_cast<TextureType>(type));
+						if (texture.m_pool != nullptr)
+						{
+							requests[texture.m_pool].push_back({ texture, pixels_per_uv });
+						}
+					}
+				}
+			}
+		}
+
+		for (auto const & [pool, pool_requests] : requests)
+		{
+			pool->RequestMips(pool_requests);
+		}
 	}
 
 } /* wr */
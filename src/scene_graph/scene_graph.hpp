@@ -46,9 +46,10 @@ namespace wr
 
 	namespace temp {
 
+		//! Per instance data; transposed 3x4 affine matrices, matching `row_major float3x4` in HLSL
 		struct ObjectData {
-			DirectX::XMMATRIX m_model;
-			DirectX::XMMATRIX m_prev_model;
+			DirectX::XMFLOAT3X4 m_model;
+			DirectX::XMFLOAT3X4 m_prev_model;
 		};
 
 		struct MeshBatch_CBData
@@ -105,6 +106,7 @@ namespace wr
 		void UpdateSkyboxNode(std::shared_ptr<SkyboxNode> node, TextureHandle new_equirectangular);
 
 		void Init();
+		void Commit();
 		void Update();
 		void Render(CommandList* cmd_list, CameraNode* camera);
 
@@ -125,9 +127,15 @@ namespace wr
 		void SetRTCullingDistance(float dist);
 		void SetRTCullingEnable(bool b);
 
+		bool GetDoubleBufferingEnabled();
+		void SetDoubleBufferingEnable(bool b);
+
 	protected:
 
 		void RegisterLight(std::shared_ptr<LightNode>& light_node);
+		static void CommitNode(std::shared_ptr<Node> const & node);
+		//! Asks the texture pools for the mips the visible mesh nodes need, from their distance to the active camera and their meshes' UV density.
+		void RequestTextureMips();
 
 	private:
 
@@ -156,6 +164,7 @@ namespace wr
 
 		uint32_t m_next_light_id = 0;
 		float m_rt_culling_distance = -1;
+		bool m_double_buffering = false;
 	};
 
 	//! Creates a child into the scene graph
@@ -20,6 +20,45 @@ namespace wr::settings
 
 	static const constexpr bool use_multithreading = true;
 	static const constexpr unsigned int num_frame_graph_threads = 4;
+	static const constexpr unsigned int num_model_load_threads = 2;
+	static const constexpr unsigned int num_model_decode_threads = 4; // glTF primitives are decoded and their tangents generated on this many threads
+	static const constexpr unsigned int num_mesh_process_threads = 4; // loaded meshes are optimized and get their meshlets and LODs on this many threads, next to the loading thread
+	static const constexpr unsigned int num_animation_threads = 4; // AnimationSystem samples poses and skins vertices on this many threads
+	static const constexpr std::size_t skinning_vertices_per_job = 8192; // larger meshes are skinned by several jobs
+	static const constexpr unsigned int num_texture_decode_threads = 4; // TexturePool::LoadFromFileAsync and LoadFromMemoryAsync read and decode images on this many threads
+	static const constexpr bool use_async_texture_loading = true; // model materials load their textures asynchronously, they show the pool's default textures until they're decoded
+	static const constexpr bool use_texture_cache = false; // TexturePool stores decoded textures with their mip chain as DDS files and uploads those as is on later loads; opt-in, as it writes to texture_cache_directory
+	static constexpr const char* texture_cache_directory = "cache/textures/";
+	static const constexpr bool use_texture_compression = true; // material textures are block compressed on the CPU: BC1/BC3 color, BC4 roughness, metallic and AO, BC5 normal maps
+	static const constexpr bool texture_compression_quality = false; // color textures use BC7 instead of BC1/BC3, slower to compress
+	static const constexpr unsigned int num_texture_bake_threads = 4; // each texture's mips are filtered and its blocks compressed on this many threads
+	static const constexpr bool use_kaiser_mip_filter = true; // 8 bit texture mips are filtered with a Kaiser windowed sinc instead of a box filter
+	static const constexpr float texture_mip_alpha_test = 0.5f; // color texture mips keep the share of texels passing this alpha test, matches the discard in deferred_geometry_pass.hlsl
+	static const constexpr bool log_texture_compression_psnr = false; // logs the PSNR of every compressed texture's top mip
+	static const constexpr bool use_texture_streaming = true; // loaded textures start with their coarse mips, SceneGraph::Optimize requests the finer mips visible meshes need
+	static const constexpr std::size_t texture_streaming_budget = 512ull * 1024ull * 1024ull; // bytes of streamed textures a texture pool keeps, counting their resident mips and the images they stream from; the finer mips that were needed least recently are evicted above it
+	static const constexpr std::size_t texture_stream_initial_size = 64; // streamed textures start with the mips of at most this many texels along their longest side
+	static const constexpr std::size_t texture_stream_bytes_per_frame = 8ull * 1024ull * 1024ull; // mip bytes a texture pool uploads per frame while streaming
+	static const constexpr float texture_stream_mip_bias = 0.f; // added to the estimated mip, negative values stream in sharper mips
+	static const constexpr std::uint32_t texture_stream_keep_frames = 120; // frames a texture keeps the mips it was last requested with, after that they can be evicted
+	static const constexpr bool automatic_16bit_indices = true; // store meshes with less than 65536 vertices with 16 bit indices
+	static const constexpr bool cache_models = true; // Load and LoadWithMaterials return the already loaded model for a path and options they've seen before
+	static const constexpr bool use_baked_model_cache = false; // Load, LoadWithMaterials and LoadAsync store converted models on disk and map them on later loads; opt-in, as it writes to baked_model_cache_directory
+	static constexpr const char* baked_model_cache_directory = "cache/models/";
+	static const constexpr bool stream_async_models = true; // LoadAsync shows the coarsest LOD of every mesh first and streams in the full meshes over the next frames
+	static const constexpr std::size_t model_stream_bytes_per_frame = 8ull * 1024ull * 1024ull; // vertex and index bytes FinalizeAsyncLoads uploads per frame while streaming
+	static const constexpr bool deduplicate_meshes = true; // meshes with identical vertex and index data share one allocation in the model pool
+	static const constexpr bool optimize_meshes = true; // reorder triangles and vertices for the vertex cache, overdraw and vertex fetch when loading
+	static const constexpr float mesh_overdraw_threshold = 1.05f; // how much vertex cache efficiency the overdraw optimization may give up
+	static const constexpr bool log_mesh_optimization_statistics = false; // logs the ACMR/ATVR of every mesh before and after optimizing
+	static const constexpr bool generate_meshlets = true; // split large loaded meshes into meshlets that can be culled individually
+	static const constexpr std::uint32_t meshlet_min_triangles = 4096; // smaller meshes are always drawn whole
+	static const constexpr std::uint32_t meshlet_max_vertices = 64;
+	static const constexpr std::uint32_t meshlet_max_triangles = 124;
+	static const constexpr unsigned int num_generated_lods = 3; // simplified versions generated per loaded mesh, 0 disables LOD generation
+	static const constexpr std::uint32_t lod_min_triangles = 16384; // smaller meshes don't get LODs
+	static const constexpr float lod_triangle_ratio = 0.5f; // triangles of a LOD relative to the previous LOD
+	static const constexpr float lod_max_error = 0.05f; // relative to the mesh size, the chain ends when a LOD can't be reached within it
 
 	static const constexpr std::uint8_t default_textures_count = 5;
 	static const constexpr std::uint32_t default_textures_size_in_bytes = 4ul * 1024ul * 1024ul;
@@ -15,55 +15,44 @@
  */
 #include "aabb.hpp"
 
+#include "simd.hpp"
+
 namespace wr
 {
 
-	Box::Box() : 
-		m_data
-		{ 
-			{
-				std::numeric_limits<float>::max(),
-				std::numeric_limits<float>::max(),
-				std::numeric_limits<float>::max()
-			},
-			{
-				-std::numeric_limits<float>::max(),
-				-std::numeric_limits<float>::max(),
-				-std::numeric_limits<float>::max()
-			},
-			{
-				std::numeric_limits<float>::max(),
-				std::numeric_limits<float>::max(),
-				std::numeric_limits<float>::max()
-			},
-			{
-				-std::numeric_limits<float>::max(),
-				-std::numeric_limits<float>::max(),
-				-std::numeric_limits<float>::max()
-			},
-			{
-				std::numeric_limits<float>::max(),
-				std::numeric_limits<float>::max(),
-				std::numeric_limits<float>::max()
-			},
-			{
-				-std::numeric_limits<float>::max(),
-				-std::numeric_limits<float>::max(),
-				-std::numeric_limits<float>::max()
-			} 
+	Box::Box() :
+		m_center{ 0, 0, 0, 0 },
+		m_extents
+		{
+			-std::numeric_limits<float>::max(),
+			-std::numeric_limits<float>::max(),
+			-std::numeric_limits<float>::max(),
+			0
 		}
 	{
 
 	}
 
-	Box::Box(DirectX::XMVECTOR(&corners)[6])
+	Box::Box(DirectX::XMVECTOR center, DirectX::XMVECTOR extents) : m_center(center), m_extents(extents)
 	{
-		memcpy(m_data, corners, sizeof(corners));
 	}
 
-	DirectX::XMVECTOR& Box::operator[](size_t i)
+	Box Box::FromMinMax(DirectX::XMVECTOR min, DirectX::XMVECTOR max)
 	{
-		return m_data[i];
+		DirectX::XMVECTOR center = DirectX::XMVectorScale(DirectX::XMVectorAdd(max, min), 0.5f);
+		DirectX::XMVECTOR extents = DirectX::XMVectorScale(DirectX::XMVectorSubtract(max, min), 0.5f);
+
+		return Box(DirectX::XMVectorSetW(center, 0), DirectX::XMVectorSetW(extents, 0));
+	}
+
+	DirectX::XMVECTOR Box::GetMin() const
+	{
+		return DirectX::XMVectorSubtract(m_center, m_extents);
+	}
+
+	DirectX::XMVECTOR Box::GetMax() const
+	{
+		return DirectX::XMVectorAdd(m_center, m_extents);
 	}
 
 	DirectX::XMVECTOR& AABB::operator[](size_t i)
@@ -73,21 +62,10 @@ namespace wr
 
 	void AABB::Expand(DirectX::XMVECTOR pos)
 	{
-		m_min =
-		{
-			std::min(pos.m128_f32[0], *m_minf),
-			std::min(pos.m128_f32[1], m_minf[1]),
-			std::min(pos.m128_f32[2], m_minf[2]),
-			1
-		};
+		pos = DirectX::XMVectorSetW(pos, 1);
 
-		m_max =
-		{
-			std::max(pos.m128_f32[0], *m_maxf),
-			std::max(pos.m128_f32[1], m_maxf[1]),
-			std::max(pos.m128_f32[2], m_maxf[2]),
-			1
-		};
+		m_min = DirectX::XMVectorMin(m_min, pos);
+		m_max = DirectX::XMVectorMax(m_max, pos);
 	}
 
 	AABB::AABB() : 
@@ -114,54 +92,79 @@ namespace wr
 	{
 	}
 
-	AABB AABB::FromTransform(Box box, DirectX::XMMATRIX transform)
+	//Absolute matrix method (Arvo); the center is transformed as a point and
+	//the world extents are the local extents projected onto the absolute basis vectors.
+	AABB AABB::FromTransform(Box const & box, DirectX::XMMATRIX transform)
 	{
-		AABB aabb;
-
-		//Transform all coords from model to world space
-		//Pick the min/max bounds
+		DirectX::XMVECTOR center = DirectX::XMVector3Transform(box.m_center, transform);
 
-		for (DirectX::XMVECTOR& vec : box.m_data)
-		{
-			DirectX::XMVECTOR tvec = DirectX::XMVector4Transform(vec, transform);
-			aabb.Expand(tvec);
-		}
+		DirectX::XMVECTOR extents = DirectX::XMVectorMultiply(DirectX::XMVectorAbs(transform.r[0]), DirectX::XMVectorSplatX(box.m_extents));
+		extents = DirectX::XMVectorMultiplyAdd(DirectX::XMVectorAbs(transform.r[1]), DirectX::XMVectorSplatY(box.m_extents), extents);
+		extents = DirectX::XMVectorMultiplyAdd(DirectX::XMVectorAbs(transform.r[2]), DirectX::XMVectorSplatZ(box.m_extents), extents);
 
-		return aabb;
+		return AABB(
+			DirectX::XMVectorSetW(DirectX::XMVectorSubtract(center, extents), 1),
+			DirectX::XMVectorSetW(DirectX::XMVectorAdd(center, extents), 1));
 	}
 
-	void Box::ExpandFromVector(DirectX::XMVECTOR pos)
+	void AABB::FromTransforms(Box const * boxes, DirectX::XMFLOAT3X4 const * transforms, AABB* out, std::size_t count)
 	{
+		std::size_t i = 0;
 
-		if (pos.m128_f32[0] < m_corners.m_xmin.m128_f32[0])
-		{
-			m_corners.m_xmin = pos;
-		}
-
-		if (pos.m128_f32[0] > m_corners.m_xmax.m128_f32[0])
-		{
-			m_corners.m_xmax = pos;
-		}
-
-		if (pos.m128_f32[1] < m_corners.m_ymin.m128_f32[1])
-		{
-			m_corners.m_ymin = pos;
-		}
+#ifdef WISP_SIMD_AVX2
+		//Two boxes per iteration; one per 128-bit lane, so every in-lane shuffle below is the 4-wide math of FromTransform
+		const __m256 w_one = _mm256_set_ps(1, 0, 0, 0, 1, 0, 0, 0);
 
-		if (pos.m128_f32[1] > m_corners.m_ymax.m128_f32[1])
+		for (; i + 2 <= count; i += 2)
 		{
-			m_corners.m_ymax = pos;
+			DirectX::XMFLOAT3X4 const & ta = transforms[i];
+			DirectX::XMFLOAT3X4 const & tb = transforms[i + 1];
+
+			//Rows of the transposed 3x4 matrices are the columns of the world matrices
+			__m256 t0 = util::simd::Load2(ta.m[0], tb.m[0]);
+			__m256 t1 = util::simd::Load2(ta.m[1], tb.m[1]);
+			__m256 t2 = util::simd::Load2(ta.m[2], tb.m[2]);
+
+			//Transpose back to rows r0..r3 (r3 being the translation)
+			__m256 tmp0 = _mm256_unpacklo_ps(t0, t1);
+			__m256 tmp1 = _mm256_unpacklo_ps(t2, w_one);
+			__m256 tmp2 = _mm256_unpackhi_ps(t0, t1);
+			__m256 tmp3 = _mm256_unpackhi_ps(t2, w_one);
+
+			__m256 r0 = _mm256_shuffle_ps(tmp0, tmp1, _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 r1 = _mm256_shuffle_ps(tmp0, tmp1, _MM_SHUFFLE(3, 2, 3, 2));
+			__m256 r2 = _mm256_shuffle_ps(tmp2, tmp3, _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 r3 = _mm256_shuffle_ps(tmp2, tmp3, _MM_SHUFFLE(3, 2, 3, 2));
+
+			__m256 c = _mm256_insertf128_ps(_mm256_castps128_ps256(boxes[i].m_center), boxes[i + 1].m_center, 1);
+			__m256 e = _mm256_insertf128_ps(_mm256_castps128_ps256(boxes[i].m_extents), boxes[i + 1].m_extents, 1);
+
+			__m256 center = _mm256_add_ps(_mm256_mul_ps(r0, util::simd::SplatLane<0>(c)), r3);
+			center = _mm256_add_ps(_mm256_mul_ps(r1, util::simd::SplatLane<1>(c)), center);
+			center = _mm256_add_ps(_mm256_mul_ps(r2, util::simd::SplatLane<2>(c)), center);
+
+			__m256 extents = _mm256_mul_ps(util::simd::Abs(r0), util::simd::SplatLane<0>(e));
+			extents = _mm256_add_ps(_mm256_mul_ps(util::simd::Abs(r1), util::simd::SplatLane<1>(e)), extents);
+			extents = _mm256_add_ps(_mm256_mul_ps(util::simd::Abs(r2), util::simd::SplatLane<2>(e)), extents);
+
+			//Force w to 1 like FromTransform does
+			__m256 min = _mm256_blend_ps(_mm256_sub_ps(center, extents), w_one, 0x88);
+			__m256 max = _mm256_blend_ps(_mm256_add_ps(center, extents), w_one, 0x88);
+
+			util::simd::Store2(&out[i].m_min, &out[i + 1].m_min, min);
+			util::simd::Store2(&out[i].m_max, &out[i + 1].m_max, max);
 		}
+#endif
 
-		if (pos.m128_f32[2] < m_corners.m_zmin.m128_f32[2])
+		for (; i < count; ++i)
 		{
-			m_corners.m_zmin = pos;
+			out[i] = FromTransform(boxes[i], DirectX::XMLoadFloat3x4(transforms + i));
 		}
+	}
 
-		if (pos.m128_f32[2] > m_corners.m_zmax.m128_f32[2])
-		{
-			m_corners.m_zmax = pos;
-		}
+	void Box::ExpandFromVector(DirectX::XMVECTOR pos)
+	{
+		*this = FromMinMax(DirectX::XMVectorMin(GetMin(), pos), DirectX::XMVectorMax(GetMax(), pos));
 	}
 
 	void Box::Expand(float(&pos)[3])
@@ -176,12 +179,8 @@ namespace wr
 		-std::numeric_limits<float>::max()
 	}{ }
 
-	Sphere::Sphere(DirectX::XMVECTOR center, float radius): m_sphere {
-		center.m128_f32[0],
-		center.m128_f32[1],
-		center.m128_f32[2],
-		radius
-	}{ }
+	Sphere::Sphere(DirectX::XMVECTOR center, float radius): m_sphere(DirectX::XMVectorSetW(center, radius))
+	{ }
 
 	bool AABB::InFrustum(const std::array<DirectX::XMVECTOR, 6>& planes) const
 	{
@@ -189,15 +188,11 @@ namespace wr
 		{
 			/* Get point of AABB that's into the plane the most */
 
-			DirectX::XMVECTOR axis_vert = {
-				*m_data[*plane.m128_f32 >= 0].m128_f32,
-				m_data[plane.m128_f32[1] >= 0].m128_f32[1],
-				m_data[plane.m128_f32[2] >= 0].m128_f32[2]
-			};
+			DirectX::XMVECTOR axis_vert = DirectX::XMVectorSelect(m_min, m_max, DirectX::XMVectorGreaterOrEqual(plane, DirectX::g_XMZero));
 
 			/* Check if it's outside */
 
-			if (*DirectX::XMVector3Dot(plane, axis_vert).m128_f32 + plane.m128_f32[3] < 0)
+			if (DirectX::XMVectorGetX(DirectX::XMPlaneDot(plane, axis_vert)) < 0)
 				return false;
 
 		}
@@ -208,20 +203,11 @@ namespace wr
 
 	bool AABB::Contains(const Sphere& sphere) const
 	{
-		float square_dist = 0;
-
-		for(size_t i = 0; i < 3; ++i)
-		{
-			if(sphere.m_data[i] < m_minf[i])
-			{
-				square_dist += pow(sphere.m_data[i] - m_minf[i], 2);
-			}
-			else if(sphere.m_data[i] > m_maxf[i])
-			{
-				square_dist += pow(sphere.m_data[i] - m_maxf[i], 2);
-			}
-		}
+		//Distance from the center to the box along each axis; zero for axes where the center is inside
+		DirectX::XMVECTOR below = DirectX::XMVectorMax(DirectX::XMVectorSubtract(m_min, sphere.m_sphere), DirectX::g_XMZero);
+		DirectX::XMVECTOR above = DirectX::XMVectorMax(DirectX::XMVectorSubtract(sphere.m_sphere, m_max), DirectX::g_XMZero);
 
+		const float square_dist = DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(DirectX::XMVectorAdd(below, above)));
 		const float r_squared = sphere.m_radius * sphere.m_radius;
 		return square_dist <= r_squared;
 	}
@@ -21,25 +21,21 @@
 
 namespace wr
 {
+	//Local space bounds stored as center and half extents
 	struct Box
 	{
-		struct Corners
-		{
-			DirectX::XMVECTOR m_xmin, m_xmax, m_ymin, m_ymax, m_zmin, m_zmax;
-		};
-
-		union
-		{
-			Corners m_corners;
-			DirectX::XMVECTOR m_data[6];
-		};
+		DirectX::XMVECTOR m_center;
+		DirectX::XMVECTOR m_extents;
 
-		//Max bounds on each corner
+		//Empty box; negative extents so the first expand snaps to the position
 		Box();
 
-		Box(DirectX::XMVECTOR (&corners)[6]);
+		Box(DirectX::XMVECTOR center, DirectX::XMVECTOR extents);
 
-		DirectX::XMVECTOR &operator[](size_t i);
+		static Box FromMinMax(DirectX::XMVECTOR min, DirectX::XMVECTOR max);
+
+		DirectX::XMVECTOR GetMin() const;
+		DirectX::XMVECTOR GetMax() const;
 
 		//Expand bounds using position
 		void ExpandFromVector(DirectX::XMVECTOR pos);
@@ -111,7 +107,10 @@ namespace wr
 		bool Contains(const Sphere& sphere) const;
 
 		//Generates AABB from transform and box
-		static AABB FromTransform(Box box, DirectX::XMMATRIX transform);
+		static AABB FromTransform(Box const & box, DirectX::XMMATRIX transform);
+
+		//Generates AABBs for count boxes with their transposed 3x4 world transforms
+		static void FromTransforms(Box const * boxes, DirectX::XMFLOAT3X4 const * transforms, AABB* out, std::size_t count);
 
 	};
 
@@ -35,14 +35,14 @@ namespace util
 	{
 		const std::uint64_t idx = IndexFromBit(frame);
 		const std::uint64_t off = OffsetFromBit(frame);
-		bitmap[idx] |= (1Ui64 << off);
+		bitmap[idx] |= (std::uint64_t(1) << off);
 	}
 
 	inline void ClearPage(std::vector<uint64_t> & bitmap, std::uint64_t frame)
 	{
 		const std::uint64_t idx = IndexFromBit(frame);
 		const std::uint64_t off = OffsetFromBit(frame);
-		bitmap[idx] &= ~(1Ui64 << off);
+		bitmap[idx] &= ~(std::uint64_t(1) << off);
 	}
 
 	inline bool TestPage(std::vector<uint64_t> const & bitmap, std::uint64_t frame)
@@ -50,7 +50,7 @@ namespace util
 		const std::uint64_t idx = IndexFromBit(frame);
 		const std::uint64_t off = OffsetFromBit(frame);
 
-		return (bitmap[idx] & (1Ui64 << off));
+		return (bitmap[idx] & (std::uint64_t(1) << off));
 	}
 
 	inline std::optional<std::uint64_t> FindFreePage(std::vector<std::uint64_t> const & bitmap, std::size_t const frame_count, std::uint64_t needed_frames)
@@ -66,7 +66,7 @@ namespace util
 		for (std::uint64_t i = 0; i < bitmap.size(); ++i)
 		{
 			//Check 64 pages at once
-			if (bitmap[i] != 0Ui64)
+			if (bitmap[i] != std::uint64_t(0))
 			{
 				//At least a single page is free, so check all 64 pages
 				for (std::uint64_t j = 0; j < 64; ++j)
@@ -78,7 +78,7 @@ namespace util
 					}
 
 					//Set bit corresponding to page being checked in temporary variable
-					std::uint64_t to_test = 1Ui64 << j;
+					std::uint64_t to_test = std::uint64_t(1) << j;
 
 					//Run an 'and' against the temporary variable to see if the page is available
 					if ((bitmap[i] & to_test))
@@ -0,0 +1,799 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "block_compression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <vector>
+
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+namespace util
+{
+
+	namespace
+	{
+		// Interpolation weights of the BC1 color indices 0 to 3, as the weight of the second endpoint
+		constexpr float bc1_weights[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+		// Interpolation weights of the 4 bit BC7 indices, out of 64
+		constexpr int bc7_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		//! Little endian bit stream of one 128 bit block.
+		struct BlockBits
+		{
+			std::uint64_t m_bits[2] = { 0, 0 };
+			unsigned int m_position = 0;
+
+			void Write(std::uint64_t value, unsigned int count)
+			{
+				if (m_position < 64)
+				{
+					m_bits[0] |= value << m_position;
+					if (m_position + count > 64)
+					{
+						m_bits[1] |= value >> (64 - m_position);
+					}
+				}
+				else
+				{
+					m_bits[1] |= value << (m_position - 64);
+				}
+
+				m_position += count;
+			}
+
+			std::uint32_t Read(unsigned int count)
+			{
+				std::uint64_t value;
+				if (m_position < 64)
+				{
+					value = m_bits[0] >> m_position;
+					if (m_position + count > 64)
+					{
+						value |= m_bits[1] << (64 - m_position);
+					}
+				}
+				else
+				{
+					value = m_bits[1] >> (m_position - 64);
+				}
+
+				m_position += count;
+				return static_cast<std::uint32_t>(value & ((1ull << count) - 1));
+			}
+		};
+
+		void WriteLE(std::uint8_t* out, std::uint64_t value, std::size_t num_bytes)
+		{
+			for (std::size_t i = 0; i < num_bytes; ++i)
+			{
+				out[i] = static_cast<std::uint8_t>(value >> (i * 8));
+			}
+		}
+
+		std::uint64_t ReadLE(std::uint8_t const * in, std::size_t num_bytes)
+		{
+			std::uint64_t value = 0;
+			for (std::size_t i = 0; i < num_bytes; ++i)
+			{
+				value |= static_cast<std::uint64_t>(in[i]) << (i * 8);
+			}
+			return value;
+		}
+
+		void LoadTexels(std::uint8_t const (&texels)[64], DirectX::XMVECTOR (&out)[16])
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				out[i] = DirectX::XMVectorSet(texels[i * 4], texels[i * 4 + 1], texels[i * 4 + 2], texels[i * 4 + 3]);
+			}
+		}
+
+		//! Endpoints with the least squared error for fixed weights, t is the weight of the second endpoint. False when the weights don't determine them.
+		bool FitEndpoints(DirectX::XMVECTOR const (&texels)[16], float const (&t)[16], DirectX::XMVECTOR& a, DirectX::XMVECTOR& b)
+		{
+			float aa = 0.f, ab = 0.f, bb = 0.f;
+			DirectX::XMVECTOR ax = DirectX::XMVectorZero();
+			DirectX::XMVECTOR bx = DirectX::XMVectorZero();
+
+			for (int i = 0; i < 16; ++i)
+			{
+				float const s = 1.f - t[i];
+
+				aa += s * s;
+				ab += s * t[i];
+				bb += t[i] * t[i];
+
+				ax = DirectX::XMVectorMultiplyAdd(texels[i], DirectX::XMVectorReplicate(s), ax);
+				bx = DirectX::XMVectorMultiplyAdd(texels[i], DirectX::XMVectorReplicate(t[i]), bx);
+			}
+
+			float const determinant = aa * bb - ab * ab;
+			if (std::abs(determinant) < 1e-6f)
+			{
+				return false;
+			}
+
+			float const inverse = 1.f / determinant;
+			a = DirectX::XMVectorScale(DirectX::XMVectorSubtract(DirectX::XMVectorScale(ax, bb), DirectX::XMVectorScale(bx, ab)), inverse);
+			b = DirectX::XMVectorScale(DirectX::XMVectorSubtract(DirectX::XMVectorScale(bx, aa), DirectX::XMVectorScale(ax, ab)), inverse);
+
+			return true;
+		}
+
+		//! Line through the texels' mean along their principal axis, mask zeroes the channels to ignore.
+		/*!
+			The axis is the dominant eigenvector of the covariance matrix, found with a few power iterations that start
+			at the diagonal of the bounding box. out_min and out_max are the ends of the texels' projections onto it.
+		*/
+		void FitLine(DirectX::XMVECTOR const (&texels)[16], DirectX::XMVECTOR mask, DirectX::XMVECTOR& out_min, DirectX::XMVECTOR& out_max)
+		{
+			DirectX::XMVECTOR mean = DirectX::XMVectorZero();
+			DirectX::XMVECTOR min = DirectX::XMVectorReplicate(std::numeric_limits<float>::max());
+			DirectX::XMVECTOR max = DirectX::XMVectorReplicate(-std::numeric_limits<float>::max());
+
+			for (DirectX::XMVECTOR const & texel : texels)
+			{
+				mean = DirectX::XMVectorAdd(mean, texel);
+				min = DirectX::XMVectorMin(min, texel);
+				max = DirectX::XMVectorMax(max, texel);
+			}
+			mean = DirectX::XMVectorMultiply(DirectX::XMVectorScale(mean, 1.f / 16.f), mask);
+
+			// Symmetric, so the rows are the columns as well
+			DirectX::XMVECTOR covariance[4] = { DirectX::XMVectorZero(), DirectX::XMVectorZero(), DirectX::XMVectorZero(), DirectX::XMVectorZero() };
+			for (DirectX::XMVECTOR const & texel : texels)
+			{
+				DirectX::XMVECTOR const d = DirectX::XMVectorMultiply(DirectX::XMVectorSubtract(texel, mean), mask);
+
+				covariance[0] = DirectX::XMVectorMultiplyAdd(d, DirectX::XMVectorSplatX(d), covariance[0]);
+				covariance[1] = DirectX::XMVectorMultiplyAdd(d, DirectX::XMVectorSplatY(d), covariance[1]);
+				covariance[2] = DirectX::XMVectorMultiplyAdd(d, DirectX::XMVectorSplatZ(d), covariance[2]);
+				covariance[3] = DirectX::XMVectorMultiplyAdd(d, DirectX::XMVectorSplatW(d), covariance[3]);
+			}
+
+			DirectX::XMVECTOR axis = DirectX::XMVectorMultiply(DirectX::XMVectorSubtract(max, min), mask);
+
+			for (int iteration = 0; iteration < 8; ++iteration)
+			{
+				DirectX::XMVECTOR next = DirectX::XMVectorMultiply(covariance[0], DirectX::XMVectorSplatX(axis));
+				next = DirectX::XMVectorMultiplyAdd(covariance[1], DirectX::XMVectorSplatY(axis), next);
+				next = DirectX::XMVectorMultiplyAdd(covariance[2], DirectX::XMVectorSplatZ(axis), next);
+				next = DirectX::XMVectorMultiplyAdd(covariance[3], DirectX::XMVectorSplatW(axis), next);
+
+				float const length = DirectX::XMVectorGetX(DirectX::XMVector4Length(next));
+				if (length < 1e-6f)
+				{
+					break;
+				}
+
+				axis = DirectX::XMVectorScale(next, 1.f / length);
+			}
+
+			float const axis_length = DirectX::XMVectorGetX(DirectX::XMVector4Length(axis));
+			if (axis_length < 1e-6f)
+			{
+				// All texels are the same color
+				out_min = out_max = DirectX::XMVectorAdd(mean, DirectX::XMVectorMultiply(texels[0], DirectX::XMVectorSubtract(DirectX::g_XMOne, mask)));
+				return;
+			}
+			axis = DirectX::XMVectorScale(axis, 1.f / axis_length);
+
+			float min_t = std::numeric_limits<float>::max();
+			float max_t = -std::numeric_limits<float>::max();
+
+			for (DirectX::XMVECTOR const & texel : texels)
+			{
+				float const t = DirectX::XMVectorGetX(DirectX::XMVector4Dot(DirectX::XMVectorSubtract(DirectX::XMVectorMultiply(texel, mask), mean), axis));
+				min_t = std::min(min_t, t);
+				max_t = std::max(max_t, t);
+			}
+
+			// Ignored channels keep the value of the first texel, so a decoder that reads them still gets something sensible
+			DirectX::XMVECTOR const rest = DirectX::XMVectorMultiply(texels[0], DirectX::XMVectorSubtract(DirectX::g_XMOne, mask));
+			out_min = DirectX::XMVectorAdd(DirectX::XMVectorMultiplyAdd(axis, DirectX::XMVectorReplicate(min_t), mean), rest);
+			out_max = DirectX::XMVectorAdd(DirectX::XMVectorMultiplyAdd(axis, DirectX::XMVectorReplicate(max_t), mean), rest);
+		}
+
+		DirectX::XMVECTOR Clamp255(DirectX::XMVECTOR v)
+		{
+			return DirectX::XMVectorClamp(v, DirectX::XMVectorZero(), DirectX::XMVectorReplicate(255.f));
+		}
+
+		std::uint16_t To565(DirectX::XMVECTOR color)
+		{
+			DirectX::XMVECTOR const scaled = DirectX::XMVectorRound(DirectX::XMVectorMultiply(Clamp255(color), DirectX::XMVectorSet(31.f / 255.f, 63.f / 255.f, 31.f / 255.f, 0.f)));
+
+			auto const r = static_cast<std::uint16_t>(DirectX::XMVectorGetX(scaled));
+			auto const g = static_cast<std::uint16_t>(DirectX::XMVectorGetY(scaled));
+			auto const b = static_cast<std::uint16_t>(DirectX::XMVectorGetZ(scaled));
+
+			return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+		}
+
+		DirectX::XMVECTOR From565(std::uint16_t color)
+		{
+			unsigned int const r = (color >> 11) & 31;
+			unsigned int const g = (color >> 5) & 63;
+			unsigned int const b = color & 31;
+
+			return DirectX::XMVectorSet(static_cast<float>((r << 3) | (r >> 2)), static_cast<float>((g << 2) | (g >> 4)), static_cast<float>((b << 3) | (b >> 2)), 255.f);
+		}
+
+		//! Picks the closest of the four colors for every texel, returns the squared error.
+		float SelectBC1Indices(DirectX::XMVECTOR const (&texels)[16], std::uint16_t c0, std::uint16_t c1, std::uint32_t& out_indices)
+		{
+			DirectX::XMVECTOR const e0 = From565(c0);
+			DirectX::XMVECTOR const e1 = From565(c1);
+			DirectX::XMVECTOR const palette[4] = { e0, e1, DirectX::XMVectorLerp(e0, e1, bc1_weights[2]), DirectX::XMVectorLerp(e0, e1, bc1_weights[3]) };
+
+			float error = 0.f;
+			out_indices = 0;
+
+			for (int i = 0; i < 16; ++i)
+			{
+				float best_error = std::numeric_limits<float>::max();
+				std::uint32_t best = 0;
+
+				for (std::uint32_t p = 0; p < 4; ++p)
+				{
+					float const e = DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(DirectX::XMVectorSubtract(texels[i], palette[p])));
+					if (e < best_error)
+					{
+						best_error = e;
+						best = p;
+					}
+				}
+
+				out_indices |= best << (i * 2);
+				error += best_error;
+			}
+
+			return error;
+		}
+
+		//! The four color mode of BC1, which is the only mode the color blocks of BC3 have.
+		void EncodeBC1Color(DirectX::XMVECTOR const (&texels)[16], std::uint8_t* out)
+		{
+			DirectX::XMVECTOR lo, hi;
+			FitLine(texels, DirectX::XMVectorSet(1.f, 1.f, 1.f, 0.f), lo, hi);
+
+			// The outermost texels are often noise, moving the endpoints in spends the palette on the bulk of the block
+			DirectX::XMVECTOR const inset = DirectX::XMVectorScale(DirectX::XMVectorSubtract(hi, lo), 1.f / 16.f);
+			lo = DirectX::XMVectorAdd(lo, inset);
+			hi = DirectX::XMVectorSubtract(hi, inset);
+
+			std::uint16_t c0 = To565(hi);
+			std::uint16_t c1 = To565(lo);
+			std::uint32_t indices;
+			float error = SelectBC1Indices(texels, c0, c1, indices);
+
+			for (int iteration = 0; iteration < 2 && error > 0.f; ++iteration)
+			{
+				float t[16];
+				for (int i = 0; i < 16; ++i)
+				{
+					t[i] = bc1_weights[(indices >> (i * 2)) & 3];
+				}
+
+				DirectX::XMVECTOR a, b;
+				if (!FitEndpoints(texels, t, a, b))
+				{
+					break;
+				}
+
+				std::uint16_t const r0 = To565(a);
+				std::uint16_t const r1 = To565(b);
+				std::uint32_t refined_indices;
+				float const refined_error = SelectBC1Indices(texels, r0, r1, refined_indices);
+
+				if (refined_error >= error)
+				{
+					break;
+				}
+
+				c0 = r0;
+				c1 = r1;
+				indices = refined_indices;
+				error = refined_error;
+			}
+
+			// Four color mode needs c0 > c1. Swapping the endpoints swaps index 0 with 1 and 2 with 3.
+			if (c0 < c1)
+			{
+				std::swap(c0, c1);
+				indices ^= 0x55555555u;
+			}
+			else if (c0 == c1)
+			{
+				indices = 0;
+			}
+
+			WriteLE(out, c0, 2);
+			WriteLE(out + 2, c1, 2);
+			WriteLE(out + 4, indices, 4);
+		}
+
+		void DecodeBC1Color(std::uint8_t const * block, std::uint8_t (&out_texels)[64], bool four_color_only)
+		{
+			auto const c0 = static_cast<std::uint16_t>(ReadLE(block, 2));
+			auto const c1 = static_cast<std::uint16_t>(ReadLE(block + 2, 2));
+			auto const indices = static_cast<std::uint32_t>(ReadLE(block + 4, 4));
+
+			DirectX::XMVECTOR const e0 = From565(c0);
+			DirectX::XMVECTOR const e1 = From565(c1);
+
+			DirectX::XMVECTOR palette[4] = { e0, e1, DirectX::XMVectorLerp(e0, e1, bc1_weights[2]), DirectX::XMVectorLerp(e0, e1, bc1_weights[3]) };
+			if (c0 <= c1 && !four_color_only)
+			{
+				palette[2] = DirectX::XMVectorLerp(e0, e1, 0.5f);
+				palette[3] = DirectX::XMVectorZero();
+			}
+
+			for (int i = 0; i < 16; ++i)
+			{
+				DirectX::XMVECTOR const color = DirectX::XMVectorRound(palette[(indices >> (i * 2)) & 3]);
+
+				out_texels[i * 4] = static_cast<std::uint8_t>(DirectX::XMVectorGetX(color));
+				out_texels[i * 4 + 1] = static_cast<std::uint8_t>(DirectX::XMVectorGetY(color));
+				out_texels[i * 4 + 2] = static_cast<std::uint8_t>(DirectX::XMVectorGetZ(color));
+				out_texels[i * 4 + 3] = static_cast<std::uint8_t>(DirectX::XMVectorGetW(color));
+			}
+		}
+
+		//! One channel of the block in the eight value mode: the block's extremes with six values between them.
+		void EncodeBC4(std::uint8_t const (&texels)[64], int channel, std::uint8_t* out)
+		{
+			std::uint8_t min = 255;
+			std::uint8_t max = 0;
+
+			for (int i = 0; i < 16; ++i)
+			{
+				min = std::min(min, texels[i * 4 + channel]);
+				max = std::max(max, texels[i * 4 + channel]);
+			}
+
+			std::uint64_t indices = 0;
+
+			if (max > min)
+			{
+				float const scale = 7.f / static_cast<float>(max - min);
+
+				for (int i = 0; i < 16; ++i)
+				{
+					// Position on the ramp from max (0) to min (7), the ends are indices 0 and 1 and the values between them 2 to 7
+					auto const position = static_cast<std::uint64_t>(std::lround((max - texels[i * 4 + channel]) * scale));
+					std::uint64_t const index = position == 0 ? 0 : position == 7 ? 1 : position + 1;
+
+					indices |= index << (i * 3);
+				}
+			}
+
+			out[0] = max;
+			out[1] = min;
+			WriteLE(out + 2, indices, 6);
+		}
+
+		void DecodeBC4(std::uint8_t const * block, int channel, std::uint8_t (&out_texels)[64])
+		{
+			int const r0 = block[0];
+			int const r1 = block[1];
+			std::uint64_t const indices = ReadLE(block + 2, 6);
+
+			int values[8] = { r0, r1 };
+			if (r0 > r1)
+			{
+				for (int i = 2; i < 8; ++i)
+				{
+					values[i] = ((8 - i) * r0 + (i - 1) * r1 + 3) / 7;
+				}
+			}
+			else
+			{
+				for (int i = 2; i < 6; ++i)
+				{
+					values[i] = ((6 - i) * r0 + (i - 1) * r1 + 2) / 5;
+				}
+				values[6] = 0;
+				values[7] = 255;
+			}
+
+			for (int i = 0; i < 16; ++i)
+			{
+				out_texels[i * 4 + channel] = static_cast<std::uint8_t>(values[(indices >> (i * 3)) & 7]);
+			}
+		}
+
+		//! 7 bit endpoint and p-bit, which is shared by the channels and becomes their lowest bit, closest to a color.
+		void QuantizeBC7Endpoint(DirectX::XMVECTOR color, std::uint32_t (&out_channels)[4], std::uint32_t& out_p)
+		{
+			color = Clamp255(color);
+
+			float best_error = std::numeric_limits<float>::max();
+
+			for (std::uint32_t p = 0; p < 2; ++p)
+			{
+				DirectX::XMVECTOR const quantized = DirectX::XMVectorClamp(
+					DirectX::XMVectorRound(DirectX::XMVectorScale(DirectX::XMVectorSubtract(color, DirectX::XMVectorReplicate(static_cast<float>(p))), 0.5f)),
+					DirectX::XMVectorZero(), DirectX::XMVectorReplicate(127.f));
+				DirectX::XMVECTOR const value = DirectX::XMVectorMultiplyAdd(quantized, DirectX::XMVectorReplicate(2.f), DirectX::XMVectorReplicate(static_cast<float>(p)));
+
+				float const error = DirectX::XMVectorGetX(DirectX::XMVector4LengthSq(DirectX::XMVectorSubtract(value, color)));
+				if (error < best_error)
+				{
+					best_error = error;
+					out_p = p;
+					out_channels[0] = static_cast<std::uint32_t>(DirectX::XMVectorGetX(quantized));
+					out_channels[1] = static_cast<std::uint32_t>(DirectX::XMVectorGetY(quantized));
+					out_channels[2] = static_cast<std::uint32_t>(DirectX::XMVectorGetZ(quantized));
+					out_channels[3] = static_cast<std::uint32_t>(DirectX::XMVectorGetW(quantized));
+				}
+			}
+		}
+
+		DirectX::XMVECTOR DecodeBC7Endpoint(std::uint32_t const (&channels)[4], std::uint32_t p)
+		{
+			return DirectX::XMVectorSet(
+				static_cast<float>((channels[0] << 1) | p),
+				static_cast<float>((channels[1] << 1) | p),
+				static_cast<float>((channels[2] << 1) | p),
+				static_cast<float>((channels[3] << 1) | p));
+		}
+
+		void GetBC7Palette(DirectX::XMVECTOR e0, DirectX::XMVECTOR e1, DirectX::XMVECTOR (&out_palette)[16])
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				// ((64 - w) * e0 + w * e1 + 32) >> 6, like the hardware
+				DirectX::XMVECTOR const sum = DirectX::XMVectorMultiplyAdd(e1, DirectX::XMVectorReplicate(static_cast<float>(bc7_weights[i])),
+					DirectX::XMVectorMultiplyAdd(e0, DirectX::XMVectorReplicate(static_cast<float>(64 - bc7_weights[i])), DirectX::XMVectorReplicate(32.f)));
+				out_palette[i] = DirectX::XMVectorFloor(DirectX::XMVectorScale(sum, 1.f / 64.f));
+			}
+		}
+
+		float SelectBC7Indices(DirectX::XMVECTOR const (&texels)[16], DirectX::XMVECTOR e0, DirectX::XMVECTOR e1, std::uint32_t (&out_indices)[16])
+		{
+			DirectX::XMVECTOR palette[16];
+			GetBC7Palette(e0, e1, palette);
+
+			float error = 0.f;
+
+			for (int i = 0; i < 16; ++i)
+			{
+				float best_error = std::numeric_limits<float>::max();
+
+				for (std::uint32_t p = 0; p < 16; ++p)
+				{
+					float const e = DirectX::XMVectorGetX(DirectX::XMVector4LengthSq(DirectX::XMVectorSubtract(texels[i], palette[p])));
+					if (e < best_error)
+					{
+						best_error = e;
+						out_indices[i] = p;
+					}
+				}
+
+				error += best_error;
+			}
+
+			return error;
+		}
+
+		//! Mode 6: one subset, RGBA endpoints of 7 bits plus a p-bit each and 4 bit indices.
+		void EncodeBC7(DirectX::XMVECTOR const (&texels)[16], std::uint8_t* out)
+		{
+			DirectX::XMVECTOR lo, hi;
+			FitLine(texels, DirectX::g_XMOne, lo, hi);
+
+			std::uint32_t channels[2][4];
+			std::uint32_t p[2];
+			QuantizeBC7Endpoint(lo, channels[0], p[0]);
+			QuantizeBC7Endpoint(hi, channels[1], p[1]);
+
+			std::uint32_t indices[16];
+			float error = SelectBC7Indices(texels, DecodeBC7Endpoint(channels[0], p[0]), DecodeBC7Endpoint(channels[1], p[1]), indices);
+
+			for (int iteration = 0; iteration < 2 && error > 0.f; ++iteration)
+			{
+				float t[16];
+				for (int i = 0; i < 16; ++i)
+				{
+					t[i] = bc7_weights[indices[i]] / 64.f;
+				}
+
+				DirectX::XMVECTOR a, b;
+				if (!FitEndpoints(texels, t, a, b))
+				{
+					break;
+				}
+
+				std::uint32_t refined_channels[2][4];
+				std::uint32_t refined_p[2];
+				QuantizeBC7Endpoint(a, refined_channels[0], refined_p[0]);
+				QuantizeBC7Endpoint(b, refined_channels[1], refined_p[1]);
+
+				std::uint32_t refined_indices[16];
+				float const refined_error = SelectBC7Indices(texels,
+					DecodeBC7Endpoint(refined_channels[0], refined_p[0]), DecodeBC7Endpoint(refined_channels[1], refined_p[1]), refined_indices);
+
+				if (refined_error >= error)
+				{
+					break;
+				}
+
+				std::copy(&refined_channels[0][0], &refined_channels[0][0] + 8, &channels[0][0]);
+				p[0] = refined_p[0];
+				p[1] = refined_p[1];
+				std::copy(std::begin(refined_indices), std::end(refined_indices), std::begin(indices));
+				error = refined_error;
+			}
+
+			// The first index is stored without its top bit, swapping the endpoints mirrors the indices to clear it
+			if (indices[0] >= 8)
+			{
+				for (int c = 0; c < 4; ++c)
+				{
+					std::swap(channels[0][c], channels[1][c]);
+				}
+				std::swap(p[0], p[1]);
+
+				for (std::uint32_t& index : indices)
+				{
+					index = 15 - index;
+				}
+			}
+
+			BlockBits bits;
+			bits.Write(1u << 6, 7);
+
+			for (int c = 0; c < 4; ++c)
+			{
+				bits.Write(channels[0][c], 7);
+				bits.Write(channels[1][c], 7);
+			}
+
+			bits.Write(p[0], 1);
+			bits.Write(p[1], 1);
+
+			bits.Write(indices[0], 3);
+			for (int i = 1; i < 16; ++i)
+			{
+				bits.Write(indices[i], 4);
+			}
+
+			WriteLE(out, bits.m_bits[0], 8);
+			WriteLE(out + 8, bits.m_bits[1], 8);
+		}
+
+		void DecodeBC7(std::uint8_t const * block, std::uint8_t (&out_texels)[64])
+		{
+			BlockBits bits;
+			bits.m_bits[0] = ReadLE(block, 8);
+			bits.m_bits[1] = ReadLE(block + 8, 8);
+
+			// Only mode 6, the mode the encoder writes
+			if (bits.Read(7) != (1u << 6))
+			{
+				std::fill(std::begin(out_texels), std::end(out_texels), std::uint8_t(0));
+				return;
+			}
+
+			std::uint32_t channels[2][4];
+			for (int c = 0; c < 4; ++c)
+			{
+				channels[0][c] = bits.Read(7);
+				channels[1][c] = bits.Read(7);
+			}
+
+			std::uint32_t const p0 = bits.Read(1);
+			std::uint32_t const p1 = bits.Read(1);
+
+			DirectX::XMVECTOR palette[16];
+			GetBC7Palette(DecodeBC7Endpoint(channels[0], p0), DecodeBC7Endpoint(channels[1], p1), palette);
+
+			for (int i = 0; i < 16; ++i)
+			{
+				DirectX::XMVECTOR const color = palette[bits.Read(i == 0 ? 3 : 4)];
+
+				out_texels[i * 4] = static_cast<std::uint8_t>(DirectX::XMVectorGetX(color));
+				out_texels[i * 4 + 1] = static_cast<std::uint8_t>(DirectX::XMVectorGetY(color));
+				out_texels[i * 4 + 2] = static_cast<std::uint8_t>(DirectX::XMVectorGetZ(color));
+				out_texels[i * 4 + 3] = static_cast<std::uint8_t>(DirectX::XMVectorGetW(color));
+			}
+		}
+
+		//! Copies the 4x4 texels of a block, repeating the edge texels past the right and bottom of the image.
+		void GatherBlock(std::uint8_t const * rgba, std::size_t width, std::size_t height, std::size_t row_pitch, std::size_t block_x, std::size_t block_y, std::uint8_t (&out_texels)[64])
+		{
+			for (std::size_t y = 0; y < 4; ++y)
+			{
+				std::uint8_t const * row = rgba + std::min(block_y * 4 + y, height - 1) * row_pitch;
+
+				for (std::size_t x = 0; x < 4; ++x)
+				{
+					std::uint8_t const * texel = row + std::min(block_x * 4 + x, width - 1) * 4;
+					std::copy(texel, texel + 4, out_texels + (y * 4 + x) * 4);
+				}
+			}
+		}
+	}
+
+	std::size_t GetBlockSize(BlockFormat format)
+	{
+		return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+	}
+
+	void EncodeBlock(BlockFormat format, std::uint8_t const (&texels)[64], std::uint8_t* out_block)
+	{
+		DirectX::XMVECTOR vectors[16];
+
+		switch (format)
+		{
+		case BlockFormat::BC1:
+			LoadTexels(texels, vectors);
+			EncodeBC1Color(vectors, out_block);
+			break;
+		case BlockFormat::BC3:
+			LoadTexels(texels, vectors);
+			EncodeBC4(texels, 3, out_block);
+			EncodeBC1Color(vectors, out_block + 8);
+			break;
+		case BlockFormat::BC4:
+			EncodeBC4(texels, 0, out_block);
+			break;
+		case BlockFormat::BC5:
+			EncodeBC4(texels, 0, out_block);
+			EncodeBC4(texels, 1, out_block + 8);
+			break;
+		case BlockFormat::BC7:
+			LoadTexels(texels, vectors);
+			EncodeBC7(vectors, out_block);
+			break;
+		}
+	}
+
+	void DecodeBlock(BlockFormat format, std::uint8_t const * block, std::uint8_t (&out_texels)[64])
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			out_texels[i * 4] = 0;
+			out_texels[i * 4 + 1] = 0;
+			out_texels[i * 4 + 2] = 0;
+			out_texels[i * 4 + 3] = 255;
+		}
+
+		switch (format)
+		{
+		case BlockFormat::BC1:
+			DecodeBC1Color(block, out_texels, false);
+			break;
+		case BlockFormat::BC3:
+			DecodeBC1Color(block + 8, out_texels, true);
+			DecodeBC4(block, 3, out_texels);
+			break;
+		case BlockFormat::BC4:
+			DecodeBC4(block, 0, out_texels);
+			break;
+		case BlockFormat::BC5:
+			DecodeBC4(block, 0, out_texels);
+			DecodeBC4(block + 8, 1, out_texels);
+			break;
+		case BlockFormat::BC7:
+			DecodeBC7(block, out_texels);
+			break;
+		}
+	}
+
+	void CompressImage(BlockFormat format, std::uint8_t const * rgba, std::size_t width, std::size_t height, std::size_t row_pitch,
+		std::uint8_t* out_blocks, std::size_t out_row_pitch, ThreadPool* thread_pool)
+	{
+		if (width == 0 || height == 0)
+		{
+			return;
+		}
+
+		std::size_t const blocks_x = (width + 3) / 4;
+		std::size_t const blocks_y = (height + 3) / 4;
+		std::size_t const block_size = GetBlockSize(format);
+
+		auto encode_rows = [=](std::size_t first, std::size_t last)
+		{
+			std::uint8_t texels[64];
+
+			for (std::size_t block_y = first; block_y < last; ++block_y)
+			{
+				std::uint8_t* out_row = out_blocks + block_y * out_row_pitch;
+
+				for (std::size_t block_x = 0; block_x < blocks_x; ++block_x)
+				{
+					GatherBlock(rgba, width, height, row_pitch, block_x, block_y, texels);
+					EncodeBlock(format, texels, out_row + block_x * block_size);
+				}
+			}
+		};
+
+		// Small images and mips aren't worth the hand-off
+		if (thread_pool == nullptr || blocks_x * blocks_y < 256)
+		{
+			encode_rows(0, blocks_y);
+			return;
+		}
+
+		std::size_t const num_jobs = std::min<std::size_t>(blocks_y, 32);
+		std::vector<std::future<void>> jobs;
+		jobs.reserve(num_jobs);
+
+		for (std::size_t j = 0; j < num_jobs; ++j)
+		{
+			std::size_t const first = blocks_y * j / num_jobs;
+			std::size_t const last = blocks_y * (j + 1) / num_jobs;
+
+			jobs.push_back(thread_pool->Enqueue([encode_rows, first, last]
+			{
+				encode_rows(first, last);
+			}));
+		}
+
+		for (auto& job : jobs)
+		{
+			job.get();
+		}
+	}
+
+	double ComputeCompressionPSNR(BlockFormat format, std::uint8_t const * rgba, std::size_t width, std::size_t height, std::size_t row_pitch,
+		std::uint8_t const * blocks, std::size_t blocks_row_pitch)
+	{
+		int const num_channels = format == BlockFormat::BC4 ? 1 : format == BlockFormat::BC5 ? 2 : format == BlockFormat::BC1 ? 3 : 4;
+		std::size_t const block_size = GetBlockSize(format);
+
+		double squared_error = 0.0;
+		std::uint8_t decoded[64];
+
+		for (std::size_t y = 0; y < height; y += 4)
+		{
+			for (std::size_t x = 0; x < width; x += 4)
+			{
+				DecodeBlock(format, blocks + (y / 4) * blocks_row_pitch + (x / 4) * block_size, decoded);
+
+				for (std::size_t ty = y; ty < std::min(y + 4, height); ++ty)
+				{
+					for (std::size_t tx = x; tx < std::min(x + 4, width); ++tx)
+					{
+						std::uint8_t const * original = rgba + ty * row_pitch + tx * 4;
+						std::uint8_t const * texel = decoded + ((ty - y) * 4 + (tx - x)) * 4;
+
+						for (int c = 0; c < num_channels; ++c)
+						{
+							double const difference = static_cast<double>(original[c]) - static_cast<double>(texel[c]);
+							squared_error += difference * difference;
+						}
+					}
+				}
+			}
+		}
+
+		double const mse = squared_error / (static_cast<double>(width) * static_cast<double>(height) * num_channels);
+		if (mse <= 0.0)
+		{
+			return std::numeric_limits<double>::infinity();
+		}
+
+		return 10.0 * std::log10(255.0 * 255.0 / mse);
+	}
+
+} /* util */
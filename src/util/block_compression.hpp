@@ -0,0 +1,59 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace util
+{
+
+	class ThreadPool;
+
+	//! Block compressed formats the encoders can write. All of them store 4x4 texel blocks.
+	enum class BlockFormat
+	{
+		BC1, // RGB, 8 bytes per block
+		BC3, // RGBA as BC1 color and BC4 alpha, 16 bytes
+		BC4, // R, 8 bytes
+		BC5, // RG as two BC4 blocks, 16 bytes
+		BC7, // RGBA in mode 6 only, 16 bytes. Slower to encode, but a lot better than BC1 and BC3 on gradients and alpha
+	};
+
+	std::size_t GetBlockSize(BlockFormat format);
+
+	//! Encodes 16 RGBA8 texels, stored row by row, into one block.
+	/*!
+		The endpoints start on the principal axis of the texels and are refined with a least squares fit to the
+		chosen indices. The color math runs on XMVECTORs, a texel per register.
+	*/
+	void EncodeBlock(BlockFormat format, std::uint8_t const (&texels)[64], std::uint8_t* out_block);
+	//! Decodes a block into 16 RGBA8 texels. Channels the format doesn't store are 0, alpha is 255.
+	void DecodeBlock(BlockFormat format, std::uint8_t const * block, std::uint8_t (&out_texels)[64]);
+
+	//! Encodes an RGBA8 image. Blocks on the right and bottom edge repeat the edge texels.
+	/*!
+		out_row_pitch is the distance in bytes between two rows of blocks. With a thread pool the rows of blocks are
+		encoded on its threads, so it can't be the pool of the calling thread.
+	*/
+	void CompressImage(BlockFormat format, std::uint8_t const * rgba, std::size_t width, std::size_t height, std::size_t row_pitch,
+		std::uint8_t* out_blocks, std::size_t out_row_pitch, ThreadPool* thread_pool = nullptr);
+
+	//! Peak signal to noise ratio in dB of compressed blocks against the image they were encoded from, over the channels the format stores.
+	double ComputeCompressionPSNR(BlockFormat format, std::uint8_t const * rgba, std::size_t width, std::size_t height, std::size_t row_pitch,
+		std::uint8_t const * blocks, std::size_t blocks_row_pitch);
+
+} /* util */
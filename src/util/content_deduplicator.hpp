@@ -0,0 +1,120 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+namespace util
+{
+
+	//! Reference counts of content that is shared between owners, found again through a hash of the content.
+	/*!
+		The content itself lives elsewhere under an id, this only tracks which id has which hash and how many owners it has.
+		A hash hit is only shared when the caller confirms the content is the same, so a hash collision never merges
+		different content; the hash then keeps pointing at the content that had it first.
+
+		Before an owner writes to shared content (IsShared) it needs its own copy and has to Release its reference to
+		the shared one. Content that is written in place has to be Forgotten, so it isn't found through its old hash.
+	*/
+	class ContentDeduplicator
+	{
+	public:
+		//! Returns the id of content with this hash for which same_content(id) is true, with an extra reference.
+		template<typename F>
+		std::optional<std::uint64_t> Acquire(std::uint64_t hash, F&& same_content)
+		{
+			auto it = m_ids_by_hash.find(hash);
+			if (it == m_ids_by_hash.end() || !same_content(it->second))
+			{
+				return std::nullopt;
+			}
+
+			++m_entries[it->second].m_ref_count;
+			return it->second;
+		}
+
+		//! Registers new content with one reference; only findable content can be returned by Acquire.
+		void Insert(std::uint64_t id, std::uint64_t hash, bool findable = true)
+		{
+			m_entries[id] = { hash, 1, false };
+
+			if (findable && m_ids_by_hash.try_emplace(hash, id).second)
+			{
+				m_entries[id].m_findable = true;
+			}
+		}
+
+		//! Drops a reference, returns true when it was the last one (or the id is unknown) and the content has to be destroyed.
+		bool Release(std::uint64_t id)
+		{
+			auto it = m_entries.find(id);
+			if (it != m_entries.end() && it->second.m_ref_count > 1)
+			{
+				--it->second.m_ref_count;
+				return false;
+			}
+
+			Remove(id);
+			return true;
+		}
+
+		//! Stops Acquire from returning the content, the references stay.
+		void Forget(std::uint64_t id)
+		{
+			auto it = m_entries.find(id);
+			if (it == m_entries.end() || !it->second.m_findable)
+			{
+				return;
+			}
+
+			m_ids_by_hash.erase(it->second.m_hash);
+			it->second.m_findable = false;
+		}
+
+		//! Forgets the content and its references, for content that is destroyed.
+		void Remove(std::uint64_t id)
+		{
+			Forget(id);
+			m_entries.erase(id);
+		}
+
+		//! Whether more than one owner references the content.
+		bool IsShared(std::uint64_t id) const
+		{
+			return GetRefCount(id) > 1;
+		}
+
+		std::uint32_t GetRefCount(std::uint64_t id) const
+		{
+			auto it = m_entries.find(id);
+			return it != m_entries.end() ? it->second.m_ref_count : 0;
+		}
+
+	private:
+		struct Entry
+		{
+			std::uint64_t m_hash = 0;
+			std::uint32_t m_ref_count = 0;
+			bool m_findable = false; // m_ids_by_hash points at this entry
+		};
+
+		std::unordered_map<std::uint64_t, Entry> m_entries;
+		std::unordered_map<std::uint64_t, std::uint64_t> m_ids_by_hash;
+	};
+
+} /* util */
@@ -0,0 +1,67 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+namespace util
+{
+
+	//! Fast non-cryptographic 64 bit hash of a block of memory, used to recognise identical data without comparing it.
+	/*!
+		Processes 8 bytes per step with a multiply-rotate mix and ends with a full avalanche, so similar inputs
+		(like vertex buffers that differ in one float) still end up far apart.
+	*/
+	inline std::uint64_t HashBytes(void const * data, std::size_t size, std::uint64_t seed = 0)
+	{
+		constexpr std::uint64_t prime_0 = 0x9E3779B185EBCA87ull;
+		constexpr std::uint64_t prime_1 = 0xC2B2AE3D27D4EB4Full;
+
+		auto mix = [&](std::uint64_t k)
+		{
+			return std::rotl(k * prime_1, 31) * prime_0;
+		};
+
+		std::uint8_t const * bytes = static_cast<std::uint8_t const *>(data);
+		std::uint64_t hash = seed ^ (static_cast<std::uint64_t>(size) * prime_0);
+
+		std::size_t i = 0;
+		for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t))
+		{
+			std::uint64_t k;
+			std::memcpy(&k, bytes + i, sizeof(k));
+			hash = std::rotl(hash ^ mix(k), 27) * prime_0 + 0x52DCE729ull;
+		}
+
+		if (i < size)
+		{
+			std::uint64_t k = 0;
+			std::memcpy(&k, bytes + i, size - i);
+			hash ^= mix(k);
+		}
+
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 33;
+		hash *= 0xC4CEB9FE1A85EC53ull;
+		hash ^= hash >> 33;
+
+		return hash;
+	}
+
+} /* util */
@@ -0,0 +1,59 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace util
+{
+
+	//! Read-only view of a whole file mapped into memory.
+	/*!
+		The operating system pages the file in on first access, so nothing is read or copied up front.
+		Data() stays valid until the file is closed or the object is destroyed.
+	*/
+	class MemoryMappedFile
+	{
+	public:
+		MemoryMappedFile() = default;
+		explicit MemoryMappedFile(std::string_view path);
+		~MemoryMappedFile();
+
+		MemoryMappedFile(MemoryMappedFile const &) = delete;
+		MemoryMappedFile& operator=(MemoryMappedFile const &) = delete;
+		MemoryMappedFile(MemoryMappedFile&&) = delete;
+		MemoryMappedFile& operator=(MemoryMappedFile&&) = delete;
+
+		//! Maps the file, returns false when it doesn't exist or can't be mapped. Empty files can't be mapped.
+		bool Open(std::string_view path);
+		void Close();
+
+		bool IsOpen() const { return m_data != nullptr; }
+		unsigned char const * Data() const { return m_data; }
+		std::size_t Size() const { return m_size; }
+
+	private:
+		unsigned char const * m_data = nullptr;
+		std::size_t m_size = 0;
+
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#endif
+	};
+
+} /* util */
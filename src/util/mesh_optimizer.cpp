@@ -0,0 +1,443 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace util
+{
+
+	namespace
+	{
+		// Forsyth's tuning values, the cache size is the size of the modelled LRU cache and not the hardware's
+		constexpr std::uint32_t forsyth_cache_size = 32;
+		constexpr float cache_decay_power = 1.5f;
+		constexpr float last_triangle_score = 0.75f;
+		constexpr float valence_boost_scale = 2.f;
+		constexpr float valence_boost_power = 0.5f;
+
+		// The FIFO size used to find cluster boundaries for the overdraw optimisation
+		constexpr std::uint32_t overdraw_cache_size = 16;
+
+		float VertexScore(int cache_position, std::uint32_t live_triangles)
+		{
+			if (live_triangles == 0)
+			{
+				return -1.f;
+			}
+
+			float score = 0.f;
+			if (cache_position >= 0)
+			{
+				// The vertices of the last triangle get a fixed score, so the next triangle doesn't just reuse its edge
+				if (cache_position < 3)
+				{
+					score = last_triangle_score;
+				}
+				else
+				{
+					float const scaler = 1.f / static_cast<float>(forsyth_cache_size - 3);
+					score = std::pow(1.f - static_cast<float>(cache_position - 3) * scaler, cache_decay_power);
+				}
+			}
+
+			// Vertices with few triangles left are finished first, so they don't have to be transformed again later
+			score += valence_boost_scale * std::pow(static_cast<float>(live_triangles), -valence_boost_power);
+
+			return score;
+		}
+
+		//! FIFO cache simulation, the cache is empty when time has advanced by more than cache_size since the last miss.
+		struct FifoCache
+		{
+			FifoCache(std::size_t num_vertices, std::uint32_t cache_size)
+				: m_timestamps(num_vertices, 0), m_time(cache_size + 1), m_cache_size(cache_size)
+			{
+			}
+
+			// Returns whether the vertex had to be transformed
+			bool Access(std::uint32_t vertex)
+			{
+				if (m_time - m_timestamps[vertex] > m_cache_size)
+				{
+					m_timestamps[vertex] = m_time++;
+					return true;
+				}
+				return false;
+			}
+
+			void Flush()
+			{
+				m_time += m_cache_size + 1;
+			}
+
+			std::vector<std::uint32_t> m_timestamps;
+			std::uint32_t m_time;
+			std::uint32_t m_cache_size;
+		};
+
+		struct Float3
+		{
+			float x, y, z;
+		};
+	}
+
+	VertexCacheStatistics AnalyzeVertexCache(std::uint32_t const * indices, std::size_t num_indices, std::size_t num_vertices, std::uint32_t cache_size)
+	{
+		VertexCacheStatistics stats;
+
+		std::size_t const num_triangles = num_indices / 3;
+		if (num_triangles == 0 || num_vertices == 0)
+		{
+			return stats;
+		}
+
+		FifoCache cache(num_vertices, cache_size);
+		std::vector<bool> referenced(num_vertices, false);
+		std::size_t num_referenced = 0;
+
+		for (std::size_t i = 0; i < num_triangles * 3; ++i)
+		{
+			std::uint32_t const v = indices[i];
+
+			if (cache.Access(v))
+			{
+				++stats.m_vertices_transformed;
+			}
+
+			if (!referenced[v])
+			{
+				referenced[v] = true;
+				++num_referenced;
+			}
+		}
+
+		stats.m_acmr = static_cast<float>(stats.m_vertices_transformed) / static_cast<float>(num_triangles);
+		stats.m_atvr = static_cast<float>(stats.m_vertices_transformed) / static_cast<float>(num_referenced);
+
+		return stats;
+	}
+
+	void OptimizeVertexCache(std::uint32_t* indices, std::size_t num_indices, std::size_t num_vertices)
+	{
+		std::size_t const num_triangles = num_indices / 3;
+		if (num_triangles == 0)
+		{
+			return;
+		}
+
+		std::vector<std::uint32_t> const source(indices, indices + num_triangles * 3);
+
+		// The triangles that still have to be emitted per vertex, packed in one array
+		std::vector<std::uint32_t> live_triangles(num_vertices, 0);
+		for (std::uint32_t v : source)
+		{
+			++live_triangles[v];
+		}
+
+		std::vector<std::uint32_t> adjacency_offsets(num_vertices + 1, 0);
+		for (std::size_t v = 0; v < num_vertices; ++v)
+		{
+			adjacency_offsets[v + 1] = adjacency_offsets[v] + live_triangles[v];
+		}
+
+		std::vector<std::uint32_t> adjacency(source.size());
+		std::vector<std::uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+		for (std::size_t i = 0; i < source.size(); ++i)
+		{
+			adjacency[fill[source[i]]++] = static_cast<std::uint32_t>(i / 3);
+		}
+
+		std::vector<int> cache_position(num_vertices, -1);
+		std::vector<float> vertex_score(num_vertices);
+		for (std::size_t v = 0; v < num_vertices; ++v)
+		{
+			vertex_score[v] = VertexScore(-1, live_triangles[v]);
+		}
+
+		std::vector<float> triangle_score(num_triangles);
+		std::vector<bool> emitted(num_triangles, false);
+
+		std::int64_t best = -1;
+		float best_score = -1.f;
+		for (std::size_t t = 0; t < num_triangles; ++t)
+		{
+			triangle_score[t] = vertex_score[source[t * 3]] + vertex_score[source[t * 3 + 1]] + vertex_score[source[t * 3 + 2]];
+			if (triangle_score[t] > best_score)
+			{
+				best = static_cast<std::int64_t>(t);
+				best_score = triangle_score[t];
+			}
+		}
+
+		std::uint32_t cache[forsyth_cache_size + 3];
+		std::uint32_t new_cache[forsyth_cache_size + 3];
+		std::uint32_t cache_count = 0;
+		std::size_t input_cursor = 0;
+
+		for (std::size_t out = 0; out < num_triangles; ++out)
+		{
+			if (best < 0)
+			{
+				// Nothing in the cache has triangles left, continue with the first triangle that wasn't emitted yet
+				while (emitted[input_cursor])
+				{
+					++input_cursor;
+				}
+				best = static_cast<std::int64_t>(input_cursor);
+			}
+
+			std::uint32_t const triangle = static_cast<std::uint32_t>(best);
+			std::uint32_t const * triangle_vertices = &source[triangle * 3];
+
+			emitted[triangle] = true;
+			std::copy(triangle_vertices, triangle_vertices + 3, indices + out * 3);
+
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				std::uint32_t const v = triangle_vertices[k];
+				std::uint32_t* list = &adjacency[adjacency_offsets[v]];
+				std::uint32_t* end = list + live_triangles[v];
+
+				*std::find(list, end, triangle) = *(end - 1);
+				--live_triangles[v];
+			}
+
+			// The vertices of the emitted triangle move to the front, entries that fall off the end are evicted
+			std::uint32_t new_count = 0;
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				std::uint32_t const v = triangle_vertices[k];
+				if (std::find(new_cache, new_cache + new_count, v) == new_cache + new_count)
+				{
+					new_cache[new_count++] = v;
+				}
+			}
+
+			std::uint32_t const num_new = new_count;
+			for (std::uint32_t i = 0; i < cache_count; ++i)
+			{
+				std::uint32_t const v = cache[i];
+				if (std::find(new_cache, new_cache + num_new, v) == new_cache + num_new)
+				{
+					new_cache[new_count++] = v;
+				}
+			}
+
+			for (std::uint32_t i = 0; i < new_count; ++i)
+			{
+				std::uint32_t const v = new_cache[i];
+				cache_position[v] = i < forsyth_cache_size ? static_cast<int>(i) : -1;
+				vertex_score[v] = VertexScore(cache_position[v], live_triangles[v]);
+			}
+
+			// Only the triangles around the touched vertices changed score, the best of those is emitted next
+			best = -1;
+			best_score = -1.f;
+			for (std::uint32_t i = 0; i < new_count; ++i)
+			{
+				std::uint32_t const v = new_cache[i];
+				std::uint32_t const * list = &adjacency[adjacency_offsets[v]];
+
+				for (std::uint32_t j = 0; j < live_triangles[v]; ++j)
+				{
+					std::uint32_t const t = list[j];
+					float const score = vertex_score[source[t * 3]] + vertex_score[source[t * 3 + 1]] + vertex_score[source[t * 3 + 2]];
+					triangle_score[t] = score;
+
+					if (score > best_score)
+					{
+						best = t;
+						best_score = score;
+					}
+				}
+			}
+
+			cache_count = std::min(new_count, forsyth_cache_size);
+			std::copy(new_cache, new_cache + cache_count, cache);
+		}
+	}
+
+	void OptimizeOverdraw(std::uint32_t* indices, std::size_t num_indices, float const * positions, std::size_t position_stride, std::size_t num_vertices, float threshold)
+	{
+		std::size_t const num_triangles = num_indices / 3;
+		if (num_triangles < 2)
+		{
+			return;
+		}
+
+		auto position = [&](std::uint32_t v)
+		{
+			float const * p = reinterpret_cast<float const *>(reinterpret_cast<std::uint8_t const *>(positions) + v * position_stride);
+			return Float3{ p[0], p[1], p[2] };
+		};
+
+		// Hard boundaries: the cache is cold when all three vertices of a triangle miss it
+		std::vector<std::size_t> hard_clusters;
+		{
+			FifoCache cache(num_vertices, overdraw_cache_size);
+			for (std::size_t t = 0; t < num_triangles; ++t)
+			{
+				int misses = 0;
+				for (std::size_t k = 0; k < 3; ++k)
+				{
+					misses += cache.Access(indices[t * 3 + k]) ? 1 : 0;
+				}
+
+				if (t == 0 || misses == 3)
+				{
+					hard_clusters.push_back(t);
+				}
+			}
+			hard_clusters.push_back(num_triangles);
+		}
+
+		// Soft boundaries: a hard cluster is split once the part so far is close to the mesh's cache efficiency on its own
+		float const acmr_limit = AnalyzeVertexCache(indices, num_indices, num_vertices, overdraw_cache_size).m_acmr * threshold;
+
+		std::vector<std::size_t> clusters;
+		{
+			FifoCache cache(num_vertices, overdraw_cache_size);
+			for (std::size_t c = 0; c + 1 < hard_clusters.size(); ++c)
+			{
+				std::size_t const end = hard_clusters[c + 1];
+				std::size_t start = hard_clusters[c];
+				std::size_t misses = 0;
+
+				clusters.push_back(start);
+				cache.Flush();
+
+				for (std::size_t t = start; t < end; ++t)
+				{
+					for (std::size_t k = 0; k < 3; ++k)
+					{
+						misses += cache.Access(indices[t * 3 + k]) ? 1 : 0;
+					}
+
+					if (t + 1 < end && static_cast<float>(misses) <= static_cast<float>(t + 1 - start) * acmr_limit)
+					{
+						start = t + 1;
+						misses = 0;
+						clusters.push_back(start);
+						cache.Flush();
+					}
+				}
+			}
+			clusters.push_back(num_triangles);
+		}
+
+		std::size_t const num_clusters = clusters.size() - 1;
+		if (num_clusters < 2)
+		{
+			return;
+		}
+
+		// Area weighted centroid and normal of every cluster, and the centroid of the whole mesh
+		std::vector<Float3> cluster_centroids(num_clusters);
+		std::vector<Float3> cluster_normals(num_clusters);
+		Float3 mesh_centroid = { 0.f, 0.f, 0.f };
+		float mesh_area = 0.f;
+
+		for (std::size_t c = 0; c < num_clusters; ++c)
+		{
+			Float3 centroid = { 0.f, 0.f, 0.f };
+			Float3 normal = { 0.f, 0.f, 0.f };
+			float area = 0.f;
+
+			for (std::size_t t = clusters[c]; t < clusters[c + 1]; ++t)
+			{
+				Float3 const a = position(indices[t * 3]);
+				Float3 const b = position(indices[t * 3 + 1]);
+				Float3 const p = position(indices[t * 3 + 2]);
+
+				Float3 const e0 = { b.x - a.x, b.y - a.y, b.z - a.z };
+				Float3 const e1 = { p.x - a.x, p.y - a.y, p.z - a.z };
+				Float3 const n = { e0.y * e1.z - e0.z * e1.y, e0.z * e1.x - e0.x * e1.z, e0.x * e1.y - e0.y * e1.x };
+				float const triangle_area = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+
+				centroid.x += (a.x + b.x + p.x) * triangle_area;
+				centroid.y += (a.y + b.y + p.y) * triangle_area;
+				centroid.z += (a.z + b.z + p.z) * triangle_area;
+
+				normal.x += n.x;
+				normal.y += n.y;
+				normal.z += n.z;
+
+				area += triangle_area;
+			}
+
+			mesh_centroid.x += centroid.x;
+			mesh_centroid.y += centroid.y;
+			mesh_centroid.z += centroid.z;
+			mesh_area += area;
+
+			float const inv_area = area > 0.f ? 1.f / (area * 3.f) : 0.f;
+			cluster_centroids[c] = { centroid.x * inv_area, centroid.y * inv_area, centroid.z * inv_area };
+
+			float const normal_length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+			float const inv_length = normal_length > 0.f ? 1.f / normal_length : 0.f;
+			cluster_normals[c] = { normal.x * inv_length, normal.y * inv_length, normal.z * inv_length };
+		}
+
+		float const inv_mesh_area = mesh_area > 0.f ? 1.f / (mesh_area * 3.f) : 0.f;
+		mesh_centroid = { mesh_centroid.x * inv_mesh_area, mesh_centroid.y * inv_mesh_area, mesh_centroid.z * inv_mesh_area };
+
+		// Clusters far out along their own normal are likely to occlude the rest of the mesh
+		std::vector<float> sort_keys(num_clusters);
+		for (std::size_t c = 0; c < num_clusters; ++c)
+		{
+			Float3 const & centroid = cluster_centroids[c];
+			Float3 const & normal = cluster_normals[c];
+			sort_keys[c] = (centroid.x - mesh_centroid.x) * normal.x + (centroid.y - mesh_centroid.y) * normal.y + (centroid.z - mesh_centroid.z) * normal.z;
+		}
+
+		std::vector<std::uint32_t> order(num_clusters);
+		std::iota(order.begin(), order.end(), 0u);
+		std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b)
+		{
+			return sort_keys[a] > sort_keys[b];
+		});
+
+		std::vector<std::uint32_t> const source(indices, indices + num_triangles * 3);
+		std::uint32_t* out = indices;
+		for (std::uint32_t c : order)
+		{
+			out = std::copy(source.begin() + clusters[c] * 3, source.begin() + clusters[c + 1] * 3, out);
+		}
+	}
+
+	std::size_t OptimizeVertexFetchRemap(std::uint32_t* indices, std::size_t num_indices, std::size_t num_vertices, std::vector<std::uint32_t>& out_remap)
+	{
+		out_remap.assign(num_vertices, ~0u);
+
+		std::uint32_t next_vertex = 0;
+		for (std::size_t i = 0; i < num_indices; ++i)
+		{
+			std::uint32_t& remapped = out_remap[indices[i]];
+			if (remapped == ~0u)
+			{
+				remapped = next_vertex++;
+			}
+
+			indices[i] = remapped;
+		}
+
+		return next_vertex;
+	}
+
+} /* util */
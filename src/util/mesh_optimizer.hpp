@@ -0,0 +1,81 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace util
+{
+
+	//! Post-transform vertex cache behaviour of an index buffer.
+	struct VertexCacheStatistics
+	{
+		std::size_t m_vertices_transformed = 0;
+		float m_acmr = 0.f; // Average cache miss ratio: transformed vertices per triangle. 0.5 is the optimum for a regular grid, 3 the worst case.
+		float m_atvr = 0.f; // Average transform to vertex ratio: transformed vertices per referenced vertex. 1 is the optimum.
+	};
+
+	//! Simulates a FIFO post-transform cache of cache_size entries.
+	VertexCacheStatistics AnalyzeVertexCache(std::uint32_t const * indices, std::size_t num_indices, std::size_t num_vertices, std::uint32_t cache_size = 16);
+
+	//! Reorders the triangles for the post-transform vertex cache.
+	/*!
+		Tom Forsyth's linear-speed vertex cache optimisation: triangles are emitted greedily by the score of their vertices,
+		which favours vertices that are in the (modelled LRU) cache and vertices with few triangles left.
+	*/
+	void OptimizeVertexCache(std::uint32_t* indices, std::size_t num_indices, std::size_t num_vertices);
+
+	//! Reorders clusters of triangles to reduce overdraw, without undoing the vertex cache optimisation.
+	/*!
+		Expects indices that are already optimised by OptimizeVertexCache. The triangles are split where the cache goes cold,
+		and where a cluster would cost at most threshold times the mesh's ACMR on its own. The clusters are then sorted
+		so the ones facing away from the centre of the mesh, which tend to occlude the others, are drawn first.
+		positions points to the first float3 position, position_stride is the distance in bytes between two positions.
+	*/
+	void OptimizeOverdraw(std::uint32_t* indices, std::size_t num_indices, float const * positions, std::size_t position_stride, std::size_t num_vertices, float threshold = 1.05f);
+
+	//! Renumbers the vertices in the order the indices first reference them, so vertex fetches walk memory linearly.
+	/*!
+		Rewrites the indices and fills out_remap with the new location of every old vertex; unreferenced vertices get ~0u.
+		Returns the number of vertices that are referenced. Apply the table to the vertex data with RemapVertices.
+	*/
+	std::size_t OptimizeVertexFetchRemap(std::uint32_t* indices, std::size_t num_indices, std::size_t num_vertices, std::vector<std::uint32_t>& out_remap);
+
+	//! Moves every vertex to the location in remap and drops unreferenced vertices.
+	template<typename T>
+	void RemapVertices(std::vector<T>& vertices, std::vector<std::uint32_t> const & remap, std::size_t num_unique_vertices)
+	{
+		// Attributes that don't exist for every vertex are left alone, same as the packing code ignores them
+		if (vertices.size() != remap.size())
+		{
+			return;
+		}
+
+		std::vector<T> remapped(num_unique_vertices);
+		for (std::size_t i = 0; i < remap.size(); ++i)
+		{
+			if (remap[i] != ~0u)
+			{
+				remapped[remap[i]] = vertices[i];
+			}
+		}
+
+		vertices.swap(remapped);
+	}
+
+} /* util */
@@ -0,0 +1,582 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mesh_simplifier.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace util
+{
+
+	namespace
+	{
+		enum class VertexKind : std::uint8_t
+		{
+			MANIFOLD,
+			BORDER,
+			SEAM,
+			LOCKED
+		};
+
+		// Open edges get an extra plane perpendicular to their triangle, weighted so moving them away from the edge is expensive
+		constexpr float edge_quadric_weight = 10.f;
+
+		struct Vec3
+		{
+			float x, y, z;
+		};
+
+		inline Vec3 Sub(Vec3 a, Vec3 b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+		inline Vec3 Cross(Vec3 a, Vec3 b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+		inline float Dot(Vec3 a, Vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+		inline float Length(Vec3 a) { return std::sqrt(Dot(a, a)); }
+
+		//! Sum of weighted squared distances to a set of planes, stored as the symmetric 4x4 matrix of the plane equations.
+		struct Quadric
+		{
+			double m_a00 = 0, m_a11 = 0, m_a22 = 0, m_a01 = 0, m_a02 = 0, m_a12 = 0;
+			double m_b0 = 0, m_b1 = 0, m_b2 = 0;
+			double m_c = 0;
+			double m_weight = 0;
+
+			void AddPlane(Vec3 n, float d, float weight)
+			{
+				m_a00 += weight * n.x * n.x;
+				m_a11 += weight * n.y * n.y;
+				m_a22 += weight * n.z * n.z;
+				m_a01 += weight * n.x * n.y;
+				m_a02 += weight * n.x * n.z;
+				m_a12 += weight * n.y * n.z;
+				m_b0 += weight * n.x * d;
+				m_b1 += weight * n.y * d;
+				m_b2 += weight * n.z * d;
+				m_c += weight * d * d;
+				m_weight += weight;
+			}
+
+			void Add(Quadric const & other)
+			{
+				m_a00 += other.m_a00;
+				m_a11 += other.m_a11;
+				m_a22 += other.m_a22;
+				m_a01 += other.m_a01;
+				m_a02 += other.m_a02;
+				m_a12 += other.m_a12;
+				m_b0 += other.m_b0;
+				m_b1 += other.m_b1;
+				m_b2 += other.m_b2;
+				m_c += other.m_c;
+				m_weight += other.m_weight;
+			}
+
+			//! Weighted average of the squared distances, so the error doesn't depend on the triangle size.
+			double Evaluate(Vec3 p) const
+			{
+				double const x = p.x, y = p.y, z = p.z;
+				double const r = m_a00 * x * x + m_a11 * y * y + m_a22 * z * z
+					+ 2.0 * (m_a01 * x * y + m_a02 * x * z + m_a12 * y * z)
+					+ 2.0 * (m_b0 * x + m_b1 * y + m_b2 * z)
+					+ m_c;
+
+				return m_weight > 0 ? std::abs(r) / m_weight : 0;
+			}
+		};
+
+		struct Collapse
+		{
+			std::uint32_t m_src;
+			std::uint32_t m_dst;
+			double m_cost;
+		};
+
+		struct PositionHash
+		{
+			std::size_t operator()(std::array<std::uint32_t, 3> const & key) const
+			{
+				return (key[0] * 73856093u) ^ (key[1] * 19349663u) ^ (key[2] * 83492791u);
+			}
+		};
+
+		inline std::uint64_t EdgeKey(std::uint32_t a, std::uint32_t b)
+		{
+			return (static_cast<std::uint64_t>(a) << 32) | b;
+		}
+	}
+
+	std::size_t SimplifyMesh(std::uint32_t* out_indices, std::uint32_t const * indices, std::size_t num_indices, float const * positions, std::size_t position_stride, std::size_t num_vertices,
+		std::size_t target_index_count, float target_error, float* out_error)
+	{
+		std::size_t index_count = num_indices / 3 * 3;
+		std::copy(indices, indices + index_count, out_indices);
+
+		if (out_error != nullptr)
+		{
+			*out_error = 0.f;
+		}
+
+		if (index_count <= target_index_count || num_vertices == 0)
+		{
+			return index_count;
+		}
+
+		auto load_position = [&](std::uint32_t v)
+		{
+			float const * p = reinterpret_cast<float const *>(reinterpret_cast<std::uint8_t const *>(positions) + v * position_stride);
+			return Vec3{ p[0], p[1], p[2] };
+		};
+
+		// Positions scaled to the unit cube, so the errors are relative to the mesh size
+		std::vector<Vec3> points(num_vertices);
+		std::vector<bool> referenced(num_vertices, false);
+		{
+			Vec3 min = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+			Vec3 max = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+
+			for (std::size_t i = 0; i < index_count; ++i)
+			{
+				std::uint32_t const v = out_indices[i];
+				referenced[v] = true;
+
+				Vec3 const p = load_position(v);
+				min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+				max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+			}
+
+			float const extent = std::max({ max.x - min.x, max.y - min.y, max.z - min.z });
+			float const inv_extent = extent > 0.f ? 1.f / extent : 0.f;
+
+			for (std::size_t v = 0; v < num_vertices; ++v)
+			{
+				Vec3 const p = Sub(load_position(static_cast<std::uint32_t>(v)), min);
+				points[v] = { p.x * inv_extent, p.y * inv_extent, p.z * inv_extent };
+			}
+		}
+
+		// Referenced vertices with the same position are wedges of one position, linked in a ring.
+		// The first wedge found represents the position; quadrics and vertex kinds are stored with it.
+		std::vector<std::uint32_t> position_of(num_vertices);
+		std::vector<std::uint32_t> next_wedge(num_vertices);
+		{
+			std::unordered_map<std::array<std::uint32_t, 3>, std::uint32_t, PositionHash> unique_positions;
+			unique_positions.reserve(num_vertices);
+
+			for (std::uint32_t v = 0; v < num_vertices; ++v)
+			{
+				position_of[v] = v;
+				next_wedge[v] = v;
+
+				if (!referenced[v])
+				{
+					continue;
+				}
+
+				std::array<std::uint32_t, 3> key;
+				Vec3 const p = load_position(v);
+				std::memcpy(key.data(), &p, sizeof(key));
+
+				auto [it, inserted] = unique_positions.try_emplace(key, v);
+				if (!inserted)
+				{
+					position_of[v] = it->second;
+					next_wedge[v] = next_wedge[it->second];
+					next_wedge[it->second] = v;
+				}
+			}
+		}
+
+		std::unordered_set<std::uint64_t> wedge_edges;
+		std::unordered_set<std::uint64_t> position_edges;
+
+		auto build_edges = [&]()
+		{
+			wedge_edges.clear();
+			position_edges.clear();
+
+			for (std::size_t i = 0; i < index_count; i += 3)
+			{
+				for (std::size_t k = 0; k < 3; ++k)
+				{
+					std::uint32_t const a = out_indices[i + k];
+					std::uint32_t const b = out_indices[i + (k + 1) % 3];
+
+					wedge_edges.insert(EdgeKey(a, b));
+					position_edges.insert(EdgeKey(position_of[a], position_of[b]));
+				}
+			}
+		};
+
+		auto is_open_wedge_edge = [&](std::uint32_t a, std::uint32_t b)
+		{
+			return wedge_edges.count(EdgeKey(b, a)) == 0;
+		};
+
+		build_edges();
+
+		// Classify every position by the open edges around it. A seam vertex has exactly two wedges,
+		// each with an open edge towards the previous and the next vertex along the seam.
+		std::vector<VertexKind> kinds(num_vertices, VertexKind::LOCKED);
+		{
+			std::vector<std::uint32_t> wedge_open(num_vertices, 0);
+			std::vector<std::uint32_t> position_open(num_vertices, 0);
+
+			for (std::uint64_t edge : wedge_edges)
+			{
+				std::uint32_t const a = static_cast<std::uint32_t>(edge >> 32);
+				std::uint32_t const b = static_cast<std::uint32_t>(edge);
+				if (is_open_wedge_edge(a, b))
+				{
+					++wedge_open[a];
+					++wedge_open[b];
+				}
+			}
+
+			for (std::uint64_t edge : position_edges)
+			{
+				std::uint32_t const a = static_cast<std::uint32_t>(edge >> 32);
+				std::uint32_t const b = static_cast<std::uint32_t>(edge);
+				if (position_edges.count(EdgeKey(b, a)) == 0)
+				{
+					++position_open[a];
+					++position_open[b];
+				}
+			}
+
+			for (std::uint32_t v = 0; v < num_vertices; ++v)
+			{
+				if (!referenced[v] || position_of[v] != v)
+				{
+					continue;
+				}
+
+				std::uint32_t const twin = next_wedge[v];
+				if (twin == v)
+				{
+					kinds[v] = position_open[v] == 0 ? VertexKind::MANIFOLD : (position_open[v] == 2 ? VertexKind::BORDER : VertexKind::LOCKED);
+				}
+				else if (next_wedge[twin] == v && position_open[v] == 0 && wedge_open[v] == 2 && wedge_open[twin] == 2)
+				{
+					kinds[v] = VertexKind::SEAM;
+				}
+			}
+		}
+
+		// Plane quadrics of the triangles around every position, plus the planes that keep open edges in place
+		std::vector<Quadric> quadrics(num_vertices);
+		for (std::size_t i = 0; i < index_count; i += 3)
+		{
+			std::uint32_t const * triangle = out_indices + i;
+
+			Vec3 const p0 = points[triangle[0]];
+			Vec3 const n = Cross(Sub(points[triangle[1]], p0), Sub(points[triangle[2]], p0));
+			float const length = Length(n);
+			if (length == 0.f)
+			{
+				continue;
+			}
+
+			Vec3 const normal = { n.x / length, n.y / length, n.z / length };
+			float const area = length * 0.5f;
+
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				quadrics[position_of[triangle[k]]].AddPlane(normal, -Dot(normal, points[triangle[k]]), area);
+			}
+
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				std::uint32_t const a = triangle[k];
+				std::uint32_t const b = triangle[(k + 1) % 3];
+				if (!is_open_wedge_edge(a, b))
+				{
+					continue;
+				}
+
+				Vec3 const edge = Sub(points[b], points[a]);
+				Vec3 const perpendicular = Cross(edge, normal);
+				float const edge_length = Length(perpendicular);
+				if (edge_length == 0.f)
+				{
+					continue;
+				}
+
+				Vec3 const plane = { perpendicular.x / edge_length, perpendicular.y / edge_length, perpendicular.z / edge_length };
+				float const d = -Dot(plane, points[a]);
+				float const weight = edge_length * edge_length * edge_quadric_weight;
+
+				quadrics[position_of[a]].AddPlane(plane, d, weight);
+				quadrics[position_of[b]].AddPlane(plane, d, weight);
+			}
+		}
+
+		// Is there an open wedge edge between the wedges of two positions, while the positions themselves are connected both ways?
+		auto is_seam_edge = [&](std::uint32_t a, std::uint32_t b)
+		{
+			std::uint32_t wa = a;
+			do
+			{
+				std::uint32_t wb = b;
+				do
+				{
+					if ((wedge_edges.count(EdgeKey(wa, wb)) && is_open_wedge_edge(wa, wb)) || (wedge_edges.count(EdgeKey(wb, wa)) && is_open_wedge_edge(wb, wa)))
+					{
+						return true;
+					}
+					wb = next_wedge[wb];
+				} while (wb != b);
+				wa = next_wedge[wa];
+			} while (wa != a);
+
+			return false;
+		};
+
+		auto can_collapse = [&](std::uint32_t src, std::uint32_t dst)
+		{
+			VertexKind const dst_kind = kinds[dst];
+			bool const open = position_edges.count(EdgeKey(src, dst)) == 0 || position_edges.count(EdgeKey(dst, src)) == 0;
+
+			switch (kinds[src])
+			{
+			case VertexKind::MANIFOLD:
+				return true;
+			case VertexKind::BORDER:
+				return (dst_kind == VertexKind::BORDER || dst_kind == VertexKind::LOCKED) && open;
+			case VertexKind::SEAM:
+				return (dst_kind == VertexKind::SEAM || dst_kind == VertexKind::LOCKED) && !open && is_seam_edge(src, dst);
+			default:
+				return false;
+			}
+		};
+
+		auto collapse_cost = [&](std::uint32_t src, std::uint32_t dst)
+		{
+			Quadric q = quadrics[src];
+			q.Add(quadrics[dst]);
+			return q.Evaluate(points[dst]);
+		};
+
+		std::vector<std::uint32_t> remap(num_vertices);
+		std::vector<bool> locked(num_vertices);
+		std::vector<std::uint32_t> triangle_offsets(num_vertices + 1);
+		std::vector<std::uint32_t> triangle_adjacency;
+		std::vector<Collapse> collapses;
+
+		double const error_limit = static_cast<double>(target_error) * static_cast<double>(target_error);
+		double max_error = 0;
+		bool first_pass = true;
+
+		while (index_count > target_index_count)
+		{
+			if (!first_pass)
+			{
+				build_edges();
+			}
+			first_pass = false;
+
+			// The triangles around every position
+			std::fill(triangle_offsets.begin(), triangle_offsets.end(), 0);
+			for (std::size_t i = 0; i < index_count; ++i)
+			{
+				++triangle_offsets[position_of[out_indices[i]] + 1];
+			}
+			std::partial_sum(triangle_offsets.begin(), triangle_offsets.end(), triangle_offsets.begin());
+
+			triangle_adjacency.resize(index_count);
+			{
+				std::vector<std::uint32_t> fill(triangle_offsets.begin(), triangle_offsets.end() - 1);
+				for (std::size_t i = 0; i < index_count; ++i)
+				{
+					triangle_adjacency[fill[position_of[out_indices[i]]]++] = static_cast<std::uint32_t>(i / 3);
+				}
+			}
+
+			// Every position edge once, in the cheapest allowed direction
+			collapses.clear();
+			for (std::size_t i = 0; i < index_count; i += 3)
+			{
+				for (std::size_t k = 0; k < 3; ++k)
+				{
+					std::uint32_t const a = position_of[out_indices[i + k]];
+					std::uint32_t const b = position_of[out_indices[i + (k + 1) % 3]];
+
+					if (a == b || (a > b && position_edges.count(EdgeKey(b, a))))
+					{
+						continue;
+					}
+
+					double const cost_ab = can_collapse(a, b) ? collapse_cost(a, b) : std::numeric_limits<double>::max();
+					double const cost_ba = can_collapse(b, a) ? collapse_cost(b, a) : std::numeric_limits<double>::max();
+
+					if (cost_ab <= cost_ba && cost_ab != std::numeric_limits<double>::max())
+					{
+						collapses.push_back({ a, b, cost_ab });
+					}
+					else if (cost_ba < cost_ab)
+					{
+						collapses.push_back({ b, a, cost_ba });
+					}
+				}
+			}
+
+			if (collapses.empty())
+			{
+				break;
+			}
+
+			std::sort(collapses.begin(), collapses.end(), [](Collapse const & a, Collapse const & b) { return a.m_cost < b.m_cost; });
+
+			std::iota(remap.begin(), remap.end(), 0u);
+			std::fill(locked.begin(), locked.end(), false);
+
+			std::size_t const triangles_to_remove = (index_count - target_index_count) / 3;
+			std::size_t triangles_removed = 0;
+			std::size_t collapses_applied = 0;
+
+			for (Collapse const & collapse : collapses)
+			{
+				if (collapse.m_cost > error_limit || triangles_removed >= std::max<std::size_t>(triangles_to_remove, 1))
+				{
+					break;
+				}
+
+				std::uint32_t const src = collapse.m_src;
+				std::uint32_t const dst = collapse.m_dst;
+
+				// Positions touched this pass are moved next pass, when their quadrics and neighbours are up to date
+				if (locked[src] || locked[dst])
+				{
+					continue;
+				}
+
+				// Every wedge of src moves to the wedge of dst on the same side of the seam
+				bool mapped = true;
+				std::uint32_t w = src;
+				do
+				{
+					std::uint32_t target = dst;
+					do
+					{
+						if (wedge_edges.count(EdgeKey(w, target)) || wedge_edges.count(EdgeKey(target, w)))
+						{
+							break;
+						}
+						target = next_wedge[target];
+					} while (target != dst);
+
+					if (!wedge_edges.count(EdgeKey(w, target)) && !wedge_edges.count(EdgeKey(target, w)))
+					{
+						mapped = false;
+						break;
+					}
+
+					remap[w] = target;
+					w = next_wedge[w];
+				} while (w != src);
+
+				// Reject collapses that flip a triangle, and count the ones that collapse
+				bool flips = false;
+				std::size_t collapsed_triangles = 0;
+
+				for (std::uint32_t j = triangle_offsets[src]; mapped && j < triangle_offsets[src + 1]; ++j)
+				{
+					std::uint32_t const * triangle = out_indices + triangle_adjacency[j] * 3;
+					std::uint32_t const p[3] = { position_of[triangle[0]], position_of[triangle[1]], position_of[triangle[2]] };
+
+					if (p[0] == dst || p[1] == dst || p[2] == dst)
+					{
+						++collapsed_triangles;
+						continue;
+					}
+
+					Vec3 before[3];
+					Vec3 after[3];
+					for (std::size_t k = 0; k < 3; ++k)
+					{
+						before[k] = points[p[k]];
+						after[k] = p[k] == src ? points[dst] : before[k];
+					}
+
+					Vec3 const n0 = Cross(Sub(before[1], before[0]), Sub(before[2], before[0]));
+					Vec3 const n1 = Cross(Sub(after[1], after[0]), Sub(after[2], after[0]));
+					if (Dot(n0, n1) <= 0.f)
+					{
+						flips = true;
+						break;
+					}
+				}
+
+				if (!mapped || flips)
+				{
+					w = src;
+					do
+					{
+						remap[w] = w;
+						w = next_wedge[w];
+					} while (w != src);
+
+					continue;
+				}
+
+				quadrics[dst].Add(quadrics[src]);
+				locked[src] = true;
+				locked[dst] = true;
+
+				triangles_removed += collapsed_triangles;
+				max_error = std::max(max_error, collapse.m_cost);
+				++collapses_applied;
+			}
+
+			if (collapses_applied == 0)
+			{
+				break;
+			}
+
+			// Apply the collapses and drop the triangles that lost an edge
+			std::size_t write = 0;
+			for (std::size_t i = 0; i < index_count; i += 3)
+			{
+				std::uint32_t const a = remap[out_indices[i]];
+				std::uint32_t const b = remap[out_indices[i + 1]];
+				std::uint32_t const c = remap[out_indices[i + 2]];
+
+				if (position_of[a] == position_of[b] || position_of[b] == position_of[c] || position_of[a] == position_of[c])
+				{
+					continue;
+				}
+
+				out_indices[write++] = a;
+				out_indices[write++] = b;
+				out_indices[write++] = c;
+			}
+
+			index_count = write;
+		}
+
+		if (out_error != nullptr)
+		{
+			*out_error = static_cast<float>(std::sqrt(max_error));
+		}
+
+		return index_count;
+	}
+
+} /* util */
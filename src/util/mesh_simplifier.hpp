@@ -0,0 +1,38 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace util
+{
+
+	//! Reduces an indexed triangle list to about target_index_count indices with edge collapses ordered by quadric error.
+	/*!
+		The vertices themselves are never modified or created: the result indexes the same vertex buffer, so it can be
+		compacted with OptimizeVertexFetchRemap. Vertices that share a position but not their other attributes (UV seams)
+		only collapse along the seam and take their twin with them, vertices on a border only collapse along the border,
+		and vertices where more seams or borders meet never move.
+
+		Simplification also stops once a collapse would cost more than target_error, which like out_error is relative
+		to the largest extent of the mesh's bounds. out_indices has to hold num_indices indices and may not alias indices.
+		Returns the number of indices written to out_indices.
+	*/
+	std::size_t SimplifyMesh(std::uint32_t* out_indices, std::uint32_t const * indices, std::size_t num_indices, float const * positions, std::size_t position_stride, std::size_t num_vertices,
+		std::size_t target_index_count, float target_error, float* out_error = nullptr);
+
+} /* util */
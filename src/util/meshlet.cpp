@@ -0,0 +1,201 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "meshlet.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace util
+{
+
+	namespace
+	{
+		float const * Position(float const * positions, std::size_t position_stride, std::uint32_t v)
+		{
+			return reinterpret_cast<float const *>(reinterpret_cast<std::uint8_t const *>(positions) + v * position_stride);
+		}
+
+		void ComputeMeshletBounds(Meshlet& meshlet, std::uint32_t const * indices, float const * positions, std::size_t position_stride)
+		{
+			std::uint32_t const * meshlet_indices = indices + meshlet.m_index_offset;
+
+			float min[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+			float max[3] = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+
+			for (std::uint32_t i = 0; i < meshlet.m_index_count; ++i)
+			{
+				float const * p = Position(positions, position_stride, meshlet_indices[i]);
+				for (std::size_t k = 0; k < 3; ++k)
+				{
+					min[k] = std::min(min[k], p[k]);
+					max[k] = std::max(max[k], p[k]);
+				}
+			}
+
+			// Sphere around the centre of the box, which is tighter than the box's own bounding sphere
+			float radius_sq = 0.f;
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				meshlet.m_center[k] = (min[k] + max[k]) * 0.5f;
+			}
+
+			for (std::uint32_t i = 0; i < meshlet.m_index_count; ++i)
+			{
+				float const * p = Position(positions, position_stride, meshlet_indices[i]);
+				float const dx = p[0] - meshlet.m_center[0];
+				float const dy = p[1] - meshlet.m_center[1];
+				float const dz = p[2] - meshlet.m_center[2];
+				radius_sq = std::max(radius_sq, dx * dx + dy * dy + dz * dz);
+			}
+
+			meshlet.m_radius = std::sqrt(radius_sq);
+
+			// The cone axis is the average triangle normal, the cutoff follows from the normal furthest away from it
+			std::uint32_t const num_triangles = meshlet.m_index_count / 3;
+			std::vector<float> normals(num_triangles * 3);
+			float axis[3] = { 0.f, 0.f, 0.f };
+
+			for (std::uint32_t t = 0; t < num_triangles; ++t)
+			{
+				float const * a = Position(positions, position_stride, meshlet_indices[t * 3]);
+				float const * b = Position(positions, position_stride, meshlet_indices[t * 3 + 1]);
+				float const * c = Position(positions, position_stride, meshlet_indices[t * 3 + 2]);
+
+				float const e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+				float const e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+				float n[3] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+
+				float const length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				float const inv_length = length > 0.f ? 1.f / length : 0.f;
+
+				for (std::size_t k = 0; k < 3; ++k)
+				{
+					normals[t * 3 + k] = n[k] * inv_length;
+					axis[k] += normals[t * 3 + k];
+				}
+			}
+
+			float const axis_length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+			if (axis_length <= 0.f)
+			{
+				return;
+			}
+
+			float min_dot = 1.f;
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				meshlet.m_cone_axis[k] = axis[k] / axis_length;
+			}
+
+			for (std::uint32_t t = 0; t < num_triangles; ++t)
+			{
+				float const * n = &normals[t * 3];
+				min_dot = std::min(min_dot, n[0] * meshlet.m_cone_axis[0] + n[1] * meshlet.m_cone_axis[1] + n[2] * meshlet.m_cone_axis[2]);
+			}
+
+			// Normals spread over more than a hemisphere (or degenerate triangles) make the meshlet visible from anywhere
+			meshlet.m_cone_cutoff = min_dot <= 0.f ? 1.f : std::sqrt(1.f - min_dot * min_dot);
+		}
+	}
+
+	std::vector<Meshlet> BuildMeshlets(std::uint32_t const * indices, std::size_t num_indices, float const * positions, std::size_t position_stride, std::size_t num_vertices,
+		std::uint32_t max_vertices, std::uint32_t max_triangles)
+	{
+		std::vector<Meshlet> meshlets;
+
+		std::size_t const num_triangles = num_indices / 3;
+		if (num_triangles == 0 || max_vertices < 3 || max_triangles == 0)
+		{
+			return meshlets;
+		}
+
+		// Which meshlet used a vertex last, so unique vertices are counted without clearing anything
+		std::vector<std::uint32_t> last_meshlet(num_vertices, ~0u);
+
+		Meshlet current;
+		std::uint32_t current_id = 0;
+
+		for (std::size_t t = 0; t < num_triangles; ++t)
+		{
+			std::uint32_t const * triangle = indices + t * 3;
+
+			std::uint32_t new_vertices = 0;
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				bool const duplicate = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+				new_vertices += (last_meshlet[triangle[k]] != current_id && !duplicate) ? 1 : 0;
+			}
+
+			if (current.m_index_count > 0 && (current.m_vertex_count + new_vertices > max_vertices || current.m_index_count / 3 >= max_triangles))
+			{
+				meshlets.push_back(current);
+
+				++current_id;
+				current = Meshlet();
+				current.m_index_offset = static_cast<std::uint32_t>(t * 3);
+				new_vertices = 0;
+
+				for (std::size_t k = 0; k < 3; ++k)
+				{
+					bool const duplicate = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+					new_vertices += duplicate ? 0 : 1;
+				}
+			}
+
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				last_meshlet[triangle[k]] = current_id;
+			}
+
+			current.m_vertex_count += new_vertices;
+			current.m_index_count += 3;
+		}
+
+		meshlets.push_back(current);
+
+		for (Meshlet& meshlet : meshlets)
+		{
+			ComputeMeshletBounds(meshlet, indices, positions, position_stride);
+		}
+
+		return meshlets;
+	}
+
+	bool MeshletInFrustum(Meshlet const & meshlet, float const (&planes)[6][4])
+	{
+		for (auto const & plane : planes)
+		{
+			float const distance = plane[0] * meshlet.m_center[0] + plane[1] * meshlet.m_center[1] + plane[2] * meshlet.m_center[2] + plane[3];
+			if (distance < -meshlet.m_radius)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool MeshletBackfacing(Meshlet const & meshlet, float const (&position)[3])
+	{
+		float const d[3] = { meshlet.m_center[0] - position[0], meshlet.m_center[1] - position[1], meshlet.m_center[2] - position[2] };
+		float const distance = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+		float const along_axis = d[0] * meshlet.m_cone_axis[0] + d[1] * meshlet.m_cone_axis[1] + d[2] * meshlet.m_cone_axis[2];
+
+		return along_axis >= meshlet.m_cone_cutoff * distance + meshlet.m_radius;
+	}
+
+} /* util */
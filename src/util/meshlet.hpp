@@ -0,0 +1,59 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace util
+{
+
+	//! A cluster of neighbouring triangles that is a contiguous range of its mesh's index buffer.
+	/*!
+		Because the range is contiguous a visible meshlet can be drawn with a regular indexed draw,
+		and runs of visible meshlets can be merged into one draw.
+	*/
+	struct Meshlet
+	{
+		std::uint32_t m_index_offset = 0; // Relative to the first index of the mesh
+		std::uint32_t m_index_count = 0;
+		std::uint32_t m_vertex_count = 0; // Unique vertices referenced by the meshlet
+
+		float m_center[3] = { 0.f, 0.f, 0.f };
+		float m_radius = 0.f;
+
+		// The meshlet faces away from a viewer at v when dot(m_center - v, m_cone_axis) >= m_cone_cutoff * length(m_center - v) + m_radius
+		float m_cone_axis[3] = { 0.f, 0.f, 0.f };
+		float m_cone_cutoff = 1.f; // 1 when the normals spread too much to ever cull the meshlet
+	};
+
+	//! Splits an index buffer into meshlets of at most max_vertices unique vertices and max_triangles triangles.
+	/*!
+		The triangles are taken in index buffer order, so the indices should be optimised for the vertex cache first;
+		that keeps neighbouring triangles together. The index buffer isn't modified.
+		positions points to the first float3 position, position_stride is the distance in bytes between two positions.
+	*/
+	std::vector<Meshlet> BuildMeshlets(std::uint32_t const * indices, std::size_t num_indices, float const * positions, std::size_t position_stride, std::size_t num_vertices,
+		std::uint32_t max_vertices = 64, std::uint32_t max_triangles = 124);
+
+	//! Whether the bounding sphere of the meshlet is on the inner side of all planes (xyz normal, w distance).
+	bool MeshletInFrustum(Meshlet const & meshlet, float const (&planes)[6][4]);
+
+	//! Whether all triangles of the meshlet face away from a viewer at position.
+	bool MeshletBackfacing(Meshlet const & meshlet, float const (&position)[3]);
+
+} /* util */
@@ -0,0 +1,436 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mip_generation.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <future>
+#include <vector>
+
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+namespace util
+{
+
+	namespace
+	{
+		// Half width of the Kaiser filter in mip texels and the shape of its window
+		constexpr float kaiser_width = 3.f;
+		constexpr float kaiser_alpha = 4.f;
+
+		// Rows of a mip filtered per job, which bounds the filtered source rows a job keeps around
+		constexpr std::size_t rows_per_job = 64;
+
+		//! A source texel and its weight.
+		struct FilterTap
+		{
+			std::size_t m_index;
+			float m_weight;
+		};
+
+		//! The taps of every mip texel along one axis. Texel i uses m_taps[m_first[i]] up to m_taps[m_first[i + 1]].
+		struct FilterTaps
+		{
+			std::vector<FilterTap> m_taps;
+			std::vector<std::size_t> m_first;
+		};
+
+		//! sRGB decode table and the linear values halfway between two sRGB codes, to round back to the nearest code.
+		struct SRGBTables
+		{
+			std::array<float, 256> m_to_linear;
+			std::array<float, 255> m_thresholds;
+
+			SRGBTables()
+			{
+				auto to_linear = [](float c)
+				{
+					return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+				};
+
+				for (std::size_t i = 0; i < 256; ++i)
+				{
+					m_to_linear[i] = to_linear(static_cast<float>(i) / 255.f);
+				}
+				for (std::size_t i = 0; i < 255; ++i)
+				{
+					m_thresholds[i] = to_linear((static_cast<float>(i) + 0.5f) / 255.f);
+				}
+			}
+		};
+
+		SRGBTables const & GetSRGBTables()
+		{
+			static SRGBTables const tables;
+			return tables;
+		}
+
+		//! Zeroth order modified Bessel function of the first kind, its power series converges fast for the values the window uses.
+		float BesselI0(float x)
+		{
+			float const half_x = x * 0.5f;
+			float term = 1.f;
+			float sum = 1.f;
+
+			for (int k = 1; term > sum * 1e-7f; ++k)
+			{
+				float const t = half_x / static_cast<float>(k);
+				term *= t * t;
+				sum += term;
+			}
+
+			return sum;
+		}
+
+		float Kaiser(float x)
+		{
+			if (std::abs(x) >= kaiser_width)
+			{
+				return 0.f;
+			}
+
+			float const pi_x = 3.14159265358979f * x;
+			float const sinc = std::abs(x) < 1e-4f ? 1.f : std::sin(pi_x) / pi_x;
+			float const t = x / kaiser_width;
+
+			return sinc * BesselI0(kaiser_alpha * std::sqrt(1.f - t * t)) / BesselI0(kaiser_alpha);
+		}
+
+		//! Weights of the source texels under each mip texel along one axis, normalized to add up to 1.
+		FilterTaps ComputeTaps(MipFilter filter, std::size_t src_size, std::size_t dst_size)
+		{
+			FilterTaps taps;
+			taps.m_first.reserve(dst_size + 1);
+
+			float const scale = static_cast<float>(src_size) / static_cast<float>(dst_size);
+			auto const last = static_cast<std::ptrdiff_t>(src_size) - 1;
+
+			for (std::size_t d = 0; d < dst_size; ++d)
+			{
+				std::size_t const first = taps.m_taps.size();
+				taps.m_first.push_back(first);
+
+				if (filter == MipFilter::BOX)
+				{
+					// The overlap of the mip texel's footprint with every source texel
+					float const lo = static_cast<float>(d) * scale;
+					float const hi = static_cast<float>(d + 1) * scale;
+
+					for (auto s = static_cast<std::ptrdiff_t>(std::floor(lo)); static_cast<float>(s) < hi; ++s)
+					{
+						float const weight = std::min(hi, static_cast<float>(s + 1)) - std::max(lo, static_cast<float>(s));
+						if (weight > 0.f)
+						{
+							taps.m_taps.push_back({ static_cast<std::size_t>(std::clamp<std::ptrdiff_t>(s, 0, last)), weight });
+						}
+					}
+				}
+				else
+				{
+					// Sampled at the source texel centers, the window stretches with the size ratio
+					float const center = (static_cast<float>(d) + 0.5f) * scale;
+					float const radius = kaiser_width * scale;
+
+					auto const lo = static_cast<std::ptrdiff_t>(std::floor(center - radius));
+					auto const hi = static_cast<std::ptrdiff_t>(std::ceil(center + radius));
+
+					for (std::ptrdiff_t s = lo; s <= hi; ++s)
+					{
+						float const weight = Kaiser((static_cast<float>(s) + 0.5f - center) / scale);
+						if (std::abs(weight) > 1e-6f)
+						{
+							taps.m_taps.push_back({ static_cast<std::size_t>(std::clamp<std::ptrdiff_t>(s, 0, last)), weight });
+						}
+					}
+				}
+
+				float sum = 0.f;
+				for (std::size_t t = first; t < taps.m_taps.size(); ++t)
+				{
+					sum += taps.m_taps[t].m_weight;
+				}
+				for (std::size_t t = first; t < taps.m_taps.size(); ++t)
+				{
+					taps.m_taps[t].m_weight /= sum;
+				}
+			}
+
+			taps.m_first.push_back(taps.m_taps.size());
+
+			return taps;
+		}
+
+		//! Decodes a row of RGBA8 texels, to linear color for sRGB textures.
+		void DecodeRow(MipChainDesc const & desc, std::uint8_t const * row, std::size_t width, DirectX::XMVECTOR* out)
+		{
+			auto const & to_linear = GetSRGBTables().m_to_linear;
+
+			for (std::size_t x = 0; x < width; ++x)
+			{
+				std::uint8_t const * texel = row + x * 4;
+
+				out[x] = desc.m_srgb
+					? DirectX::XMVectorSet(to_linear[texel[0]], to_linear[texel[1]], to_linear[texel[2]], static_cast<float>(texel[3]) / 255.f)
+					: DirectX::XMVectorScale(DirectX::XMVectorSet(texel[0], texel[1], texel[2], texel[3]), 1.f / 255.f);
+			}
+		}
+
+		//! Encodes a filtered texel as RGBA8, renormalizing normals and rounding sRGB color to the nearest code.
+		void EncodeTexel(MipChainDesc const & desc, DirectX::XMVECTOR texel, std::uint8_t* out)
+		{
+			if (desc.m_normal_map)
+			{
+				DirectX::XMVECTOR const normal = DirectX::XMVectorMultiplyAdd(texel, DirectX::XMVectorReplicate(2.f), DirectX::XMVectorReplicate(-1.f));
+				DirectX::XMVECTOR const length_sq = DirectX::XMVector3LengthSq(normal);
+
+				// Opposing normals can cancel out, those keep the flat normal
+				DirectX::XMVECTOR const unit = DirectX::XMVectorGetX(length_sq) > 1e-8f
+					? DirectX::XMVectorMultiply(normal, DirectX::XMVectorReciprocalSqrt(length_sq))
+					: DirectX::XMVectorSet(0.f, 0.f, 1.f, 0.f);
+
+				texel = DirectX::XMVectorSelect(texel, DirectX::XMVectorMultiplyAdd(unit, DirectX::XMVectorReplicate(0.5f), DirectX::XMVectorReplicate(0.5f)), DirectX::g_XMSelect1110);
+			}
+
+			// The negative lobes of the Kaiser filter can overshoot
+			texel = DirectX::XMVectorSaturate(texel);
+
+			DirectX::XMVECTOR const codes = DirectX::XMVectorRound(DirectX::XMVectorScale(texel, 255.f));
+			out[3] = static_cast<std::uint8_t>(DirectX::XMVectorGetW(codes));
+
+			if (desc.m_srgb)
+			{
+				auto const & thresholds = GetSRGBTables().m_thresholds;
+				float const color[3] = { DirectX::XMVectorGetX(texel), DirectX::XMVectorGetY(texel), DirectX::XMVectorGetZ(texel) };
+
+				for (int c = 0; c < 3; ++c)
+				{
+					out[c] = static_cast<std::uint8_t>(std::upper_bound(thresholds.begin(), thresholds.end(), color[c]) - thresholds.begin());
+				}
+			}
+			else
+			{
+				out[0] = static_cast<std::uint8_t>(DirectX::XMVectorGetX(codes));
+				out[1] = static_cast<std::uint8_t>(DirectX::XMVectorGetY(codes));
+				out[2] = static_cast<std::uint8_t>(DirectX::XMVectorGetZ(codes));
+			}
+		}
+
+		//! Filters rows first to last of a mip from the level above it.
+		void FilterRows(MipChainDesc const & desc, MipLevel const & src, MipLevel const & dst, FilterTaps const & x_taps, FilterTaps const & y_taps,
+			std::size_t first, std::size_t last)
+		{
+			// The source rows the vertical taps of these rows read, filtered horizontally once each
+			std::size_t src_first = src.m_height;
+			std::size_t src_last = 0;
+			for (std::size_t t = y_taps.m_first[first]; t < y_taps.m_first[last]; ++t)
+			{
+				src_first = std::min(src_first, y_taps.m_taps[t].m_index);
+				src_last = std::max(src_last, y_taps.m_taps[t].m_index + 1);
+			}
+
+			std::vector<DirectX::XMVECTOR> decoded(src.m_width);
+			std::vector<DirectX::XMVECTOR> filtered((src_last - src_first) * dst.m_width);
+
+			for (std::size_t y = src_first; y < src_last; ++y)
+			{
+				DecodeRow(desc, src.m_pixels + y * src.m_row_pitch, src.m_width, decoded.data());
+
+				DirectX::XMVECTOR* out = filtered.data() + (y - src_first) * dst.m_width;
+				for (std::size_t x = 0; x < dst.m_width; ++x)
+				{
+					DirectX::XMVECTOR sum = DirectX::XMVectorZero();
+					for (std::size_t t = x_taps.m_first[x]; t < x_taps.m_first[x + 1]; ++t)
+					{
+						sum = DirectX::XMVectorMultiplyAdd(decoded[x_taps.m_taps[t].m_index], DirectX::XMVectorReplicate(x_taps.m_taps[t].m_weight), sum);
+					}
+					out[x] = sum;
+				}
+			}
+
+			for (std::size_t y = first; y < last; ++y)
+			{
+				std::uint8_t* out = dst.m_pixels + y * dst.m_row_pitch;
+
+				for (std::size_t x = 0; x < dst.m_width; ++x)
+				{
+					DirectX::XMVECTOR sum = DirectX::XMVectorZero();
+					for (std::size_t t = y_taps.m_first[y]; t < y_taps.m_first[y + 1]; ++t)
+					{
+						DirectX::XMVECTOR const texel = filtered[(y_taps.m_taps[t].m_index - src_first) * dst.m_width + x];
+						sum = DirectX::XMVectorMultiplyAdd(texel, DirectX::XMVectorReplicate(y_taps.m_taps[t].m_weight), sum);
+					}
+
+					EncodeTexel(desc, sum, out + x * 4);
+				}
+			}
+		}
+
+		//! Texels with an alpha of this code or more pass an alpha test against alpha_test.
+		std::uint32_t GetAlphaTestCode(float alpha_test)
+		{
+			return std::min<std::uint32_t>(static_cast<std::uint32_t>(std::floor(alpha_test * 255.f)) + 1, 255);
+		}
+
+		//! Number of texels of a level for every alpha code.
+		std::array<std::size_t, 256> GetAlphaHistogram(MipLevel const & level)
+		{
+			std::array<std::size_t, 256> histogram = {};
+
+			for (std::size_t y = 0; y < level.m_height; ++y)
+			{
+				std::uint8_t const * row = level.m_pixels + y * level.m_row_pitch;
+				for (std::size_t x = 0; x < level.m_width; ++x)
+				{
+					++histogram[row[x * 4 + 3]];
+				}
+			}
+
+			return histogram;
+		}
+
+		//! Scales the alpha of a mip so the share of texels passing the alpha test matches coverage.
+		/*!
+			Averaging alpha shrinks alpha tested foliage and fences in the smaller mips. The code whose share of texels at
+			or above it comes closest to the coverage is scaled to the alpha test code.
+		*/
+		void PreserveAlphaCoverage(MipLevel const & level, std::uint32_t alpha_test_code, float coverage)
+		{
+			std::array<std::size_t, 256> const histogram = GetAlphaHistogram(level);
+			float const num_texels = static_cast<float>(level.m_width * level.m_height);
+
+			std::uint32_t best_code = alpha_test_code;
+			float best_error = 2.f;
+			std::size_t at_or_above = 0;
+
+			for (std::uint32_t code = 255; code > 0; --code)
+			{
+				at_or_above += histogram[code];
+
+				float const error = std::abs(static_cast<float>(at_or_above) / num_texels - coverage);
+				if (error < best_error)
+				{
+					best_error = error;
+					best_code = code;
+				}
+			}
+
+			if (best_code == alpha_test_code)
+			{
+				return;
+			}
+
+			float const scale = static_cast<float>(alpha_test_code) / static_cast<float>(best_code);
+
+			for (std::size_t y = 0; y < level.m_height; ++y)
+			{
+				std::uint8_t* row = level.m_pixels + y * level.m_row_pitch;
+				for (std::size_t x = 0; x < level.m_width; ++x)
+				{
+					std::uint8_t& alpha = row[x * 4 + 3];
+					alpha = static_cast<std::uint8_t>(std::min(255.f, std::round(static_cast<float>(alpha) * scale)));
+				}
+			}
+		}
+	}
+
+	std::size_t GetMipCount(std::size_t width, std::size_t height)
+	{
+		std::size_t count = 1;
+
+		for (std::size_t size = std::max(width, height); size > 1; size >>= 1)
+		{
+			++count;
+		}
+
+		return count;
+	}
+
+	void GenerateMipChain(MipChainDesc const & desc, MipLevel const * levels, std::size_t num_levels, ThreadPool* thread_pool)
+	{
+		if (num_levels < 2)
+		{
+			return;
+		}
+
+		// Only alpha tested textures that aren't entirely transparent or opaque can lose coverage
+		std::uint32_t const alpha_test_code = GetAlphaTestCode(desc.m_alpha_test);
+		float coverage = 0.f;
+
+		if (desc.m_alpha_test > 0.f)
+		{
+			std::array<std::size_t, 256> const histogram = GetAlphaHistogram(levels[0]);
+
+			std::size_t passing = 0;
+			for (std::uint32_t code = alpha_test_code; code < 256; ++code)
+			{
+				passing += histogram[code];
+			}
+
+			coverage = static_cast<float>(passing) / static_cast<float>(levels[0].m_width * levels[0].m_height);
+		}
+
+		bool const preserve_coverage = coverage > 0.f && coverage < 1.f;
+
+		for (std::size_t i = 1; i < num_levels; ++i)
+		{
+			MipLevel const & src = levels[i - 1];
+			MipLevel const & dst = levels[i];
+
+			FilterTaps const x_taps = ComputeTaps(desc.m_filter, src.m_width, dst.m_width);
+			FilterTaps const y_taps = ComputeTaps(desc.m_filter, src.m_height, dst.m_height);
+
+			std::size_t const num_jobs = (dst.m_height + rows_per_job - 1) / rows_per_job;
+
+			// Small mips aren't worth the hand-off
+			if (thread_pool == nullptr || dst.m_width * dst.m_height < 4096)
+			{
+				for (std::size_t j = 0; j < num_jobs; ++j)
+				{
+					FilterRows(desc, src, dst, x_taps, y_taps, j * rows_per_job, std::min(dst.m_height, (j + 1) * rows_per_job));
+				}
+			}
+			else
+			{
+				std::vector<std::future<void>> jobs;
+				jobs.reserve(num_jobs);
+
+				for (std::size_t j = 0; j < num_jobs; ++j)
+				{
+					std::size_t const first = j * rows_per_job;
+					std::size_t const last = std::min(dst.m_height, first + rows_per_job);
+
+					jobs.push_back(thread_pool->Enqueue([&desc, &src, &dst, &x_taps, &y_taps, first, last]
+					{
+						FilterRows(desc, src, dst, x_taps, y_taps, first, last);
+					}));
+				}
+
+				for (auto& job : jobs)
+				{
+					job.get();
+				}
+			}
+
+			if (preserve_coverage)
+			{
+				PreserveAlphaCoverage(dst, alpha_test_code, coverage);
+			}
+		}
+	}
+
+} /* util */
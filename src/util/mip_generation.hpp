@@ -0,0 +1,65 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace util
+{
+
+	class ThreadPool;
+
+	//! Downsampling filters of GenerateMipChain.
+	enum class MipFilter
+	{
+		BOX, // Averages the texels each mip texel covers
+		KAISER, // Kaiser windowed sinc, keeps more detail than a box filter without adding aliasing
+	};
+
+	//! How the texels of an RGBA8 mip chain are filtered.
+	struct MipChainDesc
+	{
+		MipFilter m_filter = MipFilter::KAISER;
+		// RGB is averaged in linear space and stored as sRGB again, alpha is always linear
+		bool m_srgb = false;
+		// RGB is a tangent space normal stored as 0.5 * n + 0.5, renormalized after filtering
+		bool m_normal_map = false;
+		// Above 0, alpha is scaled per mip so as many texels pass an alpha test against this value as in the top mip
+		float m_alpha_test = 0.f;
+	};
+
+	//! One RGBA8 image of a mip chain.
+	struct MipLevel
+	{
+		std::uint8_t* m_pixels = nullptr;
+		std::size_t m_width = 0;
+		std::size_t m_height = 0;
+		std::size_t m_row_pitch = 0;
+	};
+
+	//! Number of mips in a full chain down to 1x1.
+	std::size_t GetMipCount(std::size_t width, std::size_t height);
+
+	//! Fills levels 1 to num_levels - 1 of an RGBA8 mip chain, each from the level above it.
+	/*!
+		Every level is half the size of the one above, rounded down and at least 1, like D3D12 mips. The filters are
+		separable and run on XMVECTORs, a texel per register, edges are clamped. With a thread pool the rows of every
+		level are filtered on its threads, so it can't be the pool of the calling thread.
+	*/
+	void GenerateMipChain(MipChainDesc const & desc, MipLevel const * levels, std::size_t num_levels, ThreadPool* thread_pool = nullptr);
+
+} /* util */
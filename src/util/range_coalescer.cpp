@@ -0,0 +1,72 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "range_coalescer.hpp"
+
+#include <algorithm>
+#include <functional>
+
+namespace util
+{
+
+	void RangeCoalescer::Add(void* key, std::uint64_t offset, std::uint64_t size)
+	{
+		if (size == 0)
+		{
+			return;
+		}
+
+		m_ranges.push_back({ key, offset, size });
+	}
+
+	std::vector<RangeCoalescer::Range> const & RangeCoalescer::Coalesce()
+	{
+		if (m_ranges.size() <= 1)
+		{
+			return m_ranges;
+		}
+
+		std::sort(m_ranges.begin(), m_ranges.end(), [](Range const & a, Range const & b)
+		{
+			if (a.m_key != b.m_key)
+			{
+				return std::less<void*>()(a.m_key, b.m_key);
+			}
+			return a.m_offset < b.m_offset;
+		});
+
+		// Merge in place, out always trails the range being read
+		std::size_t out = 0;
+		for (std::size_t i = 1; i < m_ranges.size(); ++i)
+		{
+			Range& merged = m_ranges[out];
+			Range const & range = m_ranges[i];
+
+			if (range.m_key == merged.m_key && range.m_offset <= merged.m_offset + merged.m_size)
+			{
+				merged.m_size = std::max(merged.m_offset + merged.m_size, range.m_offset + range.m_size) - merged.m_offset;
+			}
+			else
+			{
+				m_ranges[++out] = range;
+			}
+		}
+
+		m_ranges.resize(out + 1);
+
+		return m_ranges;
+	}
+
+} /* util */
@@ -0,0 +1,53 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace util
+{
+
+	//! Collects byte ranges of several resources and merges the ones that overlap or touch.
+	/*!
+		Used to turn many small uploads into as few copies as possible. The key identifies the resource
+		and is never dereferenced, ranges with different keys are never merged.
+	*/
+	class RangeCoalescer
+	{
+	public:
+		struct Range
+		{
+			void* m_key;
+			std::uint64_t m_offset;
+			std::uint64_t m_size;
+		};
+
+		//! Empty ranges are ignored.
+		void Add(void* key, std::uint64_t offset, std::uint64_t size);
+
+		//! Merges the ranges added so far. The result is sorted by key, then by offset.
+		std::vector<Range> const & Coalesce();
+
+		//! Keeps the memory around for the next batch.
+		void Clear() { m_ranges.clear(); }
+		bool Empty() const { return m_ranges.empty(); }
+
+	private:
+		std::vector<Range> m_ranges;
+	};
+
+} /* util */
@@ -0,0 +1,94 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace util
+{
+
+	//! FIFO queue on top of a single growable array.
+	/*!
+		Popping never frees memory and pushing only allocates when the ring is full,
+		so a queue that is drained every frame stops allocating once it reached its peak size.
+	*/
+	template<typename T>
+	class RingBuffer
+	{
+	public:
+		explicit RingBuffer(std::size_t capacity = 64) : m_storage(capacity > 0 ? capacity : 1)
+		{
+		}
+
+		void Push(T const & value)
+		{
+			if (m_size == m_storage.size())
+			{
+				Grow();
+			}
+
+			m_storage[(m_head + m_size) % m_storage.size()] = value;
+			m_size++;
+		}
+
+		T& Front()
+		{
+			return m_storage[m_head];
+		}
+
+		void Pop()
+		{
+			m_head = (m_head + 1) % m_storage.size();
+			m_size--;
+		}
+
+		//! Element i counted from the front.
+		T& operator[](std::size_t i)
+		{
+			return m_storage[(m_head + i) % m_storage.size()];
+		}
+
+		void Clear()
+		{
+			m_head = 0;
+			m_size = 0;
+		}
+
+		std::size_t Size() const { return m_size; }
+		bool Empty() const { return m_size == 0; }
+		std::size_t Capacity() const { return m_storage.size(); }
+
+	private:
+		void Grow()
+		{
+			std::vector<T> storage(m_storage.size() * 2);
+			for (std::size_t i = 0; i < m_size; ++i)
+			{
+				storage[i] = std::move((*this)[i]);
+			}
+
+			m_storage = std::move(storage);
+			m_head = 0;
+		}
+
+		std::vector<T> m_storage;
+		std::size_t m_head = 0;
+		std::size_t m_size = 0;
+	};
+
+} /* util */
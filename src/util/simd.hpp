@@ -0,0 +1,69 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <DirectXMath.h>
+
+//! SIMD backend selection for hot CPU loops.
+/*!
+	DirectXMath already picks SSE2, NEON or plain scalar code for XMVECTOR, so 4-wide code should use it directly
+	together with its lane accessors (XMVectorGetX/Y/Z/W and XMVectorGetByIndex) instead of the MSVC only `m128_f32` member.
+	Loops that can process two 4-wide items per iteration may additionally use the 8-wide AVX2 path guarded by WISP_SIMD_AVX2.
+*/
+#if defined(__AVX2__) && !defined(_XM_NO_INTRINSICS_)
+	#define WISP_SIMD_AVX2 1
+	#include <immintrin.h>
+#endif
+
+#if defined(_XM_SSE_INTRINSICS_)
+	#define WISP_SIMD_SSE 1
+#elif defined(_XM_ARM_NEON_INTRINSICS_)
+	#define WISP_SIMD_NEON 1
+#else
+	#define WISP_SIMD_SCALAR 1
+#endif
+
+namespace util::simd
+{
+
+#ifdef WISP_SIMD_AVX2
+	//! Loads two XMVECTOR sized values into the low and high lane of an 8-wide register.
+	inline __m256 Load2(float const * lo, float const * hi)
+	{
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)), _mm_loadu_ps(hi), 1);
+	}
+
+	//! Stores the low and high lane of an 8-wide register as two XMVECTORs.
+	inline void Store2(DirectX::XMVECTOR* lo, DirectX::XMVECTOR* hi, __m256 v)
+	{
+		*lo = _mm256_castps256_ps128(v);
+		*hi = _mm256_extractf128_ps(v, 1);
+	}
+
+	inline __m256 Abs(__m256 v)
+	{
+		return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v);
+	}
+
+	//! Broadcasts component I of each 128-bit lane across that lane.
+	template<int I>
+	inline __m256 SplatLane(__m256 v)
+	{
+		return _mm256_permute_ps(v, _MM_SHUFFLE(I, I, I, I));
+	}
+#endif
+
+} /* util::simd */
@@ -0,0 +1,185 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace util
+{
+
+	//! Dense storage addressed by generational keys.
+	/*!
+		Values live in one contiguous array, a key is a slot index plus the generation of that slot.
+		Find is two array lookups and returns nullptr for keys of erased values, even when their slot got reused.
+		Erasing moves the last value into the gap, so pointers into the map are only valid until the next Insert or Erase.
+
+		64 bit keys use 32 bits for the index and 32 for the generation,
+		32 bit keys use 24 bits for the index and 8 for the generation.
+	*/
+	template<typename T, typename K = std::uint64_t>
+	class SlotMap
+	{
+		static_assert(sizeof(K) == 4 || sizeof(K) == 8, "Slot map keys are 32 or 64 bit integers");
+
+	public:
+		using Key = K;
+
+		static constexpr unsigned int index_bits = sizeof(K) == 8 ? 32 : 24;
+		static constexpr K index_mask = (K(1) << index_bits) - 1;
+		static constexpr K generation_mask = std::numeric_limits<K>::max() >> index_bits;
+
+		Key Insert(T value)
+		{
+			std::uint32_t slot_index;
+			if (m_free_head != invalid)
+			{
+				slot_index = m_free_head;
+				m_free_head = m_slots[slot_index].m_next_free;
+			}
+			else
+			{
+				slot_index = static_cast<std::uint32_t>(m_slots.size());
+				m_slots.push_back({ invalid, 0, invalid });
+			}
+
+			Slot& slot = m_slots[slot_index];
+			slot.m_dense_index = static_cast<std::uint32_t>(m_values.size());
+			slot.m_next_free = invalid;
+
+			m_values.push_back(std::move(value));
+			m_dense_to_slot.push_back(slot_index);
+
+			return MakeKey(slot_index, slot.m_generation);
+		}
+
+		T* Find(Key key)
+		{
+			std::uint32_t const dense_index = DenseIndex(key);
+			return dense_index != invalid ? &m_values[dense_index] : nullptr;
+		}
+
+		T const * Find(Key key) const
+		{
+			std::uint32_t const dense_index = DenseIndex(key);
+			return dense_index != invalid ? &m_values[dense_index] : nullptr;
+		}
+
+		bool Contains(Key key) const
+		{
+			return DenseIndex(key) != invalid;
+		}
+
+		//! Returns false when the key was already erased.
+		bool Erase(Key key)
+		{
+			std::uint32_t const dense_index = DenseIndex(key);
+			if (dense_index == invalid)
+			{
+				return false;
+			}
+
+			// Fill the gap with the last value to keep the values dense
+			std::uint32_t const last = static_cast<std::uint32_t>(m_values.size() - 1);
+			if (dense_index != last)
+			{
+				m_values[dense_index] = std::move(m_values[last]);
+				m_dense_to_slot[dense_index] = m_dense_to_slot[last];
+				m_slots[m_dense_to_slot[dense_index]].m_dense_index = dense_index;
+			}
+
+			m_values.pop_back();
+			m_dense_to_slot.pop_back();
+
+			std::uint32_t const slot_index = static_cast<std::uint32_t>(key & index_mask);
+			Slot& slot = m_slots[slot_index];
+			slot.m_dense_index = invalid;
+			slot.m_generation = static_cast<std::uint32_t>((slot.m_generation + 1) & generation_mask);
+			slot.m_next_free = m_free_head;
+			m_free_head = slot_index;
+
+			return true;
+		}
+
+		void Clear()
+		{
+			// Erased one by one so every key in use is invalidated
+			while (!m_values.empty())
+			{
+				Erase(KeyAt(m_values.size() - 1));
+			}
+		}
+
+		//! Key of the value at a position in the dense array, for iterating over keys and values together.
+		Key KeyAt(std::size_t dense_index) const
+		{
+			std::uint32_t const slot_index = m_dense_to_slot[dense_index];
+			return MakeKey(slot_index, m_slots[slot_index].m_generation);
+		}
+
+		T& operator[](std::size_t dense_index) { return m_values[dense_index]; }
+		T const & operator[](std::size_t dense_index) const { return m_values[dense_index]; }
+
+		auto begin() { return m_values.begin(); }
+		auto end() { return m_values.end(); }
+		auto begin() const { return m_values.begin(); }
+		auto end() const { return m_values.end(); }
+
+		std::size_t Size() const { return m_values.size(); }
+		bool Empty() const { return m_values.empty(); }
+
+	private:
+		static constexpr std::uint32_t invalid = std::numeric_limits<std::uint32_t>::max();
+
+		struct Slot
+		{
+			std::uint32_t m_dense_index;
+			std::uint32_t m_generation;
+			std::uint32_t m_next_free;
+		};
+
+		static Key MakeKey(std::uint32_t slot_index, std::uint32_t generation)
+		{
+			return static_cast<Key>((static_cast<K>(generation) << index_bits) | slot_index);
+		}
+
+		std::uint32_t DenseIndex(Key key) const
+		{
+			std::uint64_t const slot_index = key & index_mask;
+			if (slot_index >= m_slots.size())
+			{
+				return invalid;
+			}
+
+			Slot const & slot = m_slots[slot_index];
+			if (slot.m_dense_index == invalid || slot.m_generation != ((key >> index_bits) & generation_mask))
+			{
+				return invalid;
+			}
+
+			return slot.m_dense_index;
+		}
+
+		std::vector<Slot> m_slots;
+		std::vector<T> m_values;
+		std::vector<std::uint32_t> m_dense_to_slot;
+		std::uint32_t m_free_head = invalid;
+	};
+
+} /* util */
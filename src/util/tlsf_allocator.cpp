@@ -0,0 +1,413 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tlsf_allocator.hpp"
+
+#include <bit>
+#include <cassert>
+
+namespace util
+{
+
+	TLSFAllocator::TLSFAllocator(std::size_t size)
+	{
+		Resize(size);
+	}
+
+	void TLSFAllocator::MappingInsert(std::size_t size, std::size_t& fl, std::size_t& sl)
+	{
+		if (size < sl_index_count)
+		{
+			// Small sizes share the first level and are indexed linearly
+			fl = 0;
+			sl = size;
+		}
+		else
+		{
+			std::size_t msb = std::bit_width(size) - 1;
+			sl = (size >> (msb - sl_index_count_log2)) ^ sl_index_count;
+			fl = msb - sl_index_count_log2 + 1;
+		}
+	}
+
+	void TLSFAllocator::MappingSearch(std::size_t size, std::size_t& fl, std::size_t& sl)
+	{
+		// Round up to the next size class so every block in the found list is large enough
+		if (size >= sl_index_count)
+		{
+			std::size_t msb = std::bit_width(size) - 1;
+			std::size_t round = (std::size_t(1) << (msb - sl_index_count_log2)) - 1;
+			if (size <= SIZE_MAX - round)
+			{
+				size += round;
+			}
+		}
+
+		MappingInsert(size, fl, sl);
+	}
+
+	TLSFAllocator::Block* TLSFAllocator::FindSuitableBlock(std::size_t size)
+	{
+		std::size_t fl, sl;
+		MappingSearch(size, fl, sl);
+
+		if (fl >= fl_index_count)
+		{
+			return nullptr;
+		}
+
+		std::uint32_t sl_map = m_sl_bitmap[fl] & (~0u << sl);
+		if (sl_map == 0)
+		{
+			std::uint64_t fl_map = fl + 1 < 64 ? m_fl_bitmap & (~std::uint64_t(0) << (fl + 1)) : 0;
+			if (fl_map == 0)
+			{
+				return nullptr;
+			}
+
+			fl = std::countr_zero(fl_map);
+			sl_map = m_sl_bitmap[fl];
+		}
+
+		sl = std::countr_zero(sl_map);
+
+		return m_free_lists[fl][sl];
+	}
+
+	void TLSFAllocator::InsertFreeBlock(Block* block)
+	{
+		std::size_t fl, sl;
+		MappingInsert(block->m_size, fl, sl);
+
+		Block* head = m_free_lists[fl][sl];
+		block->m_free = true;
+		block->m_prev_free = nullptr;
+		block->m_next_free = head;
+		if (head != nullptr)
+		{
+			head->m_prev_free = block;
+		}
+
+		m_free_lists[fl][sl] = block;
+		m_fl_bitmap |= std::uint64_t(1) << fl;
+		m_sl_bitmap[fl] |= 1u << sl;
+
+		m_num_free_blocks++;
+	}
+
+	void TLSFAllocator::RemoveFreeBlock(Block* block)
+	{
+		std::size_t fl, sl;
+		MappingInsert(block->m_size, fl, sl);
+
+		if (block->m_prev_free != nullptr)
+		{
+			block->m_prev_free->m_next_free = block->m_next_free;
+		}
+		if (block->m_next_free != nullptr)
+		{
+			block->m_next_free->m_prev_free = block->m_prev_free;
+		}
+
+		if (m_free_lists[fl][sl] == block)
+		{
+			m_free_lists[fl][sl] = block->m_next_free;
+
+			if (block->m_next_free == nullptr)
+			{
+				m_sl_bitmap[fl] &= ~(1u << sl);
+				if (m_sl_bitmap[fl] == 0)
+				{
+					m_fl_bitmap &= ~(std::uint64_t(1) << fl);
+				}
+			}
+		}
+
+		block->m_prev_free = nullptr;
+		block->m_next_free = nullptr;
+
+		m_num_free_blocks--;
+	}
+
+	TLSFAllocator::Block* TLSFAllocator::CreateBlock()
+	{
+		if (m_unused_blocks == nullptr)
+		{
+			m_block_chunks.push_back(std::make_unique<Block[]>(block_chunk_size));
+			Block* chunk = m_block_chunks.back().get();
+
+			for (std::size_t i = 0; i < block_chunk_size; ++i)
+			{
+				chunk[i].m_next_free = m_unused_blocks;
+				m_unused_blocks = &chunk[i];
+			}
+		}
+
+		Block* block = m_unused_blocks;
+		m_unused_blocks = block->m_next_free;
+
+		*block = Block();
+		return block;
+	}
+
+	void TLSFAllocator::DestroyBlock(Block* block)
+	{
+		block->m_next_free = m_unused_blocks;
+		m_unused_blocks = block;
+	}
+
+	TLSFAllocator::Block* TLSFAllocator::SplitBlock(Block* block, std::size_t size)
+	{
+		Block* remainder = CreateBlock();
+		remainder->m_offset = block->m_offset + size;
+		remainder->m_size = block->m_size - size;
+		remainder->m_prev_physical = block;
+		remainder->m_next_physical = block->m_next_physical;
+
+		if (block->m_next_physical != nullptr)
+		{
+			block->m_next_physical->m_prev_physical = remainder;
+		}
+		else
+		{
+			m_last_block = remainder;
+		}
+
+		block->m_next_physical = remainder;
+		block->m_size = size;
+
+		return remainder;
+	}
+
+	void TLSFAllocator::MergeBlocks(Block* block, Block* next)
+	{
+		block->m_size += next->m_size;
+		block->m_next_physical = next->m_next_physical;
+
+		if (next->m_next_physical != nullptr)
+		{
+			next->m_next_physical->m_prev_physical = block;
+		}
+		else
+		{
+			m_last_block = block;
+		}
+
+		DestroyBlock(next);
+	}
+
+	TLSFAllocator::Block* TLSFAllocator::Allocate(std::size_t size, std::size_t alignment)
+	{
+		size = std::max<std::size_t>(size, 1);
+		alignment = std::max<std::size_t>(alignment, 1);
+
+		// Worst case padding to get to an aligned offset
+		Block* block = FindSuitableBlock(size + alignment - 1);
+
+		if (block == nullptr)
+		{
+			return nullptr;
+		}
+
+		RemoveFreeBlock(block);
+
+		return Carve(block, size, alignment);
+	}
+
+	TLSFAllocator::Block* TLSFAllocator::AllocateFrom(Block* free_block, std::size_t size, std::size_t alignment)
+	{
+		size = std::max<std::size_t>(size, 1);
+		alignment = std::max<std::size_t>(alignment, 1);
+
+		if (free_block == nullptr || !free_block->m_free || !Fits(free_block, size, alignment))
+		{
+			return nullptr;
+		}
+
+		RemoveFreeBlock(free_block);
+
+		return Carve(free_block, size, alignment);
+	}
+
+	bool TLSFAllocator::Fits(Block const* free_block, std::size_t size, std::size_t alignment)
+	{
+		std::size_t misalignment = free_block->m_offset % alignment;
+		std::size_t padding = misalignment == 0 ? 0 : alignment - misalignment;
+
+		return free_block->m_size >= size + padding;
+	}
+
+	TLSFAllocator::Block* TLSFAllocator::Carve(Block* block, std::size_t size, std::size_t alignment)
+	{
+		std::size_t misalignment = block->m_offset % alignment;
+		if (misalignment != 0)
+		{
+			Block* aligned = SplitBlock(block, alignment - misalignment);
+			InsertFreeBlock(block);
+			block = aligned;
+		}
+
+		if (block->m_size > size)
+		{
+			InsertFreeBlock(SplitBlock(block, size));
+		}
+
+		block->m_free = false;
+		block->m_alignment = alignment;
+		block->m_user_data = nullptr;
+
+		m_used_size += block->m_size;
+		m_num_used_blocks++;
+
+		return block;
+	}
+
+	void TLSFAllocator::Free(Block* block)
+	{
+		if (block == nullptr || block->m_free)
+		{
+			return;
+		}
+
+		m_used_size -= block->m_size;
+		m_num_used_blocks--;
+
+		block->m_free = true;
+		block->m_user_data = nullptr;
+		block->m_alignment = 1;
+
+		Block* prev = block->m_prev_physical;
+		if (prev != nullptr && prev->m_free)
+		{
+			RemoveFreeBlock(prev);
+			MergeBlocks(prev, block);
+			block = prev;
+		}
+
+		Block* next = block->m_next_physical;
+		if (next != nullptr && next->m_free)
+		{
+			RemoveFreeBlock(next);
+			MergeBlocks(block, next);
+		}
+
+		InsertFreeBlock(block);
+	}
+
+	bool TLSFAllocator::Resize(std::size_t new_size)
+	{
+		if (new_size == m_size)
+		{
+			return true;
+		}
+
+		if (new_size < GetUsedEnd())
+		{
+			return false;
+		}
+
+		Block* last = m_last_block;
+
+		if (last != nullptr && last->m_free)
+		{
+			RemoveFreeBlock(last);
+
+			if (new_size == last->m_offset)
+			{
+				m_last_block = last->m_prev_physical;
+				if (m_last_block != nullptr)
+				{
+					m_last_block->m_next_physical = nullptr;
+				}
+				else
+				{
+					m_first_block = nullptr;
+				}
+
+				DestroyBlock(last);
+			}
+			else
+			{
+				last->m_size = new_size - last->m_offset;
+				InsertFreeBlock(last);
+			}
+		}
+		else if (new_size > m_size)
+		{
+			Block* tail = CreateBlock();
+			tail->m_offset = m_size;
+			tail->m_size = new_size - m_size;
+			tail->m_prev_physical = last;
+
+			if (last != nullptr)
+			{
+				last->m_next_physical = tail;
+			}
+			else
+			{
+				m_first_block = tail;
+			}
+
+			m_last_block = tail;
+			InsertFreeBlock(tail);
+		}
+
+		m_size = new_size;
+
+		return true;
+	}
+
+	std::size_t TLSFAllocator::GetUsedEnd() const
+	{
+		if (m_last_block == nullptr)
+		{
+			return 0;
+		}
+
+		return m_last_block->m_free ? m_last_block->m_offset : m_last_block->m_offset + m_last_block->m_size;
+	}
+
+	std::size_t TLSFAllocator::GetLargestFreeBlockSize() const
+	{
+		if (m_fl_bitmap == 0)
+		{
+			return 0;
+		}
+
+		// Only the highest non-empty size classes can contain the largest block
+		std::size_t fl = 63 - std::countl_zero(m_fl_bitmap);
+		std::size_t sl = 31 - std::countl_zero(m_sl_bitmap[fl]);
+
+		std::size_t largest = 0;
+		for (Block* block = m_free_lists[fl][sl]; block != nullptr; block = block->m_next_free)
+		{
+			largest = std::max(largest, block->m_size);
+		}
+
+		return largest;
+	}
+
+	float TLSFAllocator::GetFragmentation() const
+	{
+		std::size_t free_size = GetFreeSize();
+		if (free_size == 0)
+		{
+			return 0.f;
+		}
+
+		return 1.f - static_cast<float>(GetLargestFreeBlockSize()) / static_cast<float>(free_size);
+	}
+
+} /* util */
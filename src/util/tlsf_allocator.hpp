@@ -0,0 +1,211 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace util
+{
+
+	//! Two level segregated fit sub-allocator.
+	/*!
+		Manages offsets into a linear range (for example a GPU buffer) without touching the memory itself.
+		Allocating and freeing are O(1): free blocks are kept in size class lists indexed by two bitmaps,
+		and neighbouring free blocks are merged through the physical block list.
+		Alignments don't have to be a power of two, which allows aligning to a vertex stride.
+	*/
+	class TLSFAllocator
+	{
+	public:
+		struct Block
+		{
+			std::size_t m_offset = 0;
+			std::size_t m_size = 0;
+			std::size_t m_alignment = 1;
+
+			Block* m_prev_physical = nullptr;
+			Block* m_next_physical = nullptr;
+			Block* m_prev_free = nullptr;
+			Block* m_next_free = nullptr;
+
+			//! Owner of the allocation, so blocks that get moved can be mapped back to it.
+			void* m_user_data = nullptr;
+
+			bool m_free = true;
+		};
+
+		explicit TLSFAllocator(std::size_t size = 0);
+		~TLSFAllocator() = default;
+
+		TLSFAllocator(TLSFAllocator const &) = delete;
+		TLSFAllocator& operator=(TLSFAllocator const &) = delete;
+
+		//! Returns nullptr if there is no free block that fits.
+		[[nodiscard]] Block* Allocate(std::size_t size, std::size_t alignment = 1);
+		//! Allocates from a specific free block, for callers that care about the position. Returns nullptr if it doesn't fit.
+		[[nodiscard]] Block* AllocateFrom(Block* free_block, std::size_t size, std::size_t alignment = 1);
+		//! Returns whether an allocation of this size and alignment fits in the free block.
+		static bool Fits(Block const* free_block, std::size_t size, std::size_t alignment);
+		void Free(Block* block);
+
+		//! Grows or shrinks the managed range. Fails if allocations live past the new size.
+		bool Resize(std::size_t new_size);
+
+		//! Moves all allocations to the front of the range, leaving one free block at the end.
+		/*!
+			on_move(Block* block, std::size_t old_offset) is called for every block that changed its offset,
+			in ascending order, so moving the data in the same order never overwrites data that still has to move.
+		*/
+		template<typename F>
+		void Compact(F&& on_move);
+
+		Block* GetFirstBlock() const { return m_first_block; }
+		Block* GetLastBlock() const { return m_last_block; }
+
+		std::size_t GetSize() const { return m_size; }
+		std::size_t GetUsedSize() const { return m_used_size; }
+		std::size_t GetFreeSize() const { return m_size - m_used_size; }
+		std::size_t GetNumFreeBlocks() const { return m_num_free_blocks; }
+		std::size_t GetNumUsedBlocks() const { return m_num_used_blocks; }
+		//! End of the last allocation, the range can't shrink below this.
+		std::size_t GetUsedEnd() const;
+		std::size_t GetLargestFreeBlockSize() const;
+		//! 0 when all free space is one block, approaching 1 when it's scattered over many small blocks.
+		float GetFragmentation() const;
+
+	private:
+		static constexpr std::size_t sl_index_count_log2 = 4;
+		static constexpr std::size_t sl_index_count = 1 << sl_index_count_log2;
+		static constexpr std::size_t fl_index_count = 64 - sl_index_count_log2 + 1;
+
+		static void MappingInsert(std::size_t size, std::size_t& fl, std::size_t& sl);
+		static void MappingSearch(std::size_t size, std::size_t& fl, std::size_t& sl);
+
+		Block* FindSuitableBlock(std::size_t size);
+		// Turns a free block that was removed from the free lists into an allocation
+		Block* Carve(Block* block, std::size_t size, std::size_t alignment);
+		void InsertFreeBlock(Block* block);
+		void RemoveFreeBlock(Block* block);
+
+		Block* CreateBlock();
+		void DestroyBlock(Block* block);
+
+		// Splits off the part of the block starting at the given size, returns the new block
+		Block* SplitBlock(Block* block, std::size_t size);
+		// Merges next into block, next is destroyed
+		void MergeBlocks(Block* block, Block* next);
+
+		std::uint64_t m_fl_bitmap = 0;
+		std::uint32_t m_sl_bitmap[fl_index_count] = {};
+		Block* m_free_lists[fl_index_count][sl_index_count] = {};
+
+		Block* m_first_block = nullptr;
+		Block* m_last_block = nullptr;
+
+		std::size_t m_size = 0;
+		std::size_t m_used_size = 0;
+		std::size_t m_num_free_blocks = 0;
+		std::size_t m_num_used_blocks = 0;
+
+		// Block nodes are pooled, so splitting a block doesn't hit the heap
+		static constexpr std::size_t block_chunk_size = 256;
+		std::vector<std::unique_ptr<Block[]>> m_block_chunks;
+		Block* m_unused_blocks = nullptr;
+	};
+
+	template<typename F>
+	void TLSFAllocator::Compact(F&& on_move)
+	{
+		std::fill(&m_free_lists[0][0], &m_free_lists[0][0] + fl_index_count * sl_index_count, nullptr);
+		std::fill(m_sl_bitmap, m_sl_bitmap + fl_index_count, 0u);
+		m_fl_bitmap = 0;
+		m_num_free_blocks = 0;
+
+		Block* block = m_first_block;
+		Block* last_used = nullptr;
+		std::size_t cursor = 0;
+
+		m_first_block = nullptr;
+
+		auto link = [&](Block* b)
+		{
+			b->m_prev_physical = last_used;
+			b->m_next_physical = nullptr;
+			if (last_used != nullptr)
+			{
+				last_used->m_next_physical = b;
+			}
+			else
+			{
+				m_first_block = b;
+			}
+			last_used = b;
+		};
+
+		while (block != nullptr)
+		{
+			Block* next = block->m_next_physical;
+
+			if (block->m_free)
+			{
+				DestroyBlock(block);
+			}
+			else
+			{
+				std::size_t new_offset = ((cursor + block->m_alignment - 1) / block->m_alignment) * block->m_alignment;
+
+				// Alignment padding stays behind as a small free block
+				if (new_offset != cursor)
+				{
+					Block* padding = CreateBlock();
+					padding->m_offset = cursor;
+					padding->m_size = new_offset - cursor;
+					link(padding);
+					InsertFreeBlock(padding);
+				}
+
+				std::size_t old_offset = block->m_offset;
+				block->m_offset = new_offset;
+				link(block);
+
+				if (new_offset != old_offset)
+				{
+					on_move(block, old_offset);
+				}
+
+				cursor = new_offset + block->m_size;
+			}
+
+			block = next;
+		}
+
+		if (cursor < m_size)
+		{
+			Block* tail = CreateBlock();
+			tail->m_offset = cursor;
+			tail->m_size = m_size - cursor;
+			link(tail);
+			InsertFreeBlock(tail);
+		}
+
+		m_last_block = last_used;
+	}
+
+} /* util */
@@ -0,0 +1,158 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstring>
+#include <limits>
+#include <DirectXMath.h>
+
+#include "model_loader.hpp"
+#include "util/aabb.hpp"
+
+namespace wr
+{
+
+	//! Compile time description of a vertex type.
+	/*!
+		The attributes are derived from the members the vertex struct declares, so a new vertex format only needs
+		to use the usual member names (m_pos, m_uv, m_normal, m_tangent, m_bitangent, m_color) to be packed by PackVertices.
+	*/
+	template<typename TV>
+	struct VertexLayout
+	{
+		// 2D positions don't count, they don't contribute to the bounds
+		static constexpr bool has_position = requires(TV v) { requires sizeof(v.m_pos) == 3 * sizeof(float); };
+		static constexpr bool has_uv = requires(TV v) { v.m_uv; };
+		static constexpr bool has_normal = requires(TV v) { v.m_normal; };
+		static constexpr bool has_tangent = requires(TV v) { v.m_tangent; };
+		static constexpr bool has_bitangent = requires(TV v) { v.m_bitangent; };
+		static constexpr bool has_color = requires(TV v) { v.m_color; };
+	};
+
+	namespace internal
+	{
+		//! Source of one attribute, nullptr when the mesh doesn't provide it for every vertex.
+		inline float const * AttributeSource(std::vector<DirectX::XMFLOAT3> const & attribute, std::size_t num_vertices)
+		{
+			return attribute.size() >= num_vertices ? &attribute[0].x : nullptr;
+		}
+
+		//! Copies one attribute with a size known at compile time, so it compiles down to a couple of moves.
+		template<std::size_t N>
+		inline void CopyAttribute(float (&dest)[N], float const * source, std::size_t i)
+		{
+			if (source != nullptr)
+			{
+				std::memcpy(dest, source + i * 3, sizeof(dest));
+			}
+		}
+	}
+
+	//! Interleaves the attribute arrays of a mesh into out_vertices and expands bounds with the positions.
+	/*!
+		One routine is generated per vertex type: attributes the type doesn't declare are compiled out,
+		and the bounds are accumulated with vector min/max in the same pass over the vertices.
+		out_vertices has to hold m_positions.size() zero initialized vertices; attributes the mesh doesn't provide stay zero.
+	*/
+	template<typename TV>
+	void PackVertices(ModelMeshData const & mesh, TV* out_vertices, Box& bounds)
+	{
+		using Layout = VertexLayout<TV>;
+
+		std::size_t const num_vertices = mesh.m_positions.size();
+		if (num_vertices == 0)
+		{
+			return;
+		}
+
+		float const * positions = internal::AttributeSource(mesh.m_positions, num_vertices);
+		float const * uvs = internal::AttributeSource(mesh.m_uvw, num_vertices);
+		float const * normals = internal::AttributeSource(mesh.m_normals, num_vertices);
+		float const * tangents = internal::AttributeSource(mesh.m_tangents, num_vertices);
+		float const * bitangents = internal::AttributeSource(mesh.m_bitangents, num_vertices);
+		float const * colors = internal::AttributeSource(mesh.m_colors, num_vertices);
+
+		DirectX::XMVECTOR min = DirectX::XMVectorReplicate(std::numeric_limits<float>::max());
+		DirectX::XMVECTOR max = DirectX::XMVectorReplicate(-std::numeric_limits<float>::max());
+
+		for (std::size_t i = 0; i < num_vertices; ++i)
+		{
+			TV& vertex = out_vertices[i];
+
+			if constexpr (Layout::has_position)
+			{
+				internal::CopyAttribute(vertex.m_pos, positions, i);
+
+				DirectX::XMVECTOR pos = DirectX::XMLoadFloat3(&mesh.m_positions[i]);
+				min = DirectX::XMVectorMin(min, pos);
+				max = DirectX::XMVectorMax(max, pos);
+			}
+			if constexpr (Layout::has_uv)
+			{
+				internal::CopyAttribute(vertex.m_uv, uvs, i);
+			}
+			if constexpr (Layout::has_normal)
+			{
+				internal::CopyAttribute(vertex.m_normal, normals, i);
+			}
+			if constexpr (Layout::has_tangent)
+			{
+				internal::CopyAttribute(vertex.m_tangent, tangents, i);
+			}
+			if constexpr (Layout::has_bitangent)
+			{
+				internal::CopyAttribute(vertex.m_bitangent, bitangents, i);
+			}
+			if constexpr (Layout::has_color)
+			{
+				internal::CopyAttribute(vertex.m_color, colors, i);
+			}
+		}
+
+		if constexpr (Layout::has_position)
+		{
+			bounds.ExpandFromVector(min);
+			bounds.ExpandFromVector(max);
+		}
+	}
+
+	//! Expands bounds with the positions of already packed vertices.
+	template<typename TV>
+	void ExpandBounds(TV const * vertices, std::size_t num_vertices, Box& bounds)
+	{
+		if constexpr (VertexLayout<TV>::has_position)
+		{
+			if (num_vertices == 0)
+			{
+				return;
+			}
+
+			DirectX::XMVECTOR min = DirectX::XMVectorReplicate(std::numeric_limits<float>::max());
+			DirectX::XMVECTOR max = DirectX::XMVectorReplicate(-std::numeric_limits<float>::max());
+
+			for (std::size_t i = 0; i < num_vertices; ++i)
+			{
+				DirectX::XMVECTOR pos = DirectX::XMLoadFloat3(reinterpret_cast<DirectX::XMFLOAT3 const *>(vertices[i].m_pos));
+				min = DirectX::XMVectorMin(min, pos);
+				max = DirectX::XMVectorMax(max, pos);
+			}
+
+			bounds.ExpandFromVector(min);
+			bounds.ExpandFromVector(max);
+		}
+	}
+
+} /* wr */
@@ -20,6 +20,7 @@
 #include "window.hpp"
 #include "vertex.hpp"
 #include "renderer.hpp"
+#include "animation_system.hpp"
 
 // Scene Graph
 #include "scene_graph/scene_graph.hpp"
@@ -0,0 +1,162 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the world-space AABB kernels in util/aabb.hpp against transforming all corners of the box.
+// Runs without a window or GPU: AABBBenchmark [num_boxes] [iterations]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "util/aabb.hpp"
+
+namespace
+{
+	//What the bounds were computed with before the absolute matrix method: every corner transformed and min/maxed
+	wr::AABB FromCorners(wr::Box const & box, DirectX::XMMATRIX const & transform)
+	{
+		wr::AABB aabb;
+
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			DirectX::XMVECTOR const sign = DirectX::XMVectorSet(corner & 1 ? 1.f : -1.f, corner & 2 ? 1.f : -1.f, corner & 4 ? 1.f : -1.f, 0.f);
+			DirectX::XMVECTOR const position = DirectX::XMVectorMultiplyAdd(box.m_extents, sign, box.m_center);
+			aabb.Expand(DirectX::XMVector3Transform(position, transform));
+		}
+
+		return aabb;
+	}
+
+	bool NearlyEqual(wr::AABB const & a, wr::AABB const & b)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			float const tolerance = 1e-3f * std::max({ 1.f, std::abs(a.m_minf[i]), std::abs(a.m_maxf[i]) });
+
+			if (std::abs(a.m_minf[i] - b.m_minf[i]) > tolerance || std::abs(a.m_maxf[i] - b.m_maxf[i]) > tolerance)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//Sums the bounds so the compiler can't drop the work that's being timed
+	float Checksum(std::vector<wr::AABB> const & aabbs)
+	{
+		float sum = 0.f;
+		for (auto const & aabb : aabbs)
+		{
+			sum += aabb.m_minf[0] + aabb.m_maxf[1];
+		}
+
+		return sum;
+	}
+
+	template<typename F>
+	double NanosecondsPerBox(std::size_t num_boxes, std::size_t iterations, F&& kernel)
+	{
+		auto const start = std::chrono::high_resolution_clock::now();
+
+		for (std::size_t i = 0; i < iterations; ++i)
+		{
+			kernel();
+		}
+
+		std::chrono::duration<double, std::nano> const duration = std::chrono::high_resolution_clock::now() - start;
+		return duration.count() / static_cast<double>(num_boxes * iterations);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::size_t const num_boxes = argc > 1 ? std::stoul(argv[1]) : 100000;
+	std::size_t const iterations = argc > 2 ? std::stoul(argv[2]) : 100;
+
+	//Fixed seed, so runs are comparable
+	std::mt19937 random(1337);
+	std::uniform_real_distribution<float> position(-100.f, 100.f);
+	std::uniform_real_distribution<float> extent(0.01f, 10.f);
+	std::uniform_real_distribution<float> angle(-DirectX::XM_PI, DirectX::XM_PI);
+	std::uniform_real_distribution<float> scale(0.1f, 4.f);
+
+	std::vector<wr::Box> boxes(num_boxes);
+	std::vector<DirectX::XMFLOAT3X4> transforms(num_boxes);
+
+	for (std::size_t i = 0; i < num_boxes; ++i)
+	{
+		boxes[i] = wr::Box(DirectX::XMVectorSet(position(random), position(random), position(random), 0.f), DirectX::XMVectorSet(extent(random), extent(random), extent(random), 0.f));
+
+		DirectX::XMMATRIX const transform = DirectX::XMMatrixScaling(scale(random), scale(random), scale(random))
+			* DirectX::XMMatrixRotationRollPitchYaw(angle(random), angle(random), angle(random))
+			* DirectX::XMMatrixTranslation(position(random), position(random), position(random));
+
+		//Same layout as Node::m_transform
+		DirectX::XMStoreFloat3x4(&transforms[i], transform);
+	}
+
+	std::vector<wr::AABB> corners(num_boxes);
+	std::vector<wr::AABB> single(num_boxes);
+	std::vector<wr::AABB> bulk(num_boxes);
+
+	double const corners_ns = NanosecondsPerBox(num_boxes, iterations, [&]()
+	{
+		for (std::size_t i = 0; i < num_boxes; ++i)
+		{
+			corners[i] = FromCorners(boxes[i], DirectX::XMLoadFloat3x4(&transforms[i]));
+		}
+	});
+
+	double const single_ns = NanosecondsPerBox(num_boxes, iterations, [&]()
+	{
+		for (std::size_t i = 0; i < num_boxes; ++i)
+		{
+			single[i] = wr::AABB::FromTransform(boxes[i], DirectX::XMLoadFloat3x4(&transforms[i]));
+		}
+	});
+
+	double const bulk_ns = NanosecondsPerBox(num_boxes, iterations, [&]()
+	{
+		wr::AABB::FromTransforms(boxes.data(), transforms.data(), bulk.data(), num_boxes);
+	});
+
+	std::size_t mismatches = 0;
+	for (std::size_t i = 0; i < num_boxes; ++i)
+	{
+		if (!NearlyEqual(corners[i], single[i]) || !NearlyEqual(corners[i], bulk[i]))
+		{
+			++mismatches;
+		}
+	}
+
+	std::printf("%zu boxes, %zu iterations (checksum %f)\n", num_boxes, iterations, Checksum(corners) + Checksum(single) + Checksum(bulk));
+	std::printf("  8 corners                %8.2f ns/box\n", corners_ns);
+	std::printf("  AABB::FromTransform      %8.2f ns/box (%.2fx)\n", single_ns, corners_ns / single_ns);
+	std::printf("  AABB::FromTransforms     %8.2f ns/box (%.2fx)\n", bulk_ns, corners_ns / bulk_ns);
+
+	if (mismatches > 0)
+	{
+		std::printf("%zu bounds differ from the corner reference\n", mismatches);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
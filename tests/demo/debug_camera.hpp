@@ -26,14 +26,14 @@ public:
 		: wr::CameraNode(aspect_ratio), m_forward_axis(0), m_right_axis(0), m_up_axis(0), m_rmb_down(false), m_speed(1), m_sensitivity(0.01f), m_position_lerp_speed(10.f), m_rotation_lerp_speed(5.f)
 	{
 		GetCursorPos(&m_last_cursor_pos);
-		m_target_rotation_radians = m_rotation_radians;
-		m_target_position = m_position;
+		m_target_rotation_radians = GetRotationRadians();
+		m_target_position = GetPosition();
 	}
 
 	//Takes roll, pitch and yaw and converts it to quaternion
 	void SetRotation(DirectX::XMVECTOR roll_pitch_yaw) override
 	{
-		m_rotation_radians = roll_pitch_yaw;
+		DirectX::XMStoreFloat3(&m_rotation_radians, roll_pitch_yaw);
 		m_use_quaternion = false;
 		m_target_rotation_radians = roll_pitch_yaw;
 	}
@@ -41,7 +41,7 @@ public:
 	//Sets position
 	void SetPosition(DirectX::XMVECTOR position) override
 	{
-		m_position = position;
+		DirectX::XMStoreFloat3(&m_position, position);
 		m_target_position = position;
 	}
 
@@ -67,9 +67,10 @@ public:
 			m_up_axis = std::min(m_up_axis, 1.f);
 			m_up_axis = std::max(m_up_axis, -1.f);
 
-			DirectX::XMVECTOR forward = DirectX::XMVector3Normalize(m_transform.r[2]);
-			DirectX::XMVECTOR up = DirectX::XMVector3Normalize(m_transform.r[1]);
-			DirectX::XMVECTOR right = DirectX::XMVector3Normalize(m_transform.r[0]);
+			DirectX::XMMATRIX transform = GetTransform();
+			DirectX::XMVECTOR forward = DirectX::XMVector3Normalize(transform.r[2]);
+			DirectX::XMVECTOR up = DirectX::XMVector3Normalize(transform.r[1]);
+			DirectX::XMVECTOR right = DirectX::XMVector3Normalize(transform.r[0]);
 
 			m_target_position = DirectX::XMVectorAdd(m_target_position, DirectX::XMVectorScale(forward, delta * m_speed * m_forward_axis));
 			m_target_position = DirectX::XMVectorAdd(m_target_position, DirectX::XMVectorScale(up, delta * m_speed * m_up_axis));
@@ -86,8 +87,8 @@ public:
 			m_up_axis = 0;
 		}
 
-		m_position = DirectX::XMVectorLerp(m_position, m_target_position, delta * m_position_lerp_speed);
-		SetRotation(DirectX::XMVectorLerp(m_rotation_radians, m_target_rotation_radians, delta * m_rotation_lerp_speed));
+		DirectX::XMStoreFloat3(&m_position, DirectX::XMVectorLerp(GetPosition(), m_target_position, delta * m_position_lerp_speed));
+		SetRotation(DirectX::XMVectorLerp(GetRotationRadians(), m_target_rotation_radians, delta * m_rotation_lerp_speed));
 		SignalTransformChange();
 
 		m_last_cursor_pos = cursor_pos;
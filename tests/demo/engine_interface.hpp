@@ -268,18 +268,18 @@ namespace engine
 			{
 				ImGui::Begin("Camera Settings", &open1);
 
-				auto pos = sg->GetActiveCamera()->m_position;
-				ImGui::DragFloat3("Position", pos.m128_f32, 0.5f);
+				DirectX::XMFLOAT3 pos = sg->GetActiveCamera()->m_position;
+				ImGui::DragFloat3("Position", &pos.x, 0.5f);
 
-				float rot[3] = { DirectX::XMConvertToDegrees(DirectX::XMVectorGetX(sg->GetActiveCamera()->m_rotation_radians)),
-					DirectX::XMConvertToDegrees(DirectX::XMVectorGetY(sg->GetActiveCamera()->m_rotation_radians)),
-					DirectX::XMConvertToDegrees(DirectX::XMVectorGetZ(sg->GetActiveCamera()->m_rotation_radians)) };
+				float rot[3] = { DirectX::XMConvertToDegrees(sg->GetActiveCamera()->m_rotation_radians.x),
+					DirectX::XMConvertToDegrees(sg->GetActiveCamera()->m_rotation_radians.y),
+					DirectX::XMConvertToDegrees(sg->GetActiveCamera()->m_rotation_radians.z) };
 
 				ImGui::DragFloat3("Rotation", rot, 0.01f);
 
 				if (!ImGui::IsMouseDown(1))
 				{
-					sg->GetActiveCamera()->SetPosition(pos);
+					sg->GetActiveCamera()->SetPosition(DirectX::XMLoadFloat3(&pos));
 					sg->GetActiveCamera()->SetRotation(DirectX::XMVectorSet(DirectX::XMConvertToRadians(rot[0]), DirectX::XMConvertToRadians(rot[1]), DirectX::XMConvertToRadians(rot[2]), 0));
 
 					sg->GetActiveCamera()->SignalTransformChange();
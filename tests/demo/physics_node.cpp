@@ -146,7 +146,7 @@ void PhysicsMeshNode::SetPosition(DirectX::XMVECTOR position)
 		world_trans.setOrigin(phys::util::DXV3toBV3(position));
 	}
 
-	m_position = position;
+	DirectX::XMStoreFloat3(&m_position, position);
 	SignalTransformChange();
 }
 
@@ -167,7 +167,7 @@ void PhysicsMeshNode::SetRotation(DirectX::XMVECTOR roll_pitch_yaw)
 		world_trans.setRotation(btQuaternion(quat.m128_f32[0], quat.m128_f32[1], quat.m128_f32[2], quat.m128_f32[3]));
 	}
 
-	m_rotation_radians = roll_pitch_yaw;
+	DirectX::XMStoreFloat3(&m_rotation_radians, roll_pitch_yaw);
 	SignalTransformChange();
 }
 
@@ -185,6 +185,6 @@ void PhysicsMeshNode::SetScale(DirectX::XMVECTOR scale)
 		m_shape->setLocalScaling(phys::util::DXV3toBV3(scale));
 	}
 
-	m_scale = scale;
+	DirectX::XMStoreFloat3(&m_scale, scale);
 	SignalTransformChange();
 }
\ No newline at end of file
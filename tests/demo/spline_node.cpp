@@ -79,8 +79,8 @@ SplineNode::SplineNode(std::string name, bool looping) : Node(typeid(SplineNode)
 			if (ImGui::Button("Add Control Point"))
 			{
 				ControlPoint cp{};
-				cp.m_position = scene_graph->GetActiveCamera()->m_position;
-				cp.m_rotation = scene_graph->GetActiveCamera()->m_rotation_radians;
+				cp.m_position = scene_graph->GetActiveCamera()->GetPosition();
+				cp.m_rotation = scene_graph->GetActiveCamera()->GetRotationRadians();
 
 				spline_node->m_control_points.push_back(cp);
 			}
@@ -99,8 +99,8 @@ SplineNode::SplineNode(std::string name, bool looping) : Node(typeid(SplineNode)
 
 					if (ImGui::Button("Take Camera Transform"))
 					{
-						cp.m_position = scene_graph->GetActiveCamera()->m_position;
-						cp.m_rotation = scene_graph->GetActiveCamera()->m_rotation_radians;
+						cp.m_position = scene_graph->GetActiveCamera()->GetPosition();
+						cp.m_rotation = scene_graph->GetActiveCamera()->GetRotationRadians();
 						
 					}
 
@@ -0,0 +1,253 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks the quality of the block compression encoders: every case is encoded and decoded again, and fails when its PSNR
+// drops below the threshold of its format. The images are synthetic stand-ins for the material textures, so it runs headless.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "util/block_compression.hpp"
+#include "util/thread_pool.hpp"
+#include "unit_test.hpp"
+
+namespace
+{
+	struct TestImage
+	{
+		std::string m_name;
+		std::size_t m_width = 0;
+		std::size_t m_height = 0;
+		std::vector<std::uint8_t> m_rgba;
+	};
+
+	struct TestCase
+	{
+		util::BlockFormat m_format;
+		double m_min_psnr; // In dB, over the channels the format stores
+	};
+
+	util::BlockFormat const all_formats[] = { util::BlockFormat::BC1, util::BlockFormat::BC3, util::BlockFormat::BC4, util::BlockFormat::BC5, util::BlockFormat::BC7 };
+
+	char const * GetFormatName(util::BlockFormat format)
+	{
+		switch (format)
+		{
+		case util::BlockFormat::BC1: return "BC1";
+		case util::BlockFormat::BC3: return "BC3";
+		case util::BlockFormat::BC4: return "BC4";
+		case util::BlockFormat::BC5: return "BC5";
+		case util::BlockFormat::BC7: return "BC7";
+		default: return "?";
+		}
+	}
+
+	std::uint8_t ToUnorm8(float value)
+	{
+		return static_cast<std::uint8_t>(std::lround(std::clamp(value, 0.f, 1.f) * 255.f));
+	}
+
+	template<typename F>
+	TestImage CreateImage(std::string name, std::size_t width, std::size_t height, F&& texel)
+	{
+		TestImage image;
+		image.m_name = std::move(name);
+		image.m_width = width;
+		image.m_height = height;
+		image.m_rgba.resize(width * height * 4);
+
+		for (std::size_t y = 0; y < height; ++y)
+		{
+			for (std::size_t x = 0; x < width; ++x)
+			{
+				texel(static_cast<float>(x), static_cast<float>(y), &image.m_rgba[(y * width + x) * 4]);
+			}
+		}
+
+		return image;
+	}
+
+	//Smooth color ramps, the sizes aren't multiples of 4 so the edge blocks are covered as well
+	TestImage CreateGradient()
+	{
+		return CreateImage("gradient", 250, 198, [](float x, float y, std::uint8_t* texel)
+		{
+			texel[0] = ToUnorm8(x / 250.f);
+			texel[1] = ToUnorm8(y / 198.f);
+			texel[2] = ToUnorm8(1.f - (x + y) / 448.f);
+			texel[3] = 255;
+		});
+	}
+
+	//Low frequency detail with some noise on top, about what photographed albedo looks like
+	TestImage CreateAlbedo(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> noise(-0.03f, 0.03f);
+
+		return CreateImage("albedo", 256, 256, [&](float x, float y, std::uint8_t* texel)
+		{
+			float const pattern = 0.5f + 0.25f * std::sin(x * 0.07f) * std::cos(y * 0.05f) + 0.15f * std::sin((x + y) * 0.21f);
+			texel[0] = ToUnorm8(pattern * 0.9f + noise(random));
+			texel[1] = ToUnorm8(pattern * 0.7f + 0.1f + noise(random));
+			texel[2] = ToUnorm8(pattern * 0.4f + 0.05f + noise(random));
+			texel[3] = 255;
+		});
+	}
+
+	//Albedo with a soft edged cutout in the alpha channel
+	TestImage CreateAlphaCutout(std::mt19937& random)
+	{
+		TestImage image = CreateAlbedo(random);
+		image.m_name = "alpha cutout";
+
+		for (std::size_t y = 0; y < image.m_height; ++y)
+		{
+			for (std::size_t x = 0; x < image.m_width; ++x)
+			{
+				float const distance = std::hypot(static_cast<float>(x) - 128.f, static_cast<float>(y) - 128.f);
+				image.m_rgba[(y * image.m_width + x) * 4 + 3] = ToUnorm8((96.f - distance) / 8.f);
+			}
+		}
+
+		return image;
+	}
+
+	//Tangent space normals of a bumpy height field, packed to [0, 1] like the normal maps the materials use
+	TestImage CreateNormalMap()
+	{
+		return CreateImage("normal map", 256, 256, [](float x, float y, std::uint8_t* texel)
+		{
+			float const dx = 0.6f * std::cos(x * 0.12f) * std::cos(y * 0.09f);
+			float const dy = -0.5f * std::sin(x * 0.12f) * std::sin(y * 0.09f);
+			float const length = std::sqrt(dx * dx + dy * dy + 1.f);
+
+			texel[0] = ToUnorm8(dx / length * 0.5f + 0.5f);
+			texel[1] = ToUnorm8(dy / length * 0.5f + 0.5f);
+			texel[2] = ToUnorm8(1.f / length * 0.5f + 0.5f);
+			texel[3] = 255;
+		});
+	}
+
+	//Single channel data like roughness, metallic and AO
+	TestImage CreateRoughness(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> noise(-0.02f, 0.02f);
+
+		return CreateImage("roughness", 256, 256, [&](float x, float y, std::uint8_t* texel)
+		{
+			float const value = 0.5f + 0.3f * std::sin(x * 0.04f + std::cos(y * 0.06f) * 2.f) + noise(random);
+			texel[0] = texel[1] = texel[2] = ToUnorm8(value);
+			texel[3] = 255;
+		});
+	}
+
+	//Encodes the image on the thread pool and checks it against the threshold and a single threaded encode
+	void RunCase(TestImage const & image, TestCase const & test_case, util::ThreadPool& thread_pool)
+	{
+		std::size_t const block_size = util::GetBlockSize(test_case.m_format);
+		std::size_t const blocks_row_pitch = ((image.m_width + 3) / 4) * block_size;
+		std::size_t const row_pitch = image.m_width * 4;
+
+		std::vector<std::uint8_t> blocks(blocks_row_pitch * ((image.m_height + 3) / 4));
+		util::CompressImage(test_case.m_format, image.m_rgba.data(), image.m_width, image.m_height, row_pitch, blocks.data(), blocks_row_pitch, &thread_pool);
+
+		std::vector<std::uint8_t> single_threaded_blocks(blocks.size());
+		util::CompressImage(test_case.m_format, image.m_rgba.data(), image.m_width, image.m_height, row_pitch, single_threaded_blocks.data(), blocks_row_pitch);
+
+		double const psnr = util::ComputeCompressionPSNR(test_case.m_format, image.m_rgba.data(), image.m_width, image.m_height, row_pitch, blocks.data(), blocks_row_pitch);
+		std::printf("%-32s %-4s %8.2f dB %8.2f dB\n", image.m_name.c_str(), GetFormatName(test_case.m_format), psnr, test_case.m_min_psnr);
+
+		UNIT_CHECK(psnr >= test_case.m_min_psnr);
+		UNIT_CHECK(blocks == single_threaded_blocks);
+	}
+
+	//Uniform blocks decode to their color up to the precision of the endpoints, in the channels a format stores
+	void TestUniformBlocks()
+	{
+		std::uint8_t const colors[][4] = { { 0, 0, 0, 255 }, { 255, 255, 255, 255 }, { 77, 150, 23, 255 }, { 200, 31, 128, 96 } };
+
+		for (auto const & color : colors)
+		{
+			std::uint8_t texels[64];
+			for (std::size_t i = 0; i < 64; ++i)
+			{
+				texels[i] = color[i % 4];
+			}
+
+			for (util::BlockFormat const format : all_formats)
+			{
+				// BC1 only stores opaque texels, BC4 red and BC5 red and green
+				int const num_channels = format == util::BlockFormat::BC4 ? 1 : format == util::BlockFormat::BC5 ? 2 : format == util::BlockFormat::BC1 ? 3 : 4;
+				if (format == util::BlockFormat::BC1 && color[3] != 255)
+				{
+					continue;
+				}
+
+				std::uint8_t block[16];
+				std::uint8_t decoded[64];
+				util::EncodeBlock(format, texels, block);
+				util::DecodeBlock(format, block, decoded);
+
+				// BC1 and BC3 store colors in 5:6:5, BC7 mode 6 in 7 bits with a parity bit shared by the channels. BC4 and BC5 are exact
+				int const tolerance = format == util::BlockFormat::BC1 || format == util::BlockFormat::BC3 ? 4 : format == util::BlockFormat::BC7 ? 1 : 0;
+
+				for (std::size_t i = 0; i < 64; ++i)
+				{
+					if (static_cast<int>(i % 4) < num_channels && !UNIT_CHECK(std::abs(static_cast<int>(decoded[i]) - static_cast<int>(texels[i])) <= tolerance))
+					{
+						std::printf("uniform block (%d, %d, %d, %d) %s decodes channel %zu to %d\n", color[0], color[1], color[2], color[3], GetFormatName(format), i % 4, decoded[i]);
+						break;
+					}
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	//Fixed seed, so runs are comparable
+	std::mt19937 random(1337);
+	util::ThreadPool thread_pool(4);
+
+	TestUniformBlocks();
+
+	std::printf("%-32s %-4s %11s %11s\n", "image", "fmt", "PSNR", "threshold");
+
+	//The synthetic images go through the formats the material slots they stand for use, see ModelPool::LoadMaterials
+	std::vector<std::pair<TestImage, std::vector<TestCase>>> const synthetic =
+	{
+		{ CreateGradient(), { { util::BlockFormat::BC1, 38.0 }, { util::BlockFormat::BC7, 42.0 } } },
+		{ CreateAlbedo(random), { { util::BlockFormat::BC1, 34.0 }, { util::BlockFormat::BC7, 37.0 } } },
+		{ CreateAlphaCutout(random), { { util::BlockFormat::BC3, 34.0 }, { util::BlockFormat::BC7, 35.0 } } },
+		{ CreateNormalMap(), { { util::BlockFormat::BC5, 45.0 } } },
+		{ CreateRoughness(random), { { util::BlockFormat::BC4, 40.0 } } },
+	};
+
+	for (auto const & [image, cases] : synthetic)
+	{
+		for (auto const & test_case : cases)
+		{
+			RunCase(image, test_case, thread_pool);
+		}
+	}
+
+	return unit_test::Finish("BlockCompressionTest");
+}
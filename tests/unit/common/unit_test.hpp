@@ -0,0 +1,70 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+/*!
+	Minimal checks for the unit tests in tests/unit, they run without any test framework.
+	A failed check prints where it failed and makes the test return EXIT_FAILURE from Finish, it doesn't stop the test.
+*/
+namespace unit_test
+{
+
+	inline int& Failures()
+	{
+		static int failures = 0;
+		return failures;
+	}
+
+	inline bool Check(bool condition, char const * expression, char const * file, int line)
+	{
+		if (!condition)
+		{
+			std::printf("%s(%d): check failed: %s\n", file, line, expression);
+			++Failures();
+		}
+
+		return condition;
+	}
+
+	//! Returns the exit code of the test.
+	inline int Finish(char const * name)
+	{
+		if (Failures() > 0)
+		{
+			std::printf("%s: %d check(s) failed\n", name, Failures());
+			return EXIT_FAILURE;
+		}
+
+		std::printf("%s: passed\n", name);
+		return EXIT_SUCCESS;
+	}
+
+	//! Seconds the function takes to run once.
+	template<typename F>
+	double Time(F&& function)
+	{
+		auto const start = std::chrono::high_resolution_clock::now();
+		function();
+		return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+} /* unit_test */
+
+#define UNIT_CHECK(condition) ::unit_test::Check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
@@ -0,0 +1,207 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Sharing of identical content through util::ContentDeduplicator, driven the way ModelPool deduplicates meshes:
+// copy-on-write edits of shared content, hash collisions and the reference counts.
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "util/content_deduplicator.hpp"
+#include "util/content_hash.hpp"
+#include "unit_test.hpp"
+
+namespace
+{
+	using Content = std::vector<float>;
+
+	//Stand-in for the model pool: the content of every "mesh" by id, acquired and edited like ModelPool::AcquireMesh and EditMesh
+	struct TestPool
+	{
+		util::ContentDeduplicator m_deduplicator;
+		std::map<std::uint64_t, Content> m_contents;
+		std::uint64_t m_next_id = 1;
+
+		static std::uint64_t Hash(Content const & content)
+		{
+			return util::HashBytes(content.data(), content.size() * sizeof(float));
+		}
+
+		std::uint64_t Acquire(Content const & content, std::optional<std::uint64_t> forced_hash = std::nullopt, bool deduplicate = true)
+		{
+			std::uint64_t const hash = forced_hash.value_or(Hash(content));
+
+			if (deduplicate)
+			{
+				std::optional<std::uint64_t> existing = m_deduplicator.Acquire(hash, [&](std::uint64_t id)
+				{
+					return m_contents.at(id) == content;
+				});
+
+				if (existing.has_value())
+				{
+					return existing.value();
+				}
+			}
+
+			std::uint64_t const id = m_next_id++;
+			m_contents[id] = content;
+			m_deduplicator.Insert(id, hash, deduplicate);
+			return id;
+		}
+
+		void Release(std::uint64_t id)
+		{
+			if (m_deduplicator.Release(id))
+			{
+				m_deduplicator.Remove(id);
+				m_contents.erase(id);
+			}
+		}
+
+		void Edit(std::uint64_t& id, Content const & content)
+		{
+			if (m_deduplicator.IsShared(id))
+			{
+				std::uint64_t const copy = Acquire(content, std::nullopt, false);
+				UNIT_CHECK(!m_deduplicator.Release(id));
+				id = copy;
+			}
+			else
+			{
+				m_deduplicator.Forget(id);
+				m_contents[id] = content;
+			}
+		}
+	};
+
+	void TestSharing()
+	{
+		TestPool pool;
+
+		std::uint64_t const a = pool.Acquire({ 1.f, 2.f, 3.f });
+		std::uint64_t const b = pool.Acquire({ 1.f, 2.f, 3.f });
+		std::uint64_t const c = pool.Acquire({ 1.f, 2.f, 4.f });
+
+		UNIT_CHECK(a == b);
+		UNIT_CHECK(a != c);
+		UNIT_CHECK(pool.m_deduplicator.GetRefCount(a) == 2);
+		UNIT_CHECK(pool.m_deduplicator.IsShared(a));
+		UNIT_CHECK(!pool.m_deduplicator.IsShared(c));
+
+		// Content acquired without deduplication is never shared
+		std::uint64_t const d = pool.Acquire({ 1.f, 2.f, 4.f }, std::nullopt, false);
+		UNIT_CHECK(d != c);
+		UNIT_CHECK(pool.Acquire({ 1.f, 2.f, 4.f }) == c);
+
+		// The last release destroys the content, after that the same content is new again
+		pool.Release(a);
+		UNIT_CHECK(pool.m_contents.count(a) == 1);
+		pool.Release(b);
+		UNIT_CHECK(pool.m_contents.count(a) == 0);
+		UNIT_CHECK(pool.m_deduplicator.GetRefCount(a) == 0);
+
+		std::uint64_t const e = pool.Acquire({ 1.f, 2.f, 3.f });
+		UNIT_CHECK(e != a);
+		UNIT_CHECK(pool.m_deduplicator.GetRefCount(e) == 1);
+	}
+
+	void TestCopyOnWrite()
+	{
+		TestPool pool;
+
+		Content const original = { 0.f, 1.f, 2.f, 3.f };
+		Content const edited = { 0.f, 1.f, 2.f, 5.f };
+
+		std::uint64_t first = pool.Acquire(original);
+		std::uint64_t second = pool.Acquire(original);
+		UNIT_CHECK(first == second);
+
+		// Editing one of two deduplicated meshes detaches it, the other keeps the original data
+		std::uint64_t const shared = second;
+		pool.Edit(second, edited);
+
+		UNIT_CHECK(second != first);
+		UNIT_CHECK(first == shared);
+		UNIT_CHECK(pool.m_contents.at(first) == original);
+		UNIT_CHECK(pool.m_contents.at(second) == edited);
+		UNIT_CHECK(pool.m_deduplicator.GetRefCount(first) == 1);
+		UNIT_CHECK(pool.m_deduplicator.GetRefCount(second) == 1);
+
+		// New loads of the original still share the untouched mesh, the edited copy isn't offered
+		UNIT_CHECK(pool.Acquire(original) == first);
+		UNIT_CHECK(pool.Acquire(edited) != second);
+
+		// An edit of content that isn't shared happens in place, and the old content can't be found anymore
+		TestPool single;
+		std::uint64_t only = single.Acquire(original);
+		std::uint64_t const before = only;
+		single.Edit(only, edited);
+		UNIT_CHECK(only == before);
+		UNIT_CHECK(single.m_contents.at(only) == edited);
+		UNIT_CHECK(single.Acquire(original) != only);
+		UNIT_CHECK(single.m_deduplicator.GetRefCount(only) == 1);
+	}
+
+	void TestHashCollision()
+	{
+		TestPool pool;
+
+		// Two different meshes that end up with the same hash
+		std::uint64_t const hash = 0x1234;
+		Content const a = { 1.f, 2.f, 3.f };
+		Content const b = { 4.f, 5.f, 6.f };
+
+		std::uint64_t const id_a = pool.Acquire(a, hash);
+		std::uint64_t const id_b = pool.Acquire(b, hash);
+
+		UNIT_CHECK(id_a != id_b);
+		UNIT_CHECK(pool.m_contents.at(id_a) == a);
+		UNIT_CHECK(pool.m_contents.at(id_b) == b);
+		UNIT_CHECK(pool.m_deduplicator.GetRefCount(id_a) == 1);
+		UNIT_CHECK(pool.m_deduplicator.GetRefCount(id_b) == 1);
+
+		// The hash keeps pointing at the first one, so only that one is shared
+		UNIT_CHECK(pool.Acquire(a, hash) == id_a);
+		std::uint64_t const id_b2 = pool.Acquire(b, hash);
+		UNIT_CHECK(id_b2 != id_a && id_b2 != id_b);
+
+		// Releasing the colliding mesh doesn't disturb the one the hash points at
+		pool.Release(id_b);
+		UNIT_CHECK(pool.Acquire(a, hash) == id_a);
+		UNIT_CHECK(pool.m_deduplicator.GetRefCount(id_a) == 3);
+
+		// Once the first one is gone the hash is free for the next mesh with it
+		pool.Release(id_a);
+		pool.Release(id_a);
+		pool.Release(id_a);
+		UNIT_CHECK(pool.m_contents.count(id_a) == 0);
+
+		std::uint64_t const id_c = pool.Acquire(b, hash);
+		UNIT_CHECK(pool.Acquire(b, hash) == id_c);
+	}
+}
+
+int main()
+{
+	TestSharing();
+	TestCopyOnWrite();
+	TestHashCollision();
+
+	return unit_test::Finish("ContentDeduplicatorTest");
+}
@@ -0,0 +1,257 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The mesh optimization pass of the model pool (vertex cache, overdraw and vertex fetch ordering) on synthetic meshes.
+// Checks that the triangles survive, that the vertex fetch remap is a permutation of the referenced vertices and
+// that the ACMR never gets worse than the input's, and prints the ACMR, ATVR and time of every step.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "settings.hpp"
+#include "util/mesh_optimizer.hpp"
+#include "unit_test.hpp"
+
+namespace
+{
+	using Triangle = std::array<std::uint32_t, 3>;
+
+	struct TestMesh
+	{
+		std::string m_name;
+		std::vector<float> m_positions; // float3s
+		std::vector<std::uint32_t> m_indices;
+
+		std::size_t NumVertices() const { return m_positions.size() / 3; }
+	};
+
+	//Loaders hand out triangles in whatever order the file has them, shuffling models the worst case of that
+	void ShuffleTriangles(std::vector<std::uint32_t>& indices, std::mt19937& random)
+	{
+		std::size_t const num_triangles = indices.size() / 3;
+		for (std::size_t i = num_triangles; i > 1; --i)
+		{
+			std::size_t const j = std::uniform_int_distribution<std::size_t>(0, i - 1)(random);
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				std::swap(indices[(i - 1) * 3 + k], indices[j * 3 + k]);
+			}
+		}
+	}
+
+	TestMesh CreateGrid(std::uint32_t size)
+	{
+		TestMesh mesh;
+		mesh.m_name = "grid " + std::to_string(size) + "x" + std::to_string(size);
+
+		for (std::uint32_t y = 0; y <= size; ++y)
+		{
+			for (std::uint32_t x = 0; x <= size; ++x)
+			{
+				mesh.m_positions.insert(mesh.m_positions.end(), { static_cast<float>(x), 0.f, static_cast<float>(y) });
+			}
+		}
+
+		for (std::uint32_t y = 0; y < size; ++y)
+		{
+			for (std::uint32_t x = 0; x < size; ++x)
+			{
+				std::uint32_t const i = y * (size + 1) + x;
+				mesh.m_indices.insert(mesh.m_indices.end(), { i, i + size + 1, i + 1, i + 1, i + size + 1, i + size + 2 });
+			}
+		}
+
+		return mesh;
+	}
+
+	TestMesh CreateSphere(std::uint32_t rings, std::uint32_t segments)
+	{
+		constexpr float pi = 3.14159265358979f;
+
+		TestMesh mesh;
+		mesh.m_name = "sphere " + std::to_string(rings) + "x" + std::to_string(segments);
+
+		for (std::uint32_t ring = 0; ring <= rings; ++ring)
+		{
+			float const theta = pi * static_cast<float>(ring) / static_cast<float>(rings);
+			for (std::uint32_t segment = 0; segment <= segments; ++segment)
+			{
+				float const phi = 2.f * pi * static_cast<float>(segment) / static_cast<float>(segments);
+				mesh.m_positions.insert(mesh.m_positions.end(), { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) });
+			}
+		}
+
+		for (std::uint32_t ring = 0; ring < rings; ++ring)
+		{
+			for (std::uint32_t segment = 0; segment < segments; ++segment)
+			{
+				std::uint32_t const i = ring * (segments + 1) + segment;
+				mesh.m_indices.insert(mesh.m_indices.end(), { i, i + 1, i + segments + 1, i + 1, i + segments + 2, i + segments + 1 });
+			}
+		}
+
+		return mesh;
+	}
+
+	//The triangles mapped back to the original vertices and rotated to start at the smallest index, so the winding is kept
+	std::vector<Triangle> SortedTriangles(std::vector<std::uint32_t> const & indices, std::vector<std::uint32_t> const & to_original)
+	{
+		std::vector<Triangle> triangles;
+		triangles.reserve(indices.size() / 3);
+
+		for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			Triangle triangle = { to_original[indices[i]], to_original[indices[i + 1]], to_original[indices[i + 2]] };
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back(triangle);
+		}
+
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	//Runs the same steps as ModelPool::OptimizeIndices and checks the result
+	void TestOptimize(TestMesh const & mesh)
+	{
+		std::vector<std::uint32_t> indices = mesh.m_indices;
+		std::size_t const num_vertices = mesh.NumVertices();
+
+		util::VertexCacheStatistics const before = util::AnalyzeVertexCache(indices.data(), indices.size(), num_vertices);
+
+		double const vertex_cache_time = unit_test::Time([&]()
+		{
+			util::OptimizeVertexCache(indices.data(), indices.size(), num_vertices);
+		});
+
+		double const overdraw_time = unit_test::Time([&]()
+		{
+			util::OptimizeOverdraw(indices.data(), indices.size(), mesh.m_positions.data(), 3 * sizeof(float), num_vertices, wr::settings::mesh_overdraw_threshold);
+		});
+
+		std::vector<std::uint32_t> remap;
+		std::size_t num_unique_vertices = 0;
+		double const vertex_fetch_time = unit_test::Time([&]()
+		{
+			num_unique_vertices = util::OptimizeVertexFetchRemap(indices.data(), indices.size(), num_vertices, remap);
+		});
+
+		util::VertexCacheStatistics const after = util::AnalyzeVertexCache(indices.data(), indices.size(), num_unique_vertices);
+
+		std::printf("%-24s %8zu triangles  ACMR %5.3f -> %5.3f  ATVR %5.3f -> %5.3f  cache %7.2f ms  overdraw %7.2f ms  fetch %7.2f ms\n",
+			mesh.m_name.c_str(), mesh.m_indices.size() / 3, before.m_acmr, after.m_acmr, before.m_atvr, after.m_atvr,
+			vertex_cache_time * 1000.0, overdraw_time * 1000.0, vertex_fetch_time * 1000.0);
+
+		UNIT_CHECK(after.m_acmr <= before.m_acmr);
+
+		// The remap has to be a permutation of the referenced vertices: every one gets its own slot in [0, num_unique_vertices)
+		std::vector<bool> referenced(num_vertices, false);
+		for (std::uint32_t index : mesh.m_indices)
+		{
+			referenced[index] = true;
+		}
+
+		UNIT_CHECK(remap.size() == num_vertices);
+		UNIT_CHECK(num_unique_vertices == static_cast<std::size_t>(std::count(referenced.begin(), referenced.end(), true)));
+		if (remap.size() != num_vertices)
+		{
+			return;
+		}
+
+		std::vector<std::uint32_t> to_original(num_unique_vertices, ~0u);
+		bool permutation = true;
+		for (std::uint32_t i = 0; i < num_vertices; ++i)
+		{
+			if (!referenced[i])
+			{
+				permutation &= remap[i] == ~0u;
+				continue;
+			}
+
+			if (remap[i] >= num_unique_vertices || to_original[remap[i]] != ~0u)
+			{
+				permutation = false;
+				continue;
+			}
+
+			to_original[remap[i]] = i;
+		}
+		UNIT_CHECK(permutation);
+		if (!permutation)
+		{
+			return;
+		}
+
+		UNIT_CHECK(std::all_of(indices.begin(), indices.end(), [&](std::uint32_t index) { return index < num_unique_vertices; }));
+
+		// Fetch order: the first reference to every vertex is in increasing order
+		std::uint32_t next_vertex = 0;
+		bool fetch_order = true;
+		for (std::uint32_t index : indices)
+		{
+			if (index == next_vertex)
+			{
+				++next_vertex;
+			}
+			else
+			{
+				fetch_order &= index < next_vertex;
+			}
+		}
+		UNIT_CHECK(fetch_order);
+
+		std::vector<std::uint32_t> identity(num_vertices);
+		for (std::uint32_t i = 0; i < num_vertices; ++i)
+		{
+			identity[i] = i;
+		}
+		UNIT_CHECK(SortedTriangles(indices, to_original) == SortedTriangles(mesh.m_indices, identity));
+	}
+}
+
+int main()
+{
+	//Fixed seed, so runs are comparable
+	std::mt19937 random(1337);
+
+	// Already in a cache friendly order, the passes must not make it worse
+	TestOptimize(CreateGrid(64));
+
+	TestMesh grid = CreateGrid(256);
+	grid.m_name += " shuffled";
+	ShuffleTriangles(grid.m_indices, random);
+	TestOptimize(grid);
+
+	TestMesh sphere = CreateSphere(192, 384);
+	sphere.m_name += " shuffled";
+	ShuffleTriangles(sphere.m_indices, random);
+	TestOptimize(sphere);
+
+	// Vertices that no triangle references are dropped by the remap
+	TestMesh sparse = CreateGrid(16);
+	sparse.m_name = "grid 16x16 sparse";
+	sparse.m_indices.resize(sparse.m_indices.size() / 2);
+	ShuffleTriangles(sparse.m_indices, random);
+	TestOptimize(sparse);
+
+	return unit_test::Finish("MeshOptimizerTest");
+}
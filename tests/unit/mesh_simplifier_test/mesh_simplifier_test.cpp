@@ -0,0 +1,213 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Edge collapse simplification by util::SimplifyMesh: the triangle count goes down, the indices stay valid and
+// the reported error grows with the amount of simplification, both for one target at a time and along a LOD chain.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "settings.hpp"
+#include "util/mesh_simplifier.hpp"
+#include "unit_test.hpp"
+
+namespace
+{
+	struct TestMesh
+	{
+		std::vector<float> m_positions; // float3s
+		std::vector<std::uint32_t> m_indices;
+
+		std::size_t NumVertices() const { return m_positions.size() / 3; }
+	};
+
+	TestMesh CreateGrid(std::uint32_t size)
+	{
+		TestMesh mesh;
+		for (std::uint32_t y = 0; y <= size; ++y)
+		{
+			for (std::uint32_t x = 0; x <= size; ++x)
+			{
+				mesh.m_positions.insert(mesh.m_positions.end(), { static_cast<float>(x), 0.f, static_cast<float>(y) });
+			}
+		}
+
+		for (std::uint32_t y = 0; y < size; ++y)
+		{
+			for (std::uint32_t x = 0; x < size; ++x)
+			{
+				std::uint32_t const i = y * (size + 1) + x;
+				mesh.m_indices.insert(mesh.m_indices.end(), { i, i + size + 1, i + 1, i + 1, i + size + 1, i + size + 2 });
+			}
+		}
+
+		return mesh;
+	}
+
+	TestMesh CreateSphere(std::uint32_t rings, std::uint32_t segments)
+	{
+		constexpr float pi = 3.14159265358979f;
+
+		TestMesh mesh;
+		for (std::uint32_t ring = 0; ring <= rings; ++ring)
+		{
+			float const theta = pi * static_cast<float>(ring) / static_cast<float>(rings);
+			for (std::uint32_t segment = 0; segment <= segments; ++segment)
+			{
+				float const phi = 2.f * pi * static_cast<float>(segment) / static_cast<float>(segments);
+				mesh.m_positions.insert(mesh.m_positions.end(), { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) });
+			}
+		}
+
+		for (std::uint32_t ring = 0; ring < rings; ++ring)
+		{
+			for (std::uint32_t segment = 0; segment < segments; ++segment)
+			{
+				std::uint32_t const i = ring * (segments + 1) + segment;
+				mesh.m_indices.insert(mesh.m_indices.end(), { i, i + 1, i + segments + 1, i + 1, i + segments + 2, i + segments + 1 });
+			}
+		}
+
+		return mesh;
+	}
+
+	//Indices in range and no triangle that collapsed to a line or a point
+	bool ValidIndices(std::vector<std::uint32_t> const & indices, std::size_t num_vertices)
+	{
+		if (indices.size() % 3 != 0)
+		{
+			return false;
+		}
+
+		for (std::size_t i = 0; i < indices.size(); i += 3)
+		{
+			std::uint32_t const a = indices[i];
+			std::uint32_t const b = indices[i + 1];
+			std::uint32_t const c = indices[i + 2];
+
+			if (a >= num_vertices || b >= num_vertices || c >= num_vertices || a == b || b == c || a == c)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	std::vector<std::uint32_t> Simplify(TestMesh const & mesh, std::vector<std::uint32_t> const & indices, std::size_t target_index_count, float target_error, float& out_error)
+	{
+		std::vector<std::uint32_t> result(indices.size());
+		std::size_t const count = util::SimplifyMesh(result.data(), indices.data(), indices.size(), mesh.m_positions.data(), 3 * sizeof(float), mesh.NumVertices(),
+			target_index_count, target_error, &out_error);
+
+		UNIT_CHECK(count <= indices.size());
+		result.resize(count);
+		return result;
+	}
+
+	//Simplifies the original mesh to smaller and smaller targets, the error may only grow
+	void TestTargets(TestMesh const & mesh, char const * name)
+	{
+		std::size_t previous_count = mesh.m_indices.size();
+		float previous_error = 0.f;
+
+		for (float ratio : { 0.5f, 0.25f, 0.125f, 0.0625f })
+		{
+			std::size_t const target_count = static_cast<std::size_t>(static_cast<float>(mesh.m_indices.size() / 3) * ratio) * 3;
+
+			float error = -1.f;
+			std::vector<std::uint32_t> const simplified = Simplify(mesh, mesh.m_indices, target_count, 1.f, error);
+
+			std::printf("%s: target %zu triangles -> %zu triangles, error %.6f\n", name, target_count / 3, simplified.size() / 3, error);
+
+			UNIT_CHECK(!simplified.empty());
+			UNIT_CHECK(simplified.size() < previous_count);
+			UNIT_CHECK(ValidIndices(simplified, mesh.NumVertices()));
+			UNIT_CHECK(error >= previous_error);
+
+			previous_count = simplified.size();
+			previous_error = error;
+		}
+	}
+
+	//The LOD chain of ModelPool::GenerateLODs: every LOD is simplified from the previous one within the remaining error,
+	//and stores the sum of the errors along the chain
+	void TestChain(TestMesh const & mesh, char const * name)
+	{
+		std::vector<std::uint32_t> source = mesh.m_indices;
+		float relative_error = 0.f;
+		std::vector<float> lod_errors;
+
+		for (unsigned int i = 0; i < 4; ++i)
+		{
+			std::size_t const target_count = static_cast<std::size_t>(static_cast<float>(source.size() / 3) * wr::settings::lod_triangle_ratio) * 3;
+			float const target_error = wr::settings::lod_max_error - relative_error;
+
+			float error = -1.f;
+			std::vector<std::uint32_t> simplified = Simplify(mesh, source, target_count, target_error, error);
+
+			std::printf("%s: LOD %u %zu -> %zu triangles, error %.6f\n", name, i + 1, source.size() / 3, simplified.size() / 3, error);
+
+			UNIT_CHECK(ValidIndices(simplified, mesh.NumVertices()));
+			UNIT_CHECK(error >= 0.f && error <= target_error);
+			if (simplified.empty() || simplified.size() == source.size())
+			{
+				break;
+			}
+
+			UNIT_CHECK(simplified.size() < source.size());
+
+			relative_error += error;
+			lod_errors.push_back(relative_error);
+			source = std::move(simplified);
+		}
+
+		UNIT_CHECK(!lod_errors.empty());
+		for (std::size_t i = 1; i < lod_errors.size(); ++i)
+		{
+			UNIT_CHECK(lod_errors[i] >= lod_errors[i - 1]);
+		}
+		UNIT_CHECK(relative_error <= wr::settings::lod_max_error);
+	}
+}
+
+int main()
+{
+	// Flat, only the border can limit it and collapsing inside the plane costs nothing
+	TestMesh const grid = CreateGrid(64);
+	TestTargets(grid, "grid");
+	TestChain(grid, "grid");
+
+	float error = -1.f;
+	std::vector<std::uint32_t> const flat = Simplify(grid, grid.m_indices, grid.m_indices.size() / 4, 1.f, error);
+	UNIT_CHECK(flat.size() <= grid.m_indices.size() / 4);
+	UNIT_CHECK(error < 1e-4f);
+
+	// Curved everywhere, so every collapse adds error
+	TestMesh const sphere = CreateSphere(64, 128);
+	TestTargets(sphere, "sphere");
+	TestChain(sphere, "sphere");
+
+	// A target that is already met leaves the mesh alone
+	std::vector<std::uint32_t> const unchanged = Simplify(sphere, sphere.m_indices, sphere.m_indices.size(), 1.f, error);
+	UNIT_CHECK(unchanged == sphere.m_indices);
+	UNIT_CHECK(error == 0.f);
+
+	return unit_test::Finish("MeshSimplifierTest");
+}
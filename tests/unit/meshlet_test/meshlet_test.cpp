@@ -0,0 +1,172 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Splitting of index buffers into meshlets by util::BuildMeshlets: the vertex and triangle limits, coverage of
+// every triangle, the bounding spheres and the conservativeness of the backface cones.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "settings.hpp"
+#include "util/meshlet.hpp"
+#include "util/mesh_optimizer.hpp"
+#include "unit_test.hpp"
+
+namespace
+{
+	struct TestMesh
+	{
+		std::vector<float> m_positions; // float3s
+		std::vector<std::uint32_t> m_indices;
+
+		std::size_t NumVertices() const { return m_positions.size() / 3; }
+		float const * Position(std::uint32_t v) const { return &m_positions[v * 3]; }
+	};
+
+	TestMesh CreateSphere(std::uint32_t rings, std::uint32_t segments)
+	{
+		constexpr float pi = 3.14159265358979f;
+
+		TestMesh mesh;
+		for (std::uint32_t ring = 0; ring <= rings; ++ring)
+		{
+			float const theta = pi * static_cast<float>(ring) / static_cast<float>(rings);
+			for (std::uint32_t segment = 0; segment <= segments; ++segment)
+			{
+				float const phi = 2.f * pi * static_cast<float>(segment) / static_cast<float>(segments);
+				mesh.m_positions.insert(mesh.m_positions.end(), { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) });
+			}
+		}
+
+		for (std::uint32_t ring = 0; ring < rings; ++ring)
+		{
+			for (std::uint32_t segment = 0; segment < segments; ++segment)
+			{
+				std::uint32_t const i = ring * (segments + 1) + segment;
+				mesh.m_indices.insert(mesh.m_indices.end(), { i, i + 1, i + segments + 1, i + 1, i + segments + 2, i + segments + 1 });
+			}
+		}
+
+		return mesh;
+	}
+
+	float Dot(float const * a, float const * b)
+	{
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	//Whether the triangle faces away from a viewer at position, with the same winding as the meshlet cones
+	bool TriangleBackfacing(TestMesh const & mesh, std::uint32_t const * triangle, float const (&position)[3])
+	{
+		float const * a = mesh.Position(triangle[0]);
+		float const * b = mesh.Position(triangle[1]);
+		float const * c = mesh.Position(triangle[2]);
+
+		float const e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		float const e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		float const n[3] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+		float const view[3] = { a[0] - position[0], a[1] - position[1], a[2] - position[2] };
+
+		return Dot(view, n) >= -1e-6f;
+	}
+
+	void TestMeshlets(TestMesh const & mesh, std::uint32_t max_vertices, std::uint32_t max_triangles)
+	{
+		std::vector<util::Meshlet> const meshlets = util::BuildMeshlets(mesh.m_indices.data(), mesh.m_indices.size(),
+			mesh.m_positions.data(), 3 * sizeof(float), mesh.NumVertices(), max_vertices, max_triangles);
+
+		UNIT_CHECK(!meshlets.empty());
+
+		// The meshlets are contiguous ranges that follow each other, so every triangle is in exactly one of them
+		std::uint32_t next_index = 0;
+		bool limits = true;
+		bool vertex_counts = true;
+		bool bounds = true;
+
+		for (util::Meshlet const & meshlet : meshlets)
+		{
+			UNIT_CHECK(meshlet.m_index_offset == next_index);
+			UNIT_CHECK(meshlet.m_index_count > 0 && meshlet.m_index_count % 3 == 0);
+			next_index = meshlet.m_index_offset + meshlet.m_index_count;
+
+			std::set<std::uint32_t> vertices(mesh.m_indices.begin() + meshlet.m_index_offset, mesh.m_indices.begin() + next_index);
+			limits &= vertices.size() <= max_vertices && meshlet.m_index_count / 3 <= max_triangles;
+			vertex_counts &= vertices.size() == meshlet.m_vertex_count;
+
+			for (std::uint32_t v : vertices)
+			{
+				float const * p = mesh.Position(v);
+				float const d[3] = { p[0] - meshlet.m_center[0], p[1] - meshlet.m_center[1], p[2] - meshlet.m_center[2] };
+				bounds &= std::sqrt(Dot(d, d)) <= meshlet.m_radius * 1.0001f + 1e-6f;
+			}
+		}
+
+		UNIT_CHECK(next_index == mesh.m_indices.size());
+		UNIT_CHECK(limits);
+		UNIT_CHECK(vertex_counts);
+		UNIT_CHECK(bounds);
+
+		// A meshlet may only be culled as backfacing when every one of its triangles faces away
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> distribution(-4.f, 4.f);
+		bool conservative = true;
+		std::size_t culled = 0;
+
+		for (std::size_t i = 0; i < 64; ++i)
+		{
+			float const position[3] = { distribution(random), distribution(random), distribution(random) };
+			for (util::Meshlet const & meshlet : meshlets)
+			{
+				if (!util::MeshletBackfacing(meshlet, position))
+				{
+					continue;
+				}
+
+				++culled;
+				for (std::uint32_t t = 0; t < meshlet.m_index_count; t += 3)
+				{
+					conservative &= TriangleBackfacing(mesh, &mesh.m_indices[meshlet.m_index_offset + t], position);
+				}
+			}
+		}
+
+		UNIT_CHECK(conservative);
+		// From outside a closed sphere roughly half of it faces away, the cones should catch some of that
+		UNIT_CHECK(culled > 0);
+	}
+}
+
+int main()
+{
+	TestMesh sphere = CreateSphere(48, 96);
+
+	// Index buffer order: rows of the sphere
+	TestMeshlets(sphere, wr::settings::meshlet_max_vertices, wr::settings::meshlet_max_triangles);
+
+	// Optimized like ModelPool does before building meshlets: compact clusters
+	util::OptimizeVertexCache(sphere.m_indices.data(), sphere.m_indices.size(), sphere.NumVertices());
+	TestMeshlets(sphere, wr::settings::meshlet_max_vertices, wr::settings::meshlet_max_triangles);
+
+	// Small limits, so both limits are hit many times
+	TestMeshlets(sphere, 8, 4);
+	TestMeshlets(sphere, 3, 1);
+
+	return unit_test::Finish("MeshletTest");
+}
@@ -0,0 +1,168 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Mip counts and sizes of util::GenerateMipChain, and that sRGB images are filtered in linear space while alpha and
+// data images aren't.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "util/mip_generation.hpp"
+#include "util/thread_pool.hpp"
+#include "unit_test.hpp"
+
+namespace
+{
+	//A full RGBA8 mip chain, level 0 is filled by the caller
+	struct MipChain
+	{
+		std::vector<std::vector<std::uint8_t>> m_data;
+		std::vector<util::MipLevel> m_levels;
+
+		MipChain(std::size_t width, std::size_t height)
+		{
+			std::size_t const num_levels = util::GetMipCount(width, height);
+
+			m_data.resize(num_levels);
+			for (std::size_t i = 0; i < num_levels; ++i)
+			{
+				m_data[i].resize(width * height * 4);
+				m_levels.push_back({ m_data[i].data(), width, height, width * 4 });
+
+				width = std::max<std::size_t>(1, width / 2);
+				height = std::max<std::size_t>(1, height / 2);
+			}
+		}
+
+		void Generate(util::MipChainDesc const & desc, util::ThreadPool* thread_pool = nullptr)
+		{
+			util::GenerateMipChain(desc, m_levels.data(), m_levels.size(), thread_pool);
+		}
+
+		std::uint8_t* Texel(std::size_t level, std::size_t x, std::size_t y)
+		{
+			return &m_data[level][y * m_levels[level].m_row_pitch + x * 4];
+		}
+	};
+
+	void TestMipCount()
+	{
+		UNIT_CHECK(util::GetMipCount(1, 1) == 1);
+		UNIT_CHECK(util::GetMipCount(2, 1) == 2);
+		UNIT_CHECK(util::GetMipCount(256, 256) == 9);
+		UNIT_CHECK(util::GetMipCount(256, 20) == 9);
+		UNIT_CHECK(util::GetMipCount(20, 256) == 9);
+		UNIT_CHECK(util::GetMipCount(255, 1) == 8);
+		UNIT_CHECK(util::GetMipCount(37, 20) == 6);
+		UNIT_CHECK(util::GetMipCount(4096, 2048) == 13);
+
+		// The chain ends at 1x1, like D3D12 mips
+		MipChain chain(37, 20);
+		UNIT_CHECK(chain.m_levels.back().m_width == 1);
+		UNIT_CHECK(chain.m_levels.back().m_height == 1);
+	}
+
+	//A constant image stays the same in every mip, with both filters and for non power of two sizes
+	void TestConstantImage()
+	{
+		for (util::MipFilter const filter : { util::MipFilter::BOX, util::MipFilter::KAISER })
+		{
+			for (bool const srgb : { false, true })
+			{
+				MipChain chain(37, 20);
+				std::fill(chain.m_data[0].begin(), chain.m_data[0].end(), std::uint8_t(200));
+
+				util::MipChainDesc desc;
+				desc.m_filter = filter;
+				desc.m_srgb = srgb;
+				chain.Generate(desc);
+
+				for (std::size_t level = 1; level < chain.m_levels.size(); ++level)
+				{
+					UNIT_CHECK(std::all_of(chain.m_data[level].begin(), chain.m_data[level].end(), [](std::uint8_t value) { return value == 200; }));
+				}
+			}
+		}
+	}
+
+	//A black and white checkerboard averages to half the light: 188 in sRGB, 128 when the image isn't sRGB. Alpha is always linear
+	void TestSRGB()
+	{
+		for (bool const srgb : { false, true })
+		{
+			MipChain chain(64, 64);
+			for (std::size_t y = 0; y < 64; ++y)
+			{
+				for (std::size_t x = 0; x < 64; ++x)
+				{
+					std::uint8_t const value = (x + y) % 2 ? 255 : 0;
+					std::uint8_t* texel = chain.Texel(0, x, y);
+					texel[0] = texel[1] = texel[2] = texel[3] = value;
+				}
+			}
+
+			util::MipChainDesc desc;
+			desc.m_filter = util::MipFilter::BOX;
+			desc.m_srgb = srgb;
+			chain.Generate(desc);
+
+			int const expected_color = srgb ? 188 : 128;
+
+			for (std::size_t level = 1; level < chain.m_levels.size(); ++level)
+			{
+				std::uint8_t const * texel = chain.Texel(level, 0, 0);
+				UNIT_CHECK(std::abs(texel[0] - expected_color) <= 1);
+				UNIT_CHECK(texel[0] == texel[1] && texel[1] == texel[2]);
+				UNIT_CHECK(std::abs(texel[3] - 128) <= 1);
+			}
+		}
+	}
+
+	//The rows filtered on a thread pool give the same mips as a single threaded run
+	void TestThreadPool()
+	{
+		MipChain single_threaded(250, 198);
+		for (std::size_t i = 0; i < single_threaded.m_data[0].size(); ++i)
+		{
+			single_threaded.m_data[0][i] = static_cast<std::uint8_t>((i * 2654435761u) >> 24);
+		}
+
+		MipChain threaded(250, 198);
+		threaded.m_data[0] = single_threaded.m_data[0];
+
+		util::MipChainDesc desc;
+		desc.m_srgb = true;
+
+		util::ThreadPool thread_pool(4);
+		single_threaded.Generate(desc);
+		threaded.Generate(desc, &thread_pool);
+
+		UNIT_CHECK(single_threaded.m_data == threaded.m_data);
+	}
+}
+
+int main()
+{
+	TestMipCount();
+	TestConstantImage();
+	TestSRGB();
+	TestThreadPool();
+
+	return unit_test::Finish("MipGenerationTest");
+}
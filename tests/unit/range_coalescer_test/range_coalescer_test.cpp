@@ -0,0 +1,182 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Merging of adjacent, overlapping and contained ranges in util::RangeCoalescer, compared with a per-byte reference.
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "util/range_coalescer.hpp"
+#include "unit_test.hpp"
+
+namespace
+{
+	using Range = util::RangeCoalescer::Range;
+
+	bool Equals(Range const & range, void* key, std::uint64_t offset, std::uint64_t size)
+	{
+		return range.m_key == key && range.m_offset == offset && range.m_size == size;
+	}
+
+	void TestMerging()
+	{
+		int a = 0;
+		void* key = &a;
+
+		util::RangeCoalescer coalescer;
+		UNIT_CHECK(coalescer.Empty());
+
+		// Adjacent: [0, 16) and [16, 32) touch
+		coalescer.Add(key, 16, 16);
+		coalescer.Add(key, 0, 16);
+		// Overlapping: [64, 96) and [80, 128)
+		coalescer.Add(key, 80, 48);
+		coalescer.Add(key, 64, 32);
+		// Contained in the previous one
+		coalescer.Add(key, 100, 4);
+		// Disjoint by one byte
+		coalescer.Add(key, 129, 1);
+		// Empty ranges are dropped
+		coalescer.Add(key, 200, 0);
+
+		auto const & ranges = coalescer.Coalesce();
+		UNIT_CHECK(ranges.size() == 3);
+		if (ranges.size() == 3)
+		{
+			UNIT_CHECK(Equals(ranges[0], key, 0, 32));
+			UNIT_CHECK(Equals(ranges[1], key, 64, 64));
+			UNIT_CHECK(Equals(ranges[2], key, 129, 1));
+		}
+
+		// Coalescing the result again doesn't change it
+		UNIT_CHECK(coalescer.Coalesce().size() == 3);
+
+		coalescer.Clear();
+		UNIT_CHECK(coalescer.Empty());
+		UNIT_CHECK(coalescer.Coalesce().empty());
+
+		coalescer.Add(key, 8, 8);
+		UNIT_CHECK(coalescer.Coalesce().size() == 1 && Equals(coalescer.Coalesce()[0], key, 8, 8));
+	}
+
+	void TestKeys()
+	{
+		int buffers[2] = {};
+		void* first = &buffers[0];
+		void* second = &buffers[1];
+
+		util::RangeCoalescer coalescer;
+
+		// The same bytes of two resources are never merged
+		coalescer.Add(second, 0, 16);
+		coalescer.Add(first, 8, 16);
+		coalescer.Add(second, 16, 16);
+		coalescer.Add(first, 0, 8);
+
+		auto const & ranges = coalescer.Coalesce();
+		UNIT_CHECK(ranges.size() == 2);
+		if (ranges.size() == 2)
+		{
+			// Sorted by key, and every key is one contiguous run
+			UNIT_CHECK(Equals(ranges[0], first, 0, 24));
+			UNIT_CHECK(Equals(ranges[1], second, 0, 32));
+		}
+	}
+
+	//! Random ranges on a few keys, the result has to cover exactly the bytes that were added.
+	void TestRandomized(std::uint32_t seed, std::size_t num_ranges)
+	{
+		constexpr std::uint64_t space = 1024;
+
+		std::mt19937 rng(seed);
+		std::uniform_int_distribution<std::uint64_t> offset_dist(0, space - 1);
+		std::uniform_int_distribution<std::uint64_t> size_dist(0, 24);
+
+		int keys[3] = {};
+		std::map<void*, std::vector<bool>> reference;
+
+		util::RangeCoalescer coalescer;
+		for (std::size_t i = 0; i < num_ranges; ++i)
+		{
+			void* key = &keys[rng() % 3];
+			std::uint64_t const offset = offset_dist(rng);
+			std::uint64_t const size = std::min(size_dist(rng), space - offset);
+
+			coalescer.Add(key, offset, size);
+
+			auto& bytes = reference[key];
+			bytes.resize(space, false);
+			for (std::uint64_t b = offset; b < offset + size; ++b)
+			{
+				bytes[b] = true;
+			}
+		}
+
+		std::map<void*, std::vector<bool>> covered;
+		Range const * prev = nullptr;
+		for (auto const & range : coalescer.Coalesce())
+		{
+			UNIT_CHECK(range.m_size > 0);
+
+			if (prev != nullptr && prev->m_key == range.m_key)
+			{
+				// Ranges of one key are sorted and neither overlap nor touch
+				UNIT_CHECK(prev->m_offset + prev->m_size < range.m_offset);
+			}
+			else if (prev != nullptr)
+			{
+				UNIT_CHECK(std::less<void*>()(prev->m_key, range.m_key));
+			}
+
+			auto& bytes = covered[range.m_key];
+			bytes.resize(space, false);
+			for (std::uint64_t b = range.m_offset; b < range.m_offset + range.m_size; ++b)
+			{
+				bytes[b] = true;
+			}
+
+			prev = &range;
+		}
+
+		for (auto& entry : reference)
+		{
+			// A key whose ranges were all empty doesn't show up in the result
+			covered[entry.first].resize(space, false);
+		}
+
+		UNIT_CHECK(covered == reference);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::uint32_t const first_seed = argc > 1 ? static_cast<std::uint32_t>(std::stoul(argv[1])) : 1;
+	std::size_t const num_seeds = argc > 2 ? std::stoul(argv[2]) : 16;
+
+	TestMerging();
+	TestKeys();
+
+	for (std::uint32_t seed = first_seed; seed < first_seed + num_seeds && unit_test::Failures() == 0; ++seed)
+	{
+		TestRandomized(seed, 200);
+	}
+
+	return unit_test::Finish("RangeCoalescerTest");
+}
@@ -0,0 +1,153 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Wrap-around, growth of a full ring and FIFO order of util::RingBuffer, compared with std::deque.
+
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+
+#include "util/ring_buffer.hpp"
+#include "unit_test.hpp"
+
+namespace
+{
+	void TestWrapAround()
+	{
+		util::RingBuffer<int> ring(4);
+
+		ring.Push(0);
+		ring.Push(1);
+		ring.Push(2);
+		ring.Pop();
+		ring.Pop();
+
+		// The head sits at 2, these wrap around the end of the storage
+		ring.Push(3);
+		ring.Push(4);
+		ring.Push(5);
+
+		UNIT_CHECK(ring.Capacity() == 4);
+		UNIT_CHECK(ring.Size() == 4);
+		for (std::size_t i = 0; i < ring.Size(); ++i)
+		{
+			UNIT_CHECK(ring[i] == static_cast<int>(i) + 2);
+		}
+
+		for (int expected = 2; expected <= 5; ++expected)
+		{
+			UNIT_CHECK(ring.Front() == expected);
+			ring.Pop();
+		}
+		UNIT_CHECK(ring.Empty());
+	}
+
+	void TestFull()
+	{
+		util::RingBuffer<int> ring(4);
+
+		// Wrap the head first, so the full ring is split over the end of the storage when it grows
+		ring.Push(-1);
+		ring.Push(-1);
+		ring.Pop();
+		ring.Pop();
+
+		for (int i = 0; i < 4; ++i)
+		{
+			ring.Push(i);
+		}
+		UNIT_CHECK(ring.Size() == ring.Capacity());
+		UNIT_CHECK(ring.Capacity() == 4);
+
+		// Pushing into a full ring doubles it and keeps the order
+		ring.Push(4);
+		UNIT_CHECK(ring.Capacity() == 8);
+		UNIT_CHECK(ring.Size() == 5);
+		for (std::size_t i = 0; i < ring.Size(); ++i)
+		{
+			UNIT_CHECK(ring[i] == static_cast<int>(i));
+		}
+
+		// Popping never shrinks it
+		while (!ring.Empty())
+		{
+			ring.Pop();
+		}
+		UNIT_CHECK(ring.Capacity() == 8);
+
+		ring.Push(7);
+		ring.Clear();
+		UNIT_CHECK(ring.Empty());
+		UNIT_CHECK(ring.Size() == 0);
+
+		// A capacity of zero is bumped to one, the first push after that grows
+		util::RingBuffer<int> tiny(0);
+		UNIT_CHECK(tiny.Capacity() == 1);
+		tiny.Push(1);
+		tiny.Push(2);
+		UNIT_CHECK(tiny.Capacity() == 2 && tiny.Front() == 1 && tiny[1] == 2);
+	}
+
+	void TestRandomized(std::uint32_t seed, std::size_t num_steps)
+	{
+		std::mt19937 rng(seed);
+
+		util::RingBuffer<std::string> ring(2);
+		std::deque<std::string> reference;
+
+		for (std::size_t step = 0; step < num_steps && unit_test::Failures() == 0; ++step)
+		{
+			// Slightly more pushes than pops, so the ring fills up and grows every now and then
+			if (reference.empty() || rng() % 100 < 55)
+			{
+				std::string value = std::to_string(step);
+				ring.Push(value);
+				reference.push_back(value);
+			}
+			else
+			{
+				UNIT_CHECK(ring.Front() == reference.front());
+				ring.Pop();
+				reference.pop_front();
+			}
+
+			UNIT_CHECK(ring.Size() == reference.size());
+			UNIT_CHECK(ring.Size() <= ring.Capacity());
+			if (!reference.empty())
+			{
+				std::size_t const i = rng() % reference.size();
+				UNIT_CHECK(ring[i] == reference[i]);
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::uint32_t const first_seed = argc > 1 ? static_cast<std::uint32_t>(std::stoul(argv[1])) : 1;
+	std::size_t const num_seeds = argc > 2 ? std::stoul(argv[2]) : 8;
+
+	TestWrapAround();
+	TestFull();
+
+	for (std::uint32_t seed = first_seed; seed < first_seed + num_seeds && unit_test::Failures() == 0; ++seed)
+	{
+		TestRandomized(seed, 10000);
+	}
+
+	return unit_test::Finish("RingBufferTest");
+}
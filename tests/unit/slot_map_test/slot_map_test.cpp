@@ -0,0 +1,174 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Generational keys of util::SlotMap: stale keys after erase and slot reuse, the 8 bit generations of the 32 bit
+// keys the material pool uses, and the dense storage staying consistent with the keys.
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "util/slot_map.hpp"
+#include "unit_test.hpp"
+
+namespace
+{
+	template<typename K>
+	void TestStaleKeys()
+	{
+		util::SlotMap<int, K> map;
+
+		K const a = map.Insert(1);
+		K const b = map.Insert(2);
+		UNIT_CHECK(a != b);
+		UNIT_CHECK(map.Find(a) != nullptr && *map.Find(a) == 1);
+		UNIT_CHECK(map.Find(b) != nullptr && *map.Find(b) == 2);
+
+		UNIT_CHECK(map.Erase(a));
+		UNIT_CHECK(map.Find(a) == nullptr);
+		UNIT_CHECK(!map.Contains(a));
+		UNIT_CHECK(!map.Erase(a));
+
+		// The slot of a is reused, the new key differs in its generation only
+		K const c = map.Insert(3);
+		UNIT_CHECK((c & map.index_mask) == (a & map.index_mask));
+		UNIT_CHECK(c != a);
+		UNIT_CHECK(map.Find(a) == nullptr);
+		UNIT_CHECK(!map.Erase(a));
+		UNIT_CHECK(map.Find(c) != nullptr && *map.Find(c) == 3);
+		UNIT_CHECK(map.Find(b) != nullptr && *map.Find(b) == 2);
+		UNIT_CHECK(map.Size() == 2);
+
+		// Keys of slots that never existed
+		UNIT_CHECK(map.Find(static_cast<K>(1000)) == nullptr);
+
+		map.Clear();
+		UNIT_CHECK(map.Empty());
+		UNIT_CHECK(map.Find(b) == nullptr);
+		UNIT_CHECK(map.Find(c) == nullptr);
+	}
+
+	//32 bit keys have 8 generation bits, a slot's generation wraps to 0 after 256 reuses
+	void TestGenerationWrap()
+	{
+		using Map = util::SlotMap<int, std::uint32_t>;
+		static_assert(Map::index_bits == 24);
+		static_assert(Map::generation_mask == 0xFF);
+		static_assert(Map::index_mask == 0xFFFFFF);
+
+		Map map;
+		std::uint32_t const other = map.Insert(-1);
+		std::uint32_t const first = map.Insert(0);
+		std::uint32_t const slot = first & Map::index_mask;
+
+		std::uint32_t previous = first;
+		bool same_slot = true;
+		bool stale_rejected = true;
+		bool generations_in_range = true;
+
+		for (int i = 1; i <= 256; ++i)
+		{
+			map.Erase(previous);
+			std::uint32_t const key = map.Insert(i);
+
+			same_slot &= (key & Map::index_mask) == slot;
+			generations_in_range &= (key >> Map::index_bits) == static_cast<std::uint32_t>(i & 0xFF);
+			stale_rejected &= map.Find(previous) == nullptr && map.Find(key) != nullptr && *map.Find(key) == i;
+
+			previous = key;
+		}
+
+		UNIT_CHECK(same_slot);
+		UNIT_CHECK(generations_in_range);
+		UNIT_CHECK(stale_rejected);
+
+		// After 256 reuses the generation wrapped around, the first key names the slot again
+		UNIT_CHECK(previous == first);
+		UNIT_CHECK(map.Find(first) != nullptr && *map.Find(first) == 256);
+
+		// The wrap doesn't touch the index bits of other slots
+		UNIT_CHECK(map.Find(other) != nullptr && *map.Find(other) == -1);
+		UNIT_CHECK(map.Size() == 2);
+	}
+
+	//Random inserts and erases compared with a std::map, including that KeyAt matches the dense values
+	template<typename K>
+	void TestAgainstReference()
+	{
+		util::SlotMap<int, K> map;
+		std::map<K, int> reference;
+		std::vector<K> erased;
+
+		std::mt19937 random(7);
+		int next_value = 0;
+
+		for (int step = 0; step < 20000; ++step)
+		{
+			if (reference.empty() || random() % 3 != 0)
+			{
+				K const key = map.Insert(next_value);
+				UNIT_CHECK(reference.count(key) == 0);
+				reference[key] = next_value++;
+			}
+			else
+			{
+				auto it = reference.begin();
+				std::advance(it, random() % reference.size());
+				UNIT_CHECK(map.Erase(it->first));
+				erased.push_back(it->first);
+				reference.erase(it);
+			}
+		}
+
+		UNIT_CHECK(map.Size() == reference.size());
+
+		bool found = true;
+		for (auto const & [key, value] : reference)
+		{
+			found &= map.Find(key) != nullptr && *map.Find(key) == value;
+		}
+		UNIT_CHECK(found);
+
+		bool consistent = true;
+		for (std::size_t i = 0; i < map.Size(); ++i)
+		{
+			auto it = reference.find(map.KeyAt(i));
+			consistent &= it != reference.end() && it->second == map[i];
+		}
+		UNIT_CHECK(consistent);
+
+		// Erased keys stay stale unless the slot has been reused 2^generation_bits times since
+		bool stale = true;
+		for (K key : erased)
+		{
+			stale &= reference.count(key) != 0 || map.Find(key) == nullptr;
+		}
+		UNIT_CHECK(stale);
+	}
+}
+
+int main()
+{
+	TestStaleKeys<std::uint64_t>();
+	TestStaleKeys<std::uint32_t>();
+	TestGenerationWrap();
+	TestAgainstReference<std::uint64_t>();
+	TestAgainstReference<std::uint32_t>();
+
+	return unit_test::Finish("SlotMapTest");
+}
@@ -0,0 +1,192 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Throughput of util::TLSFAllocator against a first-fit block list like the one D3D12ModelPool used before it,
+// on a workload that streams meshes in and out of a heap: TLSFAllocatorBenchmark [live_allocations] [operations]
+
+#include <cstdio>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "util/tlsf_allocator.hpp"
+#include "unit_test.hpp"
+
+namespace
+{
+	//! First fit over a linked list of blocks, freeing searches the list for the block.
+	class FirstFitAllocator
+	{
+	public:
+		struct Block
+		{
+			std::size_t m_offset;
+			std::size_t m_size;
+			bool m_free;
+		};
+
+		explicit FirstFitAllocator(std::size_t size)
+		{
+			m_blocks.push_back({ 0, size, true });
+		}
+
+		Block* Allocate(std::size_t size, std::size_t alignment)
+		{
+			for (auto it = m_blocks.begin(); it != m_blocks.end(); ++it)
+			{
+				if (!it->m_free)
+				{
+					continue;
+				}
+
+				std::size_t const misalignment = it->m_offset % alignment;
+				std::size_t const padding = misalignment == 0 ? 0 : alignment - misalignment;
+				if (it->m_size < size + padding)
+				{
+					continue;
+				}
+
+				if (padding > 0)
+				{
+					m_blocks.insert(it, { it->m_offset, padding, true });
+					it->m_offset += padding;
+					it->m_size -= padding;
+				}
+
+				if (it->m_size > size)
+				{
+					m_blocks.insert(std::next(it), { it->m_offset + size, it->m_size - size, true });
+					it->m_size = size;
+				}
+
+				it->m_free = false;
+				return &*it;
+			}
+
+			return nullptr;
+		}
+
+		void Free(Block* block)
+		{
+			auto it = m_blocks.begin();
+			while (&*it != block)
+			{
+				++it;
+			}
+
+			it->m_free = true;
+
+			if (auto next = std::next(it); next != m_blocks.end() && next->m_free)
+			{
+				it->m_size += next->m_size;
+				m_blocks.erase(next);
+			}
+
+			if (it != m_blocks.begin())
+			{
+				if (auto prev = std::prev(it); prev->m_free)
+				{
+					prev->m_size += it->m_size;
+					m_blocks.erase(it);
+				}
+			}
+		}
+
+	private:
+		std::list<Block> m_blocks;
+	};
+
+	struct Operation
+	{
+		bool m_allocate;
+		std::size_t m_size;
+		std::size_t m_alignment;
+		std::size_t m_slot; // Which live allocation is freed, or where a new one is stored
+	};
+
+	//! Fills the heap up to num_live allocations, then alternates freeing a random one and allocating a new one.
+	std::vector<Operation> GenerateWorkload(std::size_t num_live, std::size_t num_operations)
+	{
+		std::mt19937 random(42);
+		// Mesh sized allocations with typical vertex strides and index sizes as alignment
+		std::uniform_int_distribution<std::size_t> size_distribution(256, 256 * 1024);
+		std::size_t const alignments[] = { 2, 4, 32, 44, 56, 64 };
+		std::uniform_int_distribution<std::size_t> alignment_distribution(0, std::size(alignments) - 1);
+		std::uniform_int_distribution<std::size_t> slot_distribution(0, num_live - 1);
+
+		std::vector<Operation> operations;
+		operations.reserve(num_live + num_operations);
+
+		for (std::size_t i = 0; i < num_live; ++i)
+		{
+			operations.push_back({ true, size_distribution(random), alignments[alignment_distribution(random)], i });
+		}
+
+		for (std::size_t i = 0; i < num_operations / 2; ++i)
+		{
+			std::size_t const slot = slot_distribution(random);
+			operations.push_back({ false, 0, 0, slot });
+			operations.push_back({ true, size_distribution(random), alignments[alignment_distribution(random)], slot });
+		}
+
+		return operations;
+	}
+
+	template<typename Allocator>
+	void Run(char const * name, std::vector<Operation> const & operations, std::size_t num_live, std::size_t heap_size)
+	{
+		Allocator allocator(heap_size);
+		std::vector<decltype(allocator.Allocate(1, 1))> live(num_live, nullptr);
+		std::size_t failures = 0;
+
+		double const seconds = unit_test::Time([&]()
+		{
+			for (Operation const & operation : operations)
+			{
+				if (operation.m_allocate)
+				{
+					live[operation.m_slot] = allocator.Allocate(operation.m_size, operation.m_alignment);
+					failures += live[operation.m_slot] == nullptr;
+				}
+				else if (live[operation.m_slot] != nullptr)
+				{
+					allocator.Free(live[operation.m_slot]);
+					live[operation.m_slot] = nullptr;
+				}
+			}
+		});
+
+		std::printf("  %-12s %10.3f ms %12.0f ops/s %8.1f ns/op, %zu failed allocations\n",
+			name, seconds * 1000.0, operations.size() / seconds, seconds * 1e9 / operations.size(), failures);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::size_t const num_live = argc > 1 ? std::stoul(argv[1]) : 4000;
+	std::size_t const num_operations = argc > 2 ? std::stoul(argv[2]) : 200000;
+
+	// Room for twice the average live size, so failures come from fragmentation rather than a full heap
+	std::size_t const heap_size = num_live * 256 * 1024;
+	std::vector<Operation> const operations = GenerateWorkload(num_live, num_operations);
+
+	std::printf("%zu live allocations, %zu operations, %zu MiB heap\n", num_live, operations.size(), heap_size / (1024 * 1024));
+	Run<util::TLSFAllocator>("TLSF", operations, num_live, heap_size);
+	Run<FirstFitAllocator>("First fit", operations, num_live, heap_size);
+
+	return 0;
+}
@@ -0,0 +1,252 @@
+/*!
+ * Copyright 2019 Breda University of Applied Sciences and Team Wisp (Viktor Zoutman, Emilio Laiso, Jens Hagen, Meine Zeinstra, Tahar Meijs, Koen Buitenhuis, Niels Brunekreef, Darius Bouma, Florian Schut)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Randomized allocate/free/resize/compact sequences on util::TLSFAllocator, checking the block lists after every step.
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "util/tlsf_allocator.hpp"
+#include "unit_test.hpp"
+
+namespace
+{
+	struct Allocation
+	{
+		util::TLSFAllocator::Block* m_block;
+		std::size_t m_size; // What was asked for
+		std::size_t m_alignment;
+		std::size_t m_offset; // Where the owner thinks its data is, updated by Compact's callback
+	};
+
+	//! Walks the physical block list and compares it with the allocator's counters and the live allocations.
+	void CheckInvariants(util::TLSFAllocator const & allocator, std::vector<Allocation> const & allocations)
+	{
+		std::size_t offset = 0;
+		std::size_t used_size = 0;
+		std::size_t num_used = 0;
+		std::size_t num_free = 0;
+		std::size_t largest_free = 0;
+
+		util::TLSFAllocator::Block const * prev = nullptr;
+		for (auto const * block = allocator.GetFirstBlock(); block != nullptr; block = block->m_next_physical)
+		{
+			// The blocks tile the range without gaps or overlap
+			UNIT_CHECK(block->m_offset == offset);
+			UNIT_CHECK(block->m_size > 0);
+			UNIT_CHECK(block->m_prev_physical == prev);
+
+			if (block->m_free)
+			{
+				// Free neighbours are always coalesced
+				UNIT_CHECK(prev == nullptr || !prev->m_free);
+				largest_free = std::max(largest_free, block->m_size);
+				++num_free;
+			}
+			else
+			{
+				UNIT_CHECK(block->m_offset % block->m_alignment == 0);
+				used_size += block->m_size;
+				++num_used;
+			}
+
+			offset += block->m_size;
+			prev = block;
+		}
+
+		UNIT_CHECK(allocator.GetLastBlock() == prev);
+		UNIT_CHECK(offset == allocator.GetSize());
+		UNIT_CHECK(used_size == allocator.GetUsedSize());
+		UNIT_CHECK(num_used == allocator.GetNumUsedBlocks());
+		UNIT_CHECK(num_free == allocator.GetNumFreeBlocks());
+		UNIT_CHECK(num_used == allocations.size());
+		UNIT_CHECK(largest_free == allocator.GetLargestFreeBlockSize());
+
+		for (Allocation const & allocation : allocations)
+		{
+			UNIT_CHECK(!allocation.m_block->m_free);
+			UNIT_CHECK(allocation.m_block->m_offset == allocation.m_offset);
+			UNIT_CHECK(allocation.m_block->m_size >= allocation.m_size);
+			UNIT_CHECK(allocation.m_offset % allocation.m_alignment == 0);
+		}
+	}
+
+	void TestRandomized(std::uint32_t seed, std::size_t num_steps)
+	{
+		std::mt19937 random(seed);
+
+		// Vertex strides aren't powers of two, the allocator has to handle those too
+		std::size_t const alignments[] = { 1, 4, 12, 16, 32, 44, 256 };
+		std::uniform_int_distribution<std::size_t> size_distribution(1, 4096);
+		std::uniform_int_distribution<std::size_t> alignment_distribution(0, std::size(alignments) - 1);
+		std::uniform_int_distribution<int> operation_distribution(0, 99);
+
+		util::TLSFAllocator allocator(256 * 1024);
+		std::vector<Allocation> allocations;
+
+		for (std::size_t step = 0; step < num_steps; ++step)
+		{
+			int const operation = operation_distribution(random);
+
+			if (operation < 55)
+			{
+				std::size_t const size = size_distribution(random);
+				std::size_t const alignment = alignments[alignment_distribution(random)];
+
+				if (auto* block = allocator.Allocate(size, alignment))
+				{
+					allocations.push_back({ block, size, alignment, block->m_offset });
+				}
+				else
+				{
+					// Good fit: a failure means no free block is larger than the request rounded up to the next size class
+					std::size_t const worst_case = size + alignment - 1;
+					UNIT_CHECK(allocator.GetLargestFreeBlockSize() < worst_case + worst_case / 8 + 1);
+				}
+			}
+			else if (operation < 97)
+			{
+				if (!allocations.empty())
+				{
+					std::size_t const index = std::uniform_int_distribution<std::size_t>(0, allocations.size() - 1)(random);
+					allocator.Free(allocations[index].m_block);
+					allocations[index] = allocations.back();
+					allocations.pop_back();
+				}
+			}
+			else if (operation < 98)
+			{
+				// Growing always works, shrinking only down to the end of the last allocation
+				std::size_t const grown = allocator.GetSize() + 64 * 1024;
+				UNIT_CHECK(allocator.Resize(grown));
+				UNIT_CHECK(allocator.GetSize() == grown);
+
+				if (allocator.GetUsedEnd() > 0)
+				{
+					UNIT_CHECK(!allocator.Resize(allocator.GetUsedEnd() - 1));
+				}
+
+				UNIT_CHECK(allocator.Resize(allocator.GetUsedEnd() + (allocator.GetSize() - allocator.GetUsedEnd()) / 2));
+			}
+			else
+			{
+				std::unordered_map<util::TLSFAllocator::Block*, Allocation*> owners;
+				for (Allocation& allocation : allocations)
+				{
+					owners[allocation.m_block] = &allocation;
+				}
+
+				std::size_t last_old_offset = 0;
+				bool ascending = true;
+
+				allocator.Compact([&](util::TLSFAllocator::Block* block, std::size_t old_offset)
+				{
+					// Moves come in ascending order and only towards the front
+					ascending &= old_offset >= last_old_offset && block->m_offset < old_offset;
+					last_old_offset = old_offset;
+
+					Allocation* owner = owners.at(block);
+					UNIT_CHECK(owner->m_offset == old_offset);
+					owner->m_offset = block->m_offset;
+				});
+
+				UNIT_CHECK(ascending);
+				// Everything is packed at the front, only alignment padding is left in between
+				for (auto const * block = allocator.GetFirstBlock(); block != nullptr && block->m_next_physical != nullptr; block = block->m_next_physical)
+				{
+					UNIT_CHECK(!block->m_free || block->m_size < block->m_next_physical->m_alignment);
+				}
+			}
+
+			CheckInvariants(allocator, allocations);
+
+			if (unit_test::Failures() > 0)
+			{
+				std::printf("seed %u failed at step %zu\n", seed, step);
+				return;
+			}
+		}
+
+		// Freeing everything coalesces the range back into one block
+		for (Allocation const & allocation : allocations)
+		{
+			allocator.Free(allocation.m_block);
+		}
+		allocations.clear();
+
+		CheckInvariants(allocator, allocations);
+		UNIT_CHECK(allocator.GetNumFreeBlocks() == 1);
+		UNIT_CHECK(allocator.GetLargestFreeBlockSize() == allocator.GetSize());
+		UNIT_CHECK(allocator.GetFragmentation() == 0.f);
+	}
+
+	void TestCoalescing()
+	{
+		util::TLSFAllocator allocator(1024);
+
+		auto* a = allocator.Allocate(100);
+		auto* b = allocator.Allocate(100);
+		auto* c = allocator.Allocate(100);
+		UNIT_CHECK(a != nullptr && b != nullptr && c != nullptr);
+
+		// Middle, then left (merges with the middle), then right (merges with both and the tail)
+		allocator.Free(b);
+		UNIT_CHECK(allocator.GetNumFreeBlocks() == 2);
+		allocator.Free(a);
+		UNIT_CHECK(allocator.GetNumFreeBlocks() == 2);
+		UNIT_CHECK(allocator.GetFirstBlock()->m_free && allocator.GetFirstBlock()->m_size == 200);
+		allocator.Free(c);
+		UNIT_CHECK(allocator.GetNumFreeBlocks() == 1);
+		UNIT_CHECK(allocator.GetFirstBlock()->m_size == 1024);
+
+		CheckInvariants(allocator, {});
+	}
+
+	void TestExhaustion()
+	{
+		util::TLSFAllocator allocator(1024);
+
+		auto* whole = allocator.Allocate(1024);
+		UNIT_CHECK(whole != nullptr && whole->m_offset == 0);
+		UNIT_CHECK(allocator.Allocate(1) == nullptr);
+		UNIT_CHECK(allocator.GetFreeSize() == 0);
+		UNIT_CHECK(!allocator.Resize(512));
+
+		allocator.Free(whole);
+		UNIT_CHECK(allocator.Resize(512));
+		UNIT_CHECK(allocator.Allocate(1024) == nullptr);
+		UNIT_CHECK(allocator.Allocate(512) != nullptr);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::uint32_t const first_seed = argc > 1 ? static_cast<std::uint32_t>(std::stoul(argv[1])) : 1;
+	std::size_t const num_seeds = argc > 2 ? std::stoul(argv[2]) : 4;
+
+	TestCoalescing();
+	TestExhaustion();
+
+	for (std::uint32_t seed = first_seed; seed < first_seed + num_seeds && unit_test::Failures() == 0; ++seed)
+	{
+		TestRandomized(seed, 10000);
+	}
+
+	return unit_test::Finish("TLSFAllocatorTest");
+}